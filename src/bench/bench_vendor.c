@@ -0,0 +1,192 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file bench_vendor.c
+ *
+ * Vendor layer linked into the benchmark harness instead of vendor.c
+ * Registers a synthetic data model (Device.X_BENCH), whose shape is configured from the benchmark's command line
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "common_defs.h"
+#include "usp_err_codes.h"
+#include "vendor_defs.h"
+#include "vendor_api.h"
+#include "usp_api.h"
+#include "usp_bench.h"
+
+//------------------------------------------------------------------------------
+// Shape of the synthetic data model
+int bench_num_objects = 100;
+int bench_num_sub_objects = 4;
+int bench_num_params = 10;
+
+//------------------------------------------------------------------------------
+// Number of times that the vendor parameter has been read
+static unsigned bench_counter = 0;
+
+//------------------------------------------------------------------------------
+// Arguments of the Reset() operation
+static char *reset_output_args[] =
+{
+    "Status",
+};
+
+//------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+int GetBenchCounter(dm_req_t *req, char *buf, int len);
+int BenchReset(dm_req_t *req, char *command_key, kv_vector_t *input_args, kv_vector_t *output_args);
+
+/*********************************************************************//**
+**
+** VENDOR_Init
+**
+** Initialises this component, and registers all parameters and vendor hooks, which it implements
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int VENDOR_Init(void)
+{
+    int i;
+    int err;
+    char path[MAX_DM_PATH];
+
+    err = USP_ERR_OK;
+    err |= USP_REGISTER_Object(BENCH_OBJECT ".{i}", NULL, NULL, NULL, NULL, NULL, NULL);
+    err |= USP_REGISTER_Param_NumEntries(BENCH_ROOT ".ObjectNumberOfEntries", BENCH_OBJECT ".{i}");
+    err |= USP_REGISTER_DBParam_ReadWrite(BENCH_OBJECT ".{i}.Name", "", NULL, NULL, DM_STRING);
+    err |= USP_REGISTER_VendorParam_ReadOnly(BENCH_OBJECT ".{i}.Counter", GetBenchCounter, DM_UINT);
+
+    for (i=1; i <= bench_num_params; i++)
+    {
+        USP_SNPRINTF(path, sizeof(path), "%s.{i}.Param%d", BENCH_OBJECT, i);
+        err |= USP_REGISTER_DBParam_ReadWrite(path, "0", NULL, NULL, DM_UINT);
+    }
+
+    err |= USP_REGISTER_Object(BENCH_OBJECT ".{i}.Sub.{i}", NULL, NULL, NULL, NULL, NULL, NULL);
+    err |= USP_REGISTER_Param_NumEntries(BENCH_OBJECT ".{i}.SubNumberOfEntries", BENCH_OBJECT ".{i}.Sub.{i}");
+    err |= USP_REGISTER_DBParam_ReadWrite(BENCH_OBJECT ".{i}.Sub.{i}.Value", "", NULL, NULL, DM_STRING);
+
+    err |= USP_REGISTER_SyncOperation(BENCH_ROOT ".Reset()", BenchReset);
+    err |= USP_REGISTER_OperationArguments(BENCH_ROOT ".Reset()", NULL, 0, reset_output_args, NUM_ELEM(reset_output_args));
+
+    if (err != USP_ERR_OK)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** VENDOR_Start
+**
+** Called after data model has been registered and after instance numbers have been read from the USP database
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int VENDOR_Start(void)
+{
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** VENDOR_Stop
+**
+** Called when stopping USP agent gracefully
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int VENDOR_Stop(void)
+{
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** GetBenchCounter
+**
+** Gets the value of Device.X_BENCH.Object.{i}.Counter
+** This models a vendor parameter whose value is obtained from outside of the USP database
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer in which to return the value
+** \param   len - length of return buffer
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int GetBenchCounter(dm_req_t *req, char *buf, int len)
+{
+    val_uint = bench_counter++;
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** BenchReset
+**
+** Sync Operation handler for Device.X_BENCH.Reset()
+**
+** \param   req - pointer to structure identifying the operation in the data model
+** \param   command_key - pointer to string containing the command key for this operation
+** \param   input_args - vector containing input arguments and their values
+** \param   output_args - vector to return output arguments in
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BenchReset(dm_req_t *req, char *command_key, kv_vector_t *input_args, kv_vector_t *output_args)
+{
+    bench_counter = 0;
+    USP_ARG_Add(output_args, "Status", "Complete");
+
+    return USP_ERR_OK;
+}
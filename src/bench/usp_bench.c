@@ -0,0 +1,932 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file usp_bench.c
+ *
+ * Benchmark harness which replays USP messages against the agent's message handler in-process,
+ * and reports throughput, latency percentiles, allocations per message and peak memory usage
+ *
+ * The harness is linked with the core of the agent, the synthetic vendor layer in bench_vendor.c,
+ * and a loopback MTP (the responses which the agent would send to the controller are discarded)
+ * Build and run it using 'make bench'
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <curl/curl.h>
+
+#include "common_defs.h"
+#include "usp-msg.pb-c.h"
+#include "usp-record.pb-c.h"
+#include "os_utils.h"
+#include "text_utils.h"
+#include "sync_timer.h"
+#include "data_model.h"
+#include "database.h"
+#include "dm_trans.h"
+#include "dm_exec.h"
+#include "mtp_exec.h"
+#include "bdc_exec.h"
+#include "retry_wait.h"
+#include "msg_handler.h"
+#include "proto_trace.h"
+#include "device.h"
+#include "usp_bench.h"
+
+//------------------------------------------------------------------------------
+// Location of the database used by the benchmark. This is deleted before each run, so that the benchmark starts from factory reset
+#define BENCH_DATABASE_FILE   "/tmp/usp_bench.db"
+
+//------------------------------------------------------------------------------
+// Endpoint of the controller that all benchmark messages are sent from
+// NOTE: This controller is present in the factory reset database (see vendor_factory_reset_example.c)
+#define BENCH_CONTROLLER      "self::usp-controller.com"
+
+//------------------------------------------------------------------------------
+// Default number of times that each message in the corpus is replayed
+#define DEFAULT_ITERATIONS    1000
+
+//------------------------------------------------------------------------------
+// Structure containing a USP message to replay, and the statistics collected whilst replaying it
+typedef struct
+{
+    char name[64];                  // Description of the message, printed in the report
+    unsigned char *pbuf;            // Protobuf encoded USP record containing the message
+    int pbuf_len;                   // Length of the protobuf encoded USP record
+    unsigned long long *latency;    // Array containing the time taken (in nanoseconds) to handle the message, for each iteration
+    int num_samples;                // Number of entries in the latency array
+    unsigned long long allocs;      // Total number of heap allocations performed whilst handling the message, over all iterations
+    int num_errors;                 // Number of times that the agent responded with a USP Error message
+} bench_msg_t;
+
+//------------------------------------------------------------------------------
+// Corpus of USP messages to replay
+static bench_msg_t *corpus = NULL;
+static int num_corpus = 0;
+
+//------------------------------------------------------------------------------
+// Counters updated by the allocator and loopback MTP wrappers
+static unsigned long long num_allocs = 0;       // Number of calls to malloc(), calloc() and realloc() by the agent
+static unsigned num_responses = 0;              // Number of USP messages that the agent tried to send to the controller
+static Usp__Header__MsgType last_response_type; // Type of the last USP message that the agent tried to send to the controller
+
+//------------------------------------------------------------------------------
+// Global variables normally defined by main.c
+bool enable_callstack_debug = false;
+
+//------------------------------------------------------------------------------
+// Real functions wrapped by the linker (see usp_bench_LDFLAGS in Makefile.am)
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+//------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+int StartAgent(void);
+int SeedDatabase(void);
+void BuildCorpus(void);
+void AddRequest(char *name, Usp__Header__MsgType msg_type, Usp__Request *req);
+void AddRecord(char *name, unsigned char *msg_buf, int msg_len);
+int LoadCapture(char *filename);
+void LoadCapturedRecord(capture_dir_t dir, mtp_protocol_t protocol, struct timeval *tv, unsigned char *pbuf, int pbuf_len, void *arg);
+void RunBenchmark(int iterations);
+void PrintReport(unsigned long long elapsed);
+int CompareLatency(const void *a, const void *b);
+unsigned long long GetTimeNs(void);
+void PrintUsage(char *prog_name);
+
+/*********************************************************************//**
+**
+** main
+**
+** Main function of the benchmark harness
+**
+** \param   argc - Number of command line arguments
+** \param   argv - Array of pointers to command line argument strings
+**
+** \return  0 if successful, -1 if an error occurred
+**
+**************************************************************************/
+int main(int argc, char *argv[])
+{
+    int c;
+    int err;
+    unsigned value;
+    int iterations = DEFAULT_ITERATIONS;
+    char *capture_file = NULL;
+    unsigned long long start;
+
+    // Determine a handle for the data model thread (this thread)
+    OS_UTILS_SetDataModelThread();
+
+    // Exit if unable to initialise basic subsystems
+    USP_LOG_Init();
+    USP_ERR_Init();
+    err = USP_MEM_Init();
+    if (err != USP_ERR_OK)
+    {
+        return -1;
+    }
+
+    // Iterate over all command line options
+    while ((c = getopt(argc, argv, "hn:s:p:i:r:v:")) != -1)
+    {
+        if ((c == 'h') || (c == '?'))
+        {
+            PrintUsage(argv[0]);
+            return (c == 'h') ? 0 : -1;
+        }
+
+        if (c == 'r')
+        {
+            capture_file = optarg;
+            continue;
+        }
+
+        // All other options take an unsigned value
+        err = TEXT_UTILS_StringToUnsigned(optarg, &value);
+        if (err != USP_ERR_OK)
+        {
+            USP_LOG_Error("ERROR: Value of option '-%c' (%s) is invalid", c, optarg);
+            return -1;
+        }
+
+        switch (c)
+        {
+            case 'n':
+                bench_num_objects = value;
+                break;
+
+            case 's':
+                bench_num_sub_objects = value;
+                break;
+
+            case 'p':
+                bench_num_params = value;
+                break;
+
+            case 'i':
+                iterations = (value > 0) ? value : 1;
+                break;
+
+            case 'v':
+                usp_log_level = (value < kLogLevel_Max) ? value : kLogLevel_Max-1;
+                break;
+        }
+    }
+
+    // Exit if unable to start the agent with the synthetic data model
+    start = GetTimeNs();
+    err = StartAgent();
+    if (err != USP_ERR_OK)
+    {
+        USP_LOG_Error("ERROR: Unable to start USP Agent for benchmark");
+        return -1;
+    }
+
+    // Exit if unable to seed the database with instances of the synthetic data model
+    err = SeedDatabase();
+    if (err != USP_ERR_OK)
+    {
+        USP_LOG_Error("ERROR: Unable to seed the database for benchmark");
+        return -1;
+    }
+    printf("Schema: %d objects x (%d params + %d sub-objects). Startup took %llu ms\n", 
+           bench_num_objects, bench_num_params, bench_num_sub_objects, (GetTimeNs()-start)/1000000);
+
+    // Exit if unable to build the corpus of messages to replay
+    if (capture_file != NULL)
+    {
+        err = LoadCapture(capture_file);
+        if (err != USP_ERR_OK)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        BuildCorpus();
+    }
+
+    // Replay the corpus and report the results
+    start = GetTimeNs();
+    RunBenchmark(iterations);
+    PrintReport(GetTimeNs() - start);
+
+    return 0;
+}
+
+/*********************************************************************//**
+**
+** MAIN_Stop
+**
+** Called by the data model to stop the agent (eg on reboot or factory reset)
+** The benchmark ignores this, as it does not run the agent's threads
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void MAIN_Stop(void)
+{
+}
+
+/*********************************************************************//**
+**
+** __wrap_malloc, __wrap_calloc, __wrap_realloc
+**
+** Linker wrappers around the heap allocation functions, which count the number of allocations performed by the agent
+**
+**************************************************************************/
+void *__wrap_malloc(size_t size)
+{
+    num_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    num_allocs++;
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    num_allocs++;
+    return __real_realloc(ptr, size);
+}
+
+/*********************************************************************//**
+**
+** __wrap_DEVICE_CONTROLLER_QueueBinaryMessage
+**
+** Loopback MTP. Linker wrapper around DEVICE_CONTROLLER_QueueBinaryMessage(), which discards the USP record,
+** rather than sending it to the controller
+**
+** \param   usp_msg_type - Type of USP message contained in pbuf
+** \param   endpoint_id - controller to send the message to
+** \param   pbuf - pointer to buffer containing the USP record to send. Ownership passes to this function
+** \param   pbuf_len - length of buffer containing protobuf binary message
+** \param   stomp_dest - STOMP destination to send the message to (or NULL if none setup in received message)
+** \param   stomp_instance - STOMP instance (in Device.STOMP.Connection table) to send the message on
+**
+** \return  USP_ERR_OK
+**
+**************************************************************************/
+int __wrap_DEVICE_CONTROLLER_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, char *endpoint_id, unsigned char *pbuf, int pbuf_len, char *stomp_dest, int stomp_instance)
+{
+    num_responses++;
+    last_response_type = usp_msg_type;
+    USP_FREE(pbuf);
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** StartAgent
+**
+** Starts the parts of the agent needed to handle USP messages (this mirrors MAIN_Start(), but does not start any MTP connections)
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int StartAgent(void)
+{
+    int err;
+
+    // Exit if unable to initialise libraries which need to be initialised when running single threaded
+    if (curl_global_init(CURL_GLOBAL_ALL) != 0)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    SYNC_TIMER_Init();
+    signal(SIGPIPE, SIG_IGN);
+
+    // Exit if unable to create a database at factory reset
+    unlink(BENCH_DATABASE_FILE);
+    err = DATABASE_Init(BENCH_DATABASE_FILE);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if an error occurred when initialising any of the the message queues used by the threads
+    err = DM_EXEC_Init();
+    err |= MTP_EXEC_Init();
+    err |= BDC_EXEC_Init();
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    RETRY_WAIT_Init();
+
+    // Exit if unable to add all schema paths to the data model (this calls VENDOR_Init() to register the synthetic data model)
+    err = DATA_MODEL_Init();
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to start the datamodel objects
+    err = DATA_MODEL_Start();
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** SeedDatabase
+**
+** Adds the configured number of instances of the synthetic data model to the database
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int SeedDatabase(void)
+{
+    int i, j;
+    int err;
+    int instance;
+    int sub_instance;
+    dm_trans_vector_t trans;
+    char path[MAX_DM_PATH];
+    char value[32];
+
+    // Exit if unable to start a transaction
+    err = DM_TRANS_Start(&trans);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    for (i=0; i < bench_num_objects; i++)
+    {
+        // Exit if unable to add an object
+        err = DATA_MODEL_AddInstance(BENCH_OBJECT, &instance, 0);
+        if (err != USP_ERR_OK)
+        {
+            goto exit;
+        }
+
+        // Exit if unable to name the object
+        USP_SNPRINTF(path, sizeof(path), "%s.%d.Name", BENCH_OBJECT, instance);
+        USP_SNPRINTF(value, sizeof(value), "object-%d", instance);
+        err = DATA_MODEL_SetParameterValue(path, value, 0);
+        if (err != USP_ERR_OK)
+        {
+            goto exit;
+        }
+
+        // Exit if unable to add the sub-objects of the object
+        USP_SNPRINTF(path, sizeof(path), "%s.%d.Sub", BENCH_OBJECT, instance);
+        for (j=0; j < bench_num_sub_objects; j++)
+        {
+            err = DATA_MODEL_AddInstance(path, &sub_instance, 0);
+            if (err != USP_ERR_OK)
+            {
+                goto exit;
+            }
+        }
+    }
+
+    return DM_TRANS_Commit();
+
+exit:
+    DM_TRANS_Abort();
+    return err;
+}
+
+/*********************************************************************//**
+**
+** BuildCorpus
+**
+** Builds the synthetic corpus of USP messages to replay, covering each type of USP request handled by the agent
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void BuildCorpus(void)
+{
+    Usp__Request req;
+    char *path;
+
+    // Get of a single object (all of its parameters and sub-objects)
+    {
+        Usp__Get get = USP__GET__INIT;
+        path = BENCH_OBJECT ".1.";
+        get.n_param_paths = 1;
+        get.param_paths = &path;
+        req = (Usp__Request) USP__REQUEST__INIT;
+        req.req_type_case = USP__REQUEST__REQ_TYPE_GET;
+        req.get = &get;
+        AddRequest("Get (object)", USP__HEADER__MSG_TYPE__GET, &req);
+    }
+
+    // Get of a parameter across all objects
+    {
+        Usp__Get get = USP__GET__INIT;
+        path = BENCH_OBJECT ".*.Param1";
+        get.n_param_paths = 1;
+        get.param_paths = &path;
+        req = (Usp__Request) USP__REQUEST__INIT;
+        req.req_type_case = USP__REQUEST__REQ_TYPE_GET;
+        req.get = &get;
+        AddRequest("Get (wildcard)", USP__HEADER__MSG_TYPE__GET, &req);
+    }
+
+    // Set of a parameter in a single object
+    {
+        Usp__Set set = USP__SET__INIT;
+        Usp__Set__UpdateObject obj = USP__SET__UPDATE_OBJECT__INIT;
+        Usp__Set__UpdateParamSetting param = USP__SET__UPDATE_PARAM_SETTING__INIT;
+        Usp__Set__UpdateObject *pobj = &obj;
+        Usp__Set__UpdateParamSetting *pparam = &param;
+        param.param = "Param1";
+        param.value = "42";
+        param.required = true;
+        obj.obj_path = BENCH_OBJECT ".1.";
+        obj.n_param_settings = 1;
+        obj.param_settings = &pparam;
+        set.n_update_objs = 1;
+        set.update_objs = &pobj;
+        req = (Usp__Request) USP__REQUEST__INIT;
+        req.req_type_case = USP__REQUEST__REQ_TYPE_SET;
+        req.set = &set;
+        AddRequest("Set", USP__HEADER__MSG_TYPE__SET, &req);
+    }
+
+    // Add of an object (which is deleted again by the next message)
+    {
+        Usp__Add add = USP__ADD__INIT;
+        Usp__Add__CreateObject obj = USP__ADD__CREATE_OBJECT__INIT;
+        Usp__Add__CreateParamSetting param = USP__ADD__CREATE_PARAM_SETTING__INIT;
+        Usp__Add__CreateObject *pobj = &obj;
+        Usp__Add__CreateParamSetting *pparam = &param;
+        param.param = "Name";
+        param.value = BENCH_ADDED_NAME;
+        param.required = true;
+        obj.obj_path = BENCH_OBJECT ".";
+        obj.n_param_settings = 1;
+        obj.param_settings = &pparam;
+        add.n_create_objs = 1;
+        add.create_objs = &pobj;
+        req = (Usp__Request) USP__REQUEST__INIT;
+        req.req_type_case = USP__REQUEST__REQ_TYPE_ADD;
+        req.add = &add;
+        AddRequest("Add", USP__HEADER__MSG_TYPE__ADD, &req);
+    }
+
+    // Delete of the object added by the previous message
+    {
+        Usp__Delete del = USP__DELETE__INIT;
+        path = BENCH_OBJECT ".[Name==\"" BENCH_ADDED_NAME "\"].";
+        del.n_obj_paths = 1;
+        del.obj_paths = &path;
+        req = (Usp__Request) USP__REQUEST__INIT;
+        req.req_type_case = USP__REQUEST__REQ_TYPE_DELETE;
+        req.delete_ = &del;
+        AddRequest("Delete", USP__HEADER__MSG_TYPE__DELETE, &req);
+    }
+
+    // GetInstances of all objects and sub-objects
+    {
+        Usp__GetInstances gi = USP__GET_INSTANCES__INIT;
+        path = BENCH_OBJECT ".";
+        gi.n_obj_paths = 1;
+        gi.obj_paths = &path;
+        gi.first_level_only = false;
+        req = (Usp__Request) USP__REQUEST__INIT;
+        req.req_type_case = USP__REQUEST__REQ_TYPE_GET_INSTANCES;
+        req.get_instances = &gi;
+        AddRequest("GetInstances", USP__HEADER__MSG_TYPE__GET_INSTANCES, &req);
+    }
+
+    // GetSupportedDM of the synthetic data model
+    {
+        Usp__GetSupportedDM gsdm = USP__GET_SUPPORTED_DM__INIT;
+        path = BENCH_ROOT ".";
+        gsdm.n_obj_paths = 1;
+        gsdm.obj_paths = &path;
+        gsdm.return_commands = true;
+        gsdm.return_events = true;
+        gsdm.return_params = true;
+        req = (Usp__Request) USP__REQUEST__INIT;
+        req.req_type_case = USP__REQUEST__REQ_TYPE_GET_SUPPORTED_DM;
+        req.get_supported_dm = &gsdm;
+        AddRequest("GetSupportedDM", USP__HEADER__MSG_TYPE__GET_SUPPORTED_DM, &req);
+    }
+
+    // Operate of a synchronous operation
+    {
+        Usp__Operate op = USP__OPERATE__INIT;
+        op.command = BENCH_ROOT ".Reset()";
+        op.command_key = "bench";
+        op.send_resp = true;
+        req = (Usp__Request) USP__REQUEST__INIT;
+        req.req_type_case = USP__REQUEST__REQ_TYPE_OPERATE;
+        req.operate = &op;
+        AddRequest("Operate", USP__HEADER__MSG_TYPE__OPERATE, &req);
+    }
+}
+
+/*********************************************************************//**
+**
+** AddRequest
+**
+** Packs the specified USP request into a USP message, and adds it to the corpus
+**
+** \param   name - description of the message, printed in the report
+** \param   msg_type - type of USP message
+** \param   req - pointer to USP request to encapsulate in the USP message
+**
+** \return  None
+**
+**************************************************************************/
+void AddRequest(char *name, Usp__Header__MsgType msg_type, Usp__Request *req)
+{
+    Usp__Msg msg = USP__MSG__INIT;
+    Usp__Header header = USP__HEADER__INIT;
+    Usp__Body body = USP__BODY__INIT;
+    unsigned char *buf;
+    int len;
+
+    header.msg_id = name;
+    header.msg_type = msg_type;
+    body.msg_body_case = USP__BODY__MSG_BODY_REQUEST;
+    body.request = req;
+    msg.header = &header;
+    msg.body = &body;
+
+    len = usp__msg__get_packed_size(&msg);
+    buf = USP_MALLOC(len);
+    usp__msg__pack(&msg, buf);
+
+    AddRecord(name, buf, len);
+    USP_FREE(buf);
+}
+
+/*********************************************************************//**
+**
+** AddRecord
+**
+** Encapsulates the specified USP message in a USP record addressed from the benchmark controller to the agent,
+** and adds it to the corpus
+**
+** \param   name - description of the message, printed in the report
+** \param   msg_buf - pointer to buffer containing protobuf encoded USP message
+** \param   msg_len - length of protobuf encoded USP message
+**
+** \return  None
+**
+**************************************************************************/
+void AddRecord(char *name, unsigned char *msg_buf, int msg_len)
+{
+    UspRecord__Record rec = USP_RECORD__RECORD__INIT;
+    UspRecord__NoSessionContextRecord ctx = USP_RECORD__NO_SESSION_CONTEXT_RECORD__INIT;
+    bench_msg_t *bm;
+
+    rec.version = "1.0";
+    rec.to_id = DEVICE_LOCAL_AGENT_GetEndpointID();
+    rec.from_id = BENCH_CONTROLLER;
+    rec.record_type_case = USP_RECORD__RECORD__RECORD_TYPE_NO_SESSION_CONTEXT;
+    rec.no_session_context = &ctx;
+    ctx.payload.data = msg_buf;
+    ctx.payload.len = msg_len;
+
+    corpus = USP_REALLOC(corpus, (num_corpus+1)*sizeof(bench_msg_t));
+    bm = &corpus[num_corpus];
+    num_corpus++;
+
+    memset(bm, 0, sizeof(bench_msg_t));
+    USP_STRNCPY(bm->name, name, sizeof(bm->name));
+    bm->pbuf_len = usp_record__record__get_packed_size(&rec);
+    bm->pbuf = USP_MALLOC(bm->pbuf_len);
+    usp_record__record__pack(&rec, bm->pbuf);
+}
+
+/*********************************************************************//**
+**
+** LoadCapture
+**
+** Builds the corpus from the USP records received by an agent, recorded in a capture file (see the agent's '--capture' option)
+**
+** \param   filename - name of the capture file
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int LoadCapture(char *filename)
+{
+    int err;
+
+    // Exit if unable to read the capture file
+    err = PROTO_TRACE_ReadCapture(filename, LoadCapturedRecord, NULL);
+    if (err != USP_ERR_OK)
+    {
+        USP_LOG_Error("ERROR: %s", USP_ERR_GetMessage());
+        return err;
+    }
+
+    // Exit if the capture file did not contain any USP requests
+    if (num_corpus == 0)
+    {
+        USP_LOG_Error("ERROR: Capture file %s does not contain any USP requests", filename);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    printf("Loaded %d USP requests from %s\n", num_corpus, filename);
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** LoadCapturedRecord
+**
+** Callback called by PROTO_TRACE_ReadCapture() for each USP record in the capture file
+** Requests received by the agent are re-addressed from the benchmark controller to this agent, and added to the corpus
+**
+** \param   dir - whether the USP record was received or sent by the agent
+** \param   protocol - MTP protocol that the USP record was received or sent on
+** \param   tv - time at which the USP record was captured
+** \param   pbuf - pointer to buffer containing the protobuf encoded USP record
+** \param   pbuf_len - length of the protobuf encoded USP record
+** \param   arg - unused
+**
+** \return  None
+**
+**************************************************************************/
+void LoadCapturedRecord(capture_dir_t dir, mtp_protocol_t protocol, struct timeval *tv, unsigned char *pbuf, int pbuf_len, void *arg)
+{
+    UspRecord__Record *rec;
+    Usp__Msg *usp;
+
+    // Exit if this record was sent by the agent
+    if (dir != kCaptureDir_Received)
+    {
+        return;
+    }
+
+    // Exit if the record does not contain a USP request
+    rec = usp_record__record__unpack(NULL, pbuf_len, pbuf);
+    if (rec == NULL)
+    {
+        return;
+    }
+
+    if (rec->record_type_case != USP_RECORD__RECORD__RECORD_TYPE_NO_SESSION_CONTEXT)
+    {
+        goto exit;
+    }
+
+    usp = usp__msg__unpack(NULL, rec->no_session_context->payload.len, rec->no_session_context->payload.data);
+    if (usp == NULL)
+    {
+        goto exit;
+    }
+
+    // Add the request to the corpus. It is reported together with all other requests of the same type
+    if ((usp->header != NULL) && (usp->body != NULL) && (usp->body->msg_body_case == USP__BODY__MSG_BODY_REQUEST))
+    {
+        AddRecord(MSG_HANDLER_UspMsgTypeToString(usp->header->msg_type), rec->no_session_context->payload.data, rec->no_session_context->payload.len);
+    }
+
+    usp__msg__free_unpacked(usp, NULL);
+
+exit:
+    usp_record__record__free_unpacked(rec, NULL);
+}
+
+/*********************************************************************//**
+**
+** RunBenchmark
+**
+** Replays all messages in the corpus, in order, the specified number of times
+**
+** \param   iterations - number of times to replay the corpus
+**
+** \return  None
+**
+**************************************************************************/
+void RunBenchmark(int iterations)
+{
+    int i, j;
+    bench_msg_t *bm;
+    unsigned long long start;
+    unsigned long long allocs;
+
+    for (i=0; i < num_corpus; i++)
+    {
+        corpus[i].latency = USP_MALLOC(iterations*sizeof(unsigned long long));
+    }
+
+    for (j=0; j < iterations; j++)
+    {
+        for (i=0; i < num_corpus; i++)
+        {
+            bm = &corpus[i];
+
+            num_responses = 0;
+            allocs = num_allocs;
+            start = GetTimeNs();
+            MSG_HANDLER_HandleBinaryRecord(bm->pbuf, bm->pbuf_len, ROLE_NON_SSL, NULL, NULL, INVALID);
+            bm->latency[bm->num_samples++] = GetTimeNs() - start;
+            bm->allocs += num_allocs - allocs;
+
+            if ((num_responses > 0) && (last_response_type == USP__HEADER__MSG_TYPE__ERROR))
+            {
+                bm->num_errors++;
+            }
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** PrintReport
+**
+** Prints the results of the benchmark
+**
+** \param   elapsed - total time (in nanoseconds) taken to replay the corpus
+**
+** \return  None
+**
+**************************************************************************/
+void PrintReport(unsigned long long elapsed)
+{
+    int i, j;
+    bench_msg_t *bm;
+    unsigned long long *samples;
+    int num_samples;
+    unsigned long long allocs;
+    int num_errors;
+    unsigned long long total = 0;
+    unsigned long long total_allocs = 0;
+    struct rusage usage;
+
+    samples = USP_MALLOC(num_corpus*corpus[0].num_samples*sizeof(unsigned long long));
+
+    printf("\n%-24s %10s %10s %10s %10s %8s\n", "Message", "Count", "p50 (us)", "p99 (us)", "Allocs/msg", "Errors");
+    for (i=0; i < num_corpus; i++)
+    {
+        // Skip this message, if it has already been reported as part of an earlier group with the same name
+        for (j=0; j < i; j++)
+        {
+            if (strcmp(corpus[j].name, corpus[i].name) == 0)
+            {
+                break;
+            }
+        }
+
+        if (j < i)
+        {
+            continue;
+        }
+
+        // Merge the statistics of all messages with the same name (eg all Get requests replayed from a capture file)
+        num_samples = 0;
+        allocs = 0;
+        num_errors = 0;
+        for (j=i; j < num_corpus; j++)
+        {
+            bm = &corpus[j];
+            if (strcmp(bm->name, corpus[i].name) == 0)
+            {
+                memcpy(&samples[num_samples], bm->latency, bm->num_samples*sizeof(unsigned long long));
+                num_samples += bm->num_samples;
+                allocs += bm->allocs;
+                num_errors += bm->num_errors;
+            }
+        }
+
+        qsort(samples, num_samples, sizeof(unsigned long long), CompareLatency);
+        printf("%-24s %10d %10.1f %10.1f %10.1f %8d\n", corpus[i].name, num_samples,
+               samples[(num_samples-1)*50/100]/1000.0,
+               samples[(num_samples-1)*99/100]/1000.0,
+               (double)allocs/num_samples, num_errors);
+
+        total += num_samples;
+        total_allocs += allocs;
+    }
+
+    USP_FREE(samples);
+
+    getrusage(RUSAGE_SELF, &usage);
+    printf("\nTotal: %llu messages in %.3f s (%.0f msgs/s), %.1f allocs/msg, peak RSS %ld KB\n",
+           total, elapsed/1e9, (total*1e9)/elapsed, (double)total_allocs/total, usage.ru_maxrss);
+}
+
+/*********************************************************************//**
+**
+** CompareLatency
+**
+** qsort() comparison function for latency samples
+**
+** \param   a - pointer to first latency sample
+** \param   b - pointer to second latency sample
+**
+** \return  negative, zero or positive, if a is less than, equal to, or greater than b
+**
+**************************************************************************/
+int CompareLatency(const void *a, const void *b)
+{
+    unsigned long long va = *(const unsigned long long *)a;
+    unsigned long long vb = *(const unsigned long long *)b;
+
+    return (va > vb) - (va < vb);
+}
+
+/*********************************************************************//**
+**
+** GetTimeNs
+**
+** Returns a monotonic timestamp in nanoseconds
+**
+** \param   None
+**
+** \return  current monotonic time in nanoseconds
+**
+**************************************************************************/
+unsigned long long GetTimeNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*********************************************************************//**
+**
+** PrintUsage
+**
+** Prints the command line options for the benchmark harness
+**
+** \param   prog_name - name of the executable
+**
+** \return  None
+**
+**************************************************************************/
+void PrintUsage(char *prog_name)
+{
+    printf("USAGE: %s options\n", prog_name);
+    printf("-h                Displays this help\n");
+    printf("-n <number>       Number of instances of " BENCH_OBJECT " to create (default %d)\n", bench_num_objects);
+    printf("-s <number>       Number of sub-object instances in each object (default %d)\n", bench_num_sub_objects);
+    printf("-p <number>       Number of parameters in each object (default %d)\n", bench_num_params);
+    printf("-i <number>       Number of times to replay each message (default %d)\n", DEFAULT_ITERATIONS);
+    printf("-r <file>         Replays the USP requests in a capture file (recorded using the agent's --capture option), instead of the synthetic corpus\n");
+    printf("-v <level>        Log level (0=Off, 1=Error, 2=Warning, 3=Info, 4=Debug)\n");
+}
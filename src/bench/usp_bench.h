@@ -0,0 +1,56 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file usp_bench.h
+ *
+ * Definitions shared between the benchmark harness and the synthetic data model that it registers
+ *
+ */
+#ifndef USP_BENCH_H
+#define USP_BENCH_H
+
+//------------------------------------------------------------------------------
+// Root of the synthetic data model registered by the benchmark harness
+#define BENCH_ROOT          "Device.X_BENCH"
+#define BENCH_OBJECT        BENCH_ROOT ".Object"
+#define BENCH_ADDED_NAME    "bench-added"    // Value of Name parameter of instances added (then deleted) by the benchmark
+
+//------------------------------------------------------------------------------
+// Shape of the synthetic data model. These are set from the command line, before VENDOR_Init() is called
+extern int bench_num_objects;       // Number of instances of Device.X_BENCH.Object.{i} to seed the database with
+extern int bench_num_sub_objects;   // Number of instances of Device.X_BENCH.Object.{i}.Sub.{i} to seed each object with
+extern int bench_num_params;        // Number of database parameters registered in each Device.X_BENCH.Object.{i}
+
+#endif
@@ -71,7 +71,27 @@ typedef struct
     struct curl_slist *headers;
 } bdc_connection_t;
 
-static bdc_connection_t bdc_connection[BULKDATA_MAX_PROFILES];
+static bdc_connection_t bdc_connection[BULKDATA_MAX_CONNECTIONS];
+
+//------------------------------------------------------------------------------
+// Pool of curl easy handles, reused between reports sent to the same BDC server
+// Reusing a handle allows the connection to the BDC server to be kept alive between reports
+// NOTE: There is one handle per connection slot, so a handle is always available for each report being sent
+typedef struct
+{
+    CURL *curl_ctx;     // curl easy handle, or NULL if this entry is not in use
+    char *url;          // URL of the BDC server (without the query string) that this handle last sent a report to
+    bool in_use;        // Set whilst the handle is being used to send a report
+    time_t last_used;   // Time at which the handle was last used to send a report. Used to determine which handle to replace
+} bdc_pooled_handle_t;
+
+static bdc_pooled_handle_t bdc_handle_pool[BULKDATA_MAX_CONNECTIONS];
+
+//------------------------------------------------------------------------------
+// Curl share handle, used to share DNS lookups and TLS sessions between all curl easy handles
+// This allows TLS sessions to be resumed, avoiding a full TLS handshake with the BDC server
+// NOTE: No locking callbacks are registered, because the share handle is only used by the BDC thread
+static CURLSH *curl_share_ctx = NULL;
 
 //------------------------------------------------------------------------------
 // Unix domain socket pair used to implement a message queue
@@ -96,6 +116,12 @@ typedef struct
     unsigned flags;          // bitmask of options for sending eg whether to use PUT instead of POST, whether the contents are Gzipped, whether to include
 } bdc_exec_msg_t;
 
+//------------------------------------------------------------------------------
+// Queue of reports waiting for a free connection slot, oldest first
+// Reports are only queued if more reports need to be sent simultaneously than there are connection slots
+static bdc_exec_msg_t *bdc_pending_reports = NULL;
+static int num_bdc_pending_reports = 0;
+
 //------------------------------------------------------------------------------
 // Boolean controlling whether curl logs BDC server comms to stdout+stderr
 static bool show_curl_debug = false;
@@ -113,6 +139,7 @@ void UpdateBdcSockSet(socket_set_t *set);
 void ProcessBdcMessageQueueSocketActivity(socket_set_t *set);
 int StartSendingReport(bdc_connection_t *bc);
 void FreeBdcExecMsgContents(bdc_exec_msg_t *msg);
+void FreePendingReports(void);
 size_t bulkdata_curl_null_sink(void *buffer, size_t size, size_t nmemb, void *userp);
 void PerformSendingReports(void);
 void HandleBdcTransferComplete(CURL *curl_ctx, CURLcode curl_res);
@@ -120,6 +147,12 @@ bool CalcBdcTransferResult(CURL *curl_ctx, CURLcode curl_res, int profile_id);
 bdc_connection_t *FindFreeBdcConnection(void);
 bdc_connection_t *FindBdcConnectionByCurlCtx(CURL *curl_ctx);
 void FreeBdcConnection(bdc_connection_t *bc);
+void StartSendingBdcExecMsg(bdc_connection_t *bc, bdc_exec_msg_t *msg);
+void QueuePendingReport(bdc_exec_msg_t *msg);
+void StartSendingPendingReports(void);
+CURL *GetPooledCurlHandle(char *full_url, char *query_string);
+void ReleasePooledCurlHandle(CURL *curl_ctx);
+void CalcBdcTransferStats(CURL *curl_ctx, bdc_transfer_stats_t *stats);
 
 /*********************************************************************//**
 **
@@ -146,6 +179,9 @@ int BDC_EXEC_Init(void)
         bc->profile_id = INVALID;
     }
 
+    // Initialise the pool of curl easy handles
+    memset(bdc_handle_pool, 0, sizeof(bdc_handle_pool));
+
     // Exit if unable to initialize the unix domain socket pair used to implement a message queue
     err = socketpair(AF_UNIX, SOCK_DGRAM, 0, bdc_mq_sockets);
     if (err != 0)
@@ -241,6 +277,19 @@ void *BDC_EXEC_Main(void *args)
         return NULL;
     }
 
+    // Create a curl share handle, to share DNS lookups and TLS sessions between reports
+    // NOTE: If this fails, reports are still sent, but each report performs a full DNS lookup and TLS handshake
+    curl_share_ctx = curl_share_init();
+    if (curl_share_ctx != NULL)
+    {
+        curl_share_setopt(curl_share_ctx, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(curl_share_ctx, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+    else
+    {
+        USP_LOG_Warning("%s: curl_share_init() failed", __FUNCTION__);
+    }
+
     // Main loop which multiplexes the message queue with sending reports
     while(FOREVER)
     {
@@ -256,6 +305,7 @@ void *BDC_EXEC_Main(void *args)
             case -1:
                 // An unrecoverable error has occurred
                 USP_LOG_Error("%s: Unrecoverable socket select() error. Aborting Data Model thread", __FUNCTION__);
+                FreePendingReports();
                 return NULL;
                 break;
 
@@ -274,7 +324,7 @@ void *BDC_EXEC_Main(void *args)
         }
     }
 
-    // NOTE: If this thread ever exited, it should call curl_multi_cleanup(curl_multi_ctx);
+    // NOTE: If this thread ever exited, it should call FreePendingReports(), curl_easy_cleanup() on all pooled handles, then curl_multi_cleanup(curl_multi_ctx) and curl_share_cleanup(curl_share_ctx);
 }
 
 /*********************************************************************//**
@@ -345,7 +395,6 @@ void ProcessBdcMessageQueueSocketActivity(socket_set_t *set)
     int bytes_read;
     bdc_exec_msg_t  msg;
     bdc_connection_t *bc;
-    int err;
     
     // Exit if there is no activity on the message queue socket
     if (SOCKET_SET_IsReadyToRead(mq_rx_socket, set) == 0)
@@ -361,35 +410,141 @@ void ProcessBdcMessageQueueSocketActivity(socket_set_t *set)
         return;
     }
 
-    // Exit if unable to find a connection slot
+    // Exit if all connection slots are in use, queueing the report to be sent when a connection slot becomes free
     bc = FindFreeBdcConnection();
     if (bc == NULL)
     {
-        USP_LOG_Error("%s: Unable to find a free BDC connection slot", __FUNCTION__);
-        FreeBdcExecMsgContents(&msg);
+        QueuePendingReport(&msg);
         return;
     }
 
+    StartSendingBdcExecMsg(bc, &msg);
+}
+
+/*********************************************************************//**
+**
+** StartSendingBdcExecMsg
+**
+** Starts sending the report contained in the specified BDC Exec message, using the specified connection slot
+** If the report could not be started, then the data model thread is notified that sending the report failed
+**
+** \param   bc - pointer to free BDC connection slot to use
+** \param   msg - pointer to BDC Exec message containing the report and associated parameters
+**                NOTE: Ownership of the dynamically allocated buffers in the message passes to the connection slot
+**
+** \return  None
+**
+**************************************************************************/
+void StartSendingBdcExecMsg(bdc_connection_t *bc, bdc_exec_msg_t *msg)
+{
+    int err;
+    int profile_id;
+    bdc_transfer_stats_t stats;
+
     // Fill in the connection slot
     // Ownership of dynamically allocated buffers moves from the BdcExecMsg to the Bdc connection slot
-    bc->profile_id = msg.profile_id;
+    bc->profile_id = msg->profile_id;
     bc->curl_ctx = NULL;
-    bc->full_url = msg.full_url;
-    bc->query_string = msg.query_string;
-    bc->username = msg.username;
-    bc->password = msg.password;
-    bc->report = msg.report;
-    bc->report_len = msg.report_len;
-    bc->flags = msg.flags;
+    bc->full_url = msg->full_url;
+    bc->query_string = msg->query_string;
+    bc->username = msg->username;
+    bc->password = msg->password;
+    bc->report = msg->report;
+    bc->report_len = msg->report_len;
+    bc->flags = msg->flags;
     bc->headers = NULL;
 
-    // Attempt to start sending the report
+    // Exit if the report was started successfully
     err = StartSendingReport(bc);
-    if (err != USP_ERR_OK)
+    if (err == USP_ERR_OK)
+    {
+        return;
+    }
+
+    // Otherwise free the Connection slot, and notify the data model, so that the profile may retry sending the report
+    profile_id = bc->profile_id;
+    FreeBdcConnection(bc);
+    memset(&stats, 0, sizeof(stats));
+    DM_EXEC_NotifyBdcTransferResult(profile_id, false, &stats);
+}
+
+/*********************************************************************//**
+**
+** QueuePendingReport
+**
+** Queues the report contained in the specified BDC Exec message, until a connection slot becomes free
+**
+** \param   msg - pointer to BDC Exec message containing the report and associated parameters
+**                NOTE: Ownership of the dynamically allocated buffers in the message passes to the queue
+**
+** \return  None
+**
+**************************************************************************/
+void QueuePendingReport(bdc_exec_msg_t *msg)
+{
+    bdc_pending_reports = USP_REALLOC(bdc_pending_reports, (num_bdc_pending_reports+1)*sizeof(bdc_exec_msg_t));
+    memcpy(&bdc_pending_reports[num_bdc_pending_reports], msg, sizeof(bdc_exec_msg_t));
+    num_bdc_pending_reports++;
+}
+
+/*********************************************************************//**
+**
+** FreePendingReports
+**
+** Frees all reports which are queued waiting for a connection slot. Called when the BDC thread exits
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void FreePendingReports(void)
+{
+    int i;
+
+    for (i=0; i < num_bdc_pending_reports; i++)
+    {
+        FreeBdcExecMsgContents(&bdc_pending_reports[i]);
+    }
+
+    USP_SAFE_FREE(bdc_pending_reports);
+    num_bdc_pending_reports = 0;
+}
+
+/*********************************************************************//**
+**
+** StartSendingPendingReports
+**
+** Starts sending the oldest queued reports, whilst there are free connection slots
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void StartSendingPendingReports(void)
+{
+    bdc_connection_t *bc;
+    bdc_exec_msg_t msg;
+
+    while (num_bdc_pending_reports > 0)
     {
-        // Free the Connection slot, if an error occurred
-        FreeBdcConnection(bc);
+        // Exit if there are no free connection slots
+        bc = FindFreeBdcConnection();
+        if (bc == NULL)
+        {
+            return;
+        }
+
+        // Remove the oldest report from the queue
+        memcpy(&msg, &bdc_pending_reports[0], sizeof(bdc_exec_msg_t));
+        num_bdc_pending_reports--;
+        memmove(&bdc_pending_reports[0], &bdc_pending_reports[1], num_bdc_pending_reports*sizeof(bdc_exec_msg_t));
+
+        StartSendingBdcExecMsg(bc, &msg);
     }
+
+    USP_SAFE_FREE(bdc_pending_reports);
 }
 
 /*********************************************************************//**
@@ -411,14 +566,21 @@ int StartSendingReport(bdc_connection_t *bc)
     int date_len;
     bool use_authentication;
 
-    // Exit if unable to create a curl context
-    curl_ctx = curl_easy_init();
+    // Exit if unable to get a curl context
+    curl_ctx = GetPooledCurlHandle(bc->full_url, bc->query_string);
     if (curl_ctx == NULL)
     {
         USP_LOG_Error("%s: curl_easy_init failed", __FUNCTION__); 
         return USP_ERR_INTERNAL_ERROR;
     }
 
+    // Keep the connection to the BDC server alive, and share DNS lookups and TLS sessions with other reports
+    curl_easy_setopt(curl_ctx, CURLOPT_TCP_KEEPALIVE, 1L);
+    if (curl_share_ctx != NULL)
+    {
+        curl_easy_setopt(curl_ctx, CURLOPT_SHARE, curl_share_ctx);
+    }
+
     // Set options for PUT or POST    
     curl_easy_setopt(curl_ctx, CURLOPT_POSTFIELDS, (char *)bc->report);
     curl_easy_setopt(curl_ctx, CURLOPT_POSTFIELDSIZE, bc->report_len);
@@ -463,12 +625,39 @@ int StartSendingReport(bdc_connection_t *bc)
 
     // Set the list of headers
     bc->headers = NULL;
-    bc->headers = curl_slist_append(bc->headers, "Content-Type: application/json; charset=UTF-8");
-    bc->headers = curl_slist_append(bc->headers, "BBF-Report-Format: NameValuePair");
+    if (bc->flags & BDC_FLAG_CSV)
+    {
+        bc->headers = curl_slist_append(bc->headers, "Content-Type: text/csv; charset=UTF-8");
+        if (bc->flags & BDC_FLAG_CSV_PARAMETER_PER_ROW)
+        {
+            bc->headers = curl_slist_append(bc->headers, "BBF-Report-Format: ParameterPerRow");
+        }
+        else
+        {
+            bc->headers = curl_slist_append(bc->headers, "BBF-Report-Format: ParameterPerColumn");
+        }
+    }
+    else
+    {
+        bc->headers = curl_slist_append(bc->headers, "Content-Type: application/json; charset=UTF-8");
+        bc->headers = curl_slist_append(bc->headers, "BBF-Report-Format: NameValuePair");
+    }
+    if (bc->flags & BDC_FLAG_DELTA_REPORT)
+    {
+        bc->headers = curl_slist_append(bc->headers, "X-ARRIS-COM-Report-Type: Delta");
+    }
+    else if (bc->flags & BDC_FLAG_FULL_REPORT)
+    {
+        bc->headers = curl_slist_append(bc->headers, "X-ARRIS-COM-Report-Type: Full");
+    }
     if (bc->flags & BDC_FLAG_GZIP)
     {
         bc->headers = curl_slist_append(bc->headers, "Content-Encoding: gzip");
     }
+    else if (bc->flags & BDC_FLAG_DEFLATE)
+    {
+        bc->headers = curl_slist_append(bc->headers, "Content-Encoding: deflate");
+    }
 
     // lighttpd cannot handle expect headers, but curl implicitly adds one
     // To get rid of it, explicitly clear the Expect: header's value
@@ -493,7 +682,7 @@ int StartSendingReport(bdc_connection_t *bc)
 // The following code may be uncommented to change the code to do an easy perform instead of a multi-perform
 //CURLcode e = curl_easy_perform(curl_ctx);
 //bool transfer_result = CalcBdcTransferResult(curl_ctx, e, bc->profile_id);
-//DM_EXEC_NotifyBdcTransferResult(bc->profile_id, transfer_result);
+//DM_EXEC_NotifyBdcTransferResult(bc->profile_id, transfer_result, NULL);
 //FreeBdcConnection(bc);
 //curl_easy_cleanup(curl_ctx);
 //return USP_ERR_OK;
@@ -506,7 +695,7 @@ int StartSendingReport(bdc_connection_t *bc)
     {
         USP_LOG_Error("%s: curl_multi_add_handle() failed (%s)", __FUNCTION__, curl_multi_strerror(res));
         curl_slist_free_all(bc->headers);
-        curl_easy_cleanup(curl_ctx);
+        ReleasePooledCurlHandle(curl_ctx);
         bc->headers = NULL;
         return USP_ERR_INTERNAL_ERROR;
     }
@@ -584,6 +773,7 @@ void PerformSendingReports(void)
 void HandleBdcTransferComplete(CURL *curl_ctx, CURLcode curl_res)
 {
     bool transfer_result;
+    bdc_transfer_stats_t stats;
     bdc_connection_t *bc;
     int profile_id;         // Save the profile_id, so that we can notify the data model at the end of this function
 
@@ -597,20 +787,25 @@ void HandleBdcTransferComplete(CURL *curl_ctx, CURLcode curl_res)
 
     // Determine whether the transfer was successful or not
     transfer_result = CalcBdcTransferResult(curl_ctx, curl_res, bc->profile_id);
+    CalcBdcTransferStats(curl_ctx, &stats);
+    USP_LOG_Info("BULK DATA: profile_id=%d connect=%ums tls=%ums total=%ums (connection %s)", profile_id, stats.connect_time, stats.tls_time, stats.transfer_time, (stats.connection_reused) ? "reused" : "new");
 
     // Free all memory associated with this report
     FreeBdcConnection(bc);
 
-    // Remove the curl easy handle that has completed from the multi-handle and free it
+    // Remove the curl easy handle that has completed from the multi-handle, and return it to the pool
     curl_multi_remove_handle(curl_multi_ctx, curl_ctx);
-    curl_easy_cleanup(curl_ctx);
+    ReleasePooledCurlHandle(curl_ctx);
     
     // Update the number of transfers in progress in the curl multi-handle
     num_transfers_in_progress--;
     USP_ASSERT(num_transfers_in_progress >= 0);
 
-    // Finally, notify the data model about the result of the transfer
-    DM_EXEC_NotifyBdcTransferResult(profile_id, transfer_result);
+    // Notify the data model about the result of the transfer
+    DM_EXEC_NotifyBdcTransferResult(profile_id, transfer_result, &stats);
+
+    // Finally, start sending the next queued report (if any), now that a connection slot is free
+    StartSendingPendingReports();
 }
 
 /*********************************************************************//**
@@ -660,6 +855,164 @@ bool CalcBdcTransferResult(CURL *curl_ctx, CURLcode curl_res, int profile_id)
     return true;
 }
 
+/*********************************************************************//**
+**
+**  CalcBdcTransferStats
+**
+**  Obtains the timings of a completed transfer from libcurl
+**
+** \param   curl_ctx - curl easy handle for transfer that completed
+** \param   stats - pointer to structure in which to return the timings of the transfer
+**          
+** \return  None
+**
+**************************************************************************/
+void CalcBdcTransferStats(CURL *curl_ctx, bdc_transfer_stats_t *stats)
+{
+    double connect_time = 0;       // Time (in seconds) from the start of the transfer, until the TCP connection was established
+    double appconnect_time = 0;    // Time (in seconds) from the start of the transfer, until the TLS handshake completed
+    double total_time = 0;
+    long num_connects = 0;         // Number of new connections that were needed for the transfer
+
+    curl_easy_getinfo(curl_ctx, CURLINFO_CONNECT_TIME, &connect_time);
+    curl_easy_getinfo(curl_ctx, CURLINFO_APPCONNECT_TIME, &appconnect_time);
+    curl_easy_getinfo(curl_ctx, CURLINFO_TOTAL_TIME, &total_time);
+    curl_easy_getinfo(curl_ctx, CURLINFO_NUM_CONNECTS, &num_connects);
+
+    memset(stats, 0, sizeof(bdc_transfer_stats_t));
+    stats->connection_reused = (num_connects == 0) ? true : false;
+    stats->transfer_time = (unsigned)(total_time * 1000);
+
+    // Exit if no new connection was established (the timings reported by curl for a reused connection are not connection setup times)
+    if (stats->connection_reused)
+    {
+        return;
+    }
+
+    stats->connect_time = (unsigned)(connect_time * 1000);
+    if (appconnect_time > connect_time)
+    {
+        stats->tls_time = (unsigned)((appconnect_time - connect_time) * 1000);
+    }
+}
+
+/*********************************************************************//**
+**
+**  GetPooledCurlHandle
+**
+**  Gets a curl easy handle from the pool, to use to send a report to the specified BDC server
+**  A handle which was last used to send to the same BDC server is preferred, as its connection may be reused
+**  The handle is reset, so the caller must set all options required for the transfer
+**
+** \param   full_url - URL of the BDC server to post the report to (including the query string)
+** \param   query_string - HTTP query string at the end of full_url
+**          
+** \return  pointer to curl easy handle, or NULL if unable to create one
+**
+**************************************************************************/
+CURL *GetPooledCurlHandle(char *full_url, char *query_string)
+{
+    int i;
+    int len;
+    bdc_pooled_handle_t *ph;
+    bdc_pooled_handle_t *free_ph = NULL;     // Unused entry in the pool
+    bdc_pooled_handle_t *oldest_ph = NULL;   // Entry containing the least recently used handle, which is not in use
+
+    // Determine the length of the URL, excluding the query string (which may change between reports)
+    len = strlen(full_url) - strlen(query_string);
+
+    // Iterate over all entries in the pool
+    for (i=0; i<NUM_ELEM(bdc_handle_pool); i++)
+    {
+        ph = &bdc_handle_pool[i];
+        if (ph->curl_ctx == NULL)
+        {
+            // Found an unused entry
+            if (free_ph == NULL)
+            {
+                free_ph = ph;
+            }
+            continue;
+        }
+
+        // Skip this handle if it is currently being used to send a report
+        if (ph->in_use)
+        {
+            continue;
+        }
+
+        // Exit if found a handle which was last used to send to the same BDC server
+        if ((strncmp(ph->url, full_url, len) == 0) && (ph->url[len] == '\0'))
+        {
+            curl_easy_reset(ph->curl_ctx);
+            ph->in_use = true;
+            return ph->curl_ctx;
+        }
+
+        if ((oldest_ph == NULL) || (ph->last_used < oldest_ph->last_used))
+        {
+            oldest_ph = ph;
+        }
+    }
+
+    // If there are no unused entries, then replace the least recently used handle
+    if (free_ph == NULL)
+    {
+        USP_ASSERT(oldest_ph != NULL);      // There is one entry per connection slot, so there will always be a handle not in use
+        free_ph = oldest_ph;
+        curl_easy_cleanup(free_ph->curl_ctx);
+        USP_FREE(free_ph->url);
+        memset(free_ph, 0, sizeof(bdc_pooled_handle_t));
+    }
+
+    // Exit if unable to create a curl easy handle
+    free_ph->curl_ctx = curl_easy_init();
+    if (free_ph->curl_ctx == NULL)
+    {
+        return NULL;
+    }
+
+    free_ph->url = USP_MALLOC(len+1);
+    memcpy(free_ph->url, full_url, len);
+    free_ph->url[len] = '\0';
+    free_ph->in_use = true;
+
+    return free_ph->curl_ctx;
+}
+
+/*********************************************************************//**
+**
+**  ReleasePooledCurlHandle
+**
+**  Returns a curl easy handle to the pool, once it has finished being used to send a report
+**  The handle is not freed, so that its connection to the BDC server may be reused by the next report
+**
+** \param   curl_ctx - curl easy handle to return to the pool
+**          
+** \return  None
+**
+**************************************************************************/
+void ReleasePooledCurlHandle(CURL *curl_ctx)
+{
+    int i;
+    bdc_pooled_handle_t *ph;
+
+    // Iterate over all entries in the pool, finding the one containing the handle
+    for (i=0; i<NUM_ELEM(bdc_handle_pool); i++)
+    {
+        ph = &bdc_handle_pool[i];
+        if (ph->curl_ctx == curl_ctx)
+        {
+            ph->in_use = false;
+            ph->last_used = time(NULL);
+            return;
+        }
+    }
+
+    // If the code gets here, the handle was not from the pool. This should never occur
+    curl_easy_cleanup(curl_ctx);
+}
+
 /*********************************************************************//**
 **
 **  bulkdata_curl_null_sink
@@ -763,11 +1116,8 @@ void FreeBdcConnection(bdc_connection_t *bc)
     USP_SAFE_FREE(bc->username);
     USP_SAFE_FREE(bc->password);
 
-    if (bc->report != NULL)
-    {
-        free(bc->report);
-    }
-    
+    USP_SAFE_FREE(bc->report);
+
     // Free curl headers
     if (bc->headers != NULL)
     {
@@ -796,10 +1146,6 @@ void FreeBdcExecMsgContents(bdc_exec_msg_t *msg)
     USP_SAFE_FREE(msg->query_string);
     USP_SAFE_FREE(msg->username);
     USP_SAFE_FREE(msg->password);
-
-    if (msg->report != NULL)
-    {
-        free(msg->report);
-    }
+    USP_SAFE_FREE(msg->report);
 }
 
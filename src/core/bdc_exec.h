@@ -41,6 +41,16 @@
 #ifndef BDC_EXEC_H
 #define BDC_EXEC_H
 
+//------------------------------------------------------------------------------
+// Timings of the transfer of a report, obtained from libcurl. All times are in milliseconds
+typedef struct
+{
+    unsigned connect_time;      // Time taken to establish the TCP connection. 0 if an existing connection was reused
+    unsigned tls_time;          // Time taken by the TLS handshake. 0 if the connection was not secure, or was reused
+    unsigned transfer_time;     // Total time taken by the transfer, including the above
+    bool connection_reused;     // Set if the report was sent over an existing (kept alive) connection
+} bdc_transfer_stats_t;
+
 //------------------------------------------------------------------------------
 // API functions
 int BDC_EXEC_Init(void);
@@ -52,6 +62,11 @@ void *BDC_EXEC_Main(void *args);
 #define BDC_FLAG_PUT            0x00000001  // If set, HTTP PUT should be used instead of HTTP POST when sending the report to the BDC server
 #define BDC_FLAG_GZIP           0x00000002  // If set, the reports contants are Gzipped
 #define BDC_FLAG_DATE_HEADER    0x00000004  // If set, the date header should be included in the HTTP post.
+#define BDC_FLAG_DEFLATE        0x00000008  // If set, the reports contents are compressed using Deflate (zlib format)
+#define BDC_FLAG_CSV            0x00000010  // If set, the report is CSV encoded, rather than JSON encoded
+#define BDC_FLAG_CSV_PARAMETER_PER_ROW  0x00000020  // If set (with BDC_FLAG_CSV), the CSV report is in ParameterPerRow format, rather than ParameterPerColumn format
+#define BDC_FLAG_FULL_REPORT    0x00000040  // If set, the profile uses delta reports, and this report contains all parameters
+#define BDC_FLAG_DELTA_REPORT   0x00000080  // If set, the profile uses delta reports, and this report only contains the parameters which have changed
 
 
 #endif
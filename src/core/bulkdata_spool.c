@@ -0,0 +1,1064 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/**
+ * \file bulkdata_spool.c
+ *
+ * Persistent spool of bulk data reports which have failed to be sent
+ * Each profile has its own spool file, containing the reports in the form in which they are sent (ie encoded and compressed)
+ * The spool file is append-only: reports are appended as they fail to be sent, and removed by appending a record
+ * marking them as removed. The file is truncated when it no longer contains any reports, and compacted if it contains
+ * more removed reports than live reports. Every record is protected by a CRC, so a record which was only partially
+ * written (eg because of a power failure) is detected, and discarded, when the spool is next opened.
+ *
+ */
+
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include <zlib.h>
+
+#include "common_defs.h"
+#include "usp_api.h"
+#include "bulkdata_spool.h"
+
+//------------------------------------------------------------------------------------
+// Spool file format
+// The file starts with SPOOL_FILE_MAGIC, followed by the format version (32 bit, network byte order)
+// This is followed by records, each consisting of a SPOOL_RECORD_HDR_LEN byte header, followed by the contents of the record
+// Record header (all fields in network byte order):
+//    [0..3]   sequence number of the report
+//    [4..7]   length of the record's contents (in bytes)
+//    [8..9]   BDC_FLAG_xxx flags describing the encoding and compression of the report
+//    [10]     record type (SPOOL_RECORD_REPORT or SPOOL_RECORD_REMOVED)
+//    [11]     reserved (0)
+//    [12..15] CRC32 of bytes [0..11] of the header, followed by the record's contents
+#define SPOOL_FILE_MAGIC "OBUSPBDS"
+#define SPOOL_FILE_MAGIC_LEN (sizeof(SPOOL_FILE_MAGIC)-1)
+#define SPOOL_FILE_VERSION 1
+#define SPOOL_FILE_HDR_LEN (SPOOL_FILE_MAGIC_LEN + 4)
+#define SPOOL_RECORD_HDR_LEN 16
+
+#define SPOOL_RECORD_REPORT  1      // Record contains a report
+#define SPOOL_RECORD_REMOVED 2      // Record marks the report with the same sequence number as removed. The record has no contents
+
+// The spool file is compacted once the space occupied by removed reports exceeds both this size and the space occupied by live reports
+#define SPOOL_COMPACT_THRESHOLD  (64*1024)
+
+//------------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+int CheckSpoolDir(void);
+int CheckSpoolFile(int fd, char *filename);
+void SyncSpoolDir(void);
+int LoadSpoolFile(bulkdata_spool_t *spool, int fd, off_t size);
+void AddSpoolEntry(bulkdata_spool_t *spool, unsigned seq, off_t offset, int len, unsigned flags);
+void RemoveSpoolEntry(bulkdata_spool_t *spool, unsigned seq);
+int WriteSpoolRecord(int fd, unsigned seq, int type, unsigned flags, unsigned char *buf, int len);
+void DiscardSpoolRecord(int fd, off_t file_size);
+int WriteSpoolFileHeader(int fd);
+int WriteSpoolBytes(int fd, unsigned char *buf, int len);
+int ReadSpoolBytes(int fd, off_t offset, unsigned char *buf, int len);
+uint32_t CalcSpoolRecordCrc(unsigned char *hdr, unsigned char *buf, int len);
+void CompactSpoolFile(bulkdata_spool_t *spool);
+char *CalcSpoolFilename(int profile_id);
+
+/*********************************************************************//**
+**
+** BULKDATA_SPOOL_Open
+**
+** Opens the spool of the specified profile, reading the index of the reports it contains
+** The spool file is created, if it does not already exist
+** NOTE: The spool file is only used if it is a regular file owned by the agent, in a directory owned by the agent
+**
+** \param   spool - pointer to spool state to initialise
+** \param   profile_id - Instance number of profile in Device.BulkData.Profile.{i}
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BULKDATA_SPOOL_Open(bulkdata_spool_t *spool, int profile_id)
+{
+    int fd;
+    int err;
+    off_t size;
+    char *filename;
+
+    memset(spool, 0, sizeof(bulkdata_spool_t));
+    spool->next_seq = 1;
+
+    // Exit if the spool directory could not be created, or is not owned by the agent
+    err = CheckSpoolDir();
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to open the spool file
+    // NOTE: Symbolic links are not followed, so that the agent cannot be tricked into overwriting another file
+    filename = CalcSpoolFilename(profile_id);
+    fd = open(filename, O_RDWR | O_CREAT | O_NOFOLLOW, 0600);
+    if (fd == -1)
+    {
+        USP_ERR_ERRNO("open", errno);
+        USP_FREE(filename);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if the spool file is not one that the agent created, as it must not be reinitialised
+    err = CheckSpoolFile(fd, filename);
+    if (err != USP_ERR_OK)
+    {
+        close(fd);
+        USP_FREE(filename);
+        return err;
+    }
+
+    // Read the index of reports in the spool file. NOTE: This discards the file's contents, if it is not a valid spool file
+    size = lseek(fd, 0, SEEK_END);
+    err = LoadSpoolFile(spool, fd, size);
+    close(fd);
+
+    // Exit if the spool file could not be read or reinitialised
+    if (err != USP_ERR_OK)
+    {
+        USP_SAFE_FREE(spool->entries);
+        USP_FREE(filename);
+        memset(spool, 0, sizeof(bulkdata_spool_t));
+        return err;
+    }
+
+    spool->filename = filename;
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** BULKDATA_SPOOL_Close
+**
+** Frees all memory associated with the spool. The spool file is retained, so that its reports may be sent later
+**
+** \param   spool - pointer to spool state
+**
+** \return  None
+**
+**************************************************************************/
+void BULKDATA_SPOOL_Close(bulkdata_spool_t *spool)
+{
+    USP_SAFE_FREE(spool->filename);
+    USP_SAFE_FREE(spool->entries);
+    memset(spool, 0, sizeof(bulkdata_spool_t));
+}
+
+/*********************************************************************//**
+**
+** BULKDATA_SPOOL_Delete
+**
+** Deletes the spool file of the specified profile (if it exists)
+** NOTE: The spool must not be open
+**
+** \param   profile_id - Instance number of profile in Device.BulkData.Profile.{i}
+**
+** \return  None
+**
+**************************************************************************/
+void BULKDATA_SPOOL_Delete(int profile_id)
+{
+    char *filename;
+
+    filename = CalcSpoolFilename(profile_id);
+    if ((unlink(filename) != 0) && (errno != ENOENT))
+    {
+        USP_LOG_Warning("%s: Unable to delete %s (%s)", __FUNCTION__, filename, strerror(errno));
+    }
+    USP_FREE(filename);
+}
+
+/*********************************************************************//**
+**
+** BULKDATA_SPOOL_Append
+**
+** Appends a report to the spool, flushing it to disk before returning
+**
+** \param   spool - pointer to spool state
+** \param   report - pointer to buffer containing the report (as sent ie encoded and compressed)
+** \param   report_len - length of the report (in bytes)
+** \param   flags - BDC_FLAG_xxx flags describing the encoding and compression of the report
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BULKDATA_SPOOL_Append(bulkdata_spool_t *spool, unsigned char *report, int report_len, unsigned flags)
+{
+    int fd;
+    int err;
+
+    // Exit if the spool is not open
+    if (spool->filename == NULL)
+    {
+        USP_ERR_SetMessage("%s: Spool is not open", __FUNCTION__);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if the report would never fit in the spool
+    if (SPOOL_FILE_HDR_LEN + SPOOL_RECORD_HDR_LEN + report_len > BULKDATA_MAX_SPOOL_SIZE)
+    {
+        USP_ERR_SetMessage("%s: Report (%d bytes) is larger than the maximum spool size", __FUNCTION__, report_len);
+        return USP_ERR_RESOURCES_EXCEEDED;
+    }
+
+    // Make space for the report, by removing the oldest reports from the spool
+    while ((spool->num_entries > 0) && (SPOOL_FILE_HDR_LEN + spool->live_size + SPOOL_RECORD_HDR_LEN + report_len > BULKDATA_MAX_SPOOL_SIZE))
+    {
+        USP_LOG_Warning("BULK DATA: Spool full. Dropping oldest retained report from %s", spool->filename);
+        err = BULKDATA_SPOOL_Remove(spool, spool->entries[0].seq);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+    }
+
+    // Exit if unable to open the spool file
+    fd = open(spool->filename, O_WRONLY | O_NOFOLLOW);
+    if (fd == -1)
+    {
+        USP_ERR_ERRNO("open", errno);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if unable to write the report, removing any partially written record from the file
+    lseek(fd, spool->file_size, SEEK_SET);
+    err = WriteSpoolRecord(fd, spool->next_seq, SPOOL_RECORD_REPORT, flags, report, report_len);
+    if (err != USP_ERR_OK)
+    {
+        DiscardSpoolRecord(fd, spool->file_size);
+        close(fd);
+        return err;
+    }
+    close(fd);
+
+    AddSpoolEntry(spool, spool->next_seq, spool->file_size + SPOOL_RECORD_HDR_LEN, report_len, flags);
+    spool->file_size += SPOOL_RECORD_HDR_LEN + report_len;
+    spool->next_seq++;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** BULKDATA_SPOOL_ReadOldest
+**
+** Reads the oldest report in the spool
+**
+** \param   spool - pointer to spool state
+** \param   report_len - pointer to variable in which to return the length of the report
+** \param   flags - pointer to variable in which to return the BDC_FLAG_xxx flags describing the encoding and compression of the report
+** \param   seq - pointer to variable in which to return the sequence number of the report (used to remove it from the spool)
+**
+** \return  pointer to dynamically allocated buffer containing the report, or NULL if the spool is empty or an error occurred
+**
+**************************************************************************/
+unsigned char *BULKDATA_SPOOL_ReadOldest(bulkdata_spool_t *spool, int *report_len, unsigned *flags, unsigned *seq)
+{
+    int fd;
+    int err;
+    bulkdata_spool_entry_t *se;
+    unsigned char *report;
+
+    // Exit if there are no reports in the spool
+    if ((spool->filename == NULL) || (spool->num_entries == 0))
+    {
+        return NULL;
+    }
+
+    // Exit if unable to open the spool file
+    fd = open(spool->filename, O_RDONLY | O_NOFOLLOW);
+    if (fd == -1)
+    {
+        USP_ERR_ERRNO("open", errno);
+        return NULL;
+    }
+
+    // Exit if unable to read the report
+    se = &spool->entries[0];
+    report = USP_MALLOC(se->len + 1);    // Plus 1 to allow for a zero length report
+    err = ReadSpoolBytes(fd, se->offset, report, se->len);
+    close(fd);
+    if (err != USP_ERR_OK)
+    {
+        USP_FREE(report);
+        return NULL;
+    }
+
+    *report_len = se->len;
+    *flags = se->flags;
+    *seq = se->seq;
+    return report;
+}
+
+/*********************************************************************//**
+**
+** BULKDATA_SPOOL_Remove
+**
+** Removes the specified report from the spool, flushing the removal to disk before returning
+** NOTE: The report may have already been dropped from the spool (to keep within its limits), in which case nothing is done
+**
+** \param   spool - pointer to spool state
+** \param   seq - sequence number of the report to remove
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int BULKDATA_SPOOL_Remove(bulkdata_spool_t *spool, unsigned seq)
+{
+    int i;
+    int fd;
+    int err;
+    off_t removed_size;
+
+    // Exit if the report is not in the spool
+    if (spool->filename == NULL)
+    {
+        return USP_ERR_OK;
+    }
+
+    for (i=0; i < spool->num_entries; i++)
+    {
+        if (spool->entries[i].seq == seq)
+        {
+            break;
+        }
+    }
+
+    if (i == spool->num_entries)
+    {
+        return USP_ERR_OK;
+    }
+
+    // Exit if unable to open the spool file
+    fd = open(spool->filename, O_WRONLY | O_NOFOLLOW);
+    if (fd == -1)
+    {
+        USP_ERR_ERRNO("open", errno);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // If this is the only report in the spool, then just truncate the spool file
+    if (spool->num_entries == 1)
+    {
+        if ((ftruncate(fd, SPOOL_FILE_HDR_LEN) != 0) || (fdatasync(fd) != 0))
+        {
+            USP_ERR_ERRNO("ftruncate", errno);
+            close(fd);
+            return USP_ERR_INTERNAL_ERROR;
+        }
+        close(fd);
+
+        spool->num_entries = 0;
+        spool->file_size = SPOOL_FILE_HDR_LEN;
+        spool->live_size = 0;
+        return USP_ERR_OK;
+    }
+
+    // Exit if unable to append a record marking the report as removed
+    lseek(fd, spool->file_size, SEEK_SET);
+    err = WriteSpoolRecord(fd, seq, SPOOL_RECORD_REMOVED, 0, NULL, 0);
+    if (err != USP_ERR_OK)
+    {
+        DiscardSpoolRecord(fd, spool->file_size);
+        close(fd);
+        return err;
+    }
+    close(fd);
+    spool->file_size += SPOOL_RECORD_HDR_LEN;
+
+    RemoveSpoolEntry(spool, seq);
+
+    // Compact the spool file, if most of it is occupied by removed reports
+    removed_size = spool->file_size - SPOOL_FILE_HDR_LEN - spool->live_size;
+    if ((removed_size > SPOOL_COMPACT_THRESHOLD) && (removed_size > spool->live_size))
+    {
+        CompactSpoolFile(spool);
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** BULKDATA_SPOOL_Trim
+**
+** Removes the oldest reports from the spool, until it contains no more than the specified number of reports
+**
+** \param   spool - pointer to spool state
+** \param   max_reports - maximum number of reports to retain in the spool
+**
+** \return  None
+**
+**************************************************************************/
+void BULKDATA_SPOOL_Trim(bulkdata_spool_t *spool, int max_reports)
+{
+    int err;
+
+    while (spool->num_entries > max_reports)
+    {
+        err = BULKDATA_SPOOL_Remove(spool, spool->entries[0].seq);
+        if (err != USP_ERR_OK)
+        {
+            break;
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** LoadSpoolFile
+**
+** Reads the index of all reports contained in the spool file
+** Any record which fails its CRC check, or which was only partially written, is discarded along with all records following it
+** If the file is not a spool file (or is empty), then it is reinitialised as an empty spool file
+**
+** \param   spool - pointer to spool state to fill in
+** \param   fd - file descriptor of spool file
+** \param   size - size of spool file (in bytes)
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int LoadSpoolFile(bulkdata_spool_t *spool, int fd, off_t size)
+{
+    int err;
+    unsigned char file_hdr[SPOOL_FILE_HDR_LEN];
+    unsigned char hdr[SPOOL_RECORD_HDR_LEN];
+    unsigned char *buf = NULL;
+    int buf_len = 0;
+    uint32_t val;
+    off_t offset;
+    unsigned seq;
+    int len;
+    unsigned flags;
+    int type;
+
+    // Reinitialise the file as an empty spool file, if it does not start with a valid file header
+    err = ReadSpoolBytes(fd, 0, file_hdr, sizeof(file_hdr));
+    memcpy(&val, &file_hdr[SPOOL_FILE_MAGIC_LEN], sizeof(val));
+    if ((err != USP_ERR_OK) || (memcmp(file_hdr, SPOOL_FILE_MAGIC, SPOOL_FILE_MAGIC_LEN) != 0) || (ntohl(val) != SPOOL_FILE_VERSION))
+    {
+        if (size != 0)
+        {
+            USP_LOG_Warning("%s: Discarding contents of unrecognised bulk data spool file", __FUNCTION__);
+        }
+
+        if (ftruncate(fd, 0) != 0)
+        {
+            USP_ERR_ERRNO("ftruncate", errno);
+            return USP_ERR_INTERNAL_ERROR;
+        }
+
+        lseek(fd, 0, SEEK_SET);
+        err = WriteSpoolFileHeader(fd);
+        spool->file_size = SPOOL_FILE_HDR_LEN;
+        return err;
+    }
+
+    // Iterate over all records in the file
+    offset = SPOOL_FILE_HDR_LEN;
+    while (offset < size)
+    {
+        // Exit loop if the record header is incomplete
+        if ((offset + SPOOL_RECORD_HDR_LEN > size) || (ReadSpoolBytes(fd, offset, hdr, sizeof(hdr)) != USP_ERR_OK))
+        {
+            break;
+        }
+
+        // Parse the record header
+        memcpy(&val, &hdr[0], sizeof(val));
+        seq = ntohl(val);
+        memcpy(&val, &hdr[4], sizeof(val));
+        len = (int) ntohl(val);
+        flags = (hdr[8] << 8) | hdr[9];
+        type = hdr[10];
+
+        // Exit loop if the record's contents are incomplete (or the length is corrupt)
+        if ((len < 0) || (len > BULKDATA_MAX_SPOOL_SIZE) || (offset + SPOOL_RECORD_HDR_LEN + len > size))
+        {
+            break;
+        }
+
+        // Exit loop if unable to read the record's contents
+        if (len >= buf_len)
+        {
+            buf_len = len + 1;
+            buf = USP_REALLOC(buf, buf_len);
+        }
+
+        if (ReadSpoolBytes(fd, offset + SPOOL_RECORD_HDR_LEN, buf, len) != USP_ERR_OK)
+        {
+            break;
+        }
+
+        // Exit loop if the record is corrupt
+        memcpy(&val, &hdr[12], sizeof(val));
+        if (ntohl(val) != CalcSpoolRecordCrc(hdr, buf, len))
+        {
+            break;
+        }
+
+        // Apply the record to the index
+        if (type == SPOOL_RECORD_REPORT)
+        {
+            AddSpoolEntry(spool, seq, offset + SPOOL_RECORD_HDR_LEN, len, flags);
+        }
+        else if (type == SPOOL_RECORD_REMOVED)
+        {
+            RemoveSpoolEntry(spool, seq);
+        }
+
+        if (seq >= spool->next_seq)
+        {
+            spool->next_seq = seq + 1;
+        }
+
+        offset += SPOOL_RECORD_HDR_LEN + len;
+    }
+    USP_SAFE_FREE(buf);
+
+    // Discard any partially written or corrupt records at the end of the file
+    if (offset < size)
+    {
+        USP_LOG_Warning("%s: Discarding %ld bytes of incomplete or corrupt records from bulk data spool file", __FUNCTION__, (long)(size - offset));
+        if (ftruncate(fd, offset) != 0)
+        {
+            USP_ERR_ERRNO("ftruncate", errno);
+            return USP_ERR_INTERNAL_ERROR;
+        }
+    }
+
+    spool->file_size = offset;
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** AddSpoolEntry
+**
+** Adds a report to the end of the spool's index
+**
+** \param   spool - pointer to spool state
+** \param   seq - sequence number of the report
+** \param   offset - offset in the spool file of the report's contents
+** \param   len - length of the report's contents
+** \param   flags - BDC_FLAG_xxx flags describing the encoding and compression of the report
+**
+** \return  None
+**
+**************************************************************************/
+void AddSpoolEntry(bulkdata_spool_t *spool, unsigned seq, off_t offset, int len, unsigned flags)
+{
+    bulkdata_spool_entry_t *se;
+
+    spool->entries = USP_REALLOC(spool->entries, (spool->num_entries+1)*sizeof(bulkdata_spool_entry_t));
+    se = &spool->entries[spool->num_entries];
+    se->seq = seq;
+    se->offset = offset;
+    se->len = len;
+    se->flags = flags;
+    spool->num_entries++;
+
+    spool->live_size += SPOOL_RECORD_HDR_LEN + len;
+}
+
+/*********************************************************************//**
+**
+** RemoveSpoolEntry
+**
+** Removes the specified report from the spool's index
+**
+** \param   spool - pointer to spool state
+** \param   seq - sequence number of the report to remove
+**
+** \return  None
+**
+**************************************************************************/
+void RemoveSpoolEntry(bulkdata_spool_t *spool, unsigned seq)
+{
+    int i;
+    bulkdata_spool_entry_t *se;
+
+    for (i=0; i < spool->num_entries; i++)
+    {
+        se = &spool->entries[i];
+        if (se->seq == seq)
+        {
+            spool->live_size -= SPOOL_RECORD_HDR_LEN + se->len;
+            memmove(se, &se[1], (spool->num_entries - i - 1)*sizeof(bulkdata_spool_entry_t));
+            spool->num_entries--;
+            return;
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** WriteSpoolRecord
+**
+** Writes a record at the current position of the spool file, flushing it to disk before returning
+**
+** \param   fd - file descriptor of spool file
+** \param   seq - sequence number of the report
+** \param   type - type of record (SPOOL_RECORD_REPORT or SPOOL_RECORD_REMOVED)
+** \param   flags - BDC_FLAG_xxx flags describing the encoding and compression of the report
+** \param   buf - pointer to buffer containing the record's contents (or NULL if the record has no contents)
+** \param   len - length of the record's contents
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int WriteSpoolRecord(int fd, unsigned seq, int type, unsigned flags, unsigned char *buf, int len)
+{
+    int err;
+    unsigned char hdr[SPOOL_RECORD_HDR_LEN];
+    uint32_t val;
+
+    // Form the record header
+    val = htonl(seq);
+    memcpy(&hdr[0], &val, sizeof(val));
+    val = htonl((uint32_t)len);
+    memcpy(&hdr[4], &val, sizeof(val));
+    hdr[8] = (unsigned char)(flags >> 8);
+    hdr[9] = (unsigned char)flags;
+    hdr[10] = (unsigned char)type;
+    hdr[11] = 0;
+    val = htonl(CalcSpoolRecordCrc(hdr, buf, len));
+    memcpy(&hdr[12], &val, sizeof(val));
+
+    // Exit if unable to write the record
+    err = WriteSpoolBytes(fd, hdr, sizeof(hdr));
+    if ((err == USP_ERR_OK) && (len > 0))
+    {
+        err = WriteSpoolBytes(fd, buf, len);
+    }
+
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to flush the record to disk
+    if (fdatasync(fd) != 0)
+    {
+        USP_ERR_ERRNO("fdatasync", errno);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** DiscardSpoolRecord
+**
+** Removes a partially written record from the end of the spool file
+** If this fails, the record is discarded when the spool is next opened, as it will fail its CRC check
+**
+** \param   fd - file descriptor of spool file
+** \param   file_size - size of the spool file, before the record was written
+**
+** \return  None
+**
+**************************************************************************/
+void DiscardSpoolRecord(int fd, off_t file_size)
+{
+    if (ftruncate(fd, file_size) != 0)
+    {
+        USP_LOG_Warning("%s: ftruncate() failed (%s)", __FUNCTION__, strerror(errno));
+    }
+}
+
+/*********************************************************************//**
+**
+** WriteSpoolFileHeader
+**
+** Writes the spool file header at the current position of the spool file, flushing it to disk before returning
+**
+** \param   fd - file descriptor of spool file
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int WriteSpoolFileHeader(int fd)
+{
+    int err;
+    unsigned char file_hdr[SPOOL_FILE_HDR_LEN];
+    uint32_t val;
+
+    memcpy(file_hdr, SPOOL_FILE_MAGIC, SPOOL_FILE_MAGIC_LEN);
+    val = htonl(SPOOL_FILE_VERSION);
+    memcpy(&file_hdr[SPOOL_FILE_MAGIC_LEN], &val, sizeof(val));
+
+    // Exit if unable to write the header
+    err = WriteSpoolBytes(fd, file_hdr, sizeof(file_hdr));
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to flush the header to disk
+    if (fdatasync(fd) != 0)
+    {
+        USP_ERR_ERRNO("fdatasync", errno);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** WriteSpoolBytes
+**
+** Writes the specified bytes at the current position of the spool file
+**
+** \param   fd - file descriptor of spool file
+** \param   buf - pointer to buffer containing bytes to write
+** \param   len - number of bytes to write
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int WriteSpoolBytes(int fd, unsigned char *buf, int len)
+{
+    ssize_t written;
+
+    while (len > 0)
+    {
+        written = write(fd, buf, len);
+        if (written < 0)
+        {
+            // Retry if interrupted by a signal
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            USP_ERR_ERRNO("write", errno);
+            return USP_ERR_INTERNAL_ERROR;
+        }
+
+        buf += written;
+        len -= written;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** ReadSpoolBytes
+**
+** Reads the specified bytes from the spool file
+**
+** \param   fd - file descriptor of spool file
+** \param   offset - offset in the spool file to read from
+** \param   buf - pointer to buffer in which to return the bytes read
+** \param   len - number of bytes to read
+**
+** \return  USP_ERR_OK if all bytes were read
+**
+**************************************************************************/
+int ReadSpoolBytes(int fd, off_t offset, unsigned char *buf, int len)
+{
+    ssize_t bytes_read;
+
+    while (len > 0)
+    {
+        bytes_read = pread(fd, buf, len, offset);
+        if (bytes_read < 0)
+        {
+            // Retry if interrupted by a signal
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            USP_ERR_ERRNO("pread", errno);
+            return USP_ERR_INTERNAL_ERROR;
+        }
+
+        // Exit if the end of the file was reached
+        if (bytes_read == 0)
+        {
+            return USP_ERR_INTERNAL_ERROR;
+        }
+
+        buf += bytes_read;
+        offset += bytes_read;
+        len -= bytes_read;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** CalcSpoolRecordCrc
+**
+** Calculates the CRC protecting a spool record
+**
+** \param   hdr - pointer to record header. Only the first 12 bytes (ie excluding the CRC) are used
+** \param   buf - pointer to buffer containing the record's contents (or NULL if the record has no contents)
+** \param   len - length of the record's contents
+**
+** \return  CRC32 of the record
+**
+**************************************************************************/
+uint32_t CalcSpoolRecordCrc(unsigned char *hdr, unsigned char *buf, int len)
+{
+    uLong crc;
+
+    crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, hdr, 12);
+    if (len > 0)
+    {
+        crc = crc32(crc, buf, len);
+    }
+
+    return (uint32_t) crc;
+}
+
+/*********************************************************************//**
+**
+** CompactSpoolFile
+**
+** Rewrites the spool file, containing only the reports which have not been removed
+** The new file is written alongside the old one, then atomically renamed over it
+** If an error occurs, the old file is retained (so no reports are lost)
+**
+** \param   spool - pointer to spool state
+**
+** \return  None
+**
+**************************************************************************/
+void CompactSpoolFile(bulkdata_spool_t *spool)
+{
+    int i;
+    int err;
+    int old_fd;
+    int new_fd;
+    char tmp_filename[MAX_DM_PATH];
+    bulkdata_spool_entry_t *entries;
+    bulkdata_spool_entry_t *se;
+    unsigned char *buf;
+    off_t offset;
+
+    // Exit if unable to open the existing spool file
+    old_fd = open(spool->filename, O_RDONLY | O_NOFOLLOW);
+    if (old_fd == -1)
+    {
+        return;
+    }
+
+    // Exit if unable to create the new spool file
+    // NOTE: Any file left over from a previous compaction is removed first, as the new file must be newly created by the agent
+    USP_SNPRINTF(tmp_filename, sizeof(tmp_filename), "%s.tmp", spool->filename);
+    unlink(tmp_filename);
+    new_fd = open(tmp_filename, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+    if (new_fd == -1)
+    {
+        close(old_fd);
+        return;
+    }
+
+    // Copy all reports to the new spool file, calculating their new offsets
+    entries = USP_MALLOC(spool->num_entries*sizeof(bulkdata_spool_entry_t));
+    memcpy(entries, spool->entries, spool->num_entries*sizeof(bulkdata_spool_entry_t));
+    err = WriteSpoolFileHeader(new_fd);
+    offset = SPOOL_FILE_HDR_LEN;
+    for (i=0; (i < spool->num_entries) && (err == USP_ERR_OK); i++)
+    {
+        se = &entries[i];
+        buf = USP_MALLOC(se->len + 1);    // Plus 1 to allow for a zero length report
+        err = ReadSpoolBytes(old_fd, se->offset, buf, se->len);
+        if (err == USP_ERR_OK)
+        {
+            err = WriteSpoolRecord(new_fd, se->seq, SPOOL_RECORD_REPORT, se->flags, buf, se->len);
+        }
+        USP_FREE(buf);
+
+        se->offset = offset + SPOOL_RECORD_HDR_LEN;
+        offset += SPOOL_RECORD_HDR_LEN + se->len;
+    }
+    close(old_fd);
+    close(new_fd);
+
+    // Exit if an error occurred, or unable to replace the old spool file with the new one
+    if ((err != USP_ERR_OK) || (rename(tmp_filename, spool->filename) != 0))
+    {
+        USP_LOG_Warning("%s: Unable to compact bulk data spool file %s", __FUNCTION__, spool->filename);
+        unlink(tmp_filename);
+        USP_FREE(entries);
+        return;
+    }
+
+    // Ensure that the rename survives a power failure
+    SyncSpoolDir();
+
+    USP_FREE(spool->entries);
+    spool->entries = entries;
+    spool->file_size = offset;
+}
+
+/*********************************************************************//**
+**
+** CheckSpoolDir
+**
+** Creates the directory containing the spool files (if it does not already exist),
+** and checks that it is a directory owned by the agent, which other users cannot write to
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int CheckSpoolDir(void)
+{
+    struct stat st;
+
+    // Exit if unable to create the directory
+    if ((mkdir(BULKDATA_SPOOL_DIR, 0700) != 0) && (errno != EEXIST))
+    {
+        USP_ERR_ERRNO("mkdir", errno);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if unable to determine the status of the directory
+    if (lstat(BULKDATA_SPOOL_DIR, &st) != 0)
+    {
+        USP_ERR_ERRNO("lstat", errno);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if the directory might have been created by another user
+    if ((S_ISDIR(st.st_mode) == false) || (st.st_uid != geteuid()) || ((st.st_mode & (S_IWGRP | S_IWOTH)) != 0))
+    {
+        USP_ERR_SetMessage("%s: Bulk data spool directory %s is not a directory owned by (and only writable by) the agent", __FUNCTION__, BULKDATA_SPOOL_DIR);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** CheckSpoolFile
+**
+** Checks that the opened spool file is a regular file owned by the agent, which is not linked to from elsewhere
+**
+** \param   fd - file descriptor of the opened spool file
+** \param   filename - name of the spool file
+**
+** \return  USP_ERR_OK if the spool file may be used
+**
+**************************************************************************/
+int CheckSpoolFile(int fd, char *filename)
+{
+    struct stat st;
+
+    // Exit if unable to determine the status of the file
+    if (fstat(fd, &st) != 0)
+    {
+        USP_ERR_ERRNO("fstat", errno);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if the file might belong to another user
+    if ((S_ISREG(st.st_mode) == false) || (st.st_uid != geteuid()) || (st.st_nlink != 1))
+    {
+        USP_ERR_SetMessage("%s: Bulk data spool file %s is not a regular file owned by the agent", __FUNCTION__, filename);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** SyncSpoolDir
+**
+** Flushes the directory containing the spool files to disk, so that any files renamed within it are persisted
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void SyncSpoolDir(void)
+{
+    int fd;
+
+    fd = open(BULKDATA_SPOOL_DIR, O_RDONLY | O_DIRECTORY);
+    if (fd == -1)
+    {
+        USP_LOG_Warning("%s: Unable to open %s (%s)", __FUNCTION__, BULKDATA_SPOOL_DIR, strerror(errno));
+        return;
+    }
+
+    if (fsync(fd) != 0)
+    {
+        USP_LOG_Warning("%s: fsync() failed (%s)", __FUNCTION__, strerror(errno));
+    }
+
+    close(fd);
+}
+
+/*********************************************************************//**
+**
+** CalcSpoolFilename
+**
+** Returns the name of the spool file for the specified profile
+**
+** \param   profile_id - Instance number of profile in Device.BulkData.Profile.{i}
+**
+** \return  pointer to dynamically allocated string containing the name of the spool file
+**
+**************************************************************************/
+char *CalcSpoolFilename(int profile_id)
+{
+    char buf[MAX_DM_PATH];
+
+    USP_SNPRINTF(buf, sizeof(buf), "%s/bulkdata_%d.spool", BULKDATA_SPOOL_DIR, profile_id);
+    return USP_STRDUP(buf);
+}
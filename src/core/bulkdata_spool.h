@@ -0,0 +1,77 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/**
+ * \file bulkdata_spool.h
+ *
+ * Persistent spool of bulk data reports which have failed to be sent
+ *
+ */
+#ifndef BULKDATA_SPOOL_H
+#define BULKDATA_SPOOL_H
+
+#include <sys/types.h>
+
+//-----------------------------------------------------------------------------------------
+// Index entry for a report contained in the spool file. The report itself is only held on disk
+typedef struct
+{
+    unsigned seq;           // Sequence number of the report
+    off_t offset;           // Offset in the spool file of the report's contents
+    int len;                // Length (in bytes) of the report's contents
+    unsigned flags;         // BDC_FLAG_xxx flags describing the encoding and compression of the report
+} bulkdata_spool_entry_t;
+
+//-----------------------------------------------------------------------------------------
+// State of a profile's spool
+typedef struct
+{
+    char *filename;                     // Name of the spool file, or NULL if the spool is not open
+    bulkdata_spool_entry_t *entries;    // Array of reports in the spool, oldest first
+    int num_entries;
+    unsigned next_seq;                  // Sequence number to give to the next report appended to the spool
+    off_t file_size;                    // Size of the spool file (in bytes)
+    off_t live_size;                    // Number of bytes in the spool file occupied by the reports in the spool (including their record headers)
+} bulkdata_spool_t;
+
+//-----------------------------------------------------------------------------------------
+// API functions
+int BULKDATA_SPOOL_Open(bulkdata_spool_t *spool, int profile_id);
+void BULKDATA_SPOOL_Close(bulkdata_spool_t *spool);
+void BULKDATA_SPOOL_Delete(int profile_id);
+int BULKDATA_SPOOL_Append(bulkdata_spool_t *spool, unsigned char *report, int report_len, unsigned flags);
+unsigned char *BULKDATA_SPOOL_ReadOldest(bulkdata_spool_t *spool, int *report_len, unsigned *flags, unsigned *seq);
+int BULKDATA_SPOOL_Remove(bulkdata_spool_t *spool, unsigned seq);
+void BULKDATA_SPOOL_Trim(bulkdata_spool_t *spool, int max_reports);
+
+#endif
@@ -64,6 +64,8 @@
 #include "text_utils.h"
 #include "version.h"
 #include "stomp.h"
+#include "msg_stats.h"
+#include "proto_trace.h"
 
 //------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
@@ -87,6 +89,7 @@ int ExecuteCli_DbSet(char *param, char *value, char *usage);
 int ExecuteCli_DbDel(char *param, char *arg2, char *usage);
 int ExecuteCli_Verbose(char *level, char *arg2, char *usage);
 int ExecuteCli_ProtoTrace(char *level, char *arg2, char *usage);
+int ExecuteCli_Decode(char *filename, char *arg2, char *usage);
 int ExecuteCli_Stop(char *arg1, char *arg2, char *usage);
 char *SplitOffTrailingNumber(char *s);
 int SplitSetExpression(char *expr, char *search_path, int search_path_len, char *param_name, int param_name_len);
@@ -135,13 +138,14 @@ cli_cmd_t cli_commands[] =
     { "operate", 1, RUN_REMOTELY, ExecuteCli_Operate,"operate [operation]"},
     { "instances", 1, RUN_REMOTELY, ExecuteCli_GetInstances,   "instances [path-expr]" },
     { "show",    1, RUN_LOCALLY,  ExecuteCli_Show,  "show ['datamodel' | 'database' ]"},
-    { "dump",    1, RUN_REMOTELY, ExecuteCli_Dump,  "dump ['memory' | 'mdelta' | 'subscriptions' | 'instances' ]"},
+    { "dump",    1, RUN_REMOTELY, ExecuteCli_Dump,  "dump ['memory' | 'mdelta' | 'allocators' | 'subscriptions' | 'instances' | 'msgstats' | 'valuecache' ]"},
     { "perm",    1, RUN_REMOTELY, ExecuteCli_Perm,  "perm [parameter or object]"},
     { "dbget",   1, RUN_LOCALLY,  ExecuteCli_DbGet, "dbget [parameter]"},
     { "dbset",   2, RUN_LOCALLY,  ExecuteCli_DbSet, "dbset [parameter] [value]"},
     { "dbdel",   1, RUN_LOCALLY,  ExecuteCli_DbDel, "dbdel [parameter]"},
     { "verbose", 1, RUN_REMOTELY, ExecuteCli_Verbose, "verbose [level]"},
     { "prototrace", 1, RUN_REMOTELY, ExecuteCli_ProtoTrace, "prototrace [enable]"},
+    { "decode",  1, RUN_LOCALLY,  ExecuteCli_Decode, "decode [capture file]"},
     { "stop",    0, RUN_REMOTELY, ExecuteCli_Stop, "stop"},
 };
 
@@ -1205,6 +1209,14 @@ int ExecuteCli_Dump(char *arg1, char *arg2, char *usage)
         return USP_ERR_OK;
     }
 
+    // Show the call sites with the most memory currently allocated (requires '--memtrack')
+    if (strcmp(arg1, "allocators")==0)
+    {
+        #define MAX_DUMPED_ALLOCATORS 20
+        USP_MEM_DumpTopAllocators(MAX_DUMPED_ALLOCATORS);
+        return USP_ERR_OK;
+    }
+
     // Show the contents of the internal subscription array
     if (strcmp(arg1, "subscriptions")==0)
     {
@@ -1219,6 +1231,20 @@ int ExecuteCli_Dump(char *arg1, char *arg2, char *usage)
         return USP_ERR_OK;
     }
 
+    // Show the latency histograms of USP messages (requires Device.LocalAgent.X_ARRIS-COM_MessageStats.Enable)
+    if (strcmp(arg1, "msgstats")==0)
+    {
+        MSG_STATS_Dump();
+        return USP_ERR_OK;
+    }
+
+    // Show the hit statistics of vendor parameters registered with a time to live
+    if (strcmp(arg1, "valuecache")==0)
+    {
+        DATA_MODEL_DumpValueCaches();
+        return USP_ERR_OK;
+    }
+
     // If the code gets here, there is an unknown value for arg1
     SendCliResponse_InvalidValue(arg1, usage);
     return USP_ERR_INVALID_ARGUMENTS;
@@ -1481,6 +1507,25 @@ int ExecuteCli_ProtoTrace(char *arg1, char *arg2, char *usage)
     return err;
 }
 
+/*********************************************************************//**
+**
+** ExecuteCli_Decode
+**
+** Executes the decode CLI command
+** This prints all USP records contained in a capture file (created using the '--capture' command line option)
+**
+** \param   filename - name of the capture file to decode
+** \param   arg2 - unused
+** \param   usage - pointer to string containing usage info for this command
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int ExecuteCli_Decode(char *filename, char *arg2, char *usage)
+{
+    return PROTO_TRACE_DecodeCapture(filename);
+}
+
 /*********************************************************************//**
 **
 ** ExecuteCli_stop
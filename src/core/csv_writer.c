@@ -0,0 +1,374 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/**
+ * \file csv_writer.c
+ *
+ * Streaming CSV writer. Fields are serialized directly into a growable buffer, as each field is added.
+ * Separators and escape character are configurable (as required by TR-157 CSV encoding), and
+ * escaping follows RFC 4180 ie fields containing separators or the escape character are enclosed in the
+ * escape character, with any escape characters within the field doubled
+ * The writer may also stream the CSV in chunks to a sink callback (eg to compress it), so that the whole of the CSV is never held in memory
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "csv_writer.h"
+
+//------------------------------------------------------------------------------
+// Initial size of the buffer allocated by the writer. The buffer doubles in size when more space is needed
+#define INITIAL_CSV_WRITER_SIZE  256
+
+//------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+bool CsvFieldNeedsEscaping(csv_writer_t *cw, char *value);
+void CsvWriteEscapedField(csv_writer_t *cw, char *value);
+void CsvWriteChars(csv_writer_t *cw, char *str, int len);
+void CsvEnsureSpace(csv_writer_t *cw, int needed);
+void CsvFlushToSink(csv_writer_t *cw);
+
+/*********************************************************************//**
+**
+** CSV_WRITER_Init
+**
+** Initialises a CSV writer
+**
+** \param   cw - pointer to CSV writer to initialise
+** \param   field_separator - string to write between fields in a row
+** \param   row_separator - string to write at the end of each row
+** \param   escape_char - string to enclose fields needing escaping in, or an empty string if fields should never be escaped
+**
+** \return  None
+**
+**************************************************************************/
+void CSV_WRITER_Init(csv_writer_t *cw, char *field_separator, char *row_separator, char *escape_char)
+{
+    memset(cw, 0, sizeof(csv_writer_t));
+    cw->field_separator = field_separator;
+    cw->row_separator = row_separator;
+    cw->escape_char = escape_char;
+    cw->max_len = INITIAL_CSV_WRITER_SIZE;
+    cw->buf = USP_MALLOC(cw->max_len);
+    cw->buf[0] = '\0';
+}
+
+/*********************************************************************//**
+**
+** CSV_WRITER_InitStream
+**
+** Initialises a streaming CSV writer, which passes the CSV to the specified callback in chunks, as it is written
+**
+** \param   cw - pointer to CSV writer to initialise
+** \param   field_separator - string to write between fields in a row
+** \param   row_separator - string to write at the end of each row
+** \param   escape_char - string to enclose fields needing escaping in, or an empty string if fields should never be escaped
+** \param   sink - callback to pass each chunk of CSV to
+** \param   sink_arg - argument to pass to the callback
+**
+** \return  None
+**
+**************************************************************************/
+void CSV_WRITER_InitStream(csv_writer_t *cw, char *field_separator, char *row_separator, char *escape_char, csv_writer_sink_t sink, void *sink_arg)
+{
+    memset(cw, 0, sizeof(csv_writer_t));
+    cw->field_separator = field_separator;
+    cw->row_separator = row_separator;
+    cw->escape_char = escape_char;
+    cw->sink = sink;
+    cw->sink_arg = sink_arg;
+    cw->max_len = CSV_WRITER_CHUNK_SIZE;
+    cw->buf = USP_MALLOC(cw->max_len);
+    cw->buf[0] = '\0';
+}
+
+/*********************************************************************//**
+**
+** CSV_WRITER_AddField
+**
+** Adds a field to the current row, escaping it if necessary
+**
+** \param   cw - pointer to CSV writer
+** \param   value - value of the field
+**
+** \return  None
+**
+**************************************************************************/
+void CSV_WRITER_AddField(csv_writer_t *cw, char *value)
+{
+    if (cw->num_fields > 0)
+    {
+        CsvWriteChars(cw, cw->field_separator, strlen(cw->field_separator));
+    }
+
+    if (CsvFieldNeedsEscaping(cw, value))
+    {
+        CsvWriteEscapedField(cw, value);
+    }
+    else
+    {
+        CsvWriteChars(cw, value, strlen(value));
+    }
+
+    cw->num_fields++;
+}
+
+/*********************************************************************//**
+**
+** CSV_WRITER_EndRow
+**
+** Ends the current row. Subsequent fields are added to the next row
+**
+** \param   cw - pointer to CSV writer
+**
+** \return  None
+**
+**************************************************************************/
+void CSV_WRITER_EndRow(csv_writer_t *cw)
+{
+    CsvWriteChars(cw, cw->row_separator, strlen(cw->row_separator));
+    cw->num_fields = 0;
+
+    // If streaming, pass the CSV to the sink at the end of a row, once enough has accumulated
+    // (this avoids splitting rows across chunks, so that the sink may log the CSV row by row)
+    if ((cw->sink != NULL) && (cw->len >= CSV_WRITER_CHUNK_SIZE/2))
+    {
+        CsvFlushToSink(cw);
+    }
+}
+
+/*********************************************************************//**
+**
+** CSV_WRITER_Finish
+**
+** Returns the CSV written, passing ownership of the buffer to the caller
+** NOTE: The writer must not be used after this call, unless it is re-initialised
+**
+** \param   cw - pointer to CSV writer
+**
+** \return  pointer to dynamically allocated NULL terminated buffer containing the CSV. The caller must free this with USP_FREE()
+**
+**************************************************************************/
+char *CSV_WRITER_Finish(csv_writer_t *cw)
+{
+    char *buf;
+
+    buf = cw->buf;
+    cw->buf = NULL;
+    cw->len = 0;
+    cw->max_len = 0;
+
+    return buf;
+}
+
+/*********************************************************************//**
+**
+** CSV_WRITER_FinishStream
+**
+** Passes any remaining CSV to the sink callback of a streaming CSV writer, and frees the writer's buffer
+** NOTE: The writer must not be used after this call, unless it is re-initialised
+**
+** \param   cw - pointer to CSV writer
+**
+** \return  USP_ERR_OK if successful, otherwise the first error returned by the sink callback
+**
+**************************************************************************/
+int CSV_WRITER_FinishStream(csv_writer_t *cw)
+{
+    int err;
+
+    if (cw->len > 0)
+    {
+        CsvFlushToSink(cw);
+    }
+
+    err = cw->sink_err;
+    USP_FREE(cw->buf);
+    memset(cw, 0, sizeof(csv_writer_t));
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** CsvFieldNeedsEscaping
+**
+** Determines whether the specified field value must be enclosed in the escape character
+** This is the case if it contains the field separator, any of the characters of the row separator, or the escape character
+**
+** \param   cw - pointer to CSV writer
+** \param   value - value of the field
+**
+** \return  true if the field needs escaping
+**
+**************************************************************************/
+bool CsvFieldNeedsEscaping(csv_writer_t *cw, char *value)
+{
+    // Exit if escaping is disabled
+    if (cw->escape_char[0] == '\0')
+    {
+        return false;
+    }
+
+    if ((strstr(value, cw->field_separator) != NULL) || (strstr(value, cw->escape_char) != NULL))
+    {
+        return true;
+    }
+
+    if (strpbrk(value, cw->row_separator) != NULL)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+/*********************************************************************//**
+**
+** CsvWriteEscapedField
+**
+** Writes the specified field value enclosed in the escape character, doubling any escape characters within it
+**
+** \param   cw - pointer to CSV writer
+** \param   value - value of the field
+**
+** \return  None
+**
+**************************************************************************/
+void CsvWriteEscapedField(csv_writer_t *cw, char *value)
+{
+    int escape_len;
+    char *p;
+    char *match;
+
+    escape_len = strlen(cw->escape_char);
+    CsvWriteChars(cw, cw->escape_char, escape_len);
+
+    p = value;
+    match = strstr(p, cw->escape_char);
+    while (match != NULL)
+    {
+        // Write everything up to and including the escape character, then write the escape character again
+        CsvWriteChars(cw, p, match - p + escape_len);
+        CsvWriteChars(cw, cw->escape_char, escape_len);
+        p = match + escape_len;
+        match = strstr(p, cw->escape_char);
+    }
+
+    CsvWriteChars(cw, p, strlen(p));
+    CsvWriteChars(cw, cw->escape_char, escape_len);
+}
+
+/*********************************************************************//**
+**
+** CsvWriteChars
+**
+** Writes the specified characters to the writer's buffer
+**
+** \param   cw - pointer to CSV writer
+** \param   str - pointer to characters to write
+** \param   len - number of characters to write
+**
+** \return  None
+**
+**************************************************************************/
+void CsvWriteChars(csv_writer_t *cw, char *str, int len)
+{
+    CsvEnsureSpace(cw, len);
+    memcpy(&cw->buf[cw->len], str, len);
+    cw->len += len;
+    cw->buf[cw->len] = '\0';
+}
+
+/*********************************************************************//**
+**
+** CsvEnsureSpace
+**
+** Ensures that the writer's buffer has space for the specified number of characters, plus a NULL terminator
+**
+** \param   cw - pointer to CSV writer
+** \param   needed - number of characters which are going to be written
+**
+** \return  None
+**
+**************************************************************************/
+void CsvEnsureSpace(csv_writer_t *cw, int needed)
+{
+    // Exit if there is already enough space
+    if (cw->len + needed + 1 <= cw->max_len)
+    {
+        return;
+    }
+
+    // If streaming, pass the CSV written so far to the sink, rather than growing the buffer
+    if ((cw->sink != NULL) && (cw->len > 0))
+    {
+        CsvFlushToSink(cw);
+        if (needed + 1 <= cw->max_len)
+        {
+            return;
+        }
+    }
+
+    while (cw->len + needed + 1 > cw->max_len)
+    {
+        cw->max_len *= 2;
+    }
+
+    cw->buf = USP_REALLOC(cw->buf, cw->max_len);
+}
+
+/*********************************************************************//**
+**
+** CsvFlushToSink
+**
+** Passes the CSV accumulated in the buffer of a streaming CSV writer to its sink callback, then empties the buffer
+**
+** \param   cw - pointer to CSV writer
+**
+** \return  None
+**
+**************************************************************************/
+void CsvFlushToSink(csv_writer_t *cw)
+{
+    // Only call the sink, if it has not previously failed
+    if (cw->sink_err == USP_ERR_OK)
+    {
+        cw->sink_err = cw->sink(cw->buf, cw->len, cw->sink_arg);
+    }
+
+    cw->len = 0;
+    cw->buf[0] = '\0';
+}
@@ -0,0 +1,81 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/**
+ * \file csv_writer.h
+ *
+ * Streaming CSV writer, which serializes comma separated values directly into a growable buffer
+ *
+ */
+#ifndef CSV_WRITER_H
+#define CSV_WRITER_H
+
+#include <stdbool.h>
+
+//-----------------------------------------------------------------------------------------
+// Typedef for callback called by a streaming CSV writer, with each chunk of CSV written
+// NOTE: The chunk is always NULL terminated (at buf[len]), and the callback must not retain the buffer
+typedef int (*csv_writer_sink_t)(char *buf, int len, void *arg);
+
+//-----------------------------------------------------------------------------------------
+// Size of chunks passed to the sink callback of a streaming CSV writer
+// NOTE: Chunks are split at the end of a row, so may be smaller than this
+#define CSV_WRITER_CHUNK_SIZE  16384
+
+//-----------------------------------------------------------------------------------------
+// CSV writer state
+typedef struct
+{
+    char *buf;              // Buffer containing the CSV written so far. This is always NULL terminated
+    int len;                // Number of characters written to the buffer (excluding the NULL terminator)
+    int max_len;            // Number of bytes allocated to the buffer
+    char *field_separator;  // String written between fields in a row
+    char *row_separator;    // String written at the end of each row
+    char *escape_char;      // String written around fields which contain separators or escape characters (or empty string, if fields are never escaped)
+    int num_fields;         // Number of fields written to the current row so far
+    csv_writer_sink_t sink; // Callback to pass each chunk of CSV to, if the writer is streaming (or NULL if the CSV is accumulated in the buffer)
+    void *sink_arg;         // Argument to pass to the sink callback
+    int sink_err;           // Error returned by the sink callback. After an error, the sink callback is not called again
+} csv_writer_t;
+
+//-----------------------------------------------------------------------------------------
+// API functions
+// NOTE: The separator and escape strings are not copied, so must remain valid for the lifetime of the writer
+void CSV_WRITER_Init(csv_writer_t *cw, char *field_separator, char *row_separator, char *escape_char);
+void CSV_WRITER_InitStream(csv_writer_t *cw, char *field_separator, char *row_separator, char *escape_char, csv_writer_sink_t sink, void *sink_arg);
+void CSV_WRITER_AddField(csv_writer_t *cw, char *value);
+void CSV_WRITER_EndRow(csv_writer_t *cw);
+char *CSV_WRITER_Finish(csv_writer_t *cw);
+int CSV_WRITER_FinishStream(csv_writer_t *cw);
+
+#endif
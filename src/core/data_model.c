@@ -55,6 +55,8 @@
 #include "vendor_api.h"
 #include "text_utils.h"
 #include "iso8601.h"
+#include "msg_stats.h"
+#include "uptime.h"
 
 #ifdef ENABLE_COAP
 #include "usp_coap.h"
@@ -65,6 +67,10 @@
 // Boolean that allows us to control which scope the USP_REGISTER_XXX() functions can be called in
 bool is_executing_within_dm_init = false;
 
+//--------------------------------------------------------------------
+// Boolean set if any object has registered a group get callback (by USP_REGISTER_GroupGet)
+bool is_group_get_registered = false;
+
 //--------------------------------------------------------------------
 // Segment of a data model path e.g. "Device" or "LocalAgent"
 typedef struct
@@ -116,6 +122,69 @@ typedef struct
 static node_lookup_t *node_lookup = NULL;
 static int node_lookup_count = 0;
 
+//--------------------------------------------------------------------
+// Pool from which all data model nodes (and their schema path strings) are allocated
+// Nodes are only ever created during DATA_MODEL_Init() and only freed at shutdown, so they are packed into large chunks
+// rather than being allocated individually from the heap. This avoids the per allocation heap overhead, and keeps the schema compact in memory.
+typedef struct schema_chunk_tag
+{
+    struct schema_chunk_tag *next;  // Next chunk in the (LIFO) list of chunks
+    int size;                       // Number of bytes available for allocation in this chunk
+    int used;                       // Number of bytes already allocated from this chunk
+} schema_chunk_t;
+
+#define SCHEMA_ALIGN 8
+#define SCHEMA_ROUND_UP(x)  (((x) + SCHEMA_ALIGN - 1) & ~(SCHEMA_ALIGN - 1))
+#define SCHEMA_CHUNK_DATA(chunk)  ((char *)(chunk) + SCHEMA_ROUND_UP(sizeof(schema_chunk_t)))
+#define SCHEMA_CHUNK_SIZE (64*1024)
+
+static schema_chunk_t *schema_pool = NULL;
+
+//--------------------------------------------------------------------
+// Cache of the parameter values returned by group get callbacks, sorted by the path of the object instance
+// The cache is only active whilst handling a USP message or polling value change subscriptions (see DATA_MODEL_StartGroupGetCache)
+// This ensures that the vendor is called once per object instance (rather than once per parameter) within each of these,
+// and that the values of the parameters in an object instance are consistent with each other
+// NOTE: Only object instances whose object has a group get callback are cached
+typedef struct
+{
+    char *path;             // Path of the object instance
+    kv_vector_t values;     // Values returned by the group get callback for the object instance (empty if the callback failed)
+} group_cache_entry_t;
+
+static group_cache_entry_t *group_cache = NULL;
+static int num_group_cache_entries = 0;
+static int max_group_cache_entries = 0;     // Number of entries allocated in group_cache. The array is grown geometrically, to avoid reallocating it for every object instance
+static bool is_group_cache_active = false;
+static bool is_group_get_in_progress = false;   // Set whilst a group get callback is being called to fill in the cache. Gets made by the callback itself bypass the cache
+
+//--------------------------------------------------------------------
+// Cache of the values returned by the get callback of a vendor parameter registered with a time to live (see USP_REGISTER_VendorParam_ReadOnlyCached)
+// Values are reused until they are older than the time to live, or until any parameter is set or object instance deleted
+typedef struct
+{
+    int instances[MAX_DM_INSTANCE_ORDER];   // Instance numbers of the parameter. Only the first 'order' (of the parameter's node) are used
+    uint32_t fetch_time;                    // Time (in ms, see tu_uptime_msecs) at which the value was obtained from the vendor
+    char *value;
+} cached_value_t;
+
+typedef struct dm_value_cache_tag
+{
+    unsigned ttl;                   // Time (in ms) for which a value may be reused
+    cached_value_t *vector;         // Cached values, sorted by instance numbers
+    int num_entries;
+    int max_entries;                // Number of entries allocated in the vector. The vector is grown geometrically, after pruning expired values
+    unsigned hits;                  // Number of gets which were satisfied from the cache
+    unsigned misses;                // Number of gets which had to call the vendor
+} dm_value_cache_t;
+
+static dm_node_t **value_cached_nodes = NULL;   // Array of all parameters which have a value cache
+static int num_value_cached_nodes = 0;
+
+//--------------------------------------------------------------------
+// Instance node array used by nodes which are not children of any multi-instance object (ie nodes with an order of 0)
+static dm_node_t *no_instance_nodes[1] = { NULL };
+
 //--------------------------------------------------------------------
 // Typedef for the compare callback
 typedef int (*dm_cmp_cb_t)(char *lhs, expr_op_t op, char *rhs, bool *result);
@@ -124,7 +193,19 @@ typedef int (*dm_cmp_cb_t)(char *lhs, expr_op_t op, char *rhs, bool *result);
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 void SerializeNativeValue(dm_req_t *req, dm_node_t *node, char *buf, int len);
 void FormInstanceString(dm_instances_t *inst, char *buf, int len);
+dm_node_t *GetParentObjectNode(char *path);
+bool GetValueFromGroupGetCache(char *path, char *buf, int len);
+int AddToGroupGetCache(char *path, int obj_len);
+int FindInGroupGetCache(char *path, int obj_len, bool *is_found);
+void FlushGroupGetCache(void);
+bool GetValueFromValueCache(dm_node_t *node, dm_instances_t *inst, char *buf, int len);
+void AddToValueCache(dm_node_t *node, dm_instances_t *inst, char *value);
+int FindInValueCache(dm_value_cache_t *vc, int order, dm_instances_t *inst, bool *is_found);
+void PruneValueCache(dm_value_cache_t *vc, uint32_t cur_time);
+void FlushValueCaches(void);
 dm_node_t *CreateNode(char *name, dm_node_type_t type, char *schema_path);
+void *SchemaPoolAlloc(int size);
+void SchemaPoolDestroy(void);
 int ParseSchemaPath(char *path, char *path_segments, int path_segment_len, dm_node_type_t type, dm_path_segment *segments, int max_segments);
 int ParsePath(char *path, char *path_segments, int path_segment_len, char *segments[], int max_segments, dm_instances_t *inst);
 dm_node_t *FindNodeFromHash(dm_hash_t hash);
@@ -182,6 +263,7 @@ int DATA_MODEL_Init(void)
     err |= DEVICE_CTRUST_Init();
     err |= DEVICE_REQUEST_Init();
     err |= DEVICE_BULKDATA_Init();
+    err |= MSG_STATS_Init();
 
 
 
@@ -291,6 +373,7 @@ int DATA_MODEL_Start(void)
     err |= DEVICE_SECURITY_Start();
     err |= DEVICE_CTRUST_Start();
     err |= DEVICE_BULKDATA_Start();
+    err |= MSG_STATS_Start();
 
 
 
@@ -334,6 +417,8 @@ void DATA_MODEL_Stop(void)
     DEVICE_SECURITY_Stop();
     DEVICE_LOCAL_AGENT_Stop();
 
+    // Free all cached vendor parameter values here, so that they are not reported as a memory leak
+    FlushValueCaches();
 
     // Free the instance vectors here, so that they are not reported as a memory leak
     DestroyInstanceVectorRecursive(root_device_node);
@@ -347,7 +432,10 @@ void DATA_MODEL_Stop(void)
     // Free all allocations that occurred before mem info collection was turned on    
     DestroySchemaRecursive(root_device_node);
     DestroySchemaRecursive(root_internal_node);
+    SchemaPoolDestroy();
     USP_SAFE_FREE(node_lookup);
+    USP_SAFE_FREE(value_cached_nodes);
+    num_value_cached_nodes = 0;
 
     // If logging memory usage, print out all memory still in use, after attempting to free all known references
     USP_MEM_PrintLeakReport();
@@ -368,6 +456,27 @@ void DATA_MODEL_Stop(void)
 **
 **************************************************************************/
 int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
+{
+    return DATA_MODEL_GetTypedParameterValue(path, buf, len, flags, NULL);
+}
+
+/*********************************************************************//**
+**
+** DATA_MODEL_GetTypedParameterValue
+**
+** Gets a single named parameter from the data model, also returning its type and (if available) its native value
+** This allows callers which interpret the value (eg search expression comparisons) to avoid converting it back from a string
+**
+** \param   path - pointer to string containing complete data model path to the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+** \param   flags - options to control execution of this function (eg SHOW_PASSWORD, JSON_FORMAT)
+** \param   tv - pointer to structure in which to return the type and native value of the parameter, or NULL if not required
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int DATA_MODEL_GetTypedParameterValue(char *path, char *buf, int len, unsigned flags, dm_typed_value_t *tv)
 {
     dm_node_t *node;
     dm_node_t *table_node;
@@ -382,6 +491,12 @@ int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
     char *default_value;
     unsigned db_flags = 0;          // Default to database not unobfuscating values. NOTE Only secure nodes are obfuscated
 
+    // Default to the value not being available in native form
+    if (tv != NULL)
+    {
+        tv->is_native = false;
+    }
+
     // Exit if unable to get node associated with parameter
     // This could occur if the parameter is not present in the schema, or if the specified instance does not exist
     node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
@@ -451,11 +566,28 @@ int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
             table_node = node->registered.param_info.table_node;
             num_instances = DM_INST_VECTOR_GetNumInstances(table_node, &inst);
             USP_SNPRINTF(buf, len, "%d", num_instances);
+            if (tv != NULL)
+            {
+                tv->is_native = true;
+                tv->val_union.value_uint = num_instances;
+            }
             break;
 
             
         case kDMNodeType_VendorParam_ReadOnly:
         case kDMNodeType_VendorParam_ReadWrite:
+            // Use the value returned by the parent object's group get callback, if available
+            if ((is_group_cache_active) && (GetValueFromGroupGetCache(path, buf, len)))
+            {
+                break;
+            }
+
+            // Use the value cached from a previous get, if it has not expired yet
+            if ((node->registered.param_info.value_cache != NULL) && (GetValueFromValueCache(node, &inst, buf, len)))
+            {
+                break;
+            }
+
             get_cb = node->registered.param_info.get_cb;
             USP_ASSERT(get_cb != NULL)
 
@@ -471,8 +603,21 @@ int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
                 return err;
             }
 
+            // Save the native value for the caller, if the vendor returned it natively (rather than in the buffer)
+            if ((tv != NULL) && ((node->registered.param_info.type_flags & DM_STRING) == 0) && (buf[0] == '\0'))
+            {
+                tv->is_native = true;
+                tv->val_union = req.val_union;
+            }
+
             // If the parameter value was returned as a native value (in val_union), then convert it to a string
             SerializeNativeValue(&req, node, buf, len);
+
+            // Save the value, so that subsequent gets within the parameter's time to live do not call the vendor
+            if (node->registered.param_info.value_cache != NULL)
+            {
+                AddToValueCache(node, &inst, buf);
+            }
             break;
 
         case kDMNodeType_Object_MultiInstance:
@@ -503,6 +648,12 @@ int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
     // If code gets here, then value was retrieved successfully
     buf[len -1] = '\0';         // Ensure that buffer is always zero terminated (eg vendor may not do this)
 
+    // Return the type of the parameter, if required
+    if (tv != NULL)
+    {
+        tv->type_flags = node->registered.param_info.type_flags;
+    }
+
     // Convert the value in the buffer to JSON format, if required (and only if JSON format needs the string to change, based on the parameter's type)
     if ( (flags & JSON_FORMAT) && (node->registered.param_info.type_flags & (DM_STRING | DM_DATETIME)) )
     {
@@ -517,6 +668,147 @@ int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags)
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** DATA_MODEL_GetGroupParameterValues
+**
+** Gets the values of all vendor parameters in the specified object instance at once, using the object's group get callback
+** NOTE: The callback may not return all vendor parameters in the object. Those not returned must be obtained individually
+**
+** \param   path - data model path of the object instance (eg Device.Hosts.Host.3)
+** \param   params - pointer to key-value vector in which to return {parameter name vs value}.
+**                   NOTE: Parameter names are relative to the object instance
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int DATA_MODEL_GetGroupParameterValues(char *path, kv_vector_t *params)
+{
+    dm_node_t *node;
+    dm_instances_t inst;
+    bool is_qualified_instance;
+    bool exists;
+    dm_get_group_cb_t get_group_cb;
+    dm_req_t req;
+    int err;
+
+    // Exit if unable to get node associated with object
+    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
+    if (node == NULL)
+    {
+        return USP_ERR_INVALID_PATH;
+    }
+
+    // Exit if the path is not to an object instance
+    if ((IsObject(node) == false) || ((node->type == kDMNodeType_Object_MultiInstance) && (is_qualified_instance == false)))
+    {
+        USP_ERR_SetMessage("%s: Path %s is not an object instance", __FUNCTION__, path);
+        return USP_ERR_INVALID_PATH;
+    }
+
+    // Exit if the object does not have a group get callback
+    get_group_cb = node->registered.object_info.get_group_cb;
+    if (get_group_cb == NULL)
+    {
+        USP_ERR_SetMessage("%s: No group get callback registered for %s", __FUNCTION__, path);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if the object instance does not exist
+    if (inst.order > 0)
+    {
+        exists = DM_INST_VECTOR_IsExist(&inst);
+        if (exists == false)
+        {
+            USP_ERR_SetMessage("%s: Path %s: Instance numbers do not exist", __FUNCTION__, path);
+            return USP_ERR_OBJECT_DOES_NOT_EXIST;
+        }
+    }
+
+    // Exit if unable to get the values from the vendor code
+    DM_PRIV_RequestInit(&req, node, path, &inst);
+    USP_ERR_ClearMessage();
+    err = get_group_cb(&req, params);
+    if (err != USP_ERR_OK)
+    {
+        USP_ERR_ReplaceEmptyMessage("%s: Group get callback for path %s returned error %d", __FUNCTION__, path, err);
+        return err;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** DATA_MODEL_IsGroupParameter
+**
+** Determines whether the specified parameter is a vendor parameter whose parent object has a group get callback
+** If so, its value may be obtained (together with its siblings) using DATA_MODEL_GetGroupParameterValues()
+**
+** \param   path - data model path of the parameter
+**
+** \return  true if the parameter's value may be obtained from its parent object's group get callback
+**
+**************************************************************************/
+bool DATA_MODEL_IsGroupParameter(char *path)
+{
+    dm_node_t *node;
+    dm_instances_t inst;
+    bool is_qualified_instance;
+
+    // Exit if the path is not to a vendor parameter
+    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
+    if ((node == NULL) || ((node->type != kDMNodeType_VendorParam_ReadOnly) && (node->type != kDMNodeType_VendorParam_ReadWrite)))
+    {
+        return false;
+    }
+
+    // Exit if the parent object does not have a group get callback
+    node = GetParentObjectNode(path);
+    if ((node == NULL) || (node->registered.object_info.get_group_cb == NULL))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/*********************************************************************//**
+**
+** DATA_MODEL_StartGroupGetCache
+**
+** Starts caching the values returned by group get callbacks
+** Whilst the cache is active, DATA_MODEL_GetParameterValue() obtains the values of vendor parameters whose parent object has a
+** group get callback from the cache, calling the group get callback only once per object instance
+** NOTE: The cache should only be active for a short time (eg whilst handling a single USP message), as the values in it are not refreshed
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DATA_MODEL_StartGroupGetCache(void)
+{
+    is_group_cache_active = is_group_get_registered;
+}
+
+/*********************************************************************//**
+**
+** DATA_MODEL_StopGroupGetCache
+**
+** Stops caching the values returned by group get callbacks, freeing all cached values
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DATA_MODEL_StopGroupGetCache(void)
+{
+    FlushGroupGetCache();
+    is_group_cache_active = false;
+}
+
 /*********************************************************************//**
 **
 ** DATA_MODEL_SetParameterValue
@@ -538,6 +830,7 @@ int DATA_MODEL_SetParameterValue(char *path, char *new_value, unsigned flags)
     char instances[MAX_DM_PATH];
     dm_validate_value_cb_t validate_cb;
     dm_set_value_cb_t set_cb;
+    dm_node_t *parent_node;
     dm_req_t req;
     bool is_qualified_instance;
     bool exists;
@@ -545,6 +838,10 @@ int DATA_MODEL_SetParameterValue(char *path, char *new_value, unsigned flags)
 
     USP_ASSERT(DM_TRANS_IsWithinTransaction()==true);
 
+    // Ensure that values obtained after this set are up to date
+    FlushGroupGetCache();
+    FlushValueCaches();
+
     // Exit if unable to get node associated with parameter
     // This could occur if the parameter is not present in the schema
     node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
@@ -587,6 +884,14 @@ int DATA_MODEL_SetParameterValue(char *path, char *new_value, unsigned flags)
     switch(node->type)
     {
         case kDMNodeType_VendorParam_ReadWrite:
+            // If the parent object applies all of its parameters at once, then defer the set until the group sets are applied (see DM_TRANS_ApplyGroupSets)
+            parent_node = GetParentObjectNode(path);
+            if ((parent_node != NULL) && (parent_node->registered.object_info.set_group_cb != NULL))
+            {
+                DM_TRANS_AddGroupSet(path, new_value, parent_node, &inst);
+                break;
+            }
+
             // Exit if unable to set the vendor parameter, aborting the transaction
             set_cb = node->registered.param_info.set_cb;
             if (set_cb != NULL)
@@ -915,6 +1220,10 @@ int DATA_MODEL_DeleteInstance(char *path, unsigned flags)
 
     USP_ASSERT(DM_TRANS_IsWithinTransaction()==true);
 
+    // Ensure that values obtained after this delete are up to date
+    FlushGroupGetCache();
+    FlushValueCaches();
+
     // Exit if unable to find node representing this object
     node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
     if (node == NULL)
@@ -1465,33 +1774,27 @@ int DATA_MODEL_RestartAsyncOperation(char *path, kv_vector_t *input_args, int in
 int DATA_MODEL_CompareParameterValue(char *path, expr_op_t op, char *expr_constant, bool *result)
 {
     int err;
-    dm_node_t *node;
-    dm_instances_t inst;
-    bool is_qualified_instance;
+    dm_typed_value_t tv;
     dm_cmp_cb_t cmp_cb;
     char buf[MAX_DM_SHORT_VALUE_LEN];
     unsigned type_flags;
 
     // Exit if unable to get the value of the parameter
     // NOTE: Passwords will return empty string
-    err = DATA_MODEL_GetParameterValue(path, buf, sizeof(buf), 0);
+    err = DATA_MODEL_GetTypedParameterValue(path, buf, sizeof(buf), 0, &tv);
     if (err != USP_ERR_OK)
     {
         return err;
     }
 
-    // Exit if unable to get node associated with the parameter
-    // NOTE: This should not fail, as we've already got the parameter's value
-    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
-    USP_ASSERT(node != NULL);
-    USP_ASSERT( ((node->type != kDMNodeType_Object_MultiInstance) &&
-                 (node->type != kDMNodeType_Object_SingleInstance) &&
-                 (node->type != kDMNodeType_SyncOperation) &&
-                 (node->type != kDMNodeType_AsyncOperation) &&
-                 (node->type != kDMNodeType_Event)) );
+    // Exit if the value was obtained natively, comparing it without converting it back from a string
+    if (tv.is_native)
+    {
+        return DM_ACCESS_CompareNativeValue(tv.type_flags, &tv.val_union, op, expr_constant, result);
+    }
 
     // Determine the function to call to perform the comparison
-    type_flags = node->registered.param_info.type_flags;
+    type_flags = tv.type_flags;
     if (type_flags & (DM_INT | DM_UINT | DM_ULONG))
     {
         cmp_cb = DM_ACCESS_CompareNumber;
@@ -1960,6 +2263,38 @@ void DATA_MODEL_DumpInstances(void)
     DumpInstanceVectorRecursive(root_internal_node);
 }
 
+/*********************************************************************//**
+**
+** DATA_MODEL_DumpValueCaches
+**
+** Logs the hit statistics of all vendor parameters registered with a time to live
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void DATA_MODEL_DumpValueCaches(void)
+{
+    int i;
+    dm_node_t *node;
+    dm_value_cache_t *vc;
+
+    USP_DUMP("Dumping cached vendor parameters...");
+    if (num_value_cached_nodes == 0)
+    {
+        USP_DUMP("No vendor parameters are registered with a time to live");
+        return;
+    }
+
+    for (i=0; i < num_value_cached_nodes; i++)
+    {
+        node = value_cached_nodes[i];
+        vc = node->registered.param_info.value_cache;
+        USP_DUMP("%s: ttl=%ums hits=%u misses=%u cached=%d", node->path, vc->ttl, vc->hits, vc->misses, vc->num_entries);
+    }
+}
+
 /*********************************************************************//**
 **
 ** DATA_MODEL_GetNumInstances
@@ -2573,7 +2908,16 @@ dm_node_t *DM_PRIV_AddSchemaPath(char *path, dm_node_type_t type, unsigned flags
             }
 
             // Save the instance nodes for this object
-            memcpy(child->instance_nodes, &inst.nodes, inst.order*sizeof(dm_node_t *));
+            // NOTE: Only multi-instance objects need their own array, all other nodes share the array of their parent
+            if (seg->type == kDMNodeType_Object_MultiInstance)
+            {
+                child->instance_nodes = SchemaPoolAlloc(inst.order*sizeof(dm_node_t *));
+                memcpy(child->instance_nodes, &inst.nodes, inst.order*sizeof(dm_node_t *));
+            }
+            else
+            {
+                child->instance_nodes = parent->instance_nodes;
+            }
             child->order = inst.order;
         }
         else
@@ -2934,6 +3278,33 @@ int DM_PRIV_ReRegister_DBParam_Default(char *path, char *value)
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** DM_PRIV_AddValueCache
+**
+** Enables caching of the values returned by the get callback of the specified vendor parameter
+**
+** \param   node - pointer to node representing the parameter
+** \param   ttl - time (in ms) for which a value returned by the get callback may be reused
+**
+** \return  None
+**
+**************************************************************************/
+void DM_PRIV_AddValueCache(dm_node_t *node, unsigned ttl)
+{
+    dm_value_cache_t *vc;
+
+    vc = USP_MALLOC(sizeof(dm_value_cache_t));
+    memset(vc, 0, sizeof(dm_value_cache_t));
+    vc->ttl = ttl;
+    node->registered.param_info.value_cache = vc;
+
+    // Add the node to the array of nodes with caches, so that the caches can be flushed and dumped
+    value_cached_nodes = USP_REALLOC(value_cached_nodes, (num_value_cached_nodes+1)*sizeof(dm_node_t *));
+    value_cached_nodes[num_value_cached_nodes] = node;
+    num_value_cached_nodes++;
+}
+
 /*********************************************************************//**
 **
 ** SerializeNativeValue
@@ -3031,6 +3402,475 @@ unsigned short DM_PRIV_GetPermissions(dm_node_t *node, combined_role_t *combined
     return permissions;
 }
 
+/*********************************************************************//**
+**
+** GetValueFromGroupGetCache
+**
+** Gets the value of the specified vendor parameter from the values returned by its parent object's group get callback
+** If the object instance is not already in the cache, then it is added to the cache (calling its group get callback)
+**
+** \param   path - data model path of the vendor parameter
+** \param   buf - pointer to buffer in which to return the value
+** \param   len - length of buffer
+**
+** \return  true if the value was obtained from the cache, false if the parameter must be obtained individually
+**
+**************************************************************************/
+bool GetValueFromGroupGetCache(char *path, char *buf, int len)
+{
+    int pos;
+    int obj_len;
+    int index;
+    char *name;
+    bool is_found;
+    dm_node_t *node;
+    group_cache_entry_t *gce;
+
+    // Split the path into the object instance and the name of the parameter within it
+    name = strrchr(path, '.');
+    if (name == NULL)
+    {
+        return false;
+    }
+    obj_len = name - path;
+    name++;
+
+    // Exit if the object does not have a group get callback. Its parameters are obtained individually, and the object instance is not cached
+    node = GetParentObjectNode(path);
+    if ((node == NULL) || (node->registered.object_info.get_group_cb == NULL))
+    {
+        return false;
+    }
+
+    // Exit if this get is being made by a group get callback which is filling in the cache
+    // NOTE: Such gets are obtained individually, so that a callback getting a parameter of its own object does not recurse
+    if (is_group_get_in_progress)
+    {
+        return false;
+    }
+
+    // Find the object instance in the cache, adding it if not found
+    pos = FindInGroupGetCache(path, obj_len, &is_found);
+    if (is_found == false)
+    {
+        pos = AddToGroupGetCache(path, obj_len);
+    }
+    gce = &group_cache[pos];
+
+    // Exit if the parameter was not returned by the group get callback
+    index = KV_VECTOR_FindKey(&gce->values, name, 0);
+    if (index == INVALID)
+    {
+        return false;
+    }
+
+    USP_STRNCPY(buf, gce->values.vector[index].value, len);
+    return true;
+}
+
+/*********************************************************************//**
+**
+** FindInGroupGetCache
+**
+** Performs a binary search of the group get cache, to find the specified object instance
+**
+** \param   path - data model path of a parameter in the object instance
+** \param   obj_len - length of the part of the path which identifies the object instance
+** \param   is_found - pointer to variable in which to return whether the object instance is in the cache
+**
+** \return  index of the object instance in the cache if found, otherwise the index at which it should be inserted
+**
+**************************************************************************/
+int FindInGroupGetCache(char *path, int obj_len, bool *is_found)
+{
+    int lower;
+    int upper;
+    int mid;
+    int result;
+    char *entry_path;
+
+    lower = 0;
+    upper = num_group_cache_entries - 1;
+    while (lower <= upper)
+    {
+        mid = (lower + upper)/2;
+        entry_path = group_cache[mid].path;
+        result = strncmp(entry_path, path, obj_len);
+        if ((result == 0) && (entry_path[obj_len] != '\0'))
+        {
+            result = 1;     // The entry's path is longer than the object instance path, so is ordered after it
+        }
+
+        if (result == 0)
+        {
+            *is_found = true;
+            return mid;
+        }
+
+        if (result > 0)
+        {
+            upper = mid - 1;
+        }
+        else
+        {
+            lower = mid + 1;
+        }
+    }
+
+    *is_found = false;
+    return lower;
+}
+
+/*********************************************************************//**
+**
+** AddToGroupGetCache
+**
+** Adds the specified object instance to the group get cache, calling its group get callback
+** NOTE: The cache is only modified after the group get callback has returned, as the callback may itself call back into the data model
+**
+** \param   path - data model path of a parameter in the object instance
+** \param   obj_len - length of the part of the path which identifies the object instance
+**
+** \return  index of the entry in the cache
+**
+**************************************************************************/
+int AddToGroupGetCache(char *path, int obj_len)
+{
+    int err;
+    int pos;
+    bool is_found;
+    char *obj_path;
+    kv_vector_t values;
+    group_cache_entry_t *gce;
+
+    obj_path = USP_STRDUP(path);
+    obj_path[obj_len] = '\0';
+
+    // Get the values of all parameters in the object instance
+    // NOTE: If an error occurred, then the cache entry is left empty, so that the parameters are obtained individually
+    KV_VECTOR_Init(&values);
+    is_group_get_in_progress = true;
+    err = DATA_MODEL_GetGroupParameterValues(obj_path, &values);
+    is_group_get_in_progress = false;
+    if (err != USP_ERR_OK)
+    {
+        USP_LOG_Warning("%s: Unable to get values of %s. Getting them individually", __FUNCTION__, obj_path);
+        KV_VECTOR_Destroy(&values);
+    }
+
+    // Exit if the object instance was added to the cache whilst the group get callback was running
+    pos = FindInGroupGetCache(path, obj_len, &is_found);
+    if (is_found)
+    {
+        USP_FREE(obj_path);
+        KV_VECTOR_Destroy(&values);
+        return pos;
+    }
+
+    if (num_group_cache_entries == max_group_cache_entries)
+    {
+        max_group_cache_entries = (max_group_cache_entries == 0) ? 16 : 2*max_group_cache_entries;
+        group_cache = USP_REALLOC(group_cache, max_group_cache_entries*sizeof(group_cache_entry_t));
+    }
+
+    memmove(&group_cache[pos+1], &group_cache[pos], (num_group_cache_entries - pos)*sizeof(group_cache_entry_t));
+    num_group_cache_entries++;
+
+    gce = &group_cache[pos];
+    gce->path = obj_path;
+    memcpy(&gce->values, &values, sizeof(kv_vector_t));
+
+    return pos;
+}
+
+/*********************************************************************//**
+**
+** FlushGroupGetCache
+**
+** Frees all values in the group get cache
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void FlushGroupGetCache(void)
+{
+    int i;
+    group_cache_entry_t *gce;
+
+    for (i=0; i < num_group_cache_entries; i++)
+    {
+        gce = &group_cache[i];
+        USP_FREE(gce->path);
+        KV_VECTOR_Destroy(&gce->values);
+    }
+
+    USP_SAFE_FREE(group_cache);
+    num_group_cache_entries = 0;
+    max_group_cache_entries = 0;
+}
+
+/*********************************************************************//**
+**
+** GetValueFromValueCache
+**
+** Gets the value of the specified vendor parameter from its value cache, if the cached value has not expired
+**
+** \param   node - pointer to node representing the parameter
+** \param   inst - pointer to instance numbers of the parameter
+** \param   buf - pointer to buffer in which to return the value
+** \param   len - length of buffer
+**
+** \return  true if the value was obtained from the cache, false if it must be obtained from the vendor
+**
+**************************************************************************/
+bool GetValueFromValueCache(dm_node_t *node, dm_instances_t *inst, char *buf, int len)
+{
+    int pos;
+    bool is_found;
+    dm_value_cache_t *vc;
+    cached_value_t *cv;
+
+    vc = node->registered.param_info.value_cache;
+
+    // Exit if the value is not in the cache, or has expired
+    pos = FindInValueCache(vc, node->order, inst, &is_found);
+    if (is_found)
+    {
+        cv = &vc->vector[pos];
+        if ((uint32_t)(tu_uptime_msecs() - cv->fetch_time) < vc->ttl)
+        {
+            USP_STRNCPY(buf, cv->value, len);
+            vc->hits++;
+            return true;
+        }
+    }
+
+    vc->misses++;
+    return false;
+}
+
+/*********************************************************************//**
+**
+** AddToValueCache
+**
+** Saves the value obtained from the vendor for the specified parameter, replacing any expired value
+** NOTE: Expired values of other object instances are removed when the cache is full, so that the cache only grows
+**       with the number of object instances whose value is still valid
+**
+** \param   node - pointer to node representing the parameter
+** \param   inst - pointer to instance numbers of the parameter
+** \param   value - value obtained from the vendor
+**
+** \return  None
+**
+**************************************************************************/
+void AddToValueCache(dm_node_t *node, dm_instances_t *inst, char *value)
+{
+    int pos;
+    bool is_found;
+    uint32_t cur_time;
+    dm_value_cache_t *vc;
+    cached_value_t *cv;
+
+    vc = node->registered.param_info.value_cache;
+    cur_time = tu_uptime_msecs();
+    pos = FindInValueCache(vc, node->order, inst, &is_found);
+    if (is_found)
+    {
+        // Replace the expired value
+        cv = &vc->vector[pos];
+        USP_FREE(cv->value);
+    }
+    else
+    {
+        // If the vector is full, then remove all expired values, and only grow the vector if that did not free any space
+        if (vc->num_entries == vc->max_entries)
+        {
+            PruneValueCache(vc, cur_time);
+            if (vc->num_entries == vc->max_entries)
+            {
+                vc->max_entries = (vc->max_entries == 0) ? 16 : 2*vc->max_entries;
+                vc->vector = USP_REALLOC(vc->vector, vc->max_entries*sizeof(cached_value_t));
+            }
+            pos = FindInValueCache(vc, node->order, inst, &is_found);
+        }
+
+        // Insert a new entry, keeping the vector sorted
+        memmove(&vc->vector[pos+1], &vc->vector[pos], (vc->num_entries - pos)*sizeof(cached_value_t));
+        vc->num_entries++;
+
+        cv = &vc->vector[pos];
+        memset(cv->instances, 0, sizeof(cv->instances));
+        memcpy(cv->instances, inst->instances, node->order*sizeof(int));
+    }
+
+    cv->value = USP_STRDUP(value);
+    cv->fetch_time = cur_time;
+}
+
+/*********************************************************************//**
+**
+** PruneValueCache
+**
+** Removes all expired values from the specified value cache, keeping the remaining values sorted
+**
+** \param   vc - pointer to value cache of the parameter
+** \param   cur_time - current time (in ms, see tu_uptime_msecs)
+**
+** \return  None
+**
+**************************************************************************/
+void PruneValueCache(dm_value_cache_t *vc, uint32_t cur_time)
+{
+    int i;
+    int num_kept = 0;
+    cached_value_t *cv;
+
+    for (i=0; i < vc->num_entries; i++)
+    {
+        cv = &vc->vector[i];
+        if ((uint32_t)(cur_time - cv->fetch_time) < vc->ttl)
+        {
+            vc->vector[num_kept] = *cv;
+            num_kept++;
+        }
+        else
+        {
+            USP_FREE(cv->value);
+        }
+    }
+
+    vc->num_entries = num_kept;
+}
+
+/*********************************************************************//**
+**
+** FindInValueCache
+**
+** Performs a binary search of a parameter's value cache, to find the value for the specified instance numbers
+**
+** \param   vc - pointer to value cache of the parameter
+** \param   order - number of instance numbers identifying the parameter
+** \param   inst - pointer to instance numbers of the parameter
+** \param   is_found - pointer to variable in which to return whether the value is in the cache
+**
+** \return  index of the value in the cache if found, otherwise the index at which it should be inserted
+**
+**************************************************************************/
+int FindInValueCache(dm_value_cache_t *vc, int order, dm_instances_t *inst, bool *is_found)
+{
+    int i;
+    int lower;
+    int upper;
+    int mid;
+    int result;
+    int *entry_instances;
+
+    lower = 0;
+    upper = vc->num_entries - 1;
+    while (lower <= upper)
+    {
+        mid = (lower + upper)/2;
+        entry_instances = vc->vector[mid].instances;
+
+        result = 0;
+        for (i=0; (i < order) && (result == 0); i++)
+        {
+            result = entry_instances[i] - inst->instances[i];
+        }
+
+        if (result == 0)
+        {
+            *is_found = true;
+            return mid;
+        }
+
+        if (result > 0)
+        {
+            upper = mid - 1;
+        }
+        else
+        {
+            lower = mid + 1;
+        }
+    }
+
+    *is_found = false;
+    return lower;
+}
+
+/*********************************************************************//**
+**
+** FlushValueCaches
+**
+** Frees all values cached for vendor parameters registered with a time to live
+** NOTE: The hit statistics are retained
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void FlushValueCaches(void)
+{
+    int i;
+    int j;
+    dm_value_cache_t *vc;
+
+    for (i=0; i < num_value_cached_nodes; i++)
+    {
+        vc = value_cached_nodes[i]->registered.param_info.value_cache;
+        for (j=0; j < vc->num_entries; j++)
+        {
+            USP_FREE(vc->vector[j].value);
+        }
+
+        USP_SAFE_FREE(vc->vector);
+        vc->num_entries = 0;
+        vc->max_entries = 0;
+    }
+}
+
+/*********************************************************************//**
+**
+** GetParentObjectNode
+**
+** Returns the node representing the parent object of the specified parameter
+**
+** \param   path - data model path of the parameter
+**
+** \return  pointer to node representing the parent object, or NULL if it could not be found
+**
+**************************************************************************/
+dm_node_t *GetParentObjectNode(char *path)
+{
+    dm_node_t *node;
+    dm_instances_t inst;
+    bool is_qualified_instance;
+    char parent_path[MAX_DM_PATH];
+    char *p;
+
+    // Exit if the path has no parent
+    USP_STRNCPY(parent_path, path, sizeof(parent_path));
+    p = strrchr(parent_path, '.');
+    if (p == NULL)
+    {
+        return NULL;
+    }
+    *p = '\0';
+
+    // Exit if the parent is not an object
+    node = DM_PRIV_GetNodeFromPath(parent_path, &inst, &is_qualified_instance);
+    if ((node == NULL) || (IsObject(node) == false))
+    {
+        return NULL;
+    }
+
+    return node;
+}
+
 /*********************************************************************//**
 **
 ** FormInstanceString
@@ -3192,16 +4032,38 @@ dm_node_t *CreateNode(char *name, dm_node_type_t type, char *schema_path)
     node_lookup_t *nl;
     dm_hash_t hash;
     int size;
+    int name_len;
+    int path_len;
     
-    // Allocate memory for the node
-    node = USP_MALLOC(sizeof(dm_node_t));
+    // Determine whether the name of the node can share the tail of the schema path string
+    // NOTE: This is not the case for multi-instance objects, as their schema path ends in '{i}'
+    name_len = strlen(name);
+    path_len = strlen(schema_path);
+    size = sizeof(dm_node_t) + path_len + 1;
+    if ((path_len < name_len) || (strcmp(&schema_path[path_len-name_len], name) != 0))
+    {
+        size += name_len + 1;
+    }
+
+    // Allocate memory for the node, and its path string (stored immediately after the node)
+    node = SchemaPoolAlloc(size);
     memset(node, 0, sizeof(dm_node_t));     // NOTE: All roles start from zero permissions
 
     node->link.next = NULL;
     node->link.prev = NULL;
     node->type = type;
-    node->name = USP_STRDUP(name);
-    node->path = USP_STRDUP(schema_path);
+    node->path = (char *) &node[1];
+    memcpy(node->path, schema_path, path_len+1);
+    if (size == sizeof(dm_node_t) + path_len + 1)
+    {
+        node->name = &node->path[path_len-name_len];
+    }
+    else
+    {
+        node->name = &node->path[path_len+1];
+        memcpy(node->name, name, name_len+1);
+    }
+    node->instance_nodes = no_instance_nodes;
     DLLIST_Init(&node->child_nodes);
 
     // Calculate hash of node (for use in database lookups) if node is a DB parameter
@@ -3225,7 +4087,7 @@ dm_node_t *CreateNode(char *name, dm_node_type_t type, char *schema_path)
 
         // Append hash to node lookup
         size = (node_lookup_count+1) * sizeof(node_lookup_t);
-        node_lookup = USP_REALLOC(node_lookup, size);
+        node_lookup = USP_REALLOC_GEOMETRIC(node_lookup, size);
 
         nl = &node_lookup[node_lookup_count];
         nl->hash = node->hash;
@@ -3785,10 +4647,14 @@ void DestroySchemaRecursive(dm_node_t *parent)
             USP_FREE(parent->registered.param_info.default_value);
             break;
 
+        case kDMNodeType_VendorParam_ReadOnly:
+            // NOTE: The cached values should already have been freed by the time this function is called
+            USP_SAFE_FREE(parent->registered.param_info.value_cache);
+            break;
+
         default:
         case kDMNodeType_Param_NumEntries:
         case kDMNodeType_Object_SingleInstance:
-        case kDMNodeType_VendorParam_ReadOnly:
         case kDMNodeType_VendorParam_ReadWrite:
         case kDMNodeType_Event:
             // These types of nodes do not allocate anything extra in the 'registered' union
@@ -3806,10 +4672,77 @@ void DestroySchemaRecursive(dm_node_t *parent)
             break;
     }
 
-    // Finally free this node itself
-    USP_FREE(parent->path);
-    USP_FREE(parent->name);    
-    USP_FREE(parent);    
+    // NOTE: The node itself (and its path and name) is freed along with the rest of the schema pool, by SchemaPoolDestroy()
+}
+
+/*********************************************************************//**
+**
+** SchemaPoolAlloc
+**
+** Allocates a block of memory from the schema pool
+** NOTE: Memory allocated by this function cannot be freed individually, only all at once by SchemaPoolDestroy()
+**
+** \param   size - number of bytes to allocate
+**
+** \return  pointer to allocated memory (aligned to SCHEMA_ALIGN)
+**
+**************************************************************************/
+void *SchemaPoolAlloc(int size)
+{
+    schema_chunk_t *chunk;
+    int chunk_size;
+    char *ptr;
+
+    size = SCHEMA_ROUND_UP(size);
+
+    // Allocate a new chunk, if there is not enough space left in the current chunk
+    chunk = schema_pool;
+    if ((chunk == NULL) || (chunk->used + size > chunk->size))
+    {
+        chunk_size = SCHEMA_CHUNK_SIZE;
+        if (size > chunk_size)
+        {
+            chunk_size = size;
+        }
+
+        chunk = USP_MALLOC(SCHEMA_ROUND_UP(sizeof(schema_chunk_t)) + chunk_size);
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        chunk->next = schema_pool;
+        schema_pool = chunk;
+    }
+
+    ptr = SCHEMA_CHUNK_DATA(chunk) + chunk->used;
+    chunk->used += size;
+
+    return ptr;
+}
+
+/*********************************************************************//**
+**
+** SchemaPoolDestroy
+**
+** Frees all memory allocated from the schema pool (ie all data model nodes)
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void SchemaPoolDestroy(void)
+{
+    schema_chunk_t *chunk;
+    schema_chunk_t *next_chunk;
+
+    chunk = schema_pool;
+    while (chunk != NULL)
+    {
+        next_chunk = chunk->next;
+        USP_FREE(chunk);
+        chunk = next_chunk;
+    }
+
+    schema_pool = NULL;
 }
 
 /*********************************************************************//**
@@ -109,6 +109,7 @@ typedef struct
 {
     dm_instances_t *vector;
     int num_entries;
+    unsigned generation;    // Incremented whenever an instance is added to or removed from this vector. Allows cached state derived from the instances to be invalidated
 } dm_instances_vector_t;
 
 //-----------------------------------------------------------------------------------------
@@ -123,6 +124,7 @@ typedef struct
     dm_set_value_cb_t set_cb;
     unsigned type_flags;                  // type of the parameter
     struct dm_node_tag *table_node;       // database node representing the table which we need to get the number of entries in (for kDMNodeType_Param_NumEntries)
+    struct dm_value_cache_tag *value_cache; // Values previously returned by get_cb, which may be reused until they expire. NULL if the parameter's values are not cached (see USP_REGISTER_VendorParam_ReadOnlyCached)
 } dm_param_info_t;
 
 // Information registered in the data model for objects
@@ -136,6 +138,8 @@ typedef struct
     dm_notify_del_cb_t   notify_del_cb;
     dm_unique_key_vector_t unique_keys;
     dm_instances_vector_t inst_vector;
+    dm_get_group_cb_t    get_group_cb;      // Callback to get the values of all vendor parameters in an instance of this object at once. NULL if not registered
+    dm_set_group_cb_t    set_group_cb;      // Callback to apply all vendor parameters set in an instance of this object at once, when the transaction is committed. NULL if not registered
 } dm_object_info_t;
 
 // Information registered in the data model for operations
@@ -165,12 +169,15 @@ typedef int dm_hash_t;
 
 //-----------------------------------------------------------------------------------------
 // Structure describing each data model node
+// NOTE: Nodes are allocated from a schema pool (see SchemaPoolAlloc) together with their path string. They are never freed individually.
 typedef struct dm_node_tag
 {
     double_link_t link;         // Link to siblings in the data model tree
     char *path;                 // Schema path for this node. Used for debug, passed to the vendor hooks and with GetSupportedDM
+                                // NOTE: Stored immediately after the node structure, in the same allocation
 
     char *name;                 // Part of the path that this node implements
+                                // NOTE: Points into the tail of the path string, unless the node is a multi-instance object
     dm_node_type_t type;
     double_linked_list_t child_nodes;
 
@@ -182,7 +189,8 @@ typedef struct dm_node_tag
                                  // 'Device.Wifi.{i}.Interface' in the instance_nodes[] array
                                  // For nodes which are objects, if the node is a multi-instance object, then 
                                  // it's instance separator is included e.g. Device.Wifi.{i}.Interface.{i} would have an order of 2
-    struct dm_node_tag *instance_nodes[MAX_DM_INSTANCE_ORDER]; // See 'order' above
+    struct dm_node_tag **instance_nodes;   // See 'order' above. Array of 'order' entries.
+                                           // NOTE: Only multi-instance objects own an array, all other nodes share the array of their parent
 
     unsigned short permissions[kCTrustRole_Max];    // Bitmask of permissions for each role
 
@@ -190,7 +198,7 @@ typedef struct dm_node_tag
     {
         dm_param_info_t  param_info;                    // Parameters
         dm_object_info_t object_info;                   // Objects
-                                                        // NOTE: kDMNodeType_Object_SingleInstance have no entry in this union
+                                                        // NOTE: kDMNodeType_Object_SingleInstance only use get_group_cb and set_group_cb in this union
         dm_oper_info_t   oper_info;                     // Operations
         dm_event_info_t  event_info;                    // Events
     } registered;
@@ -204,6 +212,10 @@ extern vendor_hook_cb_t vendor_hook_callbacks;
 // Boolean that allows us to control which scope the USP_REGISTER_XXX() functions can be called in
 extern bool is_executing_within_dm_init;
 
+//------------------------------------------------------------------------------
+// Boolean set if any object has registered a group get callback. If not set, then there is no need to cache the values returned by them
+extern bool is_group_get_registered;
+
 //------------------------------------------------------------------------------
 // Data model path to parameter recording the cause of the last reset (Internal.Reboot.Cause)
 extern char *reboot_cause_path;
@@ -242,6 +254,15 @@ extern char *reboot_cause_path;
 #define SHOW_PASSWORD 0x00000001        // Used internally by USP Agent to get the actual value of passwords (default behaviour is to return an empty string)
 #define JSON_FORMAT   0x00000002        // Used internally by USP Agent to get the value in JSON format (if the parameter's type is a string or dateTime, then the value is quoted and escaped)
 
+//------------------------------------------------------------------------------
+// Structure containing the type of a parameter and, if available, its value in native form (see DATA_MODEL_GetTypedParameterValue)
+typedef struct dm_typed_value_tag
+{
+    unsigned type_flags;        // Type of the parameter (eg DM_STRING, DM_UINT)
+    bool is_native;             // Set if val_union contains the value of the parameter. Only set for non-string parameters whose value was obtained natively (eg returned by the vendor in req->val_union)
+    dm_val_union_t val_union;   // Native value of the parameter. Only valid if is_native is set
+} dm_typed_value_t;
+
 //------------------------------------------------------------------------------
 // Definitions for flags in DATA_MODEL_SetParameterValue()
 #define CHECK_WRITABLE 0x00000001   // Prevents read only parameters being written by a controller
@@ -278,6 +299,11 @@ int DATA_MODEL_GetPermissions(char *path, combined_role_t *combined_role, unsign
 int DATA_MODEL_NotifyInstanceAdded(char *path);
 int DATA_MODEL_NotifyInstanceDeleted(char *path);
 int DATA_MODEL_GetParameterValue(char *path, char *buf, int len, unsigned flags);
+int DATA_MODEL_GetTypedParameterValue(char *path, char *buf, int len, unsigned flags, dm_typed_value_t *tv);
+int DATA_MODEL_GetGroupParameterValues(char *path, kv_vector_t *params);
+bool DATA_MODEL_IsGroupParameter(char *path);
+void DATA_MODEL_StartGroupGetCache(void);
+void DATA_MODEL_StopGroupGetCache(void);
 int DATA_MODEL_SetParameterValue(char *path, char *new_value, unsigned flags);
 int DATA_MODEL_Operate(char *path, kv_vector_t *input_args, kv_vector_t *output_args, char *command_key, int *instance);
 int DATA_MODEL_ShouldOperationRestart(char *path, int instance, bool *is_restart, int *err_code, char *err_msg, int err_msg_len, kv_vector_t *output_args);
@@ -291,6 +317,7 @@ int DATA_MODEL_GetUniqueKeys(char *path, dm_unique_key_vector_t *ukv);
 int DATA_MODEL_GetUniqueKeyParams(char *obj_path, kv_vector_t *params, combined_role_t *combined_role);
 void DATA_MODEL_DumpSchema(void);
 void DATA_MODEL_DumpInstances(void);
+void DATA_MODEL_DumpValueCaches(void);
 int DATA_MODEL_SetParameterInDatabase(char *path, char *value);
 
 int DM_PRIV_InitSetRequest(dm_req_t *req, dm_node_t *node, char *path, dm_instances_t *inst, char *new_value);
@@ -305,6 +332,7 @@ void DM_PRIV_AddUniqueKey(dm_node_t *node, dm_unique_key_t *unique_key);
 void DM_PRIV_ApplyPermissions(dm_node_t *node, ctrust_role_t role, unsigned short permission_bitmask);
 unsigned short DM_PRIV_GetPermissions(dm_node_t *node, combined_role_t *combined_role);
 int DM_PRIV_ReRegister_DBParam_Default(char *path, char *value);
+void DM_PRIV_AddValueCache(dm_node_t *node, unsigned ttl);
 
 #endif
 
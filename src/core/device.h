@@ -48,6 +48,7 @@
 #include "usp_api.h"
 #include "subs_vector.h"
 #include "mtp_exec.h"
+#include "bdc_exec.h"
 #include "subs_vector.h"
 #include "usp-msg.pb-c.h"
 
@@ -98,6 +99,7 @@ int DEVICE_CONTROLLER_Init(void);
 int DEVICE_CONTROLLER_Start(void);
 void DEVICE_CONTROLLER_Stop(void);
 int DEVICE_CONTROLLER_FindInstanceByEndpointId(char *endpoint_id);
+bool DEVICE_CONTROLLER_IsInboundMessageAllowed(char *endpoint_id);
 int DEVICE_CONTROLLER_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, char *endpoint_id, unsigned char *pbuf, int pbuf_len, char *stomp_dest, int stomp_instance);
 char *DEVICE_CONTROLLER_FindEndpointIdByInstance(int instance);
 int DEVICE_CONTROLLER_GetCombinedRole(int instance, combined_role_t *combined_role);
@@ -117,7 +119,7 @@ int DEVICE_STOMP_Init(void);
 int DEVICE_STOMP_Start(void);
 void DEVICE_STOMP_Stop(void);
 int DEVICE_STOMP_StartAllConnections(void);
-int DEVICE_STOMP_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, int instance, char *controller_queue, char *agent_queue, unsigned char *pbuf, int pbuf_len);
+int DEVICE_STOMP_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, char *endpoint_id, int instance, char *controller_queue, char *agent_queue, unsigned char *pbuf, int pbuf_len);
 void DEVICE_STOMP_ScheduleReconnect(int instance);
 mtp_status_t DEVICE_STOMP_GetMtpStatus(int instance);
 int DEVICE_STOMP_CountEnabledConnections(void);
@@ -158,7 +160,7 @@ int DEVICE_REQUEST_PersistOperationArgs(int instance, kv_vector_t *args, char *p
 int DEVICE_BULKDATA_Init(void);
 int DEVICE_BULKDATA_Start(void);
 void DEVICE_BULKDATA_Stop(void);
-void DEVICE_BULKDATA_NotifyTransferResult(int profile_id, bool transfer_result);
+void DEVICE_BULKDATA_NotifyTransferResult(int profile_id, bool transfer_result, bdc_transfer_stats_t *stats);
 #ifndef REMOVE_SELF_TEST_DIAG_EXAMPLE
 int DEVICE_SELF_TEST_Init(void);
 #endif
@@ -42,6 +42,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <math.h>
 #include <zlib.h>
 
@@ -51,22 +52,29 @@
 #include "msg_handler.h"
 #include "path_resolver.h"
 #include "dm_access.h"
-#include "json.h"
+#include "json_writer.h"
+#include "csv_writer.h"
 #include "sync_timer.h"
 #include "iso8601.h"
 #include "text_utils.h"
 #include "retry_wait.h"
 #include "bdc_exec.h"
+#include "dm_inst_vector.h"
+#include "uptime.h"
+#include "bulkdata_spool.h"
 
 //------------------------------------------------------------------------------
 // String versions of defines in vendor_defs.h
 #define BULKDATA_MAX_PROFILES_STR  TO_STR(BULKDATA_MAX_PROFILES)
+#define BULKDATA_DEFAULT_FULL_REPORT_INTERVAL_STR  TO_STR(BULKDATA_DEFAULT_FULL_REPORT_INTERVAL)
 #define BULKDATA_MINIMUM_REPORTING_INTERVAL_STR      TO_STR(BULKDATA_MINIMUM_REPORTING_INTERVAL)
 
 //------------------------------------------------------------------------------
 // Definitions for formats that we support
 #define BULKDATA_PROTOCOL "HTTP"
-#define BULKDATA_ENCODING_TYPE "JSON"
+#define BULKDATA_ENCODING_TYPE_JSON "JSON"
+#define BULKDATA_ENCODING_TYPE_CSV  "CSV"
+#define BULKDATA_ENCODING_TYPES_SUPPORTED BULKDATA_ENCODING_TYPE_JSON "," BULKDATA_ENCODING_TYPE_CSV
 #define BULKDATA_JSON_REPORT_FORMAT "NameValuePair"
 
 
@@ -75,6 +83,16 @@
 #define BULKDATA_JSON_TIMESTAMP_FORMAT_ISO8601 "ISO-8601"
 #define BULKDATA_JSON_TIMESTAMP_FORMAT_NONE    "None"
 
+// Definitions for Device.BulkData.Profile.{i}.CSVEncoding
+// NOTE: The separators and escape character are specified using XML character references in the data model (eg "&#13;&#10;" for CRLF)
+// NOTE: RowTimestamp takes the same values as Device.BulkData.Profile.{i}.JSONEncoding.ReportTimestamp
+#define BULKDATA_CSV_REPORT_FORMAT_PER_ROW      "ParameterPerRow"
+#define BULKDATA_CSV_REPORT_FORMAT_PER_COLUMN   "ParameterPerColumn"
+#define BULKDATA_CSV_DEFAULT_FIELD_SEPARATOR    ","
+#define BULKDATA_CSV_DEFAULT_ROW_SEPARATOR      "&#13;&#10;"
+#define BULKDATA_CSV_DEFAULT_ESCAPE_CHARACTER   "&quot;"
+#define MAX_CSV_SEPARATOR_LEN 4     // Maximum number of characters in a separator or escape character, once character references have been decoded
+
 // Definitions for Device.BulkData.Profile.{i}.HTTP.Method
 #define BULKDATA_HTTP_METHOD_POST       "POST"
 #define BULKDATA_HTTP_METHOD_PUT        "PUT"
@@ -86,9 +104,50 @@
 typedef struct
 {
     time_t collection_time;     // time at which the report was collected
-    kv_vector_t  report_map;    // Map containing parameter path vs JSON type+parameter value
+    kv_vector_t  report_map;    // Map containing parameter path vs type+parameter value
 } report_t;
 
+//---------------------------------------------------------------------------------------------
+// Structure representing a parameter to collect, in the collection plan of a profile
+typedef struct
+{
+    char *path;                 // Instantiated data model path of the parameter
+    char *report_name;          // Name of the parameter in the report (reduced using the alternative name, if one was specified)
+    char type;                  // Letter code denoting the type of the parameter (see bulkdata_platform_get_parameter_type)
+    bool is_grouped;            // Set if the value of the parameter is obtained (with its siblings) from its parent object's group get callback
+} collection_item_t;
+
+//---------------------------------------------------------------------------------------------
+// Structure recording the generation of the instances of a table which a profile's parameter references may expand into
+typedef struct
+{
+    dm_node_t *node;            // Top level multi-instance object, which holds the instances of the table (and all tables nested within it)
+    unsigned generation;        // Generation count of the instances, when the collection plan was built
+} collection_table_t;
+
+//---------------------------------------------------------------------------------------------
+// Structure representing the collection plan of a profile
+// This caches the result of resolving the profile's parameter references, so that it does not have to be recalculated every reporting interval
+// The plan is rebuilt if the profile's parameter references change, or if instances are added to or deleted from any of the tables that they reference
+typedef struct
+{
+    bool is_valid;              // Set if the plan has been built, and the profile's parameter references have not changed since
+    collection_item_t *items;   // Array of parameters to collect, in the order they appear in the report
+    int num_items;
+    collection_table_t *tables; // Array of tables which the parameter references may expand into
+    int num_tables;
+} collection_plan_t;
+
+//---------------------------------------------------------------------------------------------
+// Statistics about the last completed collection of a profile (Device.BulkData.Profile.{i}.X_ARRIS-COM_LastCollection*)
+typedef struct
+{
+    unsigned duration;          // Time (in ms) from the start of collection, to the end of collection. Includes time spent waiting for other profiles to collect
+    unsigned busy_time;         // Time (in ms) spent collecting parameters on the data model thread
+    unsigned num_params;        // Number of parameters in the collection plan
+    unsigned num_slices;        // Number of data model thread loop iterations that the collection was spread over
+} collection_stats_t;
+
 //---------------------------------------------------------------------------------------------
 // Structure representing enabled profiles
 typedef struct
@@ -105,14 +164,52 @@ typedef struct
     unsigned retry_interval_multiplier;
 
     // The following variables are only used when the profile is started (ie enabled)
-    report_t reports[BULKDATA_MAX_RETAINED_FAILED_REPORTS+1]; // Plus 1 because this array includes failed reports + current report
-    int num_retained_reports;
+    report_t *reports;              // Reports contained in the report being generated. This is only ever the report just collected, as failed reports are retained (in their encoded form) in the spool
+    int num_reports;
+    bulkdata_spool_t spool;         // Spool containing the reports which have failed to be sent, oldest first
+    int max_retained_reports;       // Maximum number of failed reports to retain in the spool (from NumberOfRetainedFailedReports)
+    collection_plan_t plan;         // Cached collection plan, containing the resolved parameters to collect
+
+    // State of the collection in progress. Parameters are collected BULKDATA_COLLECTION_SLICE_SIZE at a time, so that the data model thread is not stalled
+    bool is_collecting;             // Set from the reporting instant, until all parameters in the plan have been collected
+    report_t collecting_report;     // Report being collected. Only referenced by reports once collection has completed
+    int collection_index;           // Index of the next parameter in the plan to collect
+    unsigned collection_start;      // Uptime (in ms) at which collection started (ie the reporting instant)
+    unsigned collection_busy_time;  // Time (in ms) spent collecting slices so far
+    unsigned collection_slices;     // Number of slices collected so far
+    char *group_path;               // Path of the object instance whose parameter values are cached in group_values, or NULL if none are cached
+    kv_vector_t group_values;       // Values of the parameters in the object instance, obtained from its group get callback during this collection
+    collection_stats_t last_collection;
+
+    // State of the report being sent by the BDC thread
+    bool is_sending;                // Set whilst the BDC thread is sending a report for this profile
+    bool is_sending_spooled;        // Set if the report being sent is from the spool
+    unsigned sending_seq;           // Sequence number (in the spool) of the report being sent, if it is from the spool
+    unsigned char *sending_report;  // Copy of the report being sent (if it is not from the spool), so that it can be spooled if it fails to send. NULL if it is not to be retained
+    int sending_report_len;
+    unsigned sending_report_flags;
+    bdc_transfer_stats_t last_transfer;     // Timings of the last attempt to send a report to the BDC server
     unsigned retry_count;           // Number of failed attempts. Count of what the next retry attempt will be. After a failed send, this starts counting from 1.
+
+    // State of delta reports (X_ARRIS-COM_DeltaReports)
+    // Delta reports only contain the parameters which have changed since the last report which was successfully delivered
+    bool delta_valid;               // Set if delta_values contains the values of the last report generated (so the next report may be a delta report)
+    kv_vector_t delta_values;       // Values of all parameters in the last report generated
+    kv_vector_t delta_undelivered;  // Parameters contained in the last report generated, if it has not been delivered yet
+    bool delta_full_undelivered;    // Set if the last report generated was a full report, and it has not been delivered yet
+    unsigned delta_count;           // Number of delta reports generated since the last full report
 } bulkdata_profile_t;
 
 //---------------------------------------------------------------------------------------------
 // Bulkdata library global context
-static bulkdata_profile_t bulkdata_profiles[BULKDATA_MAX_PROFILES];
+// Profiles are dynamically allocated, and held in an array sorted by instance number (profile_id), so that they can be found using a binary search
+static bulkdata_profile_t **bulkdata_profiles = NULL;
+static int num_bulkdata_profiles = 0;
+
+//---------------------------------------------------------------------------------------------
+// Profile which is currently collecting its parameters, or NULL if none is
+// Only one profile collects at a time. Other profiles which reach their reporting instant wait until it has finished
+static bulkdata_profile_t *collecting_profile = NULL;
 
 //---------------------------------------------------------------------------------------------
 // Structure containing retrieved controlling parameters for a specific profile
@@ -120,15 +217,34 @@ static bulkdata_profile_t bulkdata_profiles[BULKDATA_MAX_PROFILES];
 typedef struct
 {
     int num_retained_failed_reports;
-    char report_timestamp[33];
+    char encoding_type[5];
+    char report_timestamp[33];      // From JSONEncoding.ReportTimestamp or CSVEncoding.RowTimestamp, depending on the encoding type
+    char csv_report_format[19];
+    char csv_field_separator[MAX_CSV_SEPARATOR_LEN+1];   // Decoded from the XML character references in the data model
+    char csv_row_separator[MAX_CSV_SEPARATOR_LEN+1];
+    char csv_escape_char[MAX_CSV_SEPARATOR_LEN+1];
     char url[1025];
     char username[257];
     char password[257];
     char compression[9];
     char method[9];
     bool use_date_header;
+    bool delta_reports;             // From X_ARRIS-COM_DeltaReports
+    unsigned full_report_interval;  // From X_ARRIS-COM_FullReportInterval
 } profile_ctrl_params_t;
 
+//---------------------------------------------------------------------------------------------
+// State of a report which is being compressed as it is generated
+typedef struct
+{
+    z_stream zlib_ctx;          // zlib deflate state
+    unsigned char *buf;         // Buffer containing the compressed report so far
+    int max_len;                // Number of bytes allocated to the buffer
+} report_compressor_t;
+
+// Initial size of the buffer containing a compressed report. The buffer doubles in size, as necessary, whilst the report is generated
+#define COMPRESSED_REPORT_INITIAL_SIZE  4096
+
 //------------------------------------------------------------------------------
 // Global enable for all collection profiles (Device.BulkData.Enable)
 static bool global_enable = false;
@@ -158,10 +274,14 @@ int Validate_BulkDataReportingInterval(dm_req_t *req, char *value);
 int Validate_BulkDataReference(dm_req_t *req, char *value);
 int Validate_BulkDataReportFormat(dm_req_t *req, char *value);
 int Validate_BulkDataReportTimestamp(dm_req_t *req, char *value);
+int Validate_BulkDataCSVReportFormat(dm_req_t *req, char *value);
+int Validate_BulkDataCSVSeparator(dm_req_t *req, char *value);
+int Validate_BulkDataCSVEscapeCharacter(dm_req_t *req, char *value);
 int Validate_BulkDataCompression(dm_req_t *req, char *value);
 int Validate_BulkDataHTTPMethod(dm_req_t *req, char *value);
 int Validate_BulkDataRetryMinimumWaitInterval(dm_req_t *req, char *value);
 int Validate_BulkDataRetryIntervalMultiplier(dm_req_t *req, char *value);
+int Validate_BulkDataFullReportInterval(dm_req_t *req, char *value);
 int NotifyChange_BulkDataGlobalEnable(dm_req_t *req, char *value);
 int NotifyChange_BulkDataProfileEnable(dm_req_t *req, char *value);
 int NotifyChange_BulkDataReportingInterval(dm_req_t *req, char *value);
@@ -171,30 +291,74 @@ int NotifyChange_BulkDataRetryMinimumWaitInterval(dm_req_t *req, char *value);
 int NotifyChange_BulkDataRetryIntervalMultiplier(dm_req_t *req, char *value);
 int Notify_BulkDataProfileAdded(dm_req_t *req);
 int Notify_BulkDataProfileDeleted(dm_req_t *req);
+int NotifyChange_BulkDataParameter(dm_req_t *req, char *value);
+int Notify_BulkDataParameterAdded(dm_req_t *req);
+int Notify_BulkDataParameterDeleted(dm_req_t *req);
 int Get_BulkDataGlobalStatus(dm_req_t *req, char *buf, int len);
 int Get_BulkDataProfileStatus(dm_req_t *req, char *buf, int len);
+int Get_BulkDataLastCollectionDuration(dm_req_t *req, char *buf, int len);
+int Get_BulkDataLastCollectionBusyTime(dm_req_t *req, char *buf, int len);
+int Get_BulkDataLastCollectionParameters(dm_req_t *req, char *buf, int len);
+int Get_BulkDataLastCollectionSlices(dm_req_t *req, char *buf, int len);
+int Get_BulkDataLastConnectTime(dm_req_t *req, char *buf, int len);
+int Get_BulkDataLastTLSTime(dm_req_t *req, char *buf, int len);
+int Get_BulkDataLastTransferTime(dm_req_t *req, char *buf, int len);
+int Get_BulkDataLastConnectionReused(dm_req_t *req, char *buf, int len);
+int Get_BulkDataRetainedReports(dm_req_t *req, char *buf, int len);
 int ProcessBulkDataProfileAdded(int instance);
 void ProcessBulkDataProfileDeleted(bulkdata_profile_t *bp);
 int bulkdata_stop_profile(bulkdata_profile_t *bp);
 void bulkdata_process_profile(int id);
 void bulkdata_process_profile_work(bulkdata_profile_t *bp);
-bulkdata_profile_t *bulkdata_find_free_profile(void);
 bulkdata_profile_t *bulkdata_find_profile(int profile_id);
-int bulkdata_calc_report_map(bulkdata_profile_t *bp, kv_vector_t *report_map);
-int bulkdata_append_to_result_map(char *origin_path, char *alt_name, kv_vector_t *param_values, kv_vector_t *report_map);
+int bulkdata_find_profile_index(int profile_id);
+void bulkdata_insert_profile(bulkdata_profile_t *bp);
+void bulkdata_remove_profile(bulkdata_profile_t *bp);
+int bulkdata_start_collection(bulkdata_profile_t *bp);
+bool bulkdata_collect_slice(bulkdata_profile_t *bp);
+int bulkdata_get_group_parameter_value(bulkdata_profile_t *bp, char *path, char *buf, int len);
+void bulkdata_clear_group_values(bulkdata_profile_t *bp);
+void bulkdata_finish_collection(bulkdata_profile_t *bp);
+void bulkdata_abort_collection(bulkdata_profile_t *bp);
+void bulkdata_release_collection(bulkdata_profile_t *bp);
+int bulkdata_build_plan(int profile_id, collection_plan_t *plan);
+void bulkdata_append_to_plan(char *origin_path, char *alt_name, str_vector_t *params, collection_plan_t *plan);
+void bulkdata_add_plan_tables(char *origin_path, collection_plan_t *plan);
+void bulkdata_add_plan_child_tables(dm_node_t *node, collection_plan_t *plan);
+void bulkdata_add_plan_table(dm_node_t *top_node, collection_plan_t *plan);
+bool bulkdata_is_plan_valid(collection_plan_t *plan);
+void bulkdata_invalidate_plan(int profile_id);
+void bulkdata_destroy_plan(collection_plan_t *plan);
 int bulkdata_reduce_to_alt_name(char *spec, char *path, char *alt_name, char *out_buf, int buf_len);
-char *bulkdata_generate_json_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl);
-unsigned char *bulkdata_compress_report(profile_ctrl_params_t *ctrl, char *input_buf, int input_len, int *p_output_len);
-int bulkdata_schedule_sending_report(profile_ctrl_params_t *ctrl, bulkdata_profile_t *bp, unsigned char *json_report, int report_len);
+unsigned char *bulkdata_generate_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, int *p_report_len);
+void bulkdata_write_json_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, json_writer_t *jw);
+void bulkdata_write_csv_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, csv_writer_t *cw);
+void bulkdata_write_csv_report_per_row(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, csv_writer_t *cw);
+void bulkdata_write_csv_report_per_column(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, csv_writer_t *cw);
+void bulkdata_add_csv_timestamp_field(profile_ctrl_params_t *ctrl, report_t *report, csv_writer_t *cw);
+char *bulkdata_get_csv_type_name(char type);
+bool bulkdata_is_json_integer(char *value);
+int bulkdata_decode_csv_characters(char *value, char *buf, int len);
+unsigned char *bulkdata_generate_compressed_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, int *p_report_len);
+int bulkdata_compress_chunk(char *buf, int len, void *arg);
+int bulkdata_deflate(report_compressor_t *rc, int flush);
+int bulkdata_schedule_sending_report(profile_ctrl_params_t *ctrl, bulkdata_profile_t *bp, unsigned char *report, int report_len, unsigned flags);
 int bulkdata_start_profile(bulkdata_profile_t *bp);
 int bulkdata_resync_profile(bulkdata_profile_t *bp, int *delta_time);
 unsigned bulkdata_calc_waittime_to_next_send(bulkdata_profile_t *bp);
 unsigned bulkdata_calc_waittime_to_next_reporting_interval(time_t interval, time_t time_reference);
-void bulkdata_clear_retained_reports(bulkdata_profile_t *bp);
-void bulkdata_drop_oldest_retained_reports(bulkdata_profile_t *bp, int num_reports_to_keep);
+void bulkdata_clear_reports(bulkdata_profile_t *bp);
+void bulkdata_send_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, unsigned char *report, int report_len, unsigned flags);
+void bulkdata_send_next_spooled_report(bulkdata_profile_t *bp);
+void bulkdata_retain_failed_report(bulkdata_profile_t *bp);
+void bulkdata_free_sending_report(bulkdata_profile_t *bp);
+unsigned bulkdata_calc_report_flags(profile_ctrl_params_t *ctrl);
+unsigned bulkdata_reduce_to_delta_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, kv_vector_t *report_map);
+void bulkdata_clear_delta_state(bulkdata_profile_t *bp);
 int bulkdata_platform_get_uri_query_name_map(int profile_id, kv_vector_t *name_map);
 int bulkdata_platform_calc_uri_query_escaped_map(kv_vector_t *name_map, kv_vector_t *escaped_map);
 char *bulkdata_platform_calc_uri_query_string(kv_vector_t *escaped_map);
+int bulkdata_platform_get_csv_control_params(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl_params);
 
 
 /*********************************************************************//**
@@ -210,17 +374,11 @@ char *bulkdata_platform_calc_uri_query_string(kv_vector_t *escaped_map);
 **************************************************************************/
 int DEVICE_BULKDATA_Init(void)
 {
-    int i;
     int err = USP_ERR_OK;
-    bulkdata_profile_t *bp;
 
-    // Initialise all profiles
-    memset(bulkdata_profiles, 0, sizeof(bulkdata_profiles));
-    for (i=0; i<BULKDATA_MAX_PROFILES; i++)
-    {
-        bp = &bulkdata_profiles[i];
-        bp->profile_id = INVALID;
-    }
+    // Start from no profiles
+    bulkdata_profiles = NULL;
+    num_bulkdata_profiles = 0;
 
     // Register data model elements implemented by this component
     // Device.BulkData.
@@ -228,7 +386,7 @@ int DEVICE_BULKDATA_Init(void)
     err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Status", Get_BulkDataGlobalStatus, DM_STRING);
     err |= USP_REGISTER_Param_Constant("Device.BulkData.MinReportingInterval", BULKDATA_MINIMUM_REPORTING_INTERVAL_STR, DM_UINT);
     err |= USP_REGISTER_Param_Constant("Device.BulkData.Protocols", BULKDATA_PROTOCOL, DM_STRING);
-    err |= USP_REGISTER_Param_Constant("Device.BulkData.EncodingTypes", BULKDATA_ENCODING_TYPE, DM_STRING);
+    err |= USP_REGISTER_Param_Constant("Device.BulkData.EncodingTypes", BULKDATA_ENCODING_TYPES_SUPPORTED, DM_STRING);
     err |= USP_REGISTER_Param_Constant("Device.BulkData.ParameterWildCardSupported", "true", DM_BOOL);
     err |= USP_REGISTER_Param_Constant("Device.BulkData.MaxNumberOfProfiles", BULKDATA_MAX_PROFILES_STR, DM_INT);
     err |= USP_REGISTER_Param_Constant("Device.BulkData.MaxNumberOfParameterReferences", "-1", DM_INT);
@@ -240,29 +398,47 @@ int DEVICE_BULKDATA_Init(void)
     err |= USP_REGISTER_DBParam_Alias("Device.BulkData.Profile.{i}.Alias", NULL);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.Enable", "false", NULL, NotifyChange_BulkDataProfileEnable, DM_BOOL);
     err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_Status", Get_BulkDataProfileStatus, DM_STRING);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_LastCollectionDuration", Get_BulkDataLastCollectionDuration, DM_UINT);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_LastCollectionBusyTime", Get_BulkDataLastCollectionBusyTime, DM_UINT);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_LastCollectionParameters", Get_BulkDataLastCollectionParameters, DM_UINT);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_LastCollectionSlices", Get_BulkDataLastCollectionSlices, DM_UINT);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_LastConnectTime", Get_BulkDataLastConnectTime, DM_UINT);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_LastTLSTime", Get_BulkDataLastTLSTime, DM_UINT);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_LastTransferTime", Get_BulkDataLastTransferTime, DM_UINT);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_LastConnectionReused", Get_BulkDataLastConnectionReused, DM_BOOL);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.BulkData.Profile.{i}.X_ARRIS-COM_RetainedReports", Get_BulkDataRetainedReports, DM_UINT);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.Name", "", NULL, NULL, DM_STRING);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.NumberOfRetainedFailedReports", "0", Validate_NumberOfRetainedFailedReports, NULL, DM_INT);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.Protocol", BULKDATA_PROTOCOL, Validate_BulkDataProtocol, NULL, DM_STRING);
-    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.EncodingType", BULKDATA_ENCODING_TYPE, Validate_BulkDataEncodingType, NULL, DM_STRING);
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.EncodingType", BULKDATA_ENCODING_TYPE_JSON, Validate_BulkDataEncodingType, NULL, DM_STRING);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.ReportingInterval", "86400", Validate_BulkDataReportingInterval, NotifyChange_BulkDataReportingInterval, DM_UINT);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.TimeReference", UNKNOWN_TIME_STR, NULL, NotifyChange_BulkDataTimeReference, DM_DATETIME);
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.X_ARRIS-COM_DeltaReports", "false", NULL, NULL, DM_BOOL);
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.X_ARRIS-COM_FullReportInterval", BULKDATA_DEFAULT_FULL_REPORT_INTERVAL_STR, Validate_BulkDataFullReportInterval, NULL, DM_UINT);
 
     // Device.BulkData.Profile.{i}.Parameter.{i}
-    err |= USP_REGISTER_Object("Device.BulkData.Profile.{i}.Parameter.{i}", NULL, NULL, NULL,
-                                                                            NULL, NULL, NULL);
+    err |= USP_REGISTER_Object("Device.BulkData.Profile.{i}.Parameter.{i}", NULL, NULL, Notify_BulkDataParameterAdded,
+                                                                            NULL, NULL, Notify_BulkDataParameterDeleted);
     err |= USP_REGISTER_Param_NumEntries("Device.BulkData.Profile.{i}.ParameterNumberOfEntries", "Device.BulkData.Profile.{i}.Parameter.{i}");
-    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.Parameter.{i}.Name", "", NULL, NULL, DM_STRING);
-    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.Parameter.{i}.Reference", "", Validate_BulkDataReference, NULL, DM_STRING);
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.Parameter.{i}.Name", "", NULL, NotifyChange_BulkDataParameter, DM_STRING);
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.Parameter.{i}.Reference", "", Validate_BulkDataReference, NotifyChange_BulkDataParameter, DM_STRING);
 
     // Device.BulkData.Profile.{i}.JSONEncoding
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.JSONEncoding.ReportFormat", BULKDATA_JSON_REPORT_FORMAT, Validate_BulkDataReportFormat, NULL, DM_STRING);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.JSONEncoding.ReportTimestamp", BULKDATA_JSON_TIMESTAMP_FORMAT_EPOCH, Validate_BulkDataReportTimestamp, NULL, DM_STRING);
 
+    // Device.BulkData.Profile.{i}.CSVEncoding
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.CSVEncoding.FieldSeparator", BULKDATA_CSV_DEFAULT_FIELD_SEPARATOR, Validate_BulkDataCSVSeparator, NULL, DM_STRING);
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.CSVEncoding.RowSeparator", BULKDATA_CSV_DEFAULT_ROW_SEPARATOR, Validate_BulkDataCSVSeparator, NULL, DM_STRING);
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.CSVEncoding.EscapeCharacter", BULKDATA_CSV_DEFAULT_ESCAPE_CHARACTER, Validate_BulkDataCSVEscapeCharacter, NULL, DM_STRING);
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.CSVEncoding.ReportFormat", BULKDATA_CSV_REPORT_FORMAT_PER_COLUMN, Validate_BulkDataCSVReportFormat, NULL, DM_STRING);
+    err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.CSVEncoding.RowTimestamp", BULKDATA_JSON_TIMESTAMP_FORMAT_EPOCH, Validate_BulkDataReportTimestamp, NULL, DM_STRING);
+
     // Device.BulkData.Profile.{i}.HTTP
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.HTTP.URL", "", NULL, NULL, DM_STRING);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.HTTP.Username", "", NULL, NULL, DM_STRING);
     err |= USP_REGISTER_DBParam_Secure("Device.BulkData.Profile.{i}.HTTP.Password", "", NULL, NULL);
-    err |= USP_REGISTER_Param_Constant("Device.BulkData.Profile.{i}.HTTP.CompressionsSupported", "GZIP", DM_STRING);
+    err |= USP_REGISTER_Param_Constant("Device.BulkData.Profile.{i}.HTTP.CompressionsSupported", "GZIP,Deflate", DM_STRING);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.HTTP.Compression", "None", Validate_BulkDataCompression, NULL, DM_STRING);
     err |= USP_REGISTER_Param_Constant("Device.BulkData.Profile.{i}.HTTP.MethodsSupported", BULKDATA_HTTP_METHODS_SUPPORTED, DM_STRING);
     err |= USP_REGISTER_DBParam_ReadWrite("Device.BulkData.Profile.{i}.HTTP.Method", BULKDATA_HTTP_METHOD_POST, Validate_BulkDataHTTPMethod, NULL, DM_STRING);
@@ -360,17 +536,10 @@ exit:
 **************************************************************************/
 void DEVICE_BULKDATA_Stop(void)
 {
-    int i;
-    bulkdata_profile_t *bp;
-
-    // Iterate over all profiles, deleting them (this stops them, and frees dynamic memory associated with them)
-    for (i=0; i < BULKDATA_MAX_PROFILES; i++)
+    // Delete all profiles, starting from the last (this stops them, and frees dynamic memory associated with them)
+    while (num_bulkdata_profiles > 0)
     {
-        bp = &bulkdata_profiles[i];
-        if (bp->profile_id != INVALID)
-        {
-            ProcessBulkDataProfileDeleted(bp);
-        }
+        ProcessBulkDataProfileDeleted(bulkdata_profiles[num_bulkdata_profiles-1]);
     }
 }
 
@@ -384,11 +553,12 @@ void DEVICE_BULKDATA_Stop(void)
 **
 ** \param   profile_id - Instance number of profile in Device.Bulkdata.Profile.{i}
 ** \param   transfer_result - true if the report was sent successfully, false otherwise
+** \param   stats - pointer to timings of the transfer, or NULL if the report was not handed to the BDC thread
 **
 ** \return  None
 **
 **************************************************************************/
-void DEVICE_BULKDATA_NotifyTransferResult(int profile_id, bool transfer_result)
+void DEVICE_BULKDATA_NotifyTransferResult(int profile_id, bool transfer_result, bdc_transfer_stats_t *stats)
 {
     bulkdata_profile_t *bp;
     int err;
@@ -401,15 +571,49 @@ void DEVICE_BULKDATA_NotifyTransferResult(int profile_id, bool transfer_result)
     {
         return;
     }
-    
+
+    // Save the timings of the transfer, if the BDC thread attempted it
+    if (stats != NULL)
+    {
+        memcpy(&bp->last_transfer, stats, sizeof(bdc_transfer_stats_t));
+    }
+
+    // Exit if the profile was stopped whilst the report was being sent
+    // NOTE: If the report came from the spool, then it remains in the spool, and will be resent when the profile is restarted
+    if (bp->is_sending == false)
+    {
+        return;
+    }
+
     if (transfer_result == true)
     {
-        // Report(s) have been successfully sent, so don't retain them
-        bulkdata_clear_retained_reports(bp);
+        // Report has been successfully sent, so don't retain it
+        // NOTE: If the report was from the spool, it may have already been dropped from the spool, whilst it was being sent
+        if (bp->is_sending_spooled)
+        {
+            BULKDATA_SPOOL_Remove(&bp->spool, bp->sending_seq);
+        }
+        bulkdata_free_sending_report(bp);
+        bp->retry_count = 0;
+
+        // If there are no more reports waiting to be sent, then the last report generated has been delivered
+        // So the next delta report only needs to contain the parameters which have changed since it
+        if (bp->spool.num_entries == 0)
+        {
+            KV_VECTOR_Destroy(&bp->delta_undelivered);
+            bp->delta_full_undelivered = false;
+        }
+
+        // Send the next retained report (if there is one) immediately, otherwise restart the sync timer
+        bulkdata_send_next_spooled_report(bp);
+        return;
     }
     else
     {
+        // Report has not been sent successfully, so retain it in the spool (if it isn't already there)
         USP_LOG_Warning("BULK DATA: Failed to send report (profile_id=%d) on retry_count=%d", profile_id, bp->retry_count);
+        bulkdata_retain_failed_report(bp);
+        bulkdata_free_sending_report(bp);
         if (bp->retry_enable)
         {
             // Report(s) have not been sent successfully, so start the retry mechanism (or increment the retry_count, if it is already in progress)
@@ -526,9 +730,9 @@ int Validate_BulkDataProtocol(dm_req_t *req, char *value)
 int Validate_BulkDataEncodingType(dm_req_t *req, char *value)
 {
     // Exit if trying to set a value outside of the range we accept
-    if (strcmp(value, BULKDATA_ENCODING_TYPE) != 0)
+    if ((strcmp(value, BULKDATA_ENCODING_TYPE_JSON) != 0) && (strcmp(value, BULKDATA_ENCODING_TYPE_CSV) != 0))
     {
-        USP_ERR_SetMessage("%s: Only EncodingType supported is '%s'", __FUNCTION__, BULKDATA_ENCODING_TYPE);
+        USP_ERR_SetMessage("%s: EncodingType must be either '%s' or '%s'", __FUNCTION__, BULKDATA_ENCODING_TYPE_JSON, BULKDATA_ENCODING_TYPE_CSV);
         return USP_ERR_INVALID_VALUE;
     }
 
@@ -611,7 +815,7 @@ int Validate_BulkDataReportFormat(dm_req_t *req, char *value)
 **
 ** Validate_BulkDataReportTimestamp
 **
-** Validates Device.BulkData.Profile.{i}.JSONEncoding.ReportTimestamp
+** Validates Device.BulkData.Profile.{i}.JSONEncoding.ReportTimestamp and Device.BulkData.Profile.{i}.CSVEncoding.RowTimestamp
 **
 ** \param   req - pointer to structure identifying the parameter
 ** \param   value - value that the controller would like to set the parameter to
@@ -626,13 +830,92 @@ int Validate_BulkDataReportTimestamp(dm_req_t *req, char *value)
          (strcmp(value, BULKDATA_JSON_TIMESTAMP_FORMAT_ISO8601) != 0) &&
          (strcmp(value, BULKDATA_JSON_TIMESTAMP_FORMAT_NONE) != 0))
     {
-        USP_ERR_SetMessage("%s: ReportTimestamp must be one of '%s, '%s' or '%s'", __FUNCTION__, BULKDATA_JSON_TIMESTAMP_FORMAT_EPOCH, BULKDATA_JSON_TIMESTAMP_FORMAT_ISO8601, BULKDATA_JSON_TIMESTAMP_FORMAT_NONE);
+        USP_ERR_SetMessage("%s: Timestamp format must be one of '%s', '%s' or '%s'", __FUNCTION__, BULKDATA_JSON_TIMESTAMP_FORMAT_EPOCH, BULKDATA_JSON_TIMESTAMP_FORMAT_ISO8601, BULKDATA_JSON_TIMESTAMP_FORMAT_NONE);
+        return USP_ERR_INVALID_VALUE;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Validate_BulkDataCSVReportFormat
+**
+** Validates Device.BulkData.Profile.{i}.CSVEncoding.ReportFormat
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   value - value that the controller would like to set the parameter to
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Validate_BulkDataCSVReportFormat(dm_req_t *req, char *value)
+{
+    // Exit if trying to set a value outside of the range we accept
+    if ( (strcmp(value, BULKDATA_CSV_REPORT_FORMAT_PER_ROW) != 0) &&
+         (strcmp(value, BULKDATA_CSV_REPORT_FORMAT_PER_COLUMN) != 0))
+    {
+        USP_ERR_SetMessage("%s: CSV ReportFormat must be either '%s' or '%s'", __FUNCTION__, BULKDATA_CSV_REPORT_FORMAT_PER_ROW, BULKDATA_CSV_REPORT_FORMAT_PER_COLUMN);
+        return USP_ERR_INVALID_VALUE;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Validate_BulkDataCSVSeparator
+**
+** Validates Device.BulkData.Profile.{i}.CSVEncoding.FieldSeparator and Device.BulkData.Profile.{i}.CSVEncoding.RowSeparator
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   value - value that the controller would like to set the parameter to
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Validate_BulkDataCSVSeparator(dm_req_t *req, char *value)
+{
+    int err;
+    char buf[MAX_CSV_SEPARATOR_LEN+1];
+
+    // Exit if the value contains invalid character references, or is too long
+    err = bulkdata_decode_csv_characters(value, buf, sizeof(buf));
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if the separator is empty
+    if (buf[0] == '\0')
+    {
+        USP_ERR_SetMessage("%s: CSV separator must not be empty", __FUNCTION__);
         return USP_ERR_INVALID_VALUE;
     }
 
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** Validate_BulkDataCSVEscapeCharacter
+**
+** Validates Device.BulkData.Profile.{i}.CSVEncoding.EscapeCharacter
+** NOTE: An empty escape character is allowed, and disables escaping of fields
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   value - value that the controller would like to set the parameter to
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Validate_BulkDataCSVEscapeCharacter(dm_req_t *req, char *value)
+{
+    char buf[MAX_CSV_SEPARATOR_LEN+1];
+
+    return bulkdata_decode_csv_characters(value, buf, sizeof(buf));
+}
+
 /*********************************************************************//**
 **
 ** Validate_BulkDataCompression
@@ -648,9 +931,9 @@ int Validate_BulkDataReportTimestamp(dm_req_t *req, char *value)
 int Validate_BulkDataCompression(dm_req_t *req, char *value)
 {
     // Exit if trying to set a value outside of the range we accept
-    if ((strcmp(value, "None") != 0) && (strcmp(value, "GZIP") != 0))
+    if ((strcmp(value, "None") != 0) && (strcmp(value, "GZIP") != 0) && (strcmp(value, "Deflate") != 0))
     {
-        USP_ERR_SetMessage("%s: Only 'GZIP' and 'None' HTTP Compressions supported.", __FUNCTION__);
+        USP_ERR_SetMessage("%s: Only 'GZIP', 'Deflate' and 'None' HTTP Compressions supported.", __FUNCTION__);
         return USP_ERR_INVALID_VALUE;
     }
 
@@ -699,6 +982,24 @@ int Validate_BulkDataRetryMinimumWaitInterval(dm_req_t *req, char *value)
     return DM_ACCESS_ValidateRange_Unsigned(req, 1, 65535);
 }
 
+/*********************************************************************//**
+**
+** Validate_BulkDataFullReportInterval
+**
+** Validates Device.BulkData.Profile.{i}.X_ARRIS-COM_FullReportInterval
+** This is the number of delta reports sent between each full report (when delta reports are enabled)
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   value - value that the controller would like to set the parameter to
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Validate_BulkDataFullReportInterval(dm_req_t *req, char *value)
+{
+    return DM_ACCESS_ValidateRange_Unsigned(req, 0, 65535);
+}
+
 /*********************************************************************//**
 **
 ** Validate_BulkDataRetryIntervalMultiplier
@@ -743,17 +1044,11 @@ int NotifyChange_BulkDataGlobalEnable(dm_req_t *req, char *value)
     global_enable = val_bool;
 
     // Iterate over all profiles, starting or stopping them
-    for (i=0; i<BULKDATA_MAX_PROFILES; i++)
+    for (i=0; i < num_bulkdata_profiles; i++)
     {
-        // Skip to next profile, if this one is not in use
-        bp = &bulkdata_profiles[i];
-        if (bp->profile_id == INVALID)
-        {
-            continue;
-        }
-
         // Skip to next profile, if this one is not enabled.
         // If it is not enabled, then changing the global enable makes no difference to it - it'll still stay disabled
+        bp = bulkdata_profiles[i];
         if (bp->is_enabled == false)
         {
             continue;
@@ -1016,10 +1311,68 @@ int Notify_BulkDataProfileDeleted(dm_req_t *req)
     {
         ProcessBulkDataProfileDeleted(bp);
     }
+
+    // Delete the profile's retained reports
+    BULKDATA_SPOOL_Delete(inst1);
     
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** NotifyChange_BulkDataParameter
+**
+** Called whenever the Reference or Name of a profile's parameter (Device.BulkData.Profile.{i}.Parameter.{i}) is modified
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   value - new value of this parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int NotifyChange_BulkDataParameter(dm_req_t *req, char *value)
+{
+    // Rebuild the profile's collection plan, before collecting the next report
+    bulkdata_invalidate_plan(inst1);
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Notify_BulkDataParameterAdded
+**
+** Called whenever a parameter (Device.BulkData.Profile.{i}.Parameter.{i}) is added to a profile
+**
+** \param   req - pointer to structure identifying the object instance added
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Notify_BulkDataParameterAdded(dm_req_t *req)
+{
+    // Rebuild the profile's collection plan, before collecting the next report
+    bulkdata_invalidate_plan(inst1);
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Notify_BulkDataParameterDeleted
+**
+** Called whenever a parameter (Device.BulkData.Profile.{i}.Parameter.{i}) is deleted from a profile
+**
+** \param   req - pointer to structure identifying the object instance deleted
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Notify_BulkDataParameterDeleted(dm_req_t *req)
+{
+    // Rebuild the profile's collection plan, before collecting the next report
+    bulkdata_invalidate_plan(inst1);
+    return USP_ERR_OK;
+}
+
 /*********************************************************************//**
 **
 ** Get_BulkDataGlobalStatus
@@ -1036,7 +1389,6 @@ int Get_BulkDataGlobalStatus(dm_req_t *req, char *buf, int len)
     int i;
     bulkdata_profile_t *bp;
     char *status;
-    int num_slots;
     int num_instances;
     int err;
 
@@ -1057,18 +1409,10 @@ int Get_BulkDataGlobalStatus(dm_req_t *req, char *buf, int len)
     // By default global status follows whether global enable is on or off
     // However if any profiles are not working, then change the status to error
     status =  "Enabled";
-    num_slots = 0;
-    for (i=0; i<BULKDATA_MAX_PROFILES; i++)
+    for (i=0; i < num_bulkdata_profiles; i++)
     {
-        // Skip to next profile, if this profile is not in use
-        bp = &bulkdata_profiles[i];
-        if (bp->profile_id == INVALID)
-        {
-            continue;
-        }
-        num_slots++;
-
         // Skip to next profile, if this profile is not enabled
+        bp = bulkdata_profiles[i];
         if (bp->is_enabled == false)
         {
             continue;
@@ -1082,9 +1426,9 @@ int Get_BulkDataGlobalStatus(dm_req_t *req, char *buf, int len)
         }
     }
 
-    // If there are ever more instances in the USP DB than slots used in bulkdata_profiles[], then overall status is error
-    // (as one of the instances which is not represented by a slot is in error)
-    if (num_slots != num_instances)
+    // If there are ever more instances in the USP DB than profiles in bulkdata_profiles[], then overall status is error
+    // (as one of the instances which is not represented by a profile is in error)
+    if (num_bulkdata_profiles != num_instances)
     {
         status = "Error";
     }
@@ -1138,123 +1482,342 @@ exit:
 
 /*********************************************************************//**
 **
-** ProcessBulkDataProfileAdded
+** Get_BulkDataLastCollectionDuration
 **
-** Called when a new profile has been added by a controller
-** Also called at bootup to seed the bulkdata_profile[] array
+** Called to get the value of Device.BulkData.Profile.{i}.X_ARRIS-COM_LastCollectionDuration
+** Returns the time (in ms) taken by the last collection of the profile, from its reporting instant until all parameters had been collected
 **
-** \param   instance - instance number of the profile that has been added
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
 **
 ** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-int ProcessBulkDataProfileAdded(int instance)
+int Get_BulkDataLastCollectionDuration(dm_req_t *req, char *buf, int len)
 {
-    int err;
-    char path[MAX_DM_PATH];
-    time_t base;
     bulkdata_profile_t *bp;
 
-    // Exit if unable to find a free bulk data profile
-    // NOTE: This should never happen, as Validate_AddBulkDataProfile() should have prevented this code from being called
-    bp = bulkdata_find_free_profile();
-    if (bp == NULL)
-    {
-        USP_ERR_SetMessage("%s: Unable to add a new bulk data profile. Only %d profiles supported", __FUNCTION__, BULKDATA_MAX_PROFILES);
-    }
-
-    // Clear the profile
-    memset(bp, 0, sizeof(bulkdata_profile_t));
-
-    // Exit if unable to get the Enable for this profile
-    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.Enable", instance);
-    err = DM_ACCESS_GetBool(path, &bp->is_enabled);
-    if (err != USP_ERR_OK)
-    {
-        return err;
-    }
-
-    // Exit if unable to get the ReportingInterval for this profile
-    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.ReportingInterval", instance);
-    err = DM_ACCESS_GetInteger(path, &bp->reporting_interval);
-    if (err != USP_ERR_OK)
-    {
-        return err;
-    }
-
-    // Exit if unable to get the TimeReference for this profile
-    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.TimeReference", instance);
-    err = DM_ACCESS_GetDateTime(path, &base);
-    if (err != USP_ERR_OK)
-    {
-        return err;
-    }
-    bp->time_reference = RETRY_WAIT_UseRandomBaseIfUnknownTime(base);
-
-    // Exit if unable to get RetryMinimumWaitInterval for this profile
-    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.HTTP.RetryMinimumWaitInterval", instance);
-    err = DM_ACCESS_GetUnsigned(path, &bp->retry_minimum_wait_interval);
-    if (err != USP_ERR_OK)
-    {
-        return err;
-    }
-
-    // Exit if unable to get RetryIntervalMultiplier for this profile
-    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.HTTP.RetryIntervalMultiplier", instance);
-    err = DM_ACCESS_GetUnsigned(path, &bp->retry_interval_multiplier);
-    if (err != USP_ERR_OK)
-    {
-        return err;
-    }
-
-    // Exit if unable to get RetryEnable for this profile
-    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.HTTP.RetryEnable", instance);
-    err = DM_ACCESS_GetBool(path, &bp->retry_enable);
-    if (err != USP_ERR_OK)
-    {
-        return err;
-    }
-
-    // Since successful, mark the profile as in use
-    bp->profile_id = instance;
-    bp->is_working = true;          // Assumed to be working correctly until first post proves otherwise
-
-    // Start the profile, if enabled
-    if ((bp->is_enabled) && (global_enable))
-    {
-        // Exit if unable to start the profile
-        err = bulkdata_start_profile(bp);
-        if (err != USP_ERR_OK)
-        {
-            bp->profile_id = INVALID;   // Ensure that profile slot is not leaked
-            return err;
-        }
-    }
+    bp = bulkdata_find_profile(inst1);
+    val_uint = (bp != NULL) ? bp->last_collection.duration : 0;
 
     return USP_ERR_OK;
 }
 
 /*********************************************************************//**
 **
-** ProcessBulkDataProfileDeleted
+** Get_BulkDataLastCollectionBusyTime
 **
-** Called to stop a profile and delete all memory associated with it
+** Called to get the value of Device.BulkData.Profile.{i}.X_ARRIS-COM_LastCollectionBusyTime
+** Returns the time (in ms) that the data model thread spent collecting parameters, during the last collection of the profile
 **
-** \param   bp - pointer to profile
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
 **
-** \return  None
+** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-void ProcessBulkDataProfileDeleted(bulkdata_profile_t *bp)
+int Get_BulkDataLastCollectionBusyTime(dm_req_t *req, char *buf, int len)
 {
-    // Stop the profile, if started
-    if ((global_enable) && (bp->is_enabled))
-    {
-        bulkdata_stop_profile(bp);
-    }
+    bulkdata_profile_t *bp;
 
-    // Mark slot as not in use
-    bp->profile_id = INVALID;
+    bp = bulkdata_find_profile(inst1);
+    val_uint = (bp != NULL) ? bp->last_collection.busy_time : 0;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Get_BulkDataLastCollectionParameters
+**
+** Called to get the value of Device.BulkData.Profile.{i}.X_ARRIS-COM_LastCollectionParameters
+** Returns the number of parameters in the last collection of the profile
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_BulkDataLastCollectionParameters(dm_req_t *req, char *buf, int len)
+{
+    bulkdata_profile_t *bp;
+
+    bp = bulkdata_find_profile(inst1);
+    val_uint = (bp != NULL) ? bp->last_collection.num_params : 0;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Get_BulkDataLastCollectionSlices
+**
+** Called to get the value of Device.BulkData.Profile.{i}.X_ARRIS-COM_LastCollectionSlices
+** Returns the number of data model thread loop iterations that the last collection of the profile was spread over
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_BulkDataLastCollectionSlices(dm_req_t *req, char *buf, int len)
+{
+    bulkdata_profile_t *bp;
+
+    bp = bulkdata_find_profile(inst1);
+    val_uint = (bp != NULL) ? bp->last_collection.num_slices : 0;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Get_BulkDataLastConnectTime
+**
+** Called to get the value of Device.BulkData.Profile.{i}.X_ARRIS-COM_LastConnectTime
+** Returns the time (in ms) taken to establish the TCP connection to the BDC server, when the last report was sent (0 if the connection was reused)
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_BulkDataLastConnectTime(dm_req_t *req, char *buf, int len)
+{
+    bulkdata_profile_t *bp;
+
+    bp = bulkdata_find_profile(inst1);
+    val_uint = (bp != NULL) ? bp->last_transfer.connect_time : 0;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Get_BulkDataLastTLSTime
+**
+** Called to get the value of Device.BulkData.Profile.{i}.X_ARRIS-COM_LastTLSTime
+** Returns the time (in ms) taken by the TLS handshake with the BDC server, when the last report was sent (0 if the connection was not secure or was reused)
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_BulkDataLastTLSTime(dm_req_t *req, char *buf, int len)
+{
+    bulkdata_profile_t *bp;
+
+    bp = bulkdata_find_profile(inst1);
+    val_uint = (bp != NULL) ? bp->last_transfer.tls_time : 0;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Get_BulkDataLastTransferTime
+**
+** Called to get the value of Device.BulkData.Profile.{i}.X_ARRIS-COM_LastTransferTime
+** Returns the total time (in ms) taken to send the last report to the BDC server
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_BulkDataLastTransferTime(dm_req_t *req, char *buf, int len)
+{
+    bulkdata_profile_t *bp;
+
+    bp = bulkdata_find_profile(inst1);
+    val_uint = (bp != NULL) ? bp->last_transfer.transfer_time : 0;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Get_BulkDataLastConnectionReused
+**
+** Called to get the value of Device.BulkData.Profile.{i}.X_ARRIS-COM_LastConnectionReused
+** Returns whether the last report was sent over an existing (kept alive) connection to the BDC server
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_BulkDataLastConnectionReused(dm_req_t *req, char *buf, int len)
+{
+    bulkdata_profile_t *bp;
+
+    bp = bulkdata_find_profile(inst1);
+    val_bool = (bp != NULL) ? bp->last_transfer.connection_reused : false;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Get_BulkDataRetainedReports
+**
+** Called to get the value of Device.BulkData.Profile.{i}.X_ARRIS-COM_RetainedReports
+** Returns the number of failed reports currently retained in the profile's spool
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_BulkDataRetainedReports(dm_req_t *req, char *buf, int len)
+{
+    bulkdata_profile_t *bp;
+
+    bp = bulkdata_find_profile(inst1);
+    val_uint = (bp != NULL) ? bp->spool.num_entries : 0;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** ProcessBulkDataProfileAdded
+**
+** Called when a new profile has been added by a controller
+** Also called at bootup to seed the bulkdata_profiles[] array
+**
+** \param   instance - instance number of the profile that has been added
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int ProcessBulkDataProfileAdded(int instance)
+{
+    int err;
+    char path[MAX_DM_PATH];
+    time_t base;
+    bulkdata_profile_t *bp;
+
+    // Allocate the profile
+    // NOTE: It is only added to bulkdata_profiles[] once it has been successfully initialised
+    bp = USP_MALLOC(sizeof(bulkdata_profile_t));
+    memset(bp, 0, sizeof(bulkdata_profile_t));
+    bp->profile_id = instance;
+
+    // Exit if unable to get the Enable for this profile
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.Enable", instance);
+    err = DM_ACCESS_GetBool(path, &bp->is_enabled);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    // Exit if unable to get the ReportingInterval for this profile
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.ReportingInterval", instance);
+    err = DM_ACCESS_GetInteger(path, &bp->reporting_interval);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    // Exit if unable to get the TimeReference for this profile
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.TimeReference", instance);
+    err = DM_ACCESS_GetDateTime(path, &base);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+    bp->time_reference = RETRY_WAIT_UseRandomBaseIfUnknownTime(base);
+
+    // Exit if unable to get RetryMinimumWaitInterval for this profile
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.HTTP.RetryMinimumWaitInterval", instance);
+    err = DM_ACCESS_GetUnsigned(path, &bp->retry_minimum_wait_interval);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    // Exit if unable to get RetryIntervalMultiplier for this profile
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.HTTP.RetryIntervalMultiplier", instance);
+    err = DM_ACCESS_GetUnsigned(path, &bp->retry_interval_multiplier);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    // Exit if unable to get RetryEnable for this profile
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.HTTP.RetryEnable", instance);
+    err = DM_ACCESS_GetBool(path, &bp->retry_enable);
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
+    bp->is_working = true;          // Assumed to be working correctly until first post proves otherwise
+
+    // Exit if unable to start the profile (if enabled)
+    if ((bp->is_enabled) && (global_enable))
+    {
+        err = bulkdata_start_profile(bp);
+        if (err != USP_ERR_OK)
+        {
+            goto exit;
+        }
+    }
+
+    // Since successful, add the profile to the array of profiles
+    bulkdata_insert_profile(bp);
+    err = USP_ERR_OK;
+
+exit:
+    // Ensure that the profile is not leaked, if an error occurred
+    if (err != USP_ERR_OK)
+    {
+        USP_FREE(bp);
+    }
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** ProcessBulkDataProfileDeleted
+**
+** Called to stop a profile and delete all memory associated with it
+**
+** \param   bp - pointer to profile
+**
+** \return  None
+**
+**************************************************************************/
+void ProcessBulkDataProfileDeleted(bulkdata_profile_t *bp)
+{
+    // Stop the profile, if started
+    if ((global_enable) && (bp->is_enabled))
+    {
+        bulkdata_stop_profile(bp);
+    }
+
+    // Remove the profile from the array of profiles, and free it
+    bulkdata_remove_profile(bp);
+    USP_FREE(bp);
 }
 
 /*********************************************************************//**
@@ -1616,74 +2179,45 @@ exit:
 
 /*********************************************************************//**
 **
-** bulkdata_platform_get_parameter_values
+** bulkdata_platform_resolve_parameter_paths
 **
-** Obtains the values of all parameters given in the path expression
-** This is a map of (key=param_path, value=param_value)
+** Resolves the path expression of a parameter reference into the paths of all parameters which it references
 **
-** \param   path_expr - Path expression describing parameters to obtain the values of
-**                      (from Device.BulkData.Profile.{i}.Parameter.{i}.Reference)
-*  \param   param_refs = map containing the resolved list of parameters and their values
+** \param   path - Path expression describing parameters to collect
+**                 (from Device.BulkData.Profile.{i}.Parameter.{i}.Reference)
+** \param   params - initialised vector in which to return the resolved parameter paths
 **
 ** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-int bulkdata_platform_get_parameter_values(char *path, kv_vector_t *param_values)
+int bulkdata_platform_resolve_parameter_paths(char *path, str_vector_t *params)
 {
-    int i;
     int err;
-    str_vector_t params;
-    char value[MAX_DM_VALUE_LEN];
-    char *cur_path;
     combined_role_t combined_role;
 
-    STR_VECTOR_Init(&params);
-    KV_VECTOR_Init(param_values);
-
     // Exit if unable to get the resolved paths
     // NOTE: We can safely use the FullAccess role here, because we have already validated the path expression against the controller's role
     combined_role.inherited = kCTrustRole_FullAccess;
     combined_role.assigned = kCTrustRole_FullAccess;
-    err = PATH_RESOLVER_ResolveDevicePath(path, &params, kResolveOp_GetBulkData, NULL, &combined_role, 0);
+    err = PATH_RESOLVER_ResolveDevicePath(path, params, kResolveOp_GetBulkData, NULL, &combined_role, 0);
     if (err != USP_ERR_OK)
     {
-        goto exit;
-    }
-
-    // Iterate over all parameter paths found
-    for (i=0; i<params.num_entries; i++)
-    {
-        // Exit if unable to get the value of the parameter
-        cur_path = params.vector[i];
-        err = DATA_MODEL_GetParameterValue(cur_path, value, sizeof(value), 0);
-        if (err != USP_ERR_OK)
-        {
-            goto exit;
-        }
-
-        // Add the parameter to the map
-        KV_VECTOR_Add(param_values, cur_path, value);
+        STR_VECTOR_Destroy(params);
+        return err;
     }
 
-    err = USP_ERR_OK;
-
-exit:
-    STR_VECTOR_Destroy(&params);
-
-    if (err != USP_ERR_OK)
-    {
-        KV_VECTOR_Destroy(param_values);
-    }
-
-    return err;
-}
+    return USP_ERR_OK;
+}
 
 /*********************************************************************//**
 **
 ** bulkdata_platform_get_parameter_type
 **
 ** Obtains the type of the specified parameter
-** The type is denoted by a letter code: 'S'=strings and datetime, 'N'=number, 'B'=boolean
+** The type is denoted by a letter code: 'S'=string, 'D'=dateTime, 'I'=int, 'U'=unsignedInt, 'L'=unsignedLong, 'B'=boolean
+** NOTE: JSON reports encode 'D' as a string and 'I', 'U' and 'L' as numbers. CSV reports (ParameterPerRow) include the type name
+** NOTE: In the report map, the letter code is lower case if the value was obtained in native form (see DATA_MODEL_GetTypedParameterValue),
+**       in which case the value is known to be in canonical form, so does not need to be validated when writing the report
 ** NOTE: This function is only ever called on paths that have already been validated
 **
 ** \param   path_expr - Path expression describing parameters to obtain the values of
@@ -1711,17 +2245,29 @@ char bulkdata_platform_get_parameter_type(char *path)
 
     // Calculate the type of this parameter
     type_flags = node->registered.param_info.type_flags;
-    if (type_flags & (DM_INT | DM_UINT | DM_ULONG))
+    if (type_flags & DM_INT)
+    {
+        type = 'I';
+    }
+    else if (type_flags & DM_UINT)
+    {
+        type = 'U';
+    }
+    else if (type_flags & DM_ULONG)
     {
-        type = 'N';
+        type = 'L';
     }
     else if (type_flags & DM_BOOL)
     {
         type = 'B';
     }
+    else if (type_flags & DM_DATETIME)
+    {
+        type = 'D';
+    }
     else
     {
-        // Default, and also for DM_STRING and DM_DATETIME
+        // Default, and also for DM_STRING
         type = 'S';
     }
 
@@ -1768,6 +2314,22 @@ int bulkdata_platform_get_profile_control_params(bulkdata_profile_t *bp, profile
         return err;
     }
 
+    // Exit if unable to get X_ARRIS-COM_DeltaReports
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.X_ARRIS-COM_DeltaReports", bp->profile_id);
+    err = DM_ACCESS_GetBool(path, &ctrl_params->delta_reports);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to get X_ARRIS-COM_FullReportInterval
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.X_ARRIS-COM_FullReportInterval", bp->profile_id);
+    err = DM_ACCESS_GetUnsigned(path, &ctrl_params->full_report_interval);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
     // Exit if unable to get URL
     USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.HTTP.URL", bp->profile_id);
     err = DATA_MODEL_GetParameterValue(path, ctrl_params->url, sizeof(ctrl_params->url), 0);
@@ -1816,6 +2378,20 @@ int bulkdata_platform_get_profile_control_params(bulkdata_profile_t *bp, profile
         return err;
     }
 
+    // Exit if unable to get EncodingType
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.EncodingType", bp->profile_id);
+    err = DATA_MODEL_GetParameterValue(path, ctrl_params->encoding_type, sizeof(ctrl_params->encoding_type), 0);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Get the parameters controlling the CSV encoding, if the profile uses CSV
+    if (strcmp(ctrl_params->encoding_type, BULKDATA_ENCODING_TYPE_CSV)==0)
+    {
+        return bulkdata_platform_get_csv_control_params(bp, ctrl_params);
+    }
+
     // Exit if unable to get ReportTimestamp
     USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.JSONEncoding.ReportTimestamp", bp->profile_id);
     err = DATA_MODEL_GetParameterValue(path, ctrl_params->report_timestamp, sizeof(ctrl_params->report_timestamp), 0);
@@ -1827,6 +2403,76 @@ int bulkdata_platform_get_profile_control_params(bulkdata_profile_t *bp, profile
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** bulkdata_platform_get_csv_control_params
+**
+** Obtains the parameters controlling the CSV encoding of reports for a given profile
+** The separators and escape character are decoded from the XML character references used in the data model
+**
+** \param   bp - pointer to profile
+** \param   ctrl_params - pointer to structure in which to return the control parameters of the specified profile
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int bulkdata_platform_get_csv_control_params(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl_params)
+{
+    int i;
+    int err;
+    char path[MAX_DM_PATH];
+    char value[MAX_DM_SHORT_VALUE_LEN];
+
+    typedef struct
+    {
+        char *param_name;
+        char *buf;
+        int len;
+    } csv_chars_param_t;
+
+    csv_chars_param_t csv_chars_params[] =
+    {
+        { "FieldSeparator", ctrl_params->csv_field_separator, sizeof(ctrl_params->csv_field_separator) },
+        { "RowSeparator", ctrl_params->csv_row_separator, sizeof(ctrl_params->csv_row_separator) },
+        { "EscapeCharacter", ctrl_params->csv_escape_char, sizeof(ctrl_params->csv_escape_char) },
+    };
+
+    // Exit if unable to get ReportFormat
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.CSVEncoding.ReportFormat", bp->profile_id);
+    err = DATA_MODEL_GetParameterValue(path, ctrl_params->csv_report_format, sizeof(ctrl_params->csv_report_format), 0);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to get RowTimestamp
+    USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.CSVEncoding.RowTimestamp", bp->profile_id);
+    err = DATA_MODEL_GetParameterValue(path, ctrl_params->report_timestamp, sizeof(ctrl_params->report_timestamp), 0);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Iterate over all separators and the escape character, exiting if unable to get or decode any of them
+    for (i=0; i < NUM_ELEM(csv_chars_params); i++)
+    {
+        USP_SNPRINTF(path, sizeof(path), "Device.BulkData.Profile.%d.CSVEncoding.%s", bp->profile_id, csv_chars_params[i].param_name);
+        err = DATA_MODEL_GetParameterValue(path, value, sizeof(value), 0);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+
+        err = bulkdata_decode_csv_characters(value, csv_chars_params[i].buf, csv_chars_params[i].len);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+    }
+
+    return USP_ERR_OK;
+}
+
 /*********************************************************************//**
 **
 **  bulkdata_start_profile
@@ -1851,6 +2497,15 @@ int bulkdata_start_profile(bulkdata_profile_t *bp)
         return err;
     }
 
+    // Open the spool containing the reports which previously failed to be sent (if any)
+    // NOTE: If the spool cannot be opened, then the profile still runs, but failed reports are not retained
+    err = BULKDATA_SPOOL_Open(&bp->spool, bp->profile_id);
+    if (err != USP_ERR_OK)
+    {
+        USP_LOG_Error("%s: Unable to open spool for profile_id=%d. Failed reports will not be retained", __FUNCTION__, bp->profile_id);
+    }
+    bp->max_retained_reports = ctrl.num_retained_failed_reports;
+
     // Determine the time until the timer should next fire
     wait_time = bulkdata_calc_waittime_to_next_reporting_interval(bp->reporting_interval, bp->time_reference);
 
@@ -1858,6 +2513,7 @@ int bulkdata_start_profile(bulkdata_profile_t *bp)
     err = SYNC_TIMER_Add(bulkdata_process_profile, bp->profile_id, time(NULL) + wait_time);
     if (err != USP_ERR_OK)
     {
+        BULKDATA_SPOOL_Close(&bp->spool);
         return err;
     }
     
@@ -1896,6 +2552,12 @@ int bulkdata_resync_profile(bulkdata_profile_t *bp, int *delta_time)
     {
         return USP_ERR_OK;
     }
+
+    // Exit if the profile is collecting (or waiting to collect). Its sync timer will be restarted once the collected report has been sent
+    if (bp->is_collecting)
+    {
+        return USP_ERR_OK;
+    }
     
     // Exit if unable to restart the sync timer with the time until the next reporting interval (or retry)
     err = SYNC_TIMER_Reload(bulkdata_process_profile, bp->profile_id, time(NULL) + wait_time);
@@ -1989,7 +2651,13 @@ int bulkdata_stop_profile(bulkdata_profile_t *bp)
     int err;
 
     // Free all dynamic memory associated with this profile
-    bulkdata_clear_retained_reports(bp);
+    // NOTE: The spool file is kept, so that retained reports are sent when the profile is restarted
+    bulkdata_abort_collection(bp);
+    bulkdata_clear_reports(bp);
+    bulkdata_free_sending_report(bp);
+    bulkdata_clear_delta_state(bp);
+    BULKDATA_SPOOL_Close(&bp->spool);
+    bulkdata_destroy_plan(&bp->plan);
 
     // Exit if unable to stop the sync timer
     err = SYNC_TIMER_Remove(bulkdata_process_profile, bp->profile_id);
@@ -2033,6 +2701,8 @@ void bulkdata_process_profile(int id)
 **  bulkdata_process_profile_work
 **
 **  Perform the work of processing a profile
+**  Parameters are collected incrementally, BULKDATA_COLLECTION_SLICE_SIZE at a time, with this function being called
+**  again on the next iteration of the data model thread's loop until collection has completed
 **
 ** \param   bp - pointer to bulk data profile to process
 **          
@@ -2042,303 +2712,933 @@ void bulkdata_process_profile(int id)
 void bulkdata_process_profile_work(bulkdata_profile_t *bp)
 {
     int err;
-    report_t *cur_report;    
-    char *json_report;
     profile_ctrl_params_t ctrl;
-    unsigned char *compressed_report;
-    int compressed_len;
-    char buf[48];
+    unsigned char *report;
+    int report_len;
+    unsigned flags;
 
-    // Exit if unable to obtain the control parameters for this profile
-    err = bulkdata_platform_get_profile_control_params(bp, &ctrl);
-    if (err != USP_ERR_OK)
+    // If we are not retrying to send a failed report(s) then collect the report map for this reporting interval
+    if ((bp->retry_count == 0) || (bp->is_collecting))
     {
-        return;
-    }
+        // Start collecting, if this is the reporting instant
+        if (bp->is_collecting == false)
+        {
+            err = bulkdata_start_collection(bp);
+            if (err != USP_ERR_OK)
+            {
+                return;
+            }
+        }
 
-    // If we are not retrying to send a failed report(s) then append the report map for this reporting interval
-    if (bp->retry_count == 0)
-    {
-        // Drop the oldest retained reports, if we would store more than we're meant to
-        if (bp->num_retained_reports > ctrl.num_retained_failed_reports)
+        // Exit if another profile is collecting. This profile will be restarted once that profile has finished collecting
+        if ((collecting_profile != NULL) && (collecting_profile != bp))
         {
-            bulkdata_drop_oldest_retained_reports(bp, ctrl.num_retained_failed_reports);
+            return;
         }
-    
-        // Append the report map for this reporting interval
-        cur_report = &bp->reports[bp->num_retained_reports];
-        cur_report->collection_time = time(NULL);
+        collecting_profile = bp;
 
-        KV_VECTOR_Init(&cur_report->report_map);
+        // Exit if there are more parameters to collect, restarting the sync timer, so that the next slice is collected
+        // after the data model thread has had a chance to service other activity
+        if (bulkdata_collect_slice(bp) == false)
+        {
+            SYNC_TIMER_Reload(bulkdata_process_profile, bp->profile_id, time(NULL));
+            return;
+        }
+        bulkdata_finish_collection(bp);
 
-        // Exit if unable to get the map containing the report contents
-        err = bulkdata_calc_report_map(bp, &cur_report->report_map);
+        // Exit if unable to obtain the control parameters for this profile
+        err = bulkdata_platform_get_profile_control_params(bp, &ctrl);
         if (err != USP_ERR_OK)
         {
-            USP_ERR_SetMessage("%s: bulkdata_calc_report_map failed", __FUNCTION__);
+            KV_VECTOR_Destroy(&bp->collecting_report.report_map);
             return;
         }
-        bp->num_retained_reports++;
-    }
 
-    // Exit if unable to generate the report
-    json_report = bulkdata_generate_json_report(bp, &ctrl);
-    if (json_report == NULL)
-    {
-        USP_ERR_SetMessage("%s: bulkdata_generate_json_report failed", __FUNCTION__);
-        return;
-    }
+        // Reduce the report to only the parameters which have changed (if delta reports are enabled)
+        flags = bulkdata_reduce_to_delta_report(bp, &ctrl, &bp->collecting_report.report_map);
+        flags |= bulkdata_calc_report_flags(&ctrl);
 
-    // Print out the JSON report, if debugging is enabled
-    USP_LOG_Info("\nBULK DATA: %sing at time %s, to url=%s", ctrl.method, iso8601_cur_time(buf, sizeof(buf)), ctrl.url);
-    USP_LOG_Info("BULK DATA: using compression method=%s", ctrl.compression);
-    if (enable_protocol_trace)
-    {
-        USP_LOG_String(kLogType_Protocol, json_report);
-    }
+        // Generate the report for this reporting interval, compressing it as it is generated (if enabled)
+        bp->reports = &bp->collecting_report;
+        bp->num_reports = 1;
+        report = bulkdata_generate_report(bp, &ctrl, &report_len);
+        bulkdata_clear_reports(bp);
 
-    // Compress the report, if enabled
-    compressed_report = bulkdata_compress_report(&ctrl, json_report, strlen(json_report), &compressed_len);
-    if (compressed_report != (unsigned char *)json_report)
-    {
-        free(json_report);
-    }
-    // NOTE: From this point on, only the compressed_report exists
+        // If there are retained reports, then they must be sent first, so queue this report behind them in the spool
+        // NOTE: The spool may contain the retained reports plus this report
+        if ((bp->spool.num_entries > 0) || (bp->is_sending))
+        {
+            err = BULKDATA_SPOOL_Append(&bp->spool, report, report_len, flags);
+            if (err == USP_ERR_OK)
+            {
+                USP_FREE(report);
+                report = NULL;
+                BULKDATA_SPOOL_Trim(&bp->spool, ctrl.num_retained_failed_reports + 1);
+            }
+            else if (bp->is_sending)
+            {
+                USP_LOG_Error("%s: Unable to spool report for profile_id=%d. Dropping report", __FUNCTION__, bp->profile_id);
+                USP_FREE(report);
+                return;
+            }
+        }
 
-    // Exit if failed to tell BDC thread to send the report
-    err = bulkdata_schedule_sending_report(&ctrl, bp, compressed_report, compressed_len);
-    if (err != USP_ERR_OK)
-    {
-        DEVICE_BULKDATA_NotifyTransferResult(bp->profile_id, false);
+        // Exit if a report is already being sent. The spooled report will be sent once that report has been sent
+        if (bp->is_sending)
+        {
+            return;
+        }
     }
-}
+    else
+    {
+        // Exit if a report is already being sent (eg the sync timer was restarted by a change to the profile's parameters)
+        // The retry will be rescheduled once that report has been sent
+        if (bp->is_sending)
+        {
+            return;
+        }
 
-/*********************************************************************//**
-**
-**  bulkdata_drop_oldest_retained_reports
-**
-**  Drops the oldest retained reports to get the number of reports retained down to the specified number
-**
-** \param   bp - pointer to bulk data profile containing reports
-** \param   num_reports_to_keep - the total number of failed reports to retain
-**          
-** \return  None
-**
-**************************************************************************/
-void bulkdata_drop_oldest_retained_reports(bulkdata_profile_t *bp, int num_reports_to_keep)
-{
-    int i;
-    int reports_to_destroy;
+        // Exit if unable to obtain the control parameters for this profile
+        err = bulkdata_platform_get_profile_control_params(bp, &ctrl);
+        if (err != USP_ERR_OK)
+        {
+            return;
+        }
 
-    // Destroy the oldest report maps    
-    reports_to_destroy = bp->num_retained_reports - num_reports_to_keep;
-    for (i=0; i<reports_to_destroy; i++)
-    {
-        KV_VECTOR_Destroy(&bp->reports[i].report_map);
+        // Retry sending the oldest retained report
+        report = NULL;
+        report_len = 0;
+        flags = 0;
     }
 
-    // Move down the reports to keep
-    if (num_reports_to_keep > 0)
-    {
-        memmove(&bp->reports[0], &bp->reports[reports_to_destroy], num_reports_to_keep*sizeof(report_t));
-    }
-    
-    bp->num_retained_reports = num_reports_to_keep;
+    // Send the report (or the oldest retained report, if report is NULL)
+    bulkdata_send_report(bp, &ctrl, report, report_len, flags);
 }
 
 /*********************************************************************//**
 **
-**  bulkdata_clear_retained_reports
+**  bulkdata_start_collection
 **
-**  Clears out all of the retained reports
+**  Starts collecting the report map for this reporting interval
+**  The collection time of the report is snapshotted now, so that it denotes the reporting instant,
+**  even if the profile has to wait for other profiles to collect, and collection is spread over many slices
 **
-** \param   bp - pointer to bulk data profile to clear all report maps
-**          
-** \return  None
+** \param   bp - pointer to bulk data profile to start collecting
+**
+** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-void bulkdata_clear_retained_reports(bulkdata_profile_t *bp)
+int bulkdata_start_collection(bulkdata_profile_t *bp)
 {
-    int i;
-    report_t *r;
-    
-    for (i=0; i < bp->num_retained_reports; i++)
+    int err;
+    collection_plan_t *plan;
+
+    // Exit if unable to rebuild the collection plan (if it is out of date)
+    // NOTE: The plan is not rebuilt whilst collection is in progress, even if it becomes out of date. Parameters which no longer exist are skipped
+    plan = &bp->plan;
+    if (bulkdata_is_plan_valid(plan) == false)
     {
-        r = &bp->reports[i];
-        KV_VECTOR_Destroy(&r->report_map);
-        r->collection_time = 0;
+        bulkdata_destroy_plan(plan);
+        err = bulkdata_build_plan(bp->profile_id, plan);
+        if (err != USP_ERR_OK)
+        {
+            USP_ERR_SetMessage("%s: bulkdata_build_plan failed", __FUNCTION__);
+            return err;
+        }
     }
 
-    bp->num_retained_reports = 0;
-    bp->retry_count = 0;
+    bp->collecting_report.collection_time = time(NULL);
+    KV_VECTOR_Init(&bp->collecting_report.report_map);
+    bp->collection_index = 0;
+    bp->collection_start = tu_uptime_msecs();
+    bp->collection_busy_time = 0;
+    bp->collection_slices = 0;
+    bp->is_collecting = true;
+
+    return USP_ERR_OK;
 }
 
 /*********************************************************************//**
 **
-**  bulkdata_calc_report_map
+**  bulkdata_collect_slice
 **
-**  Calculates the map containing {parameter name vs type/value} for the specified profile
+**  Collects the values of the next BULKDATA_COLLECTION_SLICE_SIZE parameters in the profile's collection plan,
+**  adding them to the report map being collected
 **
-** \param   context - pointer to global bulkdata context
-** \param   bp - pointer to bulk data profile to get the report map for
-** \param   report_map - initialised map in which to return the report map
-**          
-** \return  USP_ERR_OK if successful
+** \param   bp - pointer to bulk data profile which is collecting
+**
+** \return  true if all parameters in the collection plan have now been collected
 **
 **************************************************************************/
-int bulkdata_calc_report_map(bulkdata_profile_t *bp, kv_vector_t *report_map)
+bool bulkdata_collect_slice(bulkdata_profile_t *bp)
 {
     int err;
-    int i;
-    char *path;
-    char *alt_name;
-    kv_vector_t param_refs;    // Map of all parameter references {parameter path vs alternative name} (from Device.BulkData.Profile.{i}.Parameter.*)
-    kv_vector_t param_values; // Map of {parameter path vs value} for a single parameter reference. There will be multiple entries in this map if the parameter reference contains wildcards or a partial path
-    kv_pair_t *kv;
-    
-    KV_VECTOR_Init(&param_values);
-    KV_VECTOR_Init(&param_refs);
-    
-    // Get the paths and alternative names of all parameters that are to be posted from this profile
-    err = bulkdata_platform_get_parameter_paths(bp->profile_id, &param_refs);
-    if (err != USP_ERR_OK)
+    int end;
+    unsigned start_time;
+    collection_plan_t *plan;
+    collection_item_t *item;
+    kv_vector_t *report_map;
+    dm_typed_value_t tv;
+    char param_type_value[MAX_DM_VALUE_LEN+1];       // plus 1 to include leading type character
+
+    // Determine the parameters to collect in this slice
+    plan = &bp->plan;
+    end = bp->collection_index + BULKDATA_COLLECTION_SLICE_SIZE;
+    if (end > plan->num_items)
     {
-        USP_ERR_SetMessage("%s: bulkdata_platform_get_parameter_paths() failed", __FUNCTION__);
-        goto exit;
+        end = plan->num_items;
     }
 
-    // Iterate over each parameter to get it's values
-    for (i=0; i < param_refs.num_entries; i++)
+    // Iterate over each parameter in the slice, adding its value to the report map
+    start_time = tu_uptime_msecs();
+    report_map = &bp->collecting_report.report_map;
+    for ( ; bp->collection_index < end; bp->collection_index++)
     {
-        // Clear the map into which we place the expanded paths and values for this path
-        KV_VECTOR_Destroy(&param_values);
-
-        // Skip this path if it is blank
-        kv = &param_refs.vector[i];
-        path = kv->key;
-        alt_name = kv->value;
-        if (*path == '\0')
+        // Form the value string containing type character, followed by actual value
+        item = &plan->items[bp->collection_index];
+        param_type_value[0] = item->type;
+        if (item->is_grouped)
         {
-            continue;
+            err = bulkdata_get_group_parameter_value(bp, item->path, &param_type_value[1], sizeof(param_type_value)-1);
         }
-
-        // Get the expanded paths and values into the 'param_values' map
-        err = bulkdata_platform_get_parameter_values(path, &param_values);
-        if (err != USP_ERR_OK)
+        else
         {
-            // Skip this parameter if an error occurred. Continue building up other parameters
-            USP_LOG_Warning("%s: bulkdata_platform_get_parameter_values(%s) failed", __FUNCTION__, path);
-            continue;
+            err = DATA_MODEL_GetTypedParameterValue(item->path, &param_type_value[1], sizeof(param_type_value)-1, 0, &tv);
+            if ((err == USP_ERR_OK) && (tv.is_native))
+            {
+                param_type_value[0] = tolower(item->type);
+            }
         }
-        
-        // Append the obtained parameters to the report map, performing reduction of their name if an alternative_name is given
-        err = bulkdata_append_to_result_map(path, alt_name, &param_values, report_map); 
         if (err != USP_ERR_OK)
         {
             // Skip this parameter if an error occurred. Continue building up other parameters
-            USP_LOG_Warning("%s: bulkdata_append_to_result_map(%s) failed", __FUNCTION__, path);
+            USP_LOG_Warning("%s: Unable to get value of %s", __FUNCTION__, item->path);
             continue;
         }
+
+        KV_VECTOR_Add(report_map, item->report_name, param_type_value);
     }
 
-    err = USP_ERR_OK;
+    bp->collection_busy_time += tu_uptime_msecs() - start_time;
+    bp->collection_slices++;
 
-exit:
-    KV_VECTOR_Destroy(&param_refs);
-    KV_VECTOR_Destroy(&param_values);
-    return err;
+    return (bp->collection_index >= plan->num_items) ? true : false;
 }
 
 /*********************************************************************//**
 **
-**  bulkdata_append_to_result_map
+**  bulkdata_get_group_parameter_value
 **
-**  Appends the parameters contained in a map to the results map
-**  When doing this, take account of alternative name, and type of each parameter
+**  Gets the value of a parameter whose parent object has a group get callback
+**  The values of all parameters in the object instance are obtained at once, and cached for the rest of the collection,
+**  so that the vendor is only called once per object instance, and the values reported for it are consistent with each other
+**  NOTE: Only the last object instance is cached. The parameters of an object instance are contiguous in the collection plan,
+**        unless the profile references them separately
+**
+** \param   bp - pointer to bulk data profile which is collecting
+** \param   path - data model path of the parameter
+** \param   buf - pointer to buffer in which to return the value
+** \param   len - length of buffer
 **
-** \param   origin_path - original path to parameter to get (This may be a partial path, or contain wildcards)
-** \param   alt_name - alternative name for the above path
-** \param   param_values - map containing {parameter path vs parameter value} obtained from expansion of the 'path'
-** \param   report_map - map which this function appends the 'param_values' map to
-**          
 ** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-int bulkdata_append_to_result_map(char *origin_path, char *alt_name, kv_vector_t *param_values, kv_vector_t *report_map)
+int bulkdata_get_group_parameter_value(bulkdata_profile_t *bp, char *path, char *buf, int len)
 {
     int err;
-    int i;
-    char *path;
-    char reduced_path[MAX_DM_PATH];
-    char param_type_value[MAX_DM_VALUE_LEN+1];       // plus 1 to include leading JSON type character
-    char type;
-    char *value;
-    kv_pair_t *kv;
+    int index;
+    char *name;
+    int obj_len;
+
+    // Split the path into the object instance and the name of the parameter within it
+    name = strrchr(path, '.');
+    USP_ASSERT(name != NULL);
+    obj_len = name - path;
+    name++;
 
-    // Iterate over each parameter, adding it to the result map
-    for (i=0; i < param_values->num_entries; i++)
+    // Get the values of all parameters in the object instance, if they are not already cached
+    if ((bp->group_path == NULL) || (strncmp(bp->group_path, path, obj_len) != 0) || (bp->group_path[obj_len] != '\0'))
     {
-        kv = &param_values->vector[i];
-        path = kv->key;
-        value = kv->value;
-        
-        // Calculate the path name to put into the result map
-        err = bulkdata_reduce_to_alt_name(origin_path, path, alt_name, reduced_path, sizeof(reduced_path));
+        bulkdata_clear_group_values(bp);
+        bp->group_path = USP_STRDUP(path);
+        bp->group_path[obj_len] = '\0';
+        err = DATA_MODEL_GetGroupParameterValues(bp->group_path, &bp->group_values);
         if (err != USP_ERR_OK)
         {
-            USP_ERR_SetMessage("%s: bulkdata_reduce_to_alt_name(%s) failed", __FUNCTION__, path);
-            continue; // Skip this parameter, if an error occurred
+            // If an error occurred, then the parameters in this object instance are obtained individually
+            USP_LOG_Warning("%s: Unable to get values of %s", __FUNCTION__, bp->group_path);
+            KV_VECTOR_Destroy(&bp->group_values);
         }
+    }
 
-        // Calculate the JSON type of the parameter
-        type = bulkdata_platform_get_parameter_type(path);
-
-        // Form the value string containing JSON type character, followed by actual value
-        param_type_value[0] = type;
-        USP_STRNCPY(&param_type_value[1], value, sizeof(param_type_value)-1);
-
-        // Finally insert the string into the report map
-        KV_VECTOR_Add(report_map, reduced_path, param_type_value);
+    // Get the parameter individually, if the group get callback did not return it
+    index = KV_VECTOR_FindKey(&bp->group_values, name, 0);
+    if (index == INVALID)
+    {
+        return DATA_MODEL_GetParameterValue(path, buf, len, 0);
     }
 
+    USP_STRNCPY(buf, bp->group_values.vector[index].value, len);
     return USP_ERR_OK;
 }
 
 /*********************************************************************//**
 **
-**  bulkdata_reduce_to_alt_name
+**  bulkdata_clear_group_values
 **
-**  Reduce the full path name to one that (potentially) contains an alternative name
-**  See TR-157 section A.3.2 for the rules involving reduction
+**  Frees the parameter values cached from the group get callback of an object instance
 **
-** \param   spec - path specification (This may be a partial path, or contain wildcards, and one of it's expansions was 'path')
-** \param   path - fully expanded data model path
-** \param   alt_name - alternative name for the above path
-** \param   reduced_path - pointer to buffer in which to return the reduced name
-** \param   len - size of buffer in which to return the reduced name
-**          
-** \return  USP_ERR_OK if successful
+** \param   bp - pointer to bulk data profile
+**
+** \return  None
 **
 **************************************************************************/
-int bulkdata_reduce_to_alt_name(char *spec, char *path, char *alt_name, char *out_buf, int buf_len)
+void bulkdata_clear_group_values(bulkdata_profile_t *bp)
 {
-    char *s;    // pointer stepping thru spec
-    char *p;    // pointer stepping thru path
-    char *o;    // pointer stepping thru out_buf
-
-    // Exit if no alt_name - no reduction necessary
-    if (*alt_name == '\0')
-    {
-        USP_STRNCPY(out_buf, path, buf_len);
-        return USP_ERR_OK;
-    }
-
-
-    // Exit if out_buf is not large enough to hold initial alt_name root
-    if (buf_len < strlen(alt_name) + 1)
-    {
-        return USP_ERR_INTERNAL_ERROR;
-    }
+    USP_SAFE_FREE(bp->group_path);
+    KV_VECTOR_Destroy(&bp->group_values);
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_finish_collection
+**
+**  Called when a profile has finished collecting its report map, to record the statistics of the collection,
+**  and to allow the next profile waiting to collect to start
+**
+** \param   bp - pointer to bulk data profile which has finished collecting
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_finish_collection(bulkdata_profile_t *bp)
+{
+    collection_stats_t *stats;
+
+    stats = &bp->last_collection;
+    stats->duration = tu_uptime_msecs() - bp->collection_start;
+    stats->busy_time = bp->collection_busy_time;
+    stats->num_params = bp->plan.num_items;
+    stats->num_slices = bp->collection_slices;
+
+    bulkdata_clear_group_values(bp);
+    bp->is_collecting = false;
+    bulkdata_release_collection(bp);
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_abort_collection
+**
+**  Abandons the collection in progress (if any) for the specified profile
+**
+** \param   bp - pointer to bulk data profile
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_abort_collection(bulkdata_profile_t *bp)
+{
+    // Exit if the profile is not collecting
+    if (bp->is_collecting == false)
+    {
+        return;
+    }
+
+    KV_VECTOR_Destroy(&bp->collecting_report.report_map);
+    bp->collecting_report.collection_time = 0;
+    bulkdata_clear_group_values(bp);
+    bp->is_collecting = false;
+    bulkdata_release_collection(bp);
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_release_collection
+**
+**  Called when a profile stops collecting, to restart the next profile which is waiting to collect
+**  Profiles are restarted in round robin order, starting from the profile after the one which stopped collecting
+**
+** \param   bp - pointer to bulk data profile which has stopped collecting
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_release_collection(bulkdata_profile_t *bp)
+{
+    int i;
+    int index;
+    bulkdata_profile_t *next;
+
+    // Exit if this profile was waiting to collect, rather than collecting
+    if (collecting_profile != bp)
+    {
+        return;
+    }
+    collecting_profile = NULL;
+
+    // Iterate over all other profiles, restarting the first one found which is waiting to collect
+    index = bulkdata_find_profile_index(bp->profile_id);
+    USP_ASSERT(index != INVALID);
+    for (i=1; i < num_bulkdata_profiles; i++)
+    {
+        next = bulkdata_profiles[(index + i) % num_bulkdata_profiles];
+        if (next->is_collecting)
+        {
+            SYNC_TIMER_Reload(bulkdata_process_profile, next->profile_id, time(NULL));
+            return;
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_send_report
+**
+**  Tells the BDC thread to send the specified report, or the oldest retained report in the spool
+**
+** \param   bp - pointer to bulk data profile
+** \param   ctrl - pointer to control parameters of the profile
+** \param   report - pointer to dynamically allocated buffer containing the report to send, or NULL to send the oldest retained report
+**                   NOTE: Ownership of this buffer passes to this function
+** \param   report_len - length of the report (if not sending the oldest retained report)
+** \param   flags - BDC_FLAG_xxx flags describing the encoding and compression of the report (if not sending the oldest retained report)
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_send_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, unsigned char *report, int report_len, unsigned flags)
+{
+    int err;
+    char buf[48];
+
+    bp->max_retained_reports = ctrl->num_retained_failed_reports;
+    if (report == NULL)
+    {
+        // Exit if there are no retained reports to send (eg the retained report being retried has been dropped)
+        report = BULKDATA_SPOOL_ReadOldest(&bp->spool, &report_len, &flags, &bp->sending_seq);
+        if (report == NULL)
+        {
+            bp->retry_count = 0;
+            bulkdata_resync_profile(bp, NULL);
+            return;
+        }
+        bp->is_sending_spooled = true;
+    }
+    else
+    {
+        // Keep a copy of the report, if it is to be retained should it fail to send
+        bp->is_sending_spooled = false;
+        if ((bp->max_retained_reports > 0) || (bp->retry_enable))
+        {
+            bp->sending_report = USP_MALLOC(report_len+1);      // Plus 1 to allow for a zero length report
+            memcpy(bp->sending_report, report, report_len);
+            bp->sending_report_len = report_len;
+            bp->sending_report_flags = flags;
+        }
+    }
+    bp->is_sending = true;
+
+    USP_LOG_Info("\nBULK DATA: %sing at time %s, to url=%s", ctrl->method, iso8601_cur_time(buf, sizeof(buf)), ctrl->url);
+    USP_LOG_Info("BULK DATA: using compression method=%s", ctrl->compression);
+
+    // Exit if failed to tell BDC thread to send the report
+    err = bulkdata_schedule_sending_report(ctrl, bp, report, report_len, flags);
+    if (err != USP_ERR_OK)
+    {
+        DEVICE_BULKDATA_NotifyTransferResult(bp->profile_id, false, NULL);
+    }
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_send_next_spooled_report
+**
+**  Called after a report has been sent successfully, to send the next retained report in the spool
+**  If there are no more retained reports, then the profile's sync timer is restarted instead
+**
+** \param   bp - pointer to bulk data profile
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_send_next_spooled_report(bulkdata_profile_t *bp)
+{
+    int err;
+    profile_ctrl_params_t ctrl;
+
+    // Exit if there are no more retained reports, restarting the sync timer with the time until the next reporting interval
+    if (bp->spool.num_entries == 0)
+    {
+        bulkdata_resync_profile(bp, NULL);
+        return;
+    }
+
+    // Exit if unable to obtain the control parameters for this profile. The retained reports will be sent at the next reporting interval
+    err = bulkdata_platform_get_profile_control_params(bp, &ctrl);
+    if (err != USP_ERR_OK)
+    {
+        bulkdata_resync_profile(bp, NULL);
+        return;
+    }
+
+    bulkdata_send_report(bp, &ctrl, NULL, 0, 0);
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_retain_failed_report
+**
+**  Called after a report has failed to send, to retain it in the spool (if it is not already there)
+**
+** \param   bp - pointer to bulk data profile
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_retain_failed_report(bulkdata_profile_t *bp)
+{
+    int err;
+    int max_reports;
+
+    // Exit if the report is already in the spool, or is not to be retained
+    if (bp->sending_report == NULL)
+    {
+        return;
+    }
+
+    // Exit if unable to append the report to the spool
+    err = BULKDATA_SPOOL_Append(&bp->spool, bp->sending_report, bp->sending_report_len, bp->sending_report_flags);
+    if (err != USP_ERR_OK)
+    {
+        USP_LOG_Error("%s: Unable to spool failed report for profile_id=%d", __FUNCTION__, bp->profile_id);
+        return;
+    }
+
+    // Drop the oldest retained reports, if we would store more than we're meant to
+    // NOTE: If failed reports are not retained, then the failed report is kept only for retries, until the next report is generated
+    max_reports = (bp->max_retained_reports > 0) ? bp->max_retained_reports : 1;
+    BULKDATA_SPOOL_Trim(&bp->spool, max_reports);
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_free_sending_report
+**
+**  Frees the copy of the report which was being sent, and marks the profile as not sending
+**
+** \param   bp - pointer to bulk data profile
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_free_sending_report(bulkdata_profile_t *bp)
+{
+    USP_SAFE_FREE(bp->sending_report);
+    bp->sending_report_len = 0;
+    bp->sending_report_flags = 0;
+    bp->is_sending = false;
+    bp->is_sending_spooled = false;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_clear_reports
+**
+**  Clears out the report maps of all reports contained in the report being generated
+**
+** \param   bp - pointer to bulk data profile to clear all report maps
+**          
+** \return  None
+**
+**************************************************************************/
+void bulkdata_clear_reports(bulkdata_profile_t *bp)
+{
+    int i;
+    report_t *r;
+    
+    for (i=0; i < bp->num_reports; i++)
+    {
+        r = &bp->reports[i];
+        KV_VECTOR_Destroy(&r->report_map);
+        r->collection_time = 0;
+    }
+
+    bp->reports = NULL;
+    bp->num_reports = 0;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_build_plan
+**
+**  Builds the collection plan for the specified profile, from its parameter references
+**  The plan contains the resolved path, report name and type of each parameter to collect, so that these do not
+**  have to be recalculated every reporting interval
+**
+** \param   profile_id - Instance number of profile in Device.BulkData.Profile.{i}
+** \param   plan - pointer to (empty) collection plan to build
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int bulkdata_build_plan(int profile_id, collection_plan_t *plan)
+{
+    int err;
+    int i;
+    char *path;
+    char *alt_name;
+    kv_vector_t param_refs;    // Map of all parameter references {parameter path vs alternative name} (from Device.BulkData.Profile.{i}.Parameter.*)
+    str_vector_t params;       // Resolved paths of a single parameter reference. There will be multiple entries if the parameter reference contains wildcards or a partial path
+    kv_pair_t *kv;
+
+    KV_VECTOR_Init(&param_refs);
+
+    // Exit if unable to get the paths and alternative names of all parameters that are to be posted from this profile
+    err = bulkdata_platform_get_parameter_paths(profile_id, &param_refs);
+    if (err != USP_ERR_OK)
+    {
+        USP_ERR_SetMessage("%s: bulkdata_platform_get_parameter_paths() failed", __FUNCTION__);
+        goto exit;
+    }
+
+    // Iterate over each parameter reference, resolving it into the parameters to collect
+    for (i=0; i < param_refs.num_entries; i++)
+    {
+        // Skip this path if it is blank
+        kv = &param_refs.vector[i];
+        path = kv->key;
+        alt_name = kv->value;
+        if (*path == '\0')
+        {
+            continue;
+        }
+
+        // Record the tables which this parameter reference may expand into, so that the plan is rebuilt if their instances change
+        // NOTE: This is done even if the reference cannot currently be resolved, as it may become resolvable when instances are added
+        bulkdata_add_plan_tables(path, plan);
+
+        // Get the expanded paths into the 'params' vector
+        STR_VECTOR_Init(&params);
+        err = bulkdata_platform_resolve_parameter_paths(path, &params);
+        if (err != USP_ERR_OK)
+        {
+            // Skip this parameter if an error occurred. Continue building up other parameters
+            USP_LOG_Warning("%s: bulkdata_platform_resolve_parameter_paths(%s) failed", __FUNCTION__, path);
+            continue;
+        }
+
+        // Append the resolved parameters to the plan, performing reduction of their name if an alternative_name is given
+        bulkdata_append_to_plan(path, alt_name, &params, plan);
+        STR_VECTOR_Destroy(&params);
+    }
+
+    plan->is_valid = true;
+    err = USP_ERR_OK;
+
+exit:
+    KV_VECTOR_Destroy(&param_refs);
+    return err;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_append_to_plan
+**
+**  Appends the resolved parameters of a parameter reference to the collection plan
+**  When doing this, take account of alternative name, and type of each parameter
+**
+** \param   origin_path - original path to parameter to get (This may be a partial path, or contain wildcards)
+** \param   alt_name - alternative name for the above path
+** \param   params - vector containing the parameter paths obtained from expansion of the 'origin_path'
+** \param   plan - pointer to collection plan to append the parameters to
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_append_to_plan(char *origin_path, char *alt_name, str_vector_t *params, collection_plan_t *plan)
+{
+    int err;
+    int i;
+    char *path;
+    char reduced_path[MAX_DM_PATH];
+    collection_item_t *item;
+
+    // Exit if there are no parameters to add
+    if (params->num_entries == 0)
+    {
+        return;
+    }
+
+    // Increase the size of the plan to accommodate all of the parameters
+    plan->items = USP_REALLOC(plan->items, (plan->num_items + params->num_entries)*sizeof(collection_item_t));
+
+    // Iterate over each parameter, adding it to the plan
+    for (i=0; i < params->num_entries; i++)
+    {
+        // Calculate the path name to put into the report
+        path = params->vector[i];
+        err = bulkdata_reduce_to_alt_name(origin_path, path, alt_name, reduced_path, sizeof(reduced_path));
+        if (err != USP_ERR_OK)
+        {
+            USP_ERR_SetMessage("%s: bulkdata_reduce_to_alt_name(%s) failed", __FUNCTION__, path);
+            continue; // Skip this parameter, if an error occurred
+        }
+
+        item = &plan->items[plan->num_items];
+        item->path = USP_STRDUP(path);
+        item->report_name = USP_STRDUP(reduced_path);
+        item->type = bulkdata_platform_get_parameter_type(path);
+        item->is_grouped = DATA_MODEL_IsGroupParameter(path);
+        plan->num_items++;
+    }
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_add_plan_tables
+**
+**  Records the tables which the specified parameter reference may expand into, in the collection plan
+**  These are all tables (top level multi-instance objects) in the path of the reference, or beneath it (if it is a partial path)
+**  NOTE: Instances of nested tables are held by their top level multi-instance object, so only top level tables need to be recorded
+**
+** \param   origin_path - path of the parameter reference (This may be a partial path, or contain wildcards)
+** \param   plan - pointer to collection plan
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_add_plan_tables(char *origin_path, collection_plan_t *plan)
+{
+    char path[MAX_DM_PATH];
+    char *p;
+    int len;
+    dm_node_t *node;
+    dm_instances_t inst;            // unused
+    bool is_qualified_instance;     // unused
+
+    // Replace wildcards with a dummy instance number, and remove any trailing '.' (from a partial path)
+    // NOTE: The node is found regardless of whether the instance numbers exist
+    USP_STRNCPY(path, origin_path, sizeof(path));
+    for (p = path; *p != '\0'; p++)
+    {
+        if (*p == '*')
+        {
+            *p = '1';
+        }
+    }
+
+    len = strlen(path);
+    if ((len > 0) && (path[len-1] == '.'))
+    {
+        path[len-1] = '\0';
+    }
+
+    // Exit if the path is not present in the schema
+    node = DM_PRIV_GetNodeFromPath(path, &inst, &is_qualified_instance);
+    if (node == NULL)
+    {
+        return;
+    }
+
+    // If the reference is within a table, then that table's top level multi-instance object holds all instances which it can expand into
+    if (node->order > 0)
+    {
+        bulkdata_add_plan_table(node->instance_nodes[0], plan);
+        return;
+    }
+
+    // Otherwise the reference is a partial path which may contain tables beneath it
+    bulkdata_add_plan_child_tables(node, plan);
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_add_plan_child_tables
+**
+**  Records all top level multi-instance objects beneath the specified node, in the collection plan
+**
+** \param   node - pointer to data model node (which is not contained within a multi-instance object)
+** \param   plan - pointer to collection plan
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_add_plan_child_tables(dm_node_t *node, collection_plan_t *plan)
+{
+    dm_node_t *child;
+
+    child = (dm_node_t *) node->child_nodes.head;
+    while (child != NULL)
+    {
+        if (child->type == kDMNodeType_Object_MultiInstance)
+        {
+            bulkdata_add_plan_table(child, plan);
+        }
+        else if (child->type == kDMNodeType_Object_SingleInstance)
+        {
+            bulkdata_add_plan_child_tables(child, plan);
+        }
+
+        child = (dm_node_t *) child->link.next;
+    }
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_add_plan_table
+**
+**  Records the current instance generation of the specified table in the collection plan (if not already recorded)
+**
+** \param   top_node - pointer to top level multi-instance object
+** \param   plan - pointer to collection plan
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_add_plan_table(dm_node_t *top_node, collection_plan_t *plan)
+{
+    int i;
+    collection_table_t *table;
+
+    // Exit if the table has already been recorded
+    for (i=0; i < plan->num_tables; i++)
+    {
+        if (plan->tables[i].node == top_node)
+        {
+            return;
+        }
+    }
+
+    plan->tables = USP_REALLOC(plan->tables, (plan->num_tables+1)*sizeof(collection_table_t));
+    table = &plan->tables[plan->num_tables];
+    table->node = top_node;
+    table->generation = DM_INST_VECTOR_GetGeneration(top_node);
+    plan->num_tables++;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_is_plan_valid
+**
+**  Determines whether the collection plan is up to date
+**  The plan is out of date if the profile's parameter references have changed, or if instances have been added to
+**  or deleted from any of the tables which the parameter references may expand into
+**
+** \param   plan - pointer to collection plan
+**
+** \return  true if the collection plan is up to date
+**
+**************************************************************************/
+bool bulkdata_is_plan_valid(collection_plan_t *plan)
+{
+    int i;
+    collection_table_t *table;
+
+    // Exit if the plan has been invalidated (or never built)
+    if (plan->is_valid == false)
+    {
+        return false;
+    }
+
+    // Exit if the instances of any table have changed
+    for (i=0; i < plan->num_tables; i++)
+    {
+        table = &plan->tables[i];
+        if (DM_INST_VECTOR_GetGeneration(table->node) != table->generation)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_invalidate_plan
+**
+**  Marks the collection plan of the specified profile as out of date, so that it is rebuilt when the next report is collected
+**
+** \param   profile_id - Instance number of profile in Device.BulkData.Profile.{i}
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_invalidate_plan(int profile_id)
+{
+    bulkdata_profile_t *bp;
+
+    bp = bulkdata_find_profile(profile_id);
+    if (bp != NULL)
+    {
+        bp->plan.is_valid = false;
+    }
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_destroy_plan
+**
+**  Frees all memory associated with the collection plan, leaving it empty and out of date
+**
+** \param   plan - pointer to collection plan
+**
+** \return  None
+**
+**************************************************************************/
+void bulkdata_destroy_plan(collection_plan_t *plan)
+{
+    int i;
+    collection_item_t *item;
+
+    for (i=0; i < plan->num_items; i++)
+    {
+        item = &plan->items[i];
+        USP_FREE(item->path);
+        USP_FREE(item->report_name);
+    }
+
+    USP_SAFE_FREE(plan->items);
+    USP_SAFE_FREE(plan->tables);
+    memset(plan, 0, sizeof(collection_plan_t));
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_reduce_to_alt_name
+**
+**  Reduce the full path name to one that (potentially) contains an alternative name
+**  See TR-157 section A.3.2 for the rules involving reduction
+**
+** \param   spec - path specification (This may be a partial path, or contain wildcards, and one of it's expansions was 'path')
+** \param   path - fully expanded data model path
+** \param   alt_name - alternative name for the above path
+** \param   reduced_path - pointer to buffer in which to return the reduced name
+** \param   len - size of buffer in which to return the reduced name
+**          
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int bulkdata_reduce_to_alt_name(char *spec, char *path, char *alt_name, char *out_buf, int buf_len)
+{
+    char *s;    // pointer stepping thru spec
+    char *p;    // pointer stepping thru path
+    char *o;    // pointer stepping thru out_buf
+
+    // Exit if no alt_name - no reduction necessary
+    if (*alt_name == '\0')
+    {
+        USP_STRNCPY(out_buf, path, buf_len);
+        return USP_ERR_OK;
+    }
+
+
+    // Exit if out_buf is not large enough to hold initial alt_name root
+    if (buf_len < strlen(alt_name) + 1)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
 
     p = path;
     s = spec;
@@ -2346,292 +3646,856 @@ int bulkdata_reduce_to_alt_name(char *spec, char *path, char *alt_name, char *ou
     o = &out_buf[strlen(out_buf)];
     *o++ = '.';     // add trailing delimiter, assuming there will be other nodes to add
 
-    while (*p != '\0')
-    {
-        // Exit if out_buf is not large enough to hold any more
-        if (o >= &out_buf[buf_len]-1)
-        {
-            return USP_ERR_INTERNAL_ERROR;
+    while (*p != '\0')
+    {
+        // Exit if out_buf is not large enough to hold any more
+        if (o >= &out_buf[buf_len]-1)
+        {
+            return USP_ERR_INTERNAL_ERROR;
+        }
+
+        if (*p == *s)
+        {
+            // Skip character, if path received equals spec
+            p++;
+            s++;
+        }
+        else
+        {
+            if (*s == '*')
+            {
+                // Copy index characters at wildcard
+                *o++ = *p++;
+                if (*p == '.')
+                {
+                    s++;    // Only move off the wildcard character when we have copied all of the index characters
+                    *o++ = '.';
+                }
+            }
+            else
+            {
+                // Copy characters at end of path, avoiding copying double '.' into output (This is necessary if spec is a partial path that does not end in a '.)
+                if ((o[-1] == '.') && (*p == '.'))
+                {
+                    p++;    // case of double '.', skip second '.'
+                }
+                else
+                {
+                    *o++ = *p++;
+                }
+            }
+        }
+    }
+
+    // Remove any trailing delimiter
+    if (o[-1] == '.')
+    {
+        o[-1] = '\0';
+    }
+
+    // Ensure buffer is zero terminated
+    *o = '\0';
+    return USP_ERR_OK;
+}
+
+#if 0
+//--------------------------------------------------------------------------
+// Test code
+
+//int test_reduce(void)
+//{
+//    char buf[100];
+//
+//    // fully qualified
+//    bulkdata_reduce_to_alt_name("Device.Stuff.Hello", 
+//                                "Device.Stuff.Hello",
+//                                "alt", buf);
+//
+//    // partial path
+//    bulkdata_reduce_to_alt_name("Device.Stuff.Hello.", 
+//                                "Device.Stuff.Hello.This.Should.Be.1.Addded",
+//                                "alt", buf);
+//
+//    // partial path, no trailing '.' in spec
+//    bulkdata_reduce_to_alt_name("Device.Stuff.Hello", 
+//                                "Device.Stuff.Hello.This.Should.Be.2.Addded",
+//                                "alt", buf);
+//
+//    // wildcard
+//    bulkdata_reduce_to_alt_name("Device.*.Stuff.*.Hello", 
+//                                "Device.56.Stuff.72.Hello",
+//                                "alt", buf);
+//
+//    // wildcard with partial path
+//    bulkdata_reduce_to_alt_name("Device.*.Stuff.*.Hello.", 
+//                                "Device.56.Stuff.72.Hello.This.Should.Be.3.Addded",
+//                                "alt", buf);
+//
+//    // wildcard with partial path, no trailing '.' in spec
+//    bulkdata_reduce_to_alt_name("Device.*.Stuff.*.Hello", 
+//                                "Device.56.Stuff.72.Hello.This.Should.Be.4.Addded",
+//                                "alt", buf);
+//
+//    return 0;
+//}
+#endif
+
+/*********************************************************************//**
+**
+**  bulkdata_generate_report
+**
+**  Generates the report to send (JSON or CSV encoded), compressing it (if enabled)
+**  When compression is enabled, the report is compressed in chunks as it is generated, so the uncompressed report is never held in memory
+**  NOTE: If compression fails, then the report is generated uncompressed, and ctrl->compression is updated to indicate this
+**
+** \param   bp - pointer to bulk data profile containing all reports (current and retained)
+** \param   ctrl - pointer to structure containing the controlling parameters for the profile we are generating a report for
+** \param   p_report_len - pointer to variable in which to return the length of the report
+**          
+** \return  pointer to dynamically allocated buffer containing the report to send
+**
+**************************************************************************/
+unsigned char *bulkdata_generate_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, int *p_report_len)
+{
+    json_writer_t jw;
+    csv_writer_t cw;
+    char *text_report;
+    unsigned char *report;
+
+    // Exit if the report was generated compressed
+    if (strcmp(ctrl->compression, "None") != 0)
+    {
+        report = bulkdata_generate_compressed_report(bp, ctrl, p_report_len);
+        if (report != NULL)
+        {
+            return report;
+        }
+
+        USP_LOG_Warning("%s: WARNING: Compression failed. Falling back to sending uncompressed data", __FUNCTION__);
+        USP_STRNCPY(ctrl->compression, "None", sizeof(ctrl->compression));
+    }
+
+    // Generate the uncompressed report
+    if (strcmp(ctrl->encoding_type, BULKDATA_ENCODING_TYPE_CSV)==0)
+    {
+        CSV_WRITER_Init(&cw, ctrl->csv_field_separator, ctrl->csv_row_separator, ctrl->csv_escape_char);
+        bulkdata_write_csv_report(bp, ctrl, &cw);
+        text_report = CSV_WRITER_Finish(&cw);
+    }
+    else
+    {
+        JSON_WRITER_Init(&jw, " ");
+        bulkdata_write_json_report(bp, ctrl, &jw);
+        text_report = JSON_WRITER_Finish(&jw);
+    }
+
+    // Print out the report, if debugging is enabled
+    if (enable_protocol_trace)
+    {
+        USP_LOG_String(kLogType_Protocol, text_report);
+    }
+
+    *p_report_len = strlen(text_report);
+    return (unsigned char *)text_report;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_write_json_report
+**
+**  Writes a JSON name-value pair format report
+**  NOTE: The report contains all retained failed reports, as well as the current report
+**  See TR-157 section A.4.2 (end) for an example, and section A.3.5.2 for layout of content containing failed report transmissions
+**
+** \param   bp - pointer to bulk data profile containing all reports (current and retained)
+** \param   ctrl - pointer to structure containing the controlling parameters for the profile we are generating a report for
+** \param   jw - pointer to JSON writer to write the report to
+**          
+** \return  None
+**
+**************************************************************************/
+void bulkdata_write_json_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, json_writer_t *jw)
+{
+    char *param_path;
+    char *param_type_value;
+    char param_type;
+    char *param_value;
+    kv_vector_t *report_map;
+    report_t *report;
+    double value_as_number;
+    bool value_as_bool;
+    char *result;
+    int i, j;
+    char buf[32];
+    kv_pair_t *kv;
+    int err;
+
+    JSON_WRITER_StartObject(jw, NULL);
+    JSON_WRITER_StartArray(jw, "Report");
+
+    // Iterate over all reports adding them to the JSON array
+    for (i=0; i < bp->num_reports; i++)
+    {
+        report = &bp->reports[i];
+        report_map = &report->report_map;
+
+        // Add Collection time to each json report element (only if specified and not 'None')
+        JSON_WRITER_StartObject(jw, NULL);
+        if (strcmp(ctrl->report_timestamp, "Unix-Epoch")==0)
+        {
+            JSON_WRITER_AddNumber(jw, "CollectionTime", report->collection_time);
+        } 
+        else if (strcmp(ctrl->report_timestamp, "ISO-8601")==0)
+        {
+            result = iso8601_from_unix_time(report->collection_time, buf, sizeof(buf));
+            if (result != NULL)
+            {
+                JSON_WRITER_AddString(jw, "CollectionTime", buf);
+            }
+        }
+
+        // Iterate over each parameter, adding it to the json element. Take account of the parameter's type
+        for (j=0; j < report_map->num_entries; j++)
+        {
+            kv = &report_map->vector[j];
+            param_path = kv->key;
+            param_type_value = kv->value;
+            param_type = param_type_value[0];           // First character denotes the type of the parameter
+            param_value = &param_type_value[1];         // Subsequent characters contain the parameter's value
+
+            switch (param_type)
+            {
+                case 'S':
+                case 'D':
+                case 'd':
+                    JSON_WRITER_AddString(jw, param_path, param_value);
+                    break;
+
+                case 'i':
+                case 'u':
+                case 'l':
+                    // Integers obtained in native form are already canonical JSON integers
+                    JSON_WRITER_AddRaw(jw, param_path, param_value);
+                    break;
+
+                case 'b':
+                    JSON_WRITER_AddBool(jw, param_path, (strcmp(param_value, "true")==0) ? true : false);
+                    break;
+
+                case 'I':
+                case 'U':
+                case 'L':
+                    // Write integers verbatim, rather than converting them to a double and back
+                    // (which is slower, and loses precision for unsignedLong values greater than 2^53)
+                    if (bulkdata_is_json_integer(param_value))
+                    {
+                        JSON_WRITER_AddRaw(jw, param_path, param_value);
+                    }
+                    else
+                    {
+                        value_as_number = atof(param_value);
+                        JSON_WRITER_AddNumber(jw, param_path, value_as_number);
+                    }
+                    break;
+
+                case 'B':
+                    err = TEXT_UTILS_StringToBool(param_value, &value_as_bool);
+                    if (err == USP_ERR_OK)
+                    {
+                        JSON_WRITER_AddBool(jw, param_path, value_as_bool);
+                    }
+                    break;
+
+                default:
+                    USP_ERR_SetMessage("%s: Invalid JSON parameter type ('%c') in report map for %s", __FUNCTION__, param_type_value[0], param_path);
+                    break;
+            }
         }
 
-        if (*p == *s)
+        // Finish the json element
+        JSON_WRITER_EndObject(jw);
+    }
+
+    // Finish the array and the report top level
+    JSON_WRITER_EndArray(jw);
+    JSON_WRITER_EndObject(jw);
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_write_csv_report
+**
+**  Writes a CSV format report, in the format selected by Device.BulkData.Profile.{i}.CSVEncoding.ReportFormat
+**  NOTE: The report contains all retained failed reports, as well as the current report
+**  See TR-157 section A.3.2 for the layout of CSV reports
+**
+** \param   bp - pointer to bulk data profile containing all reports (current and retained)
+** \param   ctrl - pointer to structure containing the controlling parameters for the profile we are generating a report for
+** \param   cw - pointer to CSV writer to write the report to
+**          
+** \return  None
+**
+**************************************************************************/
+void bulkdata_write_csv_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, csv_writer_t *cw)
+{
+    if (strcmp(ctrl->csv_report_format, BULKDATA_CSV_REPORT_FORMAT_PER_ROW)==0)
+    {
+        bulkdata_write_csv_report_per_row(bp, ctrl, cw);
+    }
+    else
+    {
+        bulkdata_write_csv_report_per_column(bp, ctrl, cw);
+    }
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_write_csv_report_per_row
+**
+**  Writes a CSV report in ParameterPerRow format
+**  Each row contains the collection time (if enabled), name, value and type of a single parameter
+**
+** \param   bp - pointer to bulk data profile containing all reports (current and retained)
+** \param   ctrl - pointer to structure containing the controlling parameters for the profile we are generating a report for
+** \param   cw - pointer to CSV writer to write the report to
+**          
+** \return  None
+**
+**************************************************************************/
+void bulkdata_write_csv_report_per_row(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, csv_writer_t *cw)
+{
+    int i, j;
+    report_t *report;
+    kv_vector_t *report_map;
+    kv_pair_t *kv;
+    bool has_timestamp;
+
+    // Write the header row
+    has_timestamp = (strcmp(ctrl->report_timestamp, BULKDATA_JSON_TIMESTAMP_FORMAT_NONE) != 0);
+    if (has_timestamp)
+    {
+        CSV_WRITER_AddField(cw, "ReportTimestamp");
+    }
+    CSV_WRITER_AddField(cw, "ParameterName");
+    CSV_WRITER_AddField(cw, "ParameterValue");
+    CSV_WRITER_AddField(cw, "ParameterType");
+    CSV_WRITER_EndRow(cw);
+
+    // Iterate over all reports, writing a row for each parameter
+    for (i=0; i < bp->num_reports; i++)
+    {
+        report = &bp->reports[i];
+        report_map = &report->report_map;
+        for (j=0; j < report_map->num_entries; j++)
         {
-            // Skip character, if path received equals spec
-            p++;
-            s++;
+            kv = &report_map->vector[j];
+            if (has_timestamp)
+            {
+                bulkdata_add_csv_timestamp_field(ctrl, report, cw);
+            }
+            CSV_WRITER_AddField(cw, kv->key);
+            CSV_WRITER_AddField(cw, &kv->value[1]);     // Skip the first character, which denotes the type of the parameter
+            CSV_WRITER_AddField(cw, bulkdata_get_csv_type_name(toupper(kv->value[0])));
+            CSV_WRITER_EndRow(cw);
         }
-        else
+    }
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_write_csv_report_per_column
+**
+**  Writes a CSV report in ParameterPerColumn format
+**  The header row contains the parameter names, and each subsequent row contains the collection time (if enabled)
+**  and parameter values of a single report
+**  NOTE: The columns are the union of the parameters in all reports. If a parameter is missing from a retained report
+**        (eg because the object containing it was deleted), then an empty field is written for it
+**
+** \param   bp - pointer to bulk data profile containing all reports (current and retained)
+** \param   ctrl - pointer to structure containing the controlling parameters for the profile we are generating a report for
+** \param   cw - pointer to CSV writer to write the report to
+**          
+** \return  None
+**
+**************************************************************************/
+void bulkdata_write_csv_report_per_column(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, csv_writer_t *cw)
+{
+    int i, j, k;
+    report_t *report;
+    kv_vector_t *report_map;
+    char **columns;
+    int num_columns;
+    int max_columns;
+    int index;
+    bool found;
+    bool has_timestamp;
+
+    // Determine the columns of the report
+    // NOTE: The columns point to the parameter names in the report maps, so are not copied
+    // NOTE: Usually every report contains the same parameters in the same order, so each parameter is first checked against the column at the same position, avoiding a search
+    max_columns = 0;
+    for (i=0; i < bp->num_reports; i++)
+    {
+        max_columns += bp->reports[i].report_map.num_entries;
+    }
+
+    columns = USP_MALLOC(sizeof(char *) * (max_columns + 1));   // Plus 1 to avoid a zero size allocation
+    num_columns = 0;
+    for (i=0; i < bp->num_reports; i++)
+    {
+        report_map = &bp->reports[i].report_map;
+        for (j=0; j < report_map->num_entries; j++)
         {
-            if (*s == '*')
+            // All parameters in the first report are new columns (parameter names within a report are unique)
+            if (i == 0)
             {
-                // Copy index characters at wildcard
-                *o++ = *p++;
-                if (*p == '.')
-                {
-                    s++;    // Only move off the wildcard character when we have copied all of the index characters
-                    *o++ = '.';
-                }
+                columns[num_columns++] = report_map->vector[j].key;
+                continue;
             }
-            else
+
+            found = ((j < num_columns) && (strcmp(columns[j], report_map->vector[j].key)==0));
+            for (k=0; (k < num_columns) && (found == false); k++)
             {
-                // Copy characters at end of path, avoiding copying double '.' into output (This is necessary if spec is a partial path that does not end in a '.)
-                if ((o[-1] == '.') && (*p == '.'))
-                {
-                    p++;    // case of double '.', skip second '.'
-                }
-                else
-                {
-                    *o++ = *p++;
-                }
+                found = (strcmp(columns[k], report_map->vector[j].key)==0);
+            }
+
+            if (found == false)
+            {
+                columns[num_columns++] = report_map->vector[j].key;
             }
         }
     }
 
-    // Remove any trailing delimiter
-    if (o[-1] == '.')
+    // Write the header row
+    has_timestamp = (strcmp(ctrl->report_timestamp, BULKDATA_JSON_TIMESTAMP_FORMAT_NONE) != 0);
+    if (has_timestamp)
     {
-        o[-1] = '\0';
+        CSV_WRITER_AddField(cw, "ReportTimestamp");
     }
 
-    // Ensure buffer is zero terminated
-    *o = '\0';
-    return USP_ERR_OK;
-}
+    for (k=0; k < num_columns; k++)
+    {
+        CSV_WRITER_AddField(cw, columns[k]);
+    }
+    CSV_WRITER_EndRow(cw);
 
-#if 0
-//--------------------------------------------------------------------------
-// Test code
+    // Iterate over all reports, writing a row for each report
+    for (i=0; i < bp->num_reports; i++)
+    {
+        report = &bp->reports[i];
+        report_map = &report->report_map;
+        if (has_timestamp)
+        {
+            bulkdata_add_csv_timestamp_field(ctrl, report, cw);
+        }
 
-//int test_reduce(void)
-//{
-//    char buf[100];
-//
-//    // fully qualified
-//    bulkdata_reduce_to_alt_name("Device.Stuff.Hello", 
-//                                "Device.Stuff.Hello",
-//                                "alt", buf);
-//
-//    // partial path
-//    bulkdata_reduce_to_alt_name("Device.Stuff.Hello.", 
-//                                "Device.Stuff.Hello.This.Should.Be.1.Addded",
-//                                "alt", buf);
-//
-//    // partial path, no trailing '.' in spec
-//    bulkdata_reduce_to_alt_name("Device.Stuff.Hello", 
-//                                "Device.Stuff.Hello.This.Should.Be.2.Addded",
-//                                "alt", buf);
-//
-//    // wildcard
-//    bulkdata_reduce_to_alt_name("Device.*.Stuff.*.Hello", 
-//                                "Device.56.Stuff.72.Hello",
-//                                "alt", buf);
-//
-//    // wildcard with partial path
-//    bulkdata_reduce_to_alt_name("Device.*.Stuff.*.Hello.", 
-//                                "Device.56.Stuff.72.Hello.This.Should.Be.3.Addded",
-//                                "alt", buf);
-//
-//    // wildcard with partial path, no trailing '.' in spec
-//    bulkdata_reduce_to_alt_name("Device.*.Stuff.*.Hello", 
-//                                "Device.56.Stuff.72.Hello.This.Should.Be.4.Addded",
-//                                "alt", buf);
-//
-//    return 0;
-//}
-#endif
+        for (k=0; k < num_columns; k++)
+        {
+            // Find the parameter for this column, checking the same position in the report map first
+            index = k;
+            if ((k >= report_map->num_entries) || (strcmp(report_map->vector[k].key, columns[k]) != 0))
+            {
+                index = KV_VECTOR_FindKey(report_map, columns[k], 0);
+            }
+
+            // Skip the first character of the value, which denotes the type of the parameter
+            CSV_WRITER_AddField(cw, (index != INVALID) ? &report_map->vector[index].value[1] : "");
+        }
+        CSV_WRITER_EndRow(cw);
+    }
+
+    USP_FREE(columns);
+}
 
 /*********************************************************************//**
 **
-**  bulkdata_generate_json_report
+**  bulkdata_add_csv_timestamp_field
 **
-**  Generates a JSON name-value pair format report
-**  NOTE: The report contains all retained failed reports, as well as the current report
-**  See TR-157 section A.4.2 (end) for an example, and section A.3.5.2 for layout of content containing failed report transmissions
+**  Adds a field containing the time at which the specified report was collected, in the format selected by CSVEncoding.RowTimestamp
 **
-** \param   bp - pointer to bulk data profile containing all reports (current and retained)
 ** \param   ctrl - pointer to structure containing the controlling parameters for the profile we are generating a report for
+** \param   report - pointer to report
+** \param   cw - pointer to CSV writer to write the field to
+**          
+** \return  None
+**
+**************************************************************************/
+void bulkdata_add_csv_timestamp_field(profile_ctrl_params_t *ctrl, report_t *report, csv_writer_t *cw)
+{
+    char buf[32];
+    char *result;
+
+    if (strcmp(ctrl->report_timestamp, BULKDATA_JSON_TIMESTAMP_FORMAT_ISO8601)==0)
+    {
+        result = iso8601_from_unix_time(report->collection_time, buf, sizeof(buf));
+        if (result == NULL)
+        {
+            buf[0] = '\0';
+        }
+    }
+    else
+    {
+        USP_SNPRINTF(buf, sizeof(buf), "%lld", (long long)report->collection_time);
+    }
+
+    CSV_WRITER_AddField(cw, buf);
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_get_csv_type_name
+**
+**  Returns the TR-106 data type name of a parameter, given the letter code denoting its type in the report map
+**
+** \param   type - letter code denoting the type of the parameter (see bulkdata_platform_get_parameter_type)
+**          
+** \return  pointer to string containing the type name
+**
+**************************************************************************/
+char *bulkdata_get_csv_type_name(char type)
+{
+    switch (type)
+    {
+        case 'D':
+            return "dateTime";
+
+        case 'I':
+            return "int";
+
+        case 'U':
+            return "unsignedInt";
+
+        case 'L':
+            return "unsignedLong";
+
+        case 'B':
+            return "boolean";
+
+        default:
+        case 'S':
+            return "string";
+    }
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_is_json_integer
+**
+**  Determines whether the specified value is an integer which may be written verbatim as a JSON number
+**  ie an optional minus sign, followed by digits without any leading zeros
+**
+** \param   value - value of the parameter from the data model
+**          
+** \return  true if the value is a valid JSON integer
+**
+**************************************************************************/
+bool bulkdata_is_json_integer(char *value)
+{
+    char *p;
+
+    p = value;
+    if (*p == '-')
+    {
+        p++;
+    }
+
+    // Exit if there are no digits, or there is a leading zero (JSON only allows a zero on its own)
+    if ((*p < '0') || (*p > '9') || ((*p == '0') && (p[1] != '\0')))
+    {
+        return false;
+    }
+
+    // Exit if any of the remaining characters are not digits
+    while (*p != '\0')
+    {
+        if ((*p < '0') || (*p > '9'))
+        {
+            return false;
+        }
+        p++;
+    }
+
+    return true;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_decode_csv_characters
+**
+**  Decodes the value of a CSV separator or escape character parameter, which may contain XML character references
+**  eg "&#13;&#10;" decodes to CRLF, and "&quot;" decodes to a double quote
+**  NOTE: Only character references to ASCII characters are supported
+**
+** \param   value - value of the parameter from the data model
+** \param   buf - pointer to buffer in which to return the decoded characters
+** \param   len - length of buffer
 **          
-** \return  pointer to NULL terminated dynamically allocated buffer containing the serialized report to send
+** \return  USP_ERR_OK if successful, USP_ERR_INVALID_VALUE if the value contained an invalid character reference, or was too long
 **
 **************************************************************************/
-char *bulkdata_generate_json_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl)
+int bulkdata_decode_csv_characters(char *value, char *buf, int len)
 {
-    JsonNode *top;          // top of report
-    JsonNode *array;        // array of reports (retained + current)
-    JsonNode *element;      // element of json array, containing an individual report
-    char *param_path;
-    char *param_type_value;
-    char param_type;
-    char *param_value;
-    kv_vector_t *report_map;
-    report_t *report;
-    double value_as_number;
-    bool value_as_bool;
-    char *result;
-    int i, j;
-    char buf[32];
-    kv_pair_t *kv;
-    int err;
-
-    top = json_mkobject();
-    array = json_mkarray();
-
-    // Iterate over all reports adding them to the JSON array
-    for (i=0; i < bp->num_retained_reports; i++)
+    int i;
+    int count = 0;
+    char *p;
+    char *end;
+    char *ref_end;
+    size_t name_len;
+    long code;
+
+    typedef struct
     {
-        report = &bp->reports[i];
-        report_map = &report->report_map;
+        char *name;
+        char c;
+    } xml_entity_t;
 
-        // Add Collection time to each json report element (only if specified and not 'None')
-        element = json_mkobject();
-        if (strcmp(ctrl->report_timestamp, "Unix-Epoch")==0)
+    static const xml_entity_t xml_entities[] =
+    {
+        { "quot", '"' },
+        { "amp", '&' },
+        { "apos", '\'' },
+        { "lt", '<' },
+        { "gt", '>' },
+    };
+
+    p = value;
+    while (*p != '\0')
+    {
+        // Exit if the decoded value will not fit in the buffer
+        if (count >= len-1)
         {
-            json_append_member(element, "CollectionTime", json_mknumber(report->collection_time));
-        } 
-        else if (strcmp(ctrl->report_timestamp, "ISO-8601")==0)
+            USP_ERR_SetMessage("%s: '%s' is too long (maximum %d characters)", __FUNCTION__, value, len-1);
+            return USP_ERR_INVALID_VALUE;
+        }
+
+        // Copy across characters which are not character references
+        if (*p != '&')
         {
-            result = iso8601_from_unix_time(report->collection_time, buf, sizeof(buf));
-            if (result != NULL)
-            {
-                json_append_member(element, "CollectionTime", json_mkstring(buf));
-            }
+            buf[count++] = *p++;
+            continue;
         }
 
-        // Iterate over each parameter, adding it to the json element. Take account of the parameter's type
-        for (j=0; j < report_map->num_entries; j++)
+        // Exit if the character reference is not terminated
+        ref_end = strchr(p, ';');
+        if (ref_end == NULL)
         {
-            kv = &report_map->vector[j];
-            param_path = kv->key;
-            param_type_value = kv->value;
-            param_type = param_type_value[0];           // First character denotes the type of the parameter
-            param_value = &param_type_value[1];         // Subsequent characters contain the parameter's value
+            USP_ERR_SetMessage("%s: Unterminated character reference in '%s'", __FUNCTION__, value);
+            return USP_ERR_INVALID_VALUE;
+        }
 
-            switch (param_type)
+        code = INVALID;
+        if (p[1] == '#')
+        {
+            // Numeric character reference (decimal or hexadecimal)
+            if ((p[2] == 'x') || (p[2] == 'X'))
             {
-                case 'S':
-                    json_append_member(element, param_path, json_mkstring(param_value) );
-                    break;
-
-                case 'N':
-                    value_as_number = atof(param_value);
-                    json_append_member(element, param_path, json_mknumber(value_as_number) );
-                    break;
-
-                case 'B':
-                    err = TEXT_UTILS_StringToBool(param_value, &value_as_bool);
-                    if (err == USP_ERR_OK)
-                    {
-                        json_append_member(element, param_path, json_mkbool(value_as_bool) );
-                    }
-                    break;
+                code = strtol(&p[3], &end, 16);
+                end = (end == &p[3]) ? NULL : end;
+            }
+            else
+            {
+                code = strtol(&p[2], &end, 10);
+                end = (end == &p[2]) ? NULL : end;
+            }
 
-                default:
-                    USP_ERR_SetMessage("%s: Invalid JSON parameter type ('%c') in report map for %s", __FUNCTION__, param_type_value[0], param_path);
+            if ((end != ref_end) || (code <= 0) || (code > 127))
+            {
+                code = INVALID;
+            }
+        }
+        else
+        {
+            // Named character reference
+            for (i=0; i < NUM_ELEM(xml_entities); i++)
+            {
+                name_len = ref_end - &p[1];
+                if ((strlen(xml_entities[i].name) == name_len) && (strncmp(&p[1], xml_entities[i].name, name_len)==0))
+                {
+                    code = xml_entities[i].c;
                     break;
+                }
             }
         }
 
-        // Add the json element to the json array
-        json_append_element(array, element);
-    }
-
-    // Finally add the array to the report top level
-    json_append_member(top, "Report", array);
-
-    // Serialize the JSON tree
-    result = json_stringify(top, " ");
+        // Exit if the character reference was not recognised
+        if (code == INVALID)
+        {
+            USP_ERR_SetMessage("%s: Invalid or unsupported character reference in '%s'", __FUNCTION__, value);
+            return USP_ERR_INVALID_VALUE;
+        }
 
-    // Clean up the JSON tree
-    json_delete(top);        // Other JsonNodes which are children of this top level tree will be deleted 
+        buf[count++] = (char) code;
+        p = ref_end + 1;
+    }
 
-    return result;
+    buf[count] = '\0';
+    return USP_ERR_OK;
 }
 
 /*********************************************************************//**
 **
-**  bulkdata_compress_report
+**  bulkdata_generate_compressed_report
 **
-**  Compresses the report to send
+**  Generates the report to send, compressing it in chunks as it is generated
 **
+** \param   bp - pointer to bulk data profile containing all reports (current and retained)
 ** \param   ctrl - parameters controlling the profile e.g. type of compression to use
-** \param   input_buf - pointer to buffer containing the uncompressed report
-** \param   input_len - length of the data in the buffer containing the uncompressed report
-** \param   p_output_len - pointer to variable in which to return the length of the compressed report
+** \param   p_report_len - pointer to variable in which to return the length of the compressed report
 **          
-** \return  pointer to compressed report to send
-**          NOTE: if compression is not required or fails, the uncompressed report is returned
+** \return  pointer to dynamically allocated buffer containing the compressed report, or NULL if compression failed
 **
 **************************************************************************/
-unsigned char *bulkdata_compress_report(profile_ctrl_params_t *ctrl, char *input_buf, int input_len, int *p_output_len)
+unsigned char *bulkdata_generate_compressed_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, int *p_report_len)
 {
-    z_stream zlib_ctx;
+    report_compressor_t rc;
+    json_writer_t jw;
+    csv_writer_t cw;
+    int window_bits;
     int err;
-    int output_len;
-    unsigned char *output_buf;
-
-    // Exit if not GZIP compression - in this case we just don't compress the report
-    if (strcmp(ctrl->compression, "GZIP") !=0)
-    {
-        *p_output_len = input_len;
-        return (unsigned char *)input_buf;
-    }
 
     // Initialise the zlib context
-    memset(&zlib_ctx, 0, sizeof(zlib_ctx));
-    zlib_ctx.zalloc = Z_NULL;
-    zlib_ctx.zfree = Z_NULL;
-    zlib_ctx.opaque = NULL;
+    memset(&rc, 0, sizeof(rc));
+    rc.zlib_ctx.zalloc = Z_NULL;
+    rc.zlib_ctx.zfree = Z_NULL;
+    rc.zlib_ctx.opaque = NULL;
 
     // Exit if unable to start deflate
-    #define WINDOW_BITS  (15+16)  // Plus 16 to get a gzip wrapper, as suggested by the zlib documentation
+    // NOTE: GZIP has a gzip wrapper, whilst Deflate (as used by the HTTP Content-Encoding) has a zlib wrapper
+    #define WINDOW_BITS  15       // This is the default value, as suggested by the zlib documentation
+    #define GZIP_WRAPPER 16       // Added to the window bits to get a gzip wrapper, as suggested by the zlib documentation
     #define MEM_LEVEL 8           // This is the default value, as suggested by the zlib documentation
-    err = deflateInit2(&zlib_ctx, Z_DEFAULT_COMPRESSION, Z_DEFLATED, WINDOW_BITS, MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    window_bits = (strcmp(ctrl->compression, "GZIP")==0) ? WINDOW_BITS + GZIP_WRAPPER : WINDOW_BITS;
+    err = deflateInit2(&rc.zlib_ctx, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, MEM_LEVEL, Z_DEFAULT_STRATEGY);
     if (err != Z_OK)
     {
-        USP_LOG_Warning("%s: WARNING: deflateInit2 returned %d. Falling back to sending uncompressed data", __FUNCTION__, err);
-        *p_output_len = input_len;
-        return (unsigned char *)input_buf;
+        USP_LOG_Warning("%s: WARNING: deflateInit2 returned %d", __FUNCTION__, err);
+        return NULL;
+    }
+
+    // Allocate the initial buffer to hold the compressed data. This grows as the report is generated
+    rc.max_len = COMPRESSED_REPORT_INITIAL_SIZE;
+    rc.buf = USP_MALLOC(rc.max_len);
+    rc.zlib_ctx.next_out = rc.buf;
+    rc.zlib_ctx.avail_out = rc.max_len;
+
+    // Generate the report, passing each chunk of it to be compressed
+    if (strcmp(ctrl->encoding_type, BULKDATA_ENCODING_TYPE_CSV)==0)
+    {
+        CSV_WRITER_InitStream(&cw, ctrl->csv_field_separator, ctrl->csv_row_separator, ctrl->csv_escape_char, bulkdata_compress_chunk, &rc);
+        bulkdata_write_csv_report(bp, ctrl, &cw);
+        err = CSV_WRITER_FinishStream(&cw);
+    }
+    else
+    {
+        JSON_WRITER_InitStream(&jw, " ", bulkdata_compress_chunk, &rc);
+        bulkdata_write_json_report(bp, ctrl, &jw);
+        err = JSON_WRITER_FinishStream(&jw);
     }
 
-    // Allocate a worst case buffer to hold the compressed data
-    output_len = (int)deflateBound(&zlib_ctx, input_len);
-    output_buf = malloc(output_len);  // Use malloc because the uncompressed report was generated with malloc() and this needs to be consistent
-    if (output_buf == NULL)
+    // Flush the remaining compressed data
+    if (err == USP_ERR_OK)
     {
-        USP_LOG_Warning("%s: WARNING: malloc failed. Falling back to sending uncompressed data", __FUNCTION__);
-        deflateEnd(&zlib_ctx);
-        *p_output_len = input_len;
-        return (unsigned char *)input_buf;
+        rc.zlib_ctx.next_in = NULL;
+        rc.zlib_ctx.avail_in = 0;
+        err = bulkdata_deflate(&rc, Z_FINISH);
     }
 
-    // Initialise the zlib context for this compression
-    zlib_ctx.next_in  = (unsigned char *)input_buf;
-    zlib_ctx.avail_in = input_len;
-    zlib_ctx.next_out = output_buf;
-    zlib_ctx.avail_out= output_len;
+    // Deallocate all compression state stored in the zlib context
+    // NOTE: Errors from this are ignored, as either the report has been completely compressed, or compression has already failed
+    deflateEnd(&rc.zlib_ctx);
 
     // Exit if compression failed
-    err = deflate(&zlib_ctx, Z_FINISH);
-    if (err != Z_STREAM_END)
+    if (err != USP_ERR_OK)
     {
-        USP_LOG_Warning("%s: WARNING: deflate failed (err=%d). Falling back to sending uncompressed data", __FUNCTION__, err);
-        deflateEnd(&zlib_ctx);
-        free(output_buf);
-        *p_output_len = input_len;
-        return (unsigned char *)input_buf;
+        USP_FREE(rc.buf);
+        return NULL;
     }
 
-    // Deallocate all compression state stored in the zlib context
-    // NOTE: We ignore errors from this and just log them
-    err = deflateEnd(&zlib_ctx);
-    if (err != Z_OK)
+    USP_LOG_Info("%s: BulkDataReport(uncompressed size=%lu, compressed size=%lu)", __FUNCTION__, rc.zlib_ctx.total_in, rc.zlib_ctx.total_out);
+    *p_report_len = rc.zlib_ctx.total_out;
+    return rc.buf;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_compress_chunk
+**
+**  Called by the JSON or CSV writer with each chunk of the report, to compress it
+**
+** \param   buf - pointer to NULL terminated buffer containing the chunk of the report
+** \param   len - number of characters in the chunk
+** \param   arg - pointer to compression state for the report
+**          
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int bulkdata_compress_chunk(char *buf, int len, void *arg)
+{
+    report_compressor_t *rc = (report_compressor_t *) arg;
+
+    // Print out the report, if debugging is enabled
+    // NOTE: The writers split chunks at the end of a line, so the report is logged line by line, as for an uncompressed report
+    if (enable_protocol_trace)
     {
-        USP_LOG_Warning("%s: WARNING: deflateEnd failed (err=%d, %s). Ignoring error.", __FUNCTION__, err, zlib_ctx.msg);
+        USP_LOG_String(kLogType_Protocol, buf);
     }
 
-    USP_LOG_Info("%s: BulkDataReport(uncompressed size=%d, compressed size=%lu)", __FUNCTION__, input_len, zlib_ctx.total_out);
-    *p_output_len = zlib_ctx.total_out;
-    return output_buf;
+    rc->zlib_ctx.next_in = (unsigned char *)buf;
+    rc->zlib_ctx.avail_in = len;
+
+    return bulkdata_deflate(rc, Z_NO_FLUSH);
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_deflate
+**
+**  Compresses all of the input data in the zlib context, growing the compressed report buffer as necessary
+**
+** \param   rc - pointer to compression state for the report
+** \param   flush - zlib flush mode (Z_NO_FLUSH whilst generating the report, Z_FINISH at the end)
+**          
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int bulkdata_deflate(report_compressor_t *rc, int flush)
+{
+    int err;
+    int used;
+
+    while (FOREVER)
+    {
+        // Grow the compressed report buffer, if it is full
+        if (rc->zlib_ctx.avail_out == 0)
+        {
+            used = rc->max_len;
+            rc->max_len *= 2;
+            rc->buf = USP_REALLOC(rc->buf, rc->max_len);
+            rc->zlib_ctx.next_out = &rc->buf[used];
+            rc->zlib_ctx.avail_out = rc->max_len - used;
+        }
+
+        // Exit if compression failed
+        err = deflate(&rc->zlib_ctx, flush);
+        if ((err != Z_OK) && (err != Z_STREAM_END) && (err != Z_BUF_ERROR))
+        {
+            USP_ERR_SetMessage("%s: deflate failed (err=%d)", __FUNCTION__, err);
+            return USP_ERR_INTERNAL_ERROR;
+        }
+
+        // Exit if all of the input has been compressed (and, if finishing, all of the output has been flushed)
+        if (flush == Z_FINISH)
+        {
+            if (err == Z_STREAM_END)
+            {
+                return USP_ERR_OK;
+            }
+        }
+        else if (rc->zlib_ctx.avail_out != 0)
+        {
+            return USP_ERR_OK;
+        }
+    }
 }
 
 /*********************************************************************//**
@@ -2645,15 +4509,16 @@ unsigned char *bulkdata_compress_report(profile_ctrl_params_t *ctrl, char *input
 ** \param   bp - pointer to bulk data profile to get the report map for
 ** \param   report - pointer to buffer containing the report to send (which may be compressed)
 ** \param   report_len - length of json_report
+** \param   flags - BDC_FLAG_xxx flags describing the encoding and compression of the report
+**                  NOTE: These are stored with retained reports, as the report may have been generated with different control parameters
 **          
 ** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-int bulkdata_schedule_sending_report(profile_ctrl_params_t *ctrl, bulkdata_profile_t *bp, unsigned char *report, int report_len)
+int bulkdata_schedule_sending_report(profile_ctrl_params_t *ctrl, bulkdata_profile_t *bp, unsigned char *report, int report_len, unsigned flags)
 {
     char *query_string = NULL;
     char *full_url = NULL;
-    unsigned flags;
     int err;
     char *username;
     char *password;
@@ -2675,18 +4540,12 @@ int bulkdata_schedule_sending_report(profile_ctrl_params_t *ctrl, bulkdata_profi
     username = USP_STRDUP(ctrl->username);
     password = USP_STRDUP(ctrl->password);
 
-    // Form the flags controlling various BDC options
-    flags = 0;
+    // Add the flags controlling various BDC options (which are not dependant on the contents of the report)
     if (strcmp(ctrl->method, "PUT")==0)
     {
         flags |= BDC_FLAG_PUT;
     }
 
-    if (strcmp(ctrl->compression, "GZIP")==0)
-    {
-        flags |= BDC_FLAG_GZIP;
-    }
-
     if (ctrl->use_date_header)
     {
         flags |= BDC_FLAG_DATE_HEADER;
@@ -2705,32 +4564,164 @@ int bulkdata_schedule_sending_report(profile_ctrl_params_t *ctrl, bulkdata_profi
 
 /*********************************************************************//**
 **
-**  bulkdata_find_free_profile
+**  bulkdata_calc_report_flags
 **
-**  Find a free profile slot
+**  Calculates the BDC_FLAG_xxx flags describing the encoding and compression of reports generated with the specified control parameters
 **
-** \param   None
+** \param   ctrl - parameters controlling the profile
+**          
+** \return  BDC_FLAG_xxx flags describing the contents of the report
+**
+**************************************************************************/
+unsigned bulkdata_calc_report_flags(profile_ctrl_params_t *ctrl)
+{
+    unsigned flags = 0;
+
+    if (strcmp(ctrl->compression, "GZIP")==0)
+    {
+        flags |= BDC_FLAG_GZIP;
+    }
+    else if (strcmp(ctrl->compression, "Deflate")==0)
+    {
+        flags |= BDC_FLAG_DEFLATE;
+    }
+
+    if (strcmp(ctrl->encoding_type, BULKDATA_ENCODING_TYPE_CSV)==0)
+    {
+        flags |= BDC_FLAG_CSV;
+        if (strcmp(ctrl->csv_report_format, BULKDATA_CSV_REPORT_FORMAT_PER_ROW)==0)
+        {
+            flags |= BDC_FLAG_CSV_PARAMETER_PER_ROW;
+        }
+    }
+
+    return flags;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_reduce_to_delta_report
+**
+**  If delta reports are enabled, reduces the report map to only contain the parameters which have changed since
+**  the last report which was successfully delivered. Every so often (and whenever the BDC server may not have
+**  received the last full report), a full report is sent instead, to resynchronise the BDC server
+**  NOTE: The report map is compared against the last report generated, rather than the last report delivered.
+**        To take account of reports which have not been delivered, the parameters in the last report generated are
+**        also included, if it has not been delivered. These include all parameters which changed in earlier undelivered reports.
+**
+** \param   bp - pointer to bulk data profile
+** \param   ctrl - pointer to control parameters of the profile
+** \param   report_map - pointer to report map containing all parameters collected. On return, this contains only the parameters to report
 **          
-** \return  pointer to a free profile slot, or NULL if unable to fins a free profile
+** \return  BDC_FLAG_xxx flags indicating whether the report is a full or delta report (or 0 if delta reports are disabled)
 **
 **************************************************************************/
-bulkdata_profile_t *bulkdata_find_free_profile(void)
+unsigned bulkdata_reduce_to_delta_report(bulkdata_profile_t *bp, profile_ctrl_params_t *ctrl, kv_vector_t *report_map)
 {
     int i;
-    bulkdata_profile_t *bp;
+    int index;
+    int values_hint;
+    int undelivered_hint;
+    bool is_changed;
+    kv_pair_t *kv;
+    kv_vector_t delta_map;
 
-    // Iterate over all profiles, exiting if a free one has been found
-    for (i=0; i<BULKDATA_MAX_PROFILES; i++)
+    // Exit if delta reports are not enabled
+    // NOTE: The delta state is cleared, so that the first report after delta reports are enabled is a full report
+    if (ctrl->delta_reports == false)
     {
-        bp = &bulkdata_profiles[i];
-        if (bp->profile_id == INVALID)
+        bulkdata_clear_delta_state(bp);
+        return 0;
+    }
+
+    // Exit if this report should be a full report, saving the values of all parameters, for comparison with the next report
+    if ((bp->delta_valid == false) || (bp->delta_full_undelivered) || (bp->delta_count >= ctrl->full_report_interval))
+    {
+        bulkdata_clear_delta_state(bp);
+        for (i=0; i < report_map->num_entries; i++)
         {
-            return bp;
+            kv = &report_map->vector[i];
+            KV_VECTOR_Add(&bp->delta_values, kv->key, kv->value);
         }
+        bp->delta_valid = true;
+        bp->delta_full_undelivered = true;
+        return BDC_FLAG_FULL_REPORT;
     }
 
-    // If the code gets here, no matching profile was found
-    return NULL;
+    // Iterate over all parameters collected, determining which to include in the delta report
+    // NOTE: Parameters are usually collected in the same order each time, so the search for each parameter starts after the previous one found
+    KV_VECTOR_Init(&delta_map);
+    values_hint = 0;
+    undelivered_hint = 0;
+    for (i=0; i < report_map->num_entries; i++)
+    {
+        // Determine whether the parameter has changed since the last report generated (including whether it is new)
+        kv = &report_map->vector[i];
+        index = KV_VECTOR_FindKey(&bp->delta_values, kv->key, values_hint);
+        if (index != INVALID)
+        {
+            is_changed = (strcmp(&bp->delta_values.vector[index].value[1], &kv->value[1]) != 0);  // Skip the type character, as its case may differ
+            values_hint = index + 1;
+        }
+        else
+        {
+            is_changed = true;
+        }
+
+        // Parameters in the last report generated must also be included, if it has not been delivered
+        if ((is_changed == false) && (bp->delta_undelivered.num_entries > 0))
+        {
+            index = KV_VECTOR_FindKey(&bp->delta_undelivered, kv->key, undelivered_hint);
+            if (index != INVALID)
+            {
+                is_changed = true;
+                undelivered_hint = index + 1;
+            }
+        }
+
+        if (is_changed)
+        {
+            KV_VECTOR_Add(&delta_map, kv->key, kv->value);
+        }
+    }
+
+    // Save the values of all parameters collected, for comparison with the next report
+    KV_VECTOR_Destroy(&bp->delta_values);
+    memcpy(&bp->delta_values, report_map, sizeof(kv_vector_t));
+
+    // Save the parameters in this delta report, in case it is not delivered
+    KV_VECTOR_Destroy(&bp->delta_undelivered);
+    for (i=0; i < delta_map.num_entries; i++)
+    {
+        kv = &delta_map.vector[i];
+        KV_VECTOR_Add(&bp->delta_undelivered, kv->key, kv->value);
+    }
+
+    // Replace the report map with the delta report map
+    memcpy(report_map, &delta_map, sizeof(kv_vector_t));
+    bp->delta_count++;
+
+    return BDC_FLAG_DELTA_REPORT;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_clear_delta_state
+**
+**  Frees all memory associated with delta reports, so that the next delta report will be a full report
+**
+** \param   bp - pointer to bulk data profile
+**          
+** \return  None
+**
+**************************************************************************/
+void bulkdata_clear_delta_state(bulkdata_profile_t *bp)
+{
+    KV_VECTOR_Destroy(&bp->delta_values);
+    KV_VECTOR_Destroy(&bp->delta_undelivered);
+    bp->delta_valid = false;
+    bp->delta_full_undelivered = false;
+    bp->delta_count = 0;
 }
 
 /*********************************************************************//**
@@ -2741,25 +4732,127 @@ bulkdata_profile_t *bulkdata_find_free_profile(void)
 **
 ** \param   profile_id - Instance number of profile in Device.Bulkdata.Profile.{i}
 **          
-** \return  pointer to a free profile slot, or NULL if unable to find a free profile
+** \return  pointer to profile, or NULL if unable to find the profile
 **
 **************************************************************************/
 bulkdata_profile_t *bulkdata_find_profile(int profile_id)
 {
-    int i;
-    bulkdata_profile_t *bp;
+    int index;
+
+    // Exit if no matching profile was found
+    index = bulkdata_find_profile_index(profile_id);
+    if (index == INVALID)
+    {
+        return NULL;
+    }
+
+    return bulkdata_profiles[index];
+}
 
-    // Iterate over all profiles, exiting if a matching one has been found
-    for (i=0; i<BULKDATA_MAX_PROFILES; i++)
+/*********************************************************************//**
+**
+**  bulkdata_find_profile_index
+**
+**  Finds the index of the specified profile in the bulkdata_profiles[] array, using a binary search
+**
+** \param   profile_id - Instance number of profile in Device.Bulkdata.Profile.{i}
+**          
+** \return  index of the profile, or INVALID if unable to find the profile
+**
+**************************************************************************/
+int bulkdata_find_profile_index(int profile_id)
+{
+    int low;
+    int high;
+    int mid;
+    int id;
+
+    low = 0;
+    high = num_bulkdata_profiles - 1;
+    while (low <= high)
     {
-        bp = &bulkdata_profiles[i];
-        if (bp->profile_id == profile_id)
+        mid = (low + high)/2;
+        id = bulkdata_profiles[mid]->profile_id;
+        if (id == profile_id)
         {
-            return bp;
+            return mid;
+        }
+
+        if (id < profile_id)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
         }
     }
 
     // If the code gets here, no matching profile was found
-    return NULL;
+    return INVALID;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_insert_profile
+**
+**  Adds the specified profile to the bulkdata_profiles[] array, keeping the array sorted by instance number
+**
+** \param   bp - pointer to dynamically allocated profile to add. Ownership of the profile passes to the array
+**          
+** \return  None
+**
+**************************************************************************/
+void bulkdata_insert_profile(bulkdata_profile_t *bp)
+{
+    int index;
+
+    // Find the position at which to insert the profile
+    // NOTE: Searching from the end, as new profiles usually have the highest instance number
+    index = num_bulkdata_profiles;
+    while ((index > 0) && (bulkdata_profiles[index-1]->profile_id > bp->profile_id))
+    {
+        index--;
+    }
+
+    // Insert the profile, moving up all profiles after it
+    bulkdata_profiles = USP_REALLOC(bulkdata_profiles, (num_bulkdata_profiles+1)*sizeof(bulkdata_profile_t *));
+    memmove(&bulkdata_profiles[index+1], &bulkdata_profiles[index], (num_bulkdata_profiles - index)*sizeof(bulkdata_profile_t *));
+    bulkdata_profiles[index] = bp;
+    num_bulkdata_profiles++;
+}
+
+/*********************************************************************//**
+**
+**  bulkdata_remove_profile
+**
+**  Removes the specified profile from the bulkdata_profiles[] array
+**  NOTE: The profile itself is not freed by this function
+**
+** \param   bp - pointer to profile to remove
+**          
+** \return  None
+**
+**************************************************************************/
+void bulkdata_remove_profile(bulkdata_profile_t *bp)
+{
+    int index;
+
+    // Exit if the profile is not in the array
+    index = bulkdata_find_profile_index(bp->profile_id);
+    if (index == INVALID)
+    {
+        return;
+    }
+
+    // Remove the profile, moving down all profiles after it
+    num_bulkdata_profiles--;
+    memmove(&bulkdata_profiles[index], &bulkdata_profiles[index+1], (num_bulkdata_profiles - index)*sizeof(bulkdata_profile_t *));
+
+    // Free the array, if it is now empty
+    if (num_bulkdata_profiles == 0)
+    {
+        USP_SAFE_FREE(bulkdata_profiles);
+    }
 }
 
@@ -55,6 +55,7 @@
 #include "text_utils.h"
 #include "iso8601.h"
 #include "retry_wait.h"
+#include "uptime.h"
 
 #ifdef ENABLE_COAP
 #include "usp_coap.h"
@@ -107,11 +108,25 @@ typedef struct
     unsigned subs_retry_min_wait_interval;
     unsigned subs_retry_interval_multiplier;
 
+    unsigned inbound_tokens;        // Number of USP messages which may currently be received from this controller, before it is rate limited
+    uint32_t inbound_refill_time;   // Uptime (in milliseconds) up to which inbound_tokens has been refilled
+    unsigned messages_received;     // Number of USP messages accepted from this controller
+    unsigned messages_rate_limited; // Number of USP messages ignored from this controller, because they exceeded the inbound rate limit
+    bool is_rate_limited;           // Set if messages from this controller are currently being ignored, because they exceeded the inbound rate limit
+    unsigned rate_limited_run;      // Number of USP messages ignored since this controller last started being rate limited
+
 } controller_t;
 
 // Array of controllers
 static controller_t controllers[MAX_CONTROLLERS];
 
+//------------------------------------------------------------------------------
+// State used to limit the rate at which messages ignored from unknown controllers are logged
+#define UNKNOWN_CONT_LOG_PERIOD 10000           // Minimum period (in milliseconds) between logging ignored messages from unknown controllers
+static bool is_unknown_cont_logged = false;     // Set if a message from an unknown controller has been logged
+static uint32_t unknown_cont_log_time;          // Uptime (in milliseconds) at which a message from an unknown controller was last logged
+static unsigned unknown_cont_ignored = 0;       // Number of messages from unknown controllers ignored since then, without being logged
+
 //------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 void PeriodicNotificationExec(int id);
@@ -138,7 +153,10 @@ int Notify_PeriodicNotifTime(dm_req_t *req, char *value);
 int Notify_ControllerRetryMinimumWaitInterval(dm_req_t *req, char *value);
 int Notify_ControllerRetryIntervalMultiplier(dm_req_t *req, char *value);
 int Get_ControllerInheritedRole(dm_req_t *req, char *buf, int len);
+int Get_ControllerMessagesReceived(dm_req_t *req, char *buf, int len);
+int Get_ControllerMessagesRateLimited(dm_req_t *req, char *buf, int len);
 int ProcessControllerAdded(int cont_instance);
+void LogUnknownControllerMessage(char *endpoint_id);
 int ProcessControllerMtpAdded(controller_t *cont, int mtp_instance);
 controller_t *FindUnusedController(void);
 controller_mtp_t *FindUnusedControllerMtp(controller_t *cont);
@@ -223,6 +241,8 @@ int DEVICE_CONTROLLER_Init(void)
     err |= USP_REGISTER_DBParam_ReadWrite(DEVICE_CONT_ROOT ".{i}.USPRetryIntervalMultiplier", "2000", Validate_ControllerRetryIntervalMultiplier, Notify_ControllerRetryIntervalMultiplier, DM_UINT);
     err |= USP_REGISTER_DBParam_ReadWrite(DEVICE_CONT_ROOT ".{i}.ControllerCode", "", NULL, NULL, DM_STRING);
     err |= USP_REGISTER_DBParam_ReadWrite(DEVICE_CONT_ROOT ".{i}.ProvisioningCode", "", NULL, NULL, DM_STRING);
+    err |= USP_REGISTER_VendorParam_ReadOnly(DEVICE_CONT_ROOT ".{i}.X_ARRIS-COM_MessagesReceived", Get_ControllerMessagesReceived, DM_UINT);
+    err |= USP_REGISTER_VendorParam_ReadOnly(DEVICE_CONT_ROOT ".{i}.X_ARRIS-COM_MessagesRateLimited", Get_ControllerMessagesRateLimited, DM_UINT);
 
     err |= USP_REGISTER_Param_NumEntries(DEVICE_CONT_ROOT ".{i}.MTPNumberOfEntries", "Device.LocalAgent.Controller.{i}.MTP.{i}");
     err |= USP_REGISTER_DBParam_ReadWrite(DEVICE_CONT_ROOT ".{i}.MTP.{i}.Enable", "false", Validate_ControllerMtpEnable, Notify_ControllerMtpEnable, DM_BOOL);
@@ -377,6 +397,121 @@ int DEVICE_CONTROLLER_FindInstanceByEndpointId(char *endpoint_id)
     return cont->instance;
 }
 
+/*********************************************************************//**
+**
+** DEVICE_CONTROLLER_IsInboundMessageAllowed
+**
+** Determines whether a USP message received from the specified controller should be processed
+** Messages are not allowed from unknown (or disabled) controllers, or if they exceed the controller's inbound rate limit
+**
+** \param   endpoint_id - endpoint_id of the controller which sent the message
+**
+** \return  true if the message should be processed, false if it should be ignored
+**
+**************************************************************************/
+bool DEVICE_CONTROLLER_IsInboundMessageAllowed(char *endpoint_id)
+{
+    controller_t *cont;
+#if INBOUND_MSG_RATE_LIMIT > 0
+    uint32_t cur_time;
+    uint32_t elapsed;
+    unsigned long long new_tokens;
+#endif
+
+    // Exit if the message came from a controller which we do not recognise
+    cont = FindEnabledControllerByEndpointId(endpoint_id);
+    if (cont == NULL)
+    {
+        LogUnknownControllerMessage(endpoint_id);
+        return false;
+    }
+
+#if INBOUND_MSG_RATE_LIMIT > 0
+    // Refill the controller's token bucket, based on the time since it was last refilled
+    cur_time = tu_uptime_msecs();
+    elapsed = cur_time - cont->inbound_refill_time;
+    new_tokens = (unsigned long long)elapsed * INBOUND_MSG_RATE_LIMIT / 1000;
+    if (new_tokens > 0)
+    {
+        if (cont->inbound_tokens + new_tokens >= INBOUND_MSG_BURST)
+        {
+            cont->inbound_tokens = INBOUND_MSG_BURST;
+            cont->inbound_refill_time = cur_time;
+        }
+        else
+        {
+            // NOTE: Only the time accounted for by the added tokens is consumed, so that partial tokens are not lost
+            cont->inbound_tokens += (unsigned) new_tokens;
+            cont->inbound_refill_time += (uint32_t)(new_tokens * 1000 / INBOUND_MSG_RATE_LIMIT);
+        }
+    }
+
+    // Exit if the controller has exceeded its rate limit
+    // NOTE: Only the start and end of each period of rate limiting are logged, so that a flood of messages does not also flood the log
+    if (cont->inbound_tokens == 0)
+    {
+        cont->messages_rate_limited++;
+        cont->rate_limited_run++;
+        if (cont->is_rate_limited == false)
+        {
+            USP_LOG_Warning("%s: Ignoring messages from endpoint_id=%s (exceeded %d messages per second)", __FUNCTION__, endpoint_id, INBOUND_MSG_RATE_LIMIT);
+            cont->is_rate_limited = true;
+        }
+        return false;
+    }
+    cont->inbound_tokens--;
+
+    // Log the number of messages ignored, if the controller has just dropped back under its rate limit
+    if (cont->is_rate_limited)
+    {
+        USP_LOG_Warning("%s: Accepting messages from endpoint_id=%s again (ignored %u messages)", __FUNCTION__, endpoint_id, cont->rate_limited_run);
+        cont->is_rate_limited = false;
+        cont->rate_limited_run = 0;
+    }
+#endif
+
+    cont->messages_received++;
+    return true;
+}
+
+/*********************************************************************//**
+**
+** LogUnknownControllerMessage
+**
+** Logs that a USP message received from an unknown (or disabled) controller is being ignored
+** At most one such log message is written out every UNKNOWN_CONT_LOG_PERIOD milliseconds, summarising the messages which were not logged
+**
+** \param   endpoint_id - endpoint_id of the controller which sent the message
+**
+** \return  None
+**
+**************************************************************************/
+void LogUnknownControllerMessage(char *endpoint_id)
+{
+    uint32_t cur_time;
+
+    // Exit if a message from an unknown controller has been logged recently
+    cur_time = tu_uptime_msecs();
+    if ((is_unknown_cont_logged) && (cur_time - unknown_cont_log_time < UNKNOWN_CONT_LOG_PERIOD))
+    {
+        unknown_cont_ignored++;
+        return;
+    }
+
+    if (unknown_cont_ignored > 0)
+    {
+        USP_LOG_Warning("%s: Ignoring message from endpoint_id=%s (unknown controller). Also ignored %u other messages from unknown controllers", __FUNCTION__, endpoint_id, unknown_cont_ignored);
+    }
+    else
+    {
+        USP_LOG_Warning("%s: Ignoring message from endpoint_id=%s (unknown controller)", __FUNCTION__, endpoint_id);
+    }
+
+    is_unknown_cont_logged = true;
+    unknown_cont_log_time = cur_time;
+    unknown_cont_ignored = 0;
+}
+
 /*********************************************************************//**
 **
 ** DEVICE_CONTROLLER_FindEndpointIdByInstance
@@ -564,7 +699,7 @@ int DEVICE_CONTROLLER_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, char
     if ((stomp_dest != NULL) && (stomp_instance != INVALID))
     {
         agent_queue = DEVICE_MTP_GetAgentStompQueue(stomp_instance);
-        err = DEVICE_STOMP_QueueBinaryMessage(usp_msg_type, stomp_instance, stomp_dest, agent_queue, pbuf, pbuf_len);
+        err = DEVICE_STOMP_QueueBinaryMessage(usp_msg_type, endpoint_id, stomp_instance, stomp_dest, agent_queue, pbuf, pbuf_len);
         return err;
     }
 
@@ -594,7 +729,7 @@ int DEVICE_CONTROLLER_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, char
             if (mtp->stomp_connection_instance != INVALID)
             {
                 agent_queue = DEVICE_MTP_GetAgentStompQueue(mtp->stomp_connection_instance);
-                err = DEVICE_STOMP_QueueBinaryMessage(usp_msg_type, mtp->stomp_connection_instance, mtp->stomp_controller_queue, agent_queue, pbuf, pbuf_len);
+                err = DEVICE_STOMP_QueueBinaryMessage(usp_msg_type, endpoint_id, mtp->stomp_connection_instance, mtp->stomp_controller_queue, agent_queue, pbuf, pbuf_len);
                 return err;
             }
             else
@@ -1624,6 +1759,52 @@ int Get_ControllerInheritedRole(dm_req_t *req, char *buf, int len)
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** Get_ControllerMessagesReceived
+**
+** Gets the value of Device.LocalAgent.Controller.{i}.X_ARRIS-COM_MessagesReceived
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer in which to return the value
+** \param   len - length of return buffer
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_ControllerMessagesReceived(dm_req_t *req, char *buf, int len)
+{
+    controller_t *cont;
+
+    cont = FindControllerByInstance(inst1);
+    val_uint = (cont != NULL) ? cont->messages_received : 0;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Get_ControllerMessagesRateLimited
+**
+** Gets the value of Device.LocalAgent.Controller.{i}.X_ARRIS-COM_MessagesRateLimited
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer in which to return the value
+** \param   len - length of return buffer
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_ControllerMessagesRateLimited(dm_req_t *req, char *buf, int len)
+{
+    controller_t *cont;
+
+    cont = FindControllerByInstance(inst1);
+    val_uint = (cont != NULL) ? cont->messages_rate_limited : 0;
+
+    return USP_ERR_OK;
+}
+
 /*********************************************************************//**
 **
 ** ProcessControllerAdded
@@ -1660,6 +1841,8 @@ int ProcessControllerAdded(int cont_instance)
     cont->instance = cont_instance;
     cont->combined_role.inherited = ROLE_DEFAULT;
     cont->combined_role.assigned = ROLE_DEFAULT;
+    cont->inbound_tokens = INBOUND_MSG_BURST;
+    cont->inbound_refill_time = tu_uptime_msecs();
     
     for (i=0; i<MAX_CONTROLLER_MTPS; i++)
     {
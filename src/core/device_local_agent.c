@@ -57,6 +57,7 @@
 #include "nu_ipaddr.h"
 #include "text_utils.h"
 #include "uptime.h"
+#include "msg_handler.h"
 
 
 
@@ -101,6 +102,7 @@ static bool dual_stack_prefer_ipv6 = false;
 int Validate_DualStackPreference(dm_req_t *req, char *value);
 int NotifyChange_DualStackPreference(dm_req_t *req, char *value);
 int GetUpTime(dm_req_t *req, char *buf, int len);
+int GetRecordsRejected(dm_req_t *req, char *buf, int len);
 int GetCurrentLocalTime(dm_req_t *req, char *buf, int len);
 int ScheduleReboot(dm_req_t *req, char *command_key, kv_vector_t *input_args, kv_vector_t *output_args);
 int ScheduleFactoryReset(dm_req_t *req, char *command_key, kv_vector_t *input_args, kv_vector_t *output_args);
@@ -136,6 +138,7 @@ int DEVICE_LOCAL_AGENT_Init(void)
     // NOTE: Device.LocalAgent.EndpointID is registered in DEVICE_LOCAL_AGENT_RegisterEndpointID()
     err = USP_ERR_OK;
     err |= USP_REGISTER_VendorParam_ReadOnly("Device.LocalAgent.UpTime", GetUpTime, DM_UINT);
+    err |= USP_REGISTER_VendorParam_ReadOnly("Device.LocalAgent.X_ARRIS-COM_RecordsRejected", GetRecordsRejected, DM_UINT);
 
     // Determine which protocol is used
     #ifdef ENABLE_COAP
@@ -544,6 +547,27 @@ int GetUpTime(dm_req_t *req, char *buf, int len)
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** GetRecordsRejected
+**
+** Gets the number of received USP records which were rejected without being unpacked
+** (because they were malformed, not addressed to this agent, from an unknown controller, or exceeded the controller's rate limit)
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int GetRecordsRejected(dm_req_t *req, char *buf, int len)
+{
+    val_uint = MSG_HANDLER_GetRecordsRejected();
+
+    return USP_ERR_OK;
+}
+
 /*********************************************************************//**
 **
 ** GetCurrentLocalTime
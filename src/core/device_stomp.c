@@ -298,6 +298,7 @@ int DEVICE_STOMP_StartAllConnections(void)
 ** Function called to queue a message on the specified STOMP connection
 **
 ** \param   usp_msg_type - Type of USP message contained in pbuf. This is used for debug logging when the message is sent by the MTP.
+** \param   endpoint_id - controller to send the message to (used for message statistics)
 ** \param   instance - instance number of the stomp connection in Device.STOMP.Connection.{i}
 ** \param   controller_queue - name of STOMP queue to send this message to
 ** \param   agent_queue - name of agent's STOMP queue configured for this connection in the data model.
@@ -308,7 +309,7 @@ int DEVICE_STOMP_StartAllConnections(void)
 ** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-int DEVICE_STOMP_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, int instance, char *controller_queue, char *agent_queue, unsigned char *pbuf, int pbuf_len)
+int DEVICE_STOMP_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, char *endpoint_id, int instance, char *controller_queue, char *agent_queue, unsigned char *pbuf, int pbuf_len)
 {
     stomp_conn_params_t *sp;
 
@@ -320,7 +321,7 @@ int DEVICE_STOMP_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, int insta
         return USP_ERR_INTERNAL_ERROR;
     }
 
-    STOMP_QueueBinaryMessage(usp_msg_type, instance, controller_queue, agent_queue, pbuf, pbuf_len);
+    STOMP_QueueBinaryMessage(usp_msg_type, endpoint_id, instance, controller_queue, agent_queue, pbuf, pbuf_len);
     
     return USP_ERR_OK;
 }
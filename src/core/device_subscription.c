@@ -58,6 +58,7 @@
 #include "subs_retry.h"
 #include "text_utils.h"
 #include "expr_vector.h"
+#include "json_writer.h"
 
 //------------------------------------------------------------------------------
 // List of notification types that USP Agent currently supports
@@ -150,7 +151,7 @@ void ProcessAllValueChangeSubscriptions(void);
 void ProcessValueChangeSubscription(subs_t *sub);
 void SendValueChangeNotify(subs_t *sub, char *path, char *value);
 void ResolveAllPathExpressions(char *source_path, str_vector_t *path_expressions, str_vector_t *resolved_paths, resolve_op_t op, int cont_instance);
-void GetAllPathExpressionParameterValues(subs_t *sub, str_vector_t *path_expressions, kv_vector_t *param_values, char *source_path, unsigned flags);
+void GetAllPathExpressionParameterValues(subs_t *sub, str_vector_t *path_expressions, kv_vector_t *param_values, dm_typed_value_t **typed_values, char *source_path, unsigned flags);
 char *SerializeToJSONObject(kv_vector_t *param_values);
 void SendOperationCompleteNotify(subs_t *sub, char *command, char *command_key, int err_code, char *err_msg, kv_vector_t *output_args);
 void SendNotify(Usp__Msg *req, subs_t *sub, char *path);
@@ -747,7 +748,7 @@ exit:
         if ((sub.enable==true) && (sub.notify_type == kSubNotifyType_ValueChange))
         {
             USP_SNPRINTF(path, sizeof(path), "%s.%d", device_subs_root, sub.instance);
-            GetAllPathExpressionParameterValues(&sub, &sub.path_expressions, &sub.last_values, path, 0);
+            GetAllPathExpressionParameterValues(&sub, &sub.path_expressions, &sub.last_values, &sub.last_typed_values, path, 0);
         }
 
         // We have successfully retrieved a subscription, so add it to the vector
@@ -892,7 +893,7 @@ int NotifyChange_SubsEnable(dm_req_t *req, char *value)
         if ((cur_enable == false) && (val_bool == true) && (sub->notify_type == kSubNotifyType_ValueChange))
         {
             USP_SNPRINTF(source_path, sizeof(source_path), "%s.%d", device_subs_root, sub->instance);
-            GetAllPathExpressionParameterValues(sub, &sub->path_expressions, &sub->last_values, source_path, 0);
+            GetAllPathExpressionParameterValues(sub, &sub->path_expressions, &sub->last_values, &sub->last_typed_values, source_path, 0);
         }
     }
 
@@ -935,7 +936,7 @@ int NotifyChange_NotifyType(dm_req_t *req, char *value)
                                   && (new_notify_type == kSubNotifyType_ValueChange))
         {
             USP_SNPRINTF(source_path, sizeof(source_path), "%s.%d", device_subs_root, sub->instance);
-            GetAllPathExpressionParameterValues(sub, &sub->path_expressions, &sub->last_values, source_path, 0);
+            GetAllPathExpressionParameterValues(sub, &sub->path_expressions, &sub->last_values, &sub->last_typed_values, source_path, 0);
         }
 
     }
@@ -1696,6 +1697,9 @@ void ProcessAllValueChangeSubscriptions(void)
     subs_t *sub;
 
     // Iterate over all enabled subscriptions, processing each value change subscription
+    // NOTE: Values returned by group get callbacks are cached for the duration of the poll, so that object instances
+    // referenced by more than one subscription are only got once
+    DATA_MODEL_StartGroupGetCache();
     for (i=0; i < subscriptions.num_entries; i++)
     {
         sub = &subscriptions.vector[i];
@@ -1704,6 +1708,7 @@ void ProcessAllValueChangeSubscriptions(void)
             ProcessValueChangeSubscription(sub);
         }
     }
+    DATA_MODEL_StopGroupGetCache();
 }
 
 /*********************************************************************//**
@@ -1721,15 +1726,18 @@ void ProcessValueChangeSubscription(subs_t *sub)
 {
     int i;
     kv_vector_t cur_values;
+    dm_typed_value_t *cur_typed_values = NULL;
+    dm_typed_value_t *tv;
+    dm_typed_value_t *last_tv;
     kv_pair_t *pair;
     int index;
     int hint_index;
-    char *value;
+    bool is_changed;
     char source_path[MAX_DM_PATH];
 
     // Get the current values of all parameters associated with this subscription
     USP_SNPRINTF(source_path, sizeof(source_path), "%s.%d", device_subs_root, sub->instance);
-    GetAllPathExpressionParameterValues(sub, &sub->path_expressions, &cur_values, source_path, 0);
+    GetAllPathExpressionParameterValues(sub, &sub->path_expressions, &cur_values, &cur_typed_values, source_path, 0);
     
     // Determine whether any of the values have changed from last time
     hint_index = 0;
@@ -1744,9 +1752,20 @@ void ProcessValueChangeSubscription(subs_t *sub)
         if (index != INVALID)
         {
             hint_index = index + 1;         // Calculate index for next hint
-            value = sub->last_values.vector[index].value;
 
-            if (strcmp(value, pair->value) != 0)
+            // Compare the values natively if both were obtained natively, otherwise compare their string forms
+            tv = &cur_typed_values[i];
+            last_tv = (sub->last_typed_values != NULL) ? &sub->last_typed_values[index] : NULL;
+            if ((last_tv != NULL) && (tv->is_native) && (last_tv->is_native) && (tv->type_flags == last_tv->type_flags))
+            {
+                is_changed = !DM_ACCESS_IsEqualNativeValue(tv->type_flags, &tv->val_union, &last_tv->val_union);
+            }
+            else
+            {
+                is_changed = (strcmp(sub->last_values.vector[index].value, pair->value) != 0);
+            }
+
+            if (is_changed)
             {
                 // The value has changed since last time, so send a Value Change NotifyRequest
                 SendValueChangeNotify(sub, pair->key, pair->value);
@@ -1762,6 +1781,8 @@ void ProcessValueChangeSubscription(subs_t *sub)
     // Finally, replace the last set of values with the current set
     KV_VECTOR_Destroy(&sub->last_values);
     memcpy(&sub->last_values, &cur_values, sizeof(kv_vector_t));
+    USP_SAFE_FREE(sub->last_typed_values);
+    sub->last_typed_values = cur_typed_values;
 }
 
 /*********************************************************************//**
@@ -1774,18 +1795,22 @@ void ProcessValueChangeSubscription(subs_t *sub)
 ** \param   path_expressions - vector of path expressions to get the values of
 ** \param   param_values - vector in which parameter values are returned (key=parameter name, value=parameter value)
 **                         NOTE: This function overwrites any contents in this vector
+** \param   typed_values - pointer to variable in which to return a dynamically allocated array containing the type and native value
+**                         of each parameter in param_values (same order), or NULL if these are not required
+**                         NOTE: This function frees any array already referenced by this variable
 ** \param   source_path - string naming the table entry that the path expression came from. Used only for debug.
 ** \param   flags - flags to pass to the DATA_MODEL_GetParameterValue() function (eg JSON_FORMAT)
 **
 ** \return  None
 **
 **************************************************************************/
-void GetAllPathExpressionParameterValues(subs_t *sub, str_vector_t *path_expressions, kv_vector_t *param_values, char *source_path, unsigned flags)
+void GetAllPathExpressionParameterValues(subs_t *sub, str_vector_t *path_expressions, kv_vector_t *param_values, dm_typed_value_t **typed_values, char *source_path, unsigned flags)
 {
     int i;
     int err;
     str_vector_t params;
     kv_pair_t *pair;
+    dm_typed_value_t *tv = NULL;
     char buf[MAX_DM_VALUE_LEN];
 
     // Form a vector list containing all the parameters to get the value of
@@ -1795,6 +1820,16 @@ void GetAllPathExpressionParameterValues(subs_t *sub, str_vector_t *path_express
     // NOTE: We do not have to call STR_VECTOR_Destroy(&params) because STR_VECTOR_ConvertToKeyValueVector() destroys the string vector
     STR_VECTOR_ConvertToKeyValueVector(&params, param_values);
 
+    // Allocate the array in which to return the native values, if required
+    if (typed_values != NULL)
+    {
+        USP_SAFE_FREE(*typed_values);
+        if (param_values->num_entries > 0)
+        {
+            *typed_values = USP_MALLOC(param_values->num_entries*sizeof(dm_typed_value_t));
+        }
+    }
+
     // Iterate over all parameters in the key-value pair vector, getting their values from the data model
     for (i=0; i < param_values->num_entries; i++)
     {
@@ -1803,7 +1838,11 @@ void GetAllPathExpressionParameterValues(subs_t *sub, str_vector_t *path_express
 
         // Get the value of the parameter.
         buf[0] = '\0';
-        err = DATA_MODEL_GetParameterValue(pair->key, buf, sizeof(buf), flags);
+        if (typed_values != NULL)
+        {
+            tv = &(*typed_values)[i];
+        }
+        err = DATA_MODEL_GetTypedParameterValue(pair->key, buf, sizeof(buf), flags, tv);
         if (err == USP_ERR_OK)
         {
             pair->value = USP_STRDUP(buf);
@@ -1970,7 +2009,7 @@ void SendBootNotify(subs_t *sub)
 
     // Get the values of all parameters specified by the list of path expressions into the param_values vector
     USP_SNPRINTF(path, sizeof(path), "%s.%d", device_subs_root, sub->instance);
-    GetAllPathExpressionParameterValues(sub, &path_expr, &param_values, path, JSON_FORMAT);
+    GetAllPathExpressionParameterValues(sub, &path_expr, &param_values, NULL, path, JSON_FORMAT);
     STR_VECTOR_Destroy(&path_expr);
 
     // Create a JSON object containing the boot params (and associated values)
@@ -2005,44 +2044,21 @@ void SendBootNotify(subs_t *sub)
 **************************************************************************/
 char *SerializeToJSONObject(kv_vector_t *param_values)
 {
+    json_writer_t jw;
     kv_pair_t *kv;
-    int size;
-    char *buf;
-    char *p;
     int i;
 
-    // Calculate the size of buffer to allocate to store the JSON object
-    size = 3;       // Start from JSON Object including opening and closing braces and NULL terminator
-    for (i=0; i < param_values->num_entries; i++)
-    {
-        kv = &param_values->vector[i];
-        size += strlen(kv->key) + strlen(kv->value) + 4; // Plus 4 to include quoting the param path, adding colon separator and traling comma
-    }
-
-    // Allocate a buffer to store the JSON object
-    buf = USP_MALLOC(size);
-
-    // Write all parameters and values into the JSON buffer
-    p = buf;
-    *p++ = '{';
+    // Write all parameters and values into the JSON object
+    JSON_WRITER_Init(&jw, NULL);
+    JSON_WRITER_StartObject(&jw, NULL);
     for (i=0; i < param_values->num_entries; i++)
     {
-        // Add trailing separator from last iteration
-        if (i > 0)
-        {
-            *p++ = ',';
-        }
-
-        // Write parameter and value into buffer
         kv = &param_values->vector[i];
-        p += USP_SNPRINTF(p, &buf[size]-p, "\"%s\":%s", kv->key, kv->value);
+        JSON_WRITER_AddRaw(&jw, kv->key, kv->value);
     }
+    JSON_WRITER_EndObject(&jw);
 
-    // Finish the JSON object
-    *p++ = '}';
-    *p++ = '\0';
-
-    return buf;
+    return JSON_WRITER_Finish(&jw);
 }
 
 /*********************************************************************//**
@@ -53,6 +53,10 @@
 #include "expr_vector.h"
 #include "nu_ipaddr.h"
 
+//------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+int CompareNumericValues(long double lh_value, expr_op_t op, long double rh_value, bool *result);
+
 /*********************************************************************//**
 **
 ** DM_ACCESS_GetString
@@ -663,7 +667,6 @@ int DM_ACCESS_CompareNumber(char *lhs, expr_op_t op, char *rhs, bool *result)
 {
     long double lh_value;
     long double rh_value;
-    int err;
     int num_converted;
 
     // Exit if the left hand operand could not be converted
@@ -684,58 +687,7 @@ int DM_ACCESS_CompareNumber(char *lhs, expr_op_t op, char *rhs, bool *result)
         return USP_ERR_INVALID_PATH_SYNTAX;
     }
 
-    *result = false;    // Assume that comparison failed to match
-    err = USP_ERR_OK;   // Assume that comparison operator was valid
-    switch(op)
-    {
-        case kExprOp_Equal:
-            if (lh_value == rh_value)
-            {
-                *result = true;
-            }
-            break;
-
-        case kExprOp_NotEqual:
-            if (lh_value != rh_value)
-            {
-                *result = true;
-            }
-            break;
-
-        case kExprOp_LessThanOrEqual:
-            if (lh_value <= rh_value)
-            {
-                *result = true;
-            }
-            break;
-            
-        case kExprOp_GreaterThanOrEqual:
-            if (lh_value >= rh_value)
-            {
-                *result = true;
-            }
-            break;
-            
-        case kExprOp_LessThan:
-            if (lh_value < rh_value)
-            {
-                *result = true;
-            }
-            break;
-            
-        case kExprOp_GreaterThan:
-            if (lh_value > rh_value)
-            {
-                *result = true;
-            }
-            break;
-
-        default:        
-            TERMINATE_BAD_CASE(op);
-            break;
-    }
-
-    return err;
+    return CompareNumericValues(lh_value, op, rh_value, result);
 }
 
 /*********************************************************************//**
@@ -902,6 +854,205 @@ int DM_ACCESS_CompareDateTime(char *lhs, expr_op_t op, char *rhs, bool *result)
     return err;
 }
 
+/*********************************************************************//**
+**
+** DM_ACCESS_CompareNativeValue
+**
+** Compares a parameter's value, supplied in native form, against a value supplied as a string
+** This avoids the cost of converting the parameter's value to a string and back again
+**
+** \param   type_flags - type of the parameter (eg DM_UINT)
+** \param   lhs - pointer to native value of the left hand operand to compare
+** \param   op - operator to use when comparing the values
+** \param   rhs - string representing the right hand operand to compare
+** \param   result - pointer to boolean in which to return whether the comparison matched or not
+**
+** \return  USP_ERR_OK if validated successfully
+**
+**************************************************************************/
+int DM_ACCESS_CompareNativeValue(unsigned type_flags, dm_val_union_t *lhs, expr_op_t op, char *rhs, bool *result)
+{
+    long double lh_value;
+    long double rh_value;
+    time_t rh_datetime;
+    bool rh_bool;
+    int num_converted;
+    int err;
+
+    *result = false;    // Assume that comparison failed to match
+    if (type_flags & DM_BOOL)
+    {
+        // Exit if the right hand operand could not be converted
+        // NOTE: This could occur if the search expression contained errors in it
+        err = TEXT_UTILS_StringToBool(rhs, &rh_bool);
+        if (err != USP_ERR_OK)
+        {
+            USP_ERR_SetMessage("%s: Expecting expression constant ('%s') to be a boolean", __FUNCTION__, rhs);
+            return USP_ERR_INVALID_PATH_SYNTAX;
+        }
+
+        // Exit if the operator is not supported for booleans
+        if ((op != kExprOp_Equal) && (op != kExprOp_NotEqual))
+        {
+            USP_ERR_SetMessage("%s: Operator '%s' not supported for booleans", __FUNCTION__, expr_op_2_str[op]);
+            return USP_ERR_INVALID_PATH_SYNTAX;
+        }
+
+        lh_value = (lhs->value_bool) ? 1 : 0;
+        rh_value = (rh_bool) ? 1 : 0;
+    }
+    else if (type_flags & DM_DATETIME)
+    {
+        // Exit if the right hand operand could not be converted
+        // NOTE: This could occur if the search expression contained errors in it
+        err = TEXT_UTILS_StringToDateTime(rhs, &rh_datetime);
+        if (err != USP_ERR_OK)
+        {
+            USP_ERR_SetMessage("%s: Expecting expression constant ('%s') to be an ISO8601 dateTime", __FUNCTION__, rhs);
+            return USP_ERR_INVALID_PATH_SYNTAX;
+        }
+
+        lh_value = lhs->value_datetime;
+        rh_value = rh_datetime;
+    }
+    else
+    {
+        // Exit if the right hand operand could not be converted
+        // NOTE: This could occur if the search expression contained errors in it
+        num_converted = sscanf(rhs, "%Lf", &rh_value);
+        if (num_converted == 0)
+        {
+            USP_ERR_SetMessage("%s: Expecting expression constant ('%s') to be a number", __FUNCTION__, rhs);
+            return USP_ERR_INVALID_PATH_SYNTAX;
+        }
+
+        if (type_flags & DM_INT)
+        {
+            lh_value = lhs->value_int;
+        }
+        else if (type_flags & DM_UINT)
+        {
+            lh_value = lhs->value_uint;
+        }
+        else
+        {
+            USP_ASSERT(type_flags & DM_ULONG);
+            lh_value = lhs->value_ulong;
+        }
+    }
+
+    return CompareNumericValues(lh_value, op, rh_value, result);
+}
+
+/*********************************************************************//**
+**
+** DM_ACCESS_IsEqualNativeValue
+**
+** Determines whether two values of a parameter, both supplied in native form, are the same
+** This avoids the cost of comparing the values as strings
+**
+** \param   type_flags - type of the parameter (eg DM_UINT)
+** \param   v1 - pointer to native value to compare
+** \param   v2 - pointer to native value to compare against
+**
+** \return  true if the values are the same
+**
+**************************************************************************/
+bool DM_ACCESS_IsEqualNativeValue(unsigned type_flags, dm_val_union_t *v1, dm_val_union_t *v2)
+{
+    if (type_flags & DM_BOOL)
+    {
+        return (v1->value_bool == v2->value_bool);
+    }
+    else if (type_flags & DM_DATETIME)
+    {
+        return (v1->value_datetime == v2->value_datetime);
+    }
+    else if (type_flags & DM_INT)
+    {
+        return (v1->value_int == v2->value_int);
+    }
+    else if (type_flags & DM_UINT)
+    {
+        return (v1->value_uint == v2->value_uint);
+    }
+
+    USP_ASSERT(type_flags & DM_ULONG);
+    return (v1->value_ulong == v2->value_ulong);
+}
+
+/*********************************************************************//**
+**
+** CompareNumericValues
+**
+** Compares two numeric values
+**
+** \param   lh_value - left hand operand to compare
+** \param   op - operator to use when comparing the values
+** \param   rh_value - right hand operand to compare
+** \param   result - pointer to boolean in which to return whether the comparison matched or not
+**
+** \return  USP_ERR_OK if validated successfully
+**
+**************************************************************************/
+int CompareNumericValues(long double lh_value, expr_op_t op, long double rh_value, bool *result)
+{
+    int err;
+
+    *result = false;    // Assume that comparison failed to match
+    err = USP_ERR_OK;   // Assume that comparison operator was valid
+    switch(op)
+    {
+        case kExprOp_Equal:
+            if (lh_value == rh_value)
+            {
+                *result = true;
+            }
+            break;
+
+        case kExprOp_NotEqual:
+            if (lh_value != rh_value)
+            {
+                *result = true;
+            }
+            break;
+
+        case kExprOp_LessThanOrEqual:
+            if (lh_value <= rh_value)
+            {
+                *result = true;
+            }
+            break;
+            
+        case kExprOp_GreaterThanOrEqual:
+            if (lh_value >= rh_value)
+            {
+                *result = true;
+            }
+            break;
+            
+        case kExprOp_LessThan:
+            if (lh_value < rh_value)
+            {
+                *result = true;
+            }
+            break;
+            
+        case kExprOp_GreaterThan:
+            if (lh_value > rh_value)
+            {
+                *result = true;
+            }
+            break;
+
+        default:        
+            TERMINATE_BAD_CASE(op);
+            break;
+    }
+
+    return err;
+}
+
 /*********************************************************************//**
 **
 ** DM_ACCESS_RestartAsyncOperation
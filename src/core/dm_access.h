@@ -70,6 +70,8 @@ int DM_ACCESS_CompareString(char *lhs, expr_op_t op, char *rhs, bool *result);
 int DM_ACCESS_CompareNumber(char *lhs, expr_op_t op, char *rhs, bool *result);
 int DM_ACCESS_CompareBool(char *lhs, expr_op_t op, char *rhs, bool *result);
 int DM_ACCESS_CompareDateTime(char *lhs, expr_op_t op, char *rhs, bool *result);
+int DM_ACCESS_CompareNativeValue(unsigned type_flags, dm_val_union_t *lhs, expr_op_t op, char *rhs, bool *result);
+bool DM_ACCESS_IsEqualNativeValue(unsigned type_flags, dm_val_union_t *v1, dm_val_union_t *v2);
 int DM_ACCESS_RestartAsyncOperation(dm_req_t *req, int instance, bool *is_restart, int *err_code, char *err_msg, int err_msg_len, kv_vector_t *output_args);
 int DM_ACCESS_DontRestartAsyncOperation(dm_req_t *req, int instance, bool *is_restart, int *err_code, char *err_msg, int err_msg_len, kv_vector_t *output_args);
 int DM_ACCESS_PopulateAliasParam(dm_req_t *req, char *buf, int len);
@@ -158,6 +158,7 @@ typedef struct
 {
     int profile_id;         // Instance number of profile in Device.Bulkdata.Profile.{i}
     bool transfer_result;   // Set to true if report sent successfully, false otherwise
+    bdc_transfer_stats_t stats; // Timings of the transfer
 } bdc_transfer_result_msg_t;
 
 
@@ -658,11 +659,12 @@ void DM_EXEC_PostMtpThreadExited(void)
 **
 ** \param   profile_id - Instance number of profile in Device.Bulkdata.Profile.{i}
 ** \param   transfer_result - set to true if the report was sent successfuly, false otherwise
+** \param   stats - pointer to timings of the transfer
 **
 ** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-int DM_EXEC_NotifyBdcTransferResult(int profile_id, bool transfer_result)
+int DM_EXEC_NotifyBdcTransferResult(int profile_id, bool transfer_result, bdc_transfer_stats_t *stats)
 {
     dm_exec_msg_t  msg;
     bdc_transfer_result_msg_t *btr;
@@ -681,6 +683,7 @@ int DM_EXEC_NotifyBdcTransferResult(int profile_id, bool transfer_result)
     btr = &msg.params.bdc_transfer_result;
     btr->profile_id = profile_id;
     btr->transfer_result = transfer_result;
+    memcpy(&btr->stats, stats, sizeof(bdc_transfer_stats_t));
 
     // Send the message
     bytes_sent = send(mq_tx_socket, &msg, sizeof(msg), 0);
@@ -993,7 +996,7 @@ void ProcessMessageQueueSocketActivity(socket_set_t *set)
 
         case kDmExecMsg_BdcTransferResult:
             btr = &msg.params.bdc_transfer_result;
-            DEVICE_BULKDATA_NotifyTransferResult(btr->profile_id, btr->transfer_result);
+            DEVICE_BULKDATA_NotifyTransferResult(btr->profile_id, btr->transfer_result, &btr->stats);
             break;    
 
         default:
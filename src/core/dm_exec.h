@@ -41,6 +41,8 @@
 #ifndef DM_EXEC_H
 #define DM_EXEC_H
 
+#include "bdc_exec.h"
+
 //------------------------------------------------------------------------------
 // API functions
 int DM_EXEC_Init(void);
@@ -49,7 +51,7 @@ void DM_EXEC_PostUspRecord(unsigned char *pbuf, int pbuf_len, ctrust_role_t role
 void DM_EXEC_PostStompHandshakeComplete(int stomp_instance, ctrust_role_t role, char *allowed_controllers);
 void DM_EXEC_PostMtpThreadExited(void);
 void DM_EXEC_HandleStompHandshakeComplete(int stomp_instance, ctrust_role_t role, char *allowed_controllers);
-int DM_EXEC_NotifyBdcTransferResult(int profile_id, bool transfer_result);
+int DM_EXEC_NotifyBdcTransferResult(int profile_id, bool transfer_result, bdc_transfer_stats_t *stats);
 void *DM_EXEC_Main(void *args);
 //------------------------------------------------------------------------------
 
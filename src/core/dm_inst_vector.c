@@ -69,6 +69,7 @@ void DM_INST_VECTOR_Init(dm_instances_vector_t *div)
 {
     div->vector = NULL;
     div->num_entries = 0;
+    div->generation = 0;
 }
 
 /*********************************************************************//**
@@ -91,6 +92,7 @@ void DM_INST_VECTOR_Destroy(dm_instances_vector_t *div)
 
     div->vector = NULL;
     div->num_entries = 0;
+    div->generation++;
 }
 
 /*********************************************************************//**
@@ -146,6 +148,7 @@ int DM_INST_VECTOR_Add(dm_instances_t *inst)
     // And store this object instance
     memcpy(&div->vector[div->num_entries], inst, sizeof(dm_instances_t));
     div->num_entries++;
+    div->generation++;
 
     return USP_ERR_OK;
 }
@@ -212,7 +215,30 @@ void DM_INST_VECTOR_Remove(dm_instances_t *inst)
 
     // NOTE: Don't bother reallocating the memory for the array (it could now be smaller).
     // It will be resized next time an instance is added.
-    div->num_entries = j;
+    if (j != div->num_entries)
+    {
+        div->num_entries = j;
+        div->generation++;
+    }
+}
+
+/*********************************************************************//**
+**
+** DM_INST_VECTOR_GetGeneration
+**
+** Returns the generation count of the instances of the specified top level multi-instance object (and all of its child objects)
+** The generation count changes whenever any of these instances are added or removed, so callers may cache state
+** derived from the instances (eg the resolved paths of a path expression), and detect when it becomes stale
+**
+** \param   top_node - pointer to top level multi-instance object node, which holds the dm_instances_vector
+**
+** \return  generation count of the instances
+**
+**************************************************************************/
+unsigned DM_INST_VECTOR_GetGeneration(dm_node_t *top_node)
+{
+    USP_ASSERT(top_node->type == kDMNodeType_Object_MultiInstance);
+    return top_node->registered.object_info.inst_vector.generation;
 }
 
 /*********************************************************************//**
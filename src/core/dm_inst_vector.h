@@ -55,6 +55,7 @@ int DM_INST_VECTOR_GetNumInstances(dm_node_t *node, dm_instances_t *inst);
 int DM_INST_VECTOR_GetInstances(dm_node_t *node, dm_instances_t *inst, int_vector_t *iv);
 void DM_INST_VECTOR_GetAllInstancePaths_Unqualified(dm_node_t *node, dm_instances_t *inst, str_vector_t *sv, combined_role_t *combined_role);
 void DM_INST_VECTOR_GetAllInstancePaths_Qualified(dm_instances_t *inst, str_vector_t *sv, combined_role_t *combined_role);
+unsigned DM_INST_VECTOR_GetGeneration(dm_node_t *top_node);
 void DM_INST_VECTOR_Dump(dm_instances_vector_t *div);
 
 #endif
@@ -43,6 +43,7 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "common_defs.h"
@@ -70,6 +71,13 @@ static const char *op_to_str[kDMOp_Max] =
 //--------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 void ClearTransaction(dm_trans_vector_t *trans);
+bool IsPartOfAddOperation(dm_trans_vector_t *trans, dm_instances_t *inst);
+int FindAddOperation(dm_trans_vector_t *trans, dm_node_t *node, int *instances, bool *is_found);
+void AddToAddOperations(dm_trans_vector_t *trans, int index);
+int CompareAddOperation(dm_node_t *node, int *instances, dm_trans_t *dt);
+int ApplyGroupSets(dm_trans_vector_t *trans);
+void FreeGroupSets(dm_trans_vector_t *trans);
+int CompareGroupSets(const void *entry1, const void *entry2);
 
 /*********************************************************************//**
 **
@@ -89,8 +97,7 @@ int DM_TRANS_Start(dm_trans_vector_t *trans)
     dm_vendor_start_trans_cb_t   start_trans_cb;
 
     // Initialise the vector of operations to notify
-    trans->num_entries = 0;
-    trans->vector = NULL;
+    memset(trans, 0, sizeof(dm_trans_vector_t));
 
     // Save this vector - it will be used when adding all subsequent operations
     USP_ASSERT(cur_transaction == NULL);
@@ -148,31 +155,14 @@ void DM_TRANS_Add(dm_op_t op, char *path, char *value, dm_val_union_t *val_union
 {
     int new_num_entries;
     dm_trans_t *dt;
-    int i;
 
     USP_ASSERT(cur_transaction != NULL);
 
     // Do not add set operations, if they are part of a larger add operation - we only want to notify the add
     // NOTE: When processing a USP AddRequest message, default values are not added to the transaction, only the overridden default values (in the USP AddRequest message)
-    if (op == kDMOp_Set)
+    if ((op == kDMOp_Set) && (IsPartOfAddOperation(cur_transaction, inst)))
     {
-        // Iterate over all operations, seeing if any were an add operation
-        for (i=0; i < cur_transaction->num_entries; i++)
-        {
-            dt = &cur_transaction->vector[i];
-            if (dt->op == kDMOp_Add)
-            {
-                if (inst->order >= dt->inst.order)
-                {
-                    // If this set is for a parameter whose parent instances match that of the add, then do not add to transaction
-                    if ( (memcmp(inst->nodes, dt->node->instance_nodes, (dt->inst.order)*sizeof(dm_node_t *)) == 0) &&
-                         (memcmp(inst->instances, dt->inst.instances, (dt->inst.order)*sizeof(int)) == 0) )
-                    {
-                        return;
-                    }
-                }
-            }
-        }
+        return;
     }
 
     // For us to detect that a delete operation matches a resolved path, we need to resolve the list of
@@ -182,9 +172,13 @@ void DM_TRANS_Add(dm_op_t op, char *path, char *value, dm_val_union_t *val_union
         DEVICE_SUBSCRIPTION_ResolveObjectDeletionPaths();
     }
 
-    // Increase the size of the current transaction vector
+    // Increase the size of the current transaction vector, if it is full
     new_num_entries = cur_transaction->num_entries + 1;
-    cur_transaction->vector = USP_REALLOC(cur_transaction->vector, new_num_entries * sizeof(dm_trans_t));
+    if (new_num_entries > cur_transaction->max_entries)
+    {
+        cur_transaction->max_entries = (cur_transaction->max_entries == 0) ? 16 : 2*cur_transaction->max_entries;
+        cur_transaction->vector = USP_REALLOC(cur_transaction->vector, cur_transaction->max_entries * sizeof(dm_trans_t));
+    }
 
     // And store this operation
     dt = &cur_transaction->vector[ new_num_entries-1 ];
@@ -210,6 +204,78 @@ void DM_TRANS_Add(dm_op_t op, char *path, char *value, dm_val_union_t *val_union
     }
 
     cur_transaction->num_entries = new_num_entries;
+
+    // Index add operations, so that sets which are part of them can be found quickly
+    if (op == kDMOp_Add)
+    {
+        AddToAddOperations(cur_transaction, new_num_entries-1);
+    }
+}
+
+/*********************************************************************//**
+**
+** DM_TRANS_AddGroupSet
+**
+** Adds the set of a vendor parameter, whose parent object has a group set callback, to the current transaction
+** The parameter is not set until DM_TRANS_ApplyGroupSets() is called or the transaction is committed, at which point
+** all parameters set in the object instance are passed to the group set callback at once
+**
+** \param   path - pointer to full data model path to parameter
+** \param   value - pointer to string containing the value to set
+** \param   obj_node - pointer to node in data model representing the parent object of the parameter
+** \param   inst - pointer to parsed instance numbers for the parameter
+**
+** \return  None
+**
+**************************************************************************/
+void DM_TRANS_AddGroupSet(char *path, char *value, dm_node_t *obj_node, dm_instances_t *inst)
+{
+    dm_trans_t *dt;
+
+    USP_ASSERT(cur_transaction != NULL);
+
+    // Increase the size of the vector of group sets, if it is full
+    if (cur_transaction->num_group_sets == cur_transaction->max_group_sets)
+    {
+        cur_transaction->max_group_sets = (cur_transaction->max_group_sets == 0) ? 16 : 2*cur_transaction->max_group_sets;
+        cur_transaction->group_sets = USP_REALLOC(cur_transaction->group_sets, cur_transaction->max_group_sets * sizeof(dm_trans_t));
+    }
+
+    // And store this set
+    dt = &cur_transaction->group_sets[ cur_transaction->num_group_sets ];
+    memset(dt, 0, sizeof(dm_trans_t));
+    dt->op = kDMOp_Set;
+    dt->path = USP_STRDUP(path);
+    dt->value = USP_STRDUP(value);
+    dt->node = obj_node;
+    memcpy(&dt->inst, inst, sizeof(dm_req_instances_t));
+    cur_transaction->num_group_sets++;
+}
+
+/*********************************************************************//**
+**
+** DM_TRANS_ApplyGroupSets
+**
+** Applies all vendor parameter sets which have been staged for group set callbacks in the current transaction,
+** then removes them from the transaction, so that they are not applied again when the transaction is committed
+** NOTE: This is called by the USP message handlers once all parameters of an object instance have been set,
+**       so that subsequent reads of the parameters within the same transaction (eg of unique keys) return the new values
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int DM_TRANS_ApplyGroupSets(void)
+{
+    int err;
+
+    USP_ASSERT(cur_transaction != NULL);
+
+    err = ApplyGroupSets(cur_transaction);
+    FreeGroupSets(cur_transaction);
+
+    return err;
 }
 
 /*********************************************************************//**
@@ -237,6 +303,14 @@ int DM_TRANS_Commit(void)
 
     USP_ASSERT(cur_transaction != NULL);
 
+    // Exit if unable to apply any vendor parameters which are still staged for group set callbacks, aborting the transaction
+    err = DM_TRANS_ApplyGroupSets();
+    if (err != USP_ERR_OK)
+    {
+        DM_TRANS_Abort();
+        return err;
+    }
+
 #ifdef ENABLE_HIDL
     // Exit if unable to commit a HIDL client transaction 
     err = HIDL_CommitTransaction();
@@ -407,7 +481,7 @@ int DM_TRANS_Abort(void)
             // Form object instances array
             memset(&inst, 0, sizeof(inst));
             memcpy(&inst, &dt->inst, sizeof(dt->inst));
-            memcpy(&inst.nodes, &node->instance_nodes, node->order*sizeof(dm_node_t *));
+            memcpy(&inst.nodes, node->instance_nodes, node->order*sizeof(dm_node_t *));
     
             if (dt->op == kDMOp_Add)
             {
@@ -515,9 +589,337 @@ void ClearTransaction(dm_trans_vector_t *trans)
     USP_FREE(trans->vector);
 
 exit:
+    // Free all group sets
+    FreeGroupSets(trans);
+    USP_SAFE_FREE(trans->group_sets);
+
     // Ensure queue is re-initialised to empty state
-    trans->vector = NULL;
-    trans->num_entries = 0;
+    USP_SAFE_FREE(trans->adds);
+    memset(trans, 0, sizeof(dm_trans_vector_t));
+}
+
+/*********************************************************************//**
+**
+** ApplyGroupSets
+**
+** Calls the group set callback of each object instance which has had vendor parameters set in the transaction,
+** passing it all of the parameters set in the object instance
+** NOTE: If a parameter was set more than once, only the last value is passed
+**
+** \param   trans - pointer to transaction
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int ApplyGroupSets(dm_trans_vector_t *trans)
+{
+    int i;
+    int start;
+    int err;
+    int obj_len;
+    char *name;
+    dm_trans_t **sorted;
+    dm_trans_t *dt;
+    dm_set_group_cb_t set_group_cb;
+    kv_vector_t params;
+    dm_req_t req;
+    char obj_path[MAX_DM_PATH];
+
+    // Exit if there are no group sets in the transaction
+    if (trans->num_group_sets == 0)
+    {
+        return USP_ERR_OK;
+    }
+
+    // Sort the group sets by object instance, so that the sets to each object instance are contiguous
+    // NOTE: Sets to the same parameter remain in the order they were made
+    sorted = USP_MALLOC(trans->num_group_sets * sizeof(dm_trans_t *));
+    for (i=0; i < trans->num_group_sets; i++)
+    {
+        sorted[i] = &trans->group_sets[i];
+    }
+    qsort(sorted, trans->num_group_sets, sizeof(dm_trans_t *), CompareGroupSets);
+
+    // Iterate over all object instances which have had parameters set
+    err = USP_ERR_OK;
+    start = 0;
+    while (start < trans->num_group_sets)
+    {
+        // Determine the path of this object instance
+        dt = sorted[start];
+        name = strrchr(dt->path, '.');
+        USP_ASSERT(name != NULL);
+        obj_len = name - dt->path;
+        USP_STRNCPY(obj_path, dt->path, MIN(obj_len+1, sizeof(obj_path)));
+
+        // Form the map of all parameters set in this object instance
+        KV_VECTOR_Init(&params);
+        for (i=start; i < trans->num_group_sets; i++)
+        {
+            // Exit the loop if this parameter is not an immediate child of the object instance
+            dt = sorted[i];
+            if ((strncmp(dt->path, obj_path, obj_len) != 0) || (dt->path[obj_len] != '.') || (strchr(&dt->path[obj_len+1], '.') != NULL))
+            {
+                break;
+            }
+
+            name = &dt->path[obj_len+1];
+            if (KV_VECTOR_Replace(&params, name, dt->value) == false)
+            {
+                KV_VECTOR_Add(&params, name, dt->value);
+            }
+        }
+
+        // Exit if the vendor was unable to apply the parameters
+        dt = sorted[start];
+        set_group_cb = dt->node->registered.object_info.set_group_cb;
+        USP_ASSERT(set_group_cb != NULL);
+        DM_PRIV_RequestInit(&req, dt->node, obj_path, (dm_instances_t *) &dt->inst);
+        USP_ERR_ClearMessage();
+        err = set_group_cb(&req, &params);
+        KV_VECTOR_Destroy(&params);
+        if (err != USP_ERR_OK)
+        {
+            USP_ERR_ReplaceEmptyMessage("%s: Group set callback for path %s returned error %d", __FUNCTION__, obj_path, err);
+            goto exit;
+        }
+
+        start = i;
+    }
+
+exit:
+    USP_FREE(sorted);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** FreeGroupSets
+**
+** Frees all group sets staged in the transaction, leaving the vector of group sets empty (but allocated)
+**
+** \param   trans - pointer to transaction
+**
+** \return  None
+**
+**************************************************************************/
+void FreeGroupSets(dm_trans_vector_t *trans)
+{
+    int i;
+    dm_trans_t *dt;
+
+    for (i=0; i < trans->num_group_sets; i++)
+    {
+        dt = &trans->group_sets[i];
+        USP_FREE(dt->path);
+        USP_FREE(dt->value);
+    }
+
+    trans->num_group_sets = 0;
+}
+
+/*********************************************************************//**
+**
+** CompareGroupSets
+**
+** Comparison function used by qsort to sort the group sets in a transaction by the path of their object instance, then by parameter name
+** Sets to the same parameter are ordered by their position in the transaction (ie the order in which they were made)
+**
+** \param   entry1 - pointer to pointer to first group set to compare
+** \param   entry2 - pointer to pointer to second group set to compare
+**
+** \return  negative if entry1 is before entry2, positive if after
+**
+**************************************************************************/
+int CompareGroupSets(const void *entry1, const void *entry2)
+{
+    dm_trans_t *dt1 = *((dm_trans_t **) entry1);
+    dm_trans_t *dt2 = *((dm_trans_t **) entry2);
+    int len1;
+    int len2;
+    int result;
+
+    // Compare the paths of the object instances
+    len1 = strrchr(dt1->path, '.') - dt1->path;
+    len2 = strrchr(dt2->path, '.') - dt2->path;
+    result = strncmp(dt1->path, dt2->path, MIN(len1, len2));
+    if (result != 0)
+    {
+        return result;
+    }
+
+    if (len1 != len2)
+    {
+        return len1 - len2;
+    }
+
+    // Compare the parameter names
+    result = strcmp(dt1->path, dt2->path);
+    if (result != 0)
+    {
+        return result;
+    }
+
+    return (dt1 < dt2) ? -1 : 1;
+}
+
+/*********************************************************************//**
+**
+** IsPartOfAddOperation
+**
+** Determines whether the specified parameter is in an object (or a child of an object) added in the transaction
+**
+** \param   trans - pointer to transaction
+** \param   inst - pointer to parsed instance numbers (and associated nodes) of the parameter
+**
+** \return  true if the parameter is part of an add operation in the transaction
+**
+**************************************************************************/
+bool IsPartOfAddOperation(dm_trans_vector_t *trans, dm_instances_t *inst)
+{
+    int order;
+    bool is_found;
+
+    // Exit if there are no add operations in the transaction
+    if (trans->num_adds == 0)
+    {
+        return false;
+    }
+
+    // Iterate over all objects containing the parameter, seeing if any were added in the transaction
+    for (order=1; order <= inst->order; order++)
+    {
+        FindAddOperation(trans, inst->nodes[order-1], inst->instances, &is_found);
+        if (is_found)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*********************************************************************//**
+**
+** FindAddOperation
+**
+** Performs a binary search of the add operations in the transaction, to find the one which added the specified object instance
+**
+** \param   trans - pointer to transaction
+** \param   node - pointer to node representing the multi-instance object
+** \param   instances - pointer to array of instance numbers for the object instance (and its parents)
+**                      NOTE: Only the first node->order instance numbers are used
+** \param   is_found - pointer to variable in which to return whether the object instance was added in the transaction
+**
+** \return  index (in trans->adds) of the matching add operation if found, otherwise the index at which it should be inserted
+**
+**************************************************************************/
+int FindAddOperation(dm_trans_vector_t *trans, dm_node_t *node, int *instances, bool *is_found)
+{
+    int lower;
+    int upper;
+    int mid;
+    int result;
+
+    lower = 0;
+    upper = trans->num_adds - 1;
+    while (lower <= upper)
+    {
+        mid = (lower + upper)/2;
+        result = CompareAddOperation(node, instances, &trans->vector[ trans->adds[mid] ]);
+        if (result == 0)
+        {
+            *is_found = true;
+            return mid;
+        }
+
+        if (result < 0)
+        {
+            upper = mid - 1;
+        }
+        else
+        {
+            lower = mid + 1;
+        }
+    }
+
+    *is_found = false;
+    return lower;
+}
+
+/*********************************************************************//**
+**
+** AddToAddOperations
+**
+** Inserts the specified add operation into the sorted index of add operations in the transaction
+**
+** \param   trans - pointer to transaction
+** \param   index - index (in trans->vector) of the add operation
+**
+** \return  None
+**
+**************************************************************************/
+void AddToAddOperations(dm_trans_vector_t *trans, int index)
+{
+    int pos;
+    bool is_found;
+    dm_trans_t *dt;
+
+    // Exit if this object instance has already been added in the transaction
+    // NOTE: This could occur if the object instance was added, deleted, then added again
+    dt = &trans->vector[index];
+    pos = FindAddOperation(trans, dt->node, dt->inst.instances, &is_found);
+    if (is_found)
+    {
+        return;
+    }
+
+    // Increase the size of the index, if it is full
+    if (trans->num_adds == trans->max_adds)
+    {
+        trans->max_adds = (trans->max_adds == 0) ? 16 : 2*trans->max_adds;
+        trans->adds = USP_REALLOC(trans->adds, trans->max_adds * sizeof(int));
+    }
+
+    // Insert the add operation into the index
+    // NOTE: Objects are usually added in increasing instance number order, so this is usually an append
+    memmove(&trans->adds[pos+1], &trans->adds[pos], (trans->num_adds - pos)*sizeof(int));
+    trans->adds[pos] = index;
+    trans->num_adds++;
+}
+
+/*********************************************************************//**
+**
+** CompareAddOperation
+**
+** Compares the specified object instance against the object instance added by an add operation
+** Add operations are ordered by the node of the object, then by its instance numbers
+**
+** \param   node - pointer to node representing the multi-instance object
+** \param   instances - pointer to array of instance numbers for the object instance (and its parents)
+** \param   dt - pointer to add operation to compare against
+**
+** \return  negative if the object instance is before the add operation, positive if after, or 0 if they match
+**
+**************************************************************************/
+int CompareAddOperation(dm_node_t *node, int *instances, dm_trans_t *dt)
+{
+    int i;
+
+    if (node != dt->node)
+    {
+        return ((uintptr_t)node < (uintptr_t)dt->node) ? -1 : 1;
+    }
+
+    for (i=0; i < dt->inst.order; i++)
+    {
+        if (instances[i] != dt->inst.instances[i])
+        {
+            return (instances[i] < dt->inst.instances[i]) ? -1 : 1;
+        }
+    }
+
+    return 0;
 }
 
 
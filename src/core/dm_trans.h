@@ -74,13 +74,26 @@ typedef struct
 typedef struct
 {
     int num_entries;
+    int max_entries;    // Number of entries allocated in the vector. The vector is grown geometrically, to avoid reallocating it for every operation
     dm_trans_t *vector;
+
+    int *adds;          // Index (into the vector) of each Add operation, sorted by the node and instance numbers of the added object
+                        // This allows sets which are part of an add operation to be found, without iterating over the whole transaction
+    int num_adds;
+    int max_adds;
+
+    dm_trans_t *group_sets; // Sets of vendor parameters which are applied by their parent object's group set callback, when DM_TRANS_ApplyGroupSets() is called or the transaction is committed
+                            // NOTE: For these entries, 'node' is the parent object, rather than the parameter
+    int num_group_sets;
+    int max_group_sets;
 } dm_trans_vector_t;
 
 //-----------------------------------------------------------------------------------------
 // API
 int DM_TRANS_Start(dm_trans_vector_t *trans);
 void DM_TRANS_Add(dm_op_t op, char *path, char *value, dm_val_union_t *val_union, dm_node_t *node, dm_instances_t *inst);
+void DM_TRANS_AddGroupSet(char *path, char *value, dm_node_t *obj_node, dm_instances_t *inst);
+int DM_TRANS_ApplyGroupSets(void);
 int DM_TRANS_Commit(void);
 int DM_TRANS_Abort(void);
 bool DM_TRANS_IsWithinTransaction(void);
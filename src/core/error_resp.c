@@ -112,21 +112,21 @@ Usp__Msg *ERROR_RESP_Create(char *msg_id, int err_code, char *err_msg)
     Usp__Error *error;
 
     // Allocate memory to store the USP message
-    resp = USP_MALLOC(sizeof(Usp__Msg));
+    resp = USP_ARENA_MALLOC(sizeof(Usp__Msg));
     usp__msg__init(resp);
 
-    header = USP_MALLOC(sizeof(Usp__Header));
+    header = USP_ARENA_MALLOC(sizeof(Usp__Header));
     usp__header__init(header);
 
-    body = USP_MALLOC(sizeof(Usp__Body));
+    body = USP_ARENA_MALLOC(sizeof(Usp__Body));
     usp__body__init(body);
 
-    error = USP_MALLOC(sizeof(Usp__Error));
+    error = USP_ARENA_MALLOC(sizeof(Usp__Error));
     usp__error__init(error);
 
     // Connect the structures together
     resp->header = header;
-    header->msg_id = USP_STRDUP(msg_id);
+    header->msg_id = USP_ARENA_STRDUP(msg_id);
     header->msg_type = USP__HEADER__MSG_TYPE__ERROR;
 
     resp->body = body;
@@ -134,7 +134,7 @@ Usp__Msg *ERROR_RESP_Create(char *msg_id, int err_code, char *err_msg)
     body->error = error;
 
     error->err_code = err_code;
-    error->err_msg = USP_STRDUP(err_msg);
+    error->err_msg = USP_ARENA_STRDUP(err_msg);
     error->n_param_errs = 0;
     error->param_errs = NULL;
 
@@ -164,20 +164,20 @@ ERROR_RESP_AddParamError(Usp__Msg *resp, char *path, int err_code, char *err_msg
     int new_num;    // new number of param_error
 
     // Allocate memory to store the param_error
-    param_err = USP_MALLOC(sizeof(Usp__Error__ParamError));
+    param_err = USP_ARENA_MALLOC(sizeof(Usp__Error__ParamError));
     usp__error__param_error__init(param_err);
 
     // Increase the size of the vector containing pointers to the param_errors
     error = resp->body->error;
     new_num = error->n_param_errs + 1;
-    error->param_errs = USP_REALLOC(error->param_errs, new_num*sizeof(void *));
+    error->param_errs = USP_ARENA_REALLOC(error->param_errs, new_num*sizeof(void *));
     error->n_param_errs = new_num;
     error->param_errs[new_num-1] = param_err;
 
     // Initialise the param_error
-    param_err->param_path = USP_STRDUP(path);
+    param_err->param_path = USP_ARENA_STRDUP(path);
     param_err->err_code = err_code;
-    param_err->err_msg = USP_STRDUP(err_msg);
+    param_err->err_msg = USP_ARENA_STRDUP(err_msg);
 
     return param_err;
 }
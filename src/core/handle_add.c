@@ -392,12 +392,20 @@ int CreateObject(char *obj_path, Usp__AddResp *add_resp, Usp__Add__CreateObject
         }
     }
 
+    // Exit if the vendor was unable to apply the parameters set in this object by its group set callback
+    // NOTE: This must be done before reading the unique keys, as they may be vendor parameters applied by the group set callback
+    param_name = NULL;
+    err = DM_TRANS_ApplyGroupSets();
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
     // If the code gets here, then all overriden parameters for this object have been successfully set
     // So now we need to get the values of all parameters used as unique keys
 
     // Exit if unable to retrieve the parameters used as unique keys for this object
     full_path[len] = '\0';
-    param_name = NULL;
     err = DATA_MODEL_GetUniqueKeyParams(full_path, &unique_key_params, &combined_role);
     if (err != USP_ERR_OK)
     {
@@ -450,24 +458,24 @@ Usp__Msg *CreateAddResp(char *msg_id)
     Usp__AddResp *add_resp;
 
     // Allocate and initialise memory to store the parts of the USP message
-    resp = USP_MALLOC(sizeof(Usp__Msg));
+    resp = USP_ARENA_MALLOC(sizeof(Usp__Msg));
     usp__msg__init(resp);
 
-    header = USP_MALLOC(sizeof(Usp__Header));
+    header = USP_ARENA_MALLOC(sizeof(Usp__Header));
     usp__header__init(header);
 
-    body = USP_MALLOC(sizeof(Usp__Body));
+    body = USP_ARENA_MALLOC(sizeof(Usp__Body));
     usp__body__init(body);
 
-    response = USP_MALLOC(sizeof(Usp__Response));
+    response = USP_ARENA_MALLOC(sizeof(Usp__Response));
     usp__response__init(response);
 
-    add_resp = USP_MALLOC(sizeof(Usp__AddResp));
+    add_resp = USP_ARENA_MALLOC(sizeof(Usp__AddResp));
     usp__add_resp__init(add_resp);
 
     // Connect the structures together
     resp->header = header;
-    header->msg_id = USP_STRDUP(msg_id);
+    header->msg_id = USP_ARENA_STRDUP(msg_id);
     header->msg_type = USP__HEADER__MSG_TYPE__ADD_RESP;
 
     resp->body = body;
@@ -507,30 +515,30 @@ AddResp_OperFailure(Usp__AddResp *add_resp, char *path, char *param_name, int er
     int new_num;    // new number of entries in the created object result array
     
     // Allocate memory to store the created object result
-    created_obj_res = USP_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult));
+    created_obj_res = USP_ARENA_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult));
     usp__add_resp__created_object_result__init(created_obj_res);
 
-    oper_status = USP_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus));
+    oper_status = USP_ARENA_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus));
     usp__add_resp__created_object_result__operation_status__init(oper_status);    
 
-    oper_failure = USP_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus__OperationFailure));
+    oper_failure = USP_ARENA_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus__OperationFailure));
     usp__add_resp__created_object_result__operation_status__operation_failure__init(oper_failure);
 
     // Increase the size of the vector
     new_num = add_resp->n_created_obj_results + 1;
-    add_resp->created_obj_results = USP_REALLOC(add_resp->created_obj_results, new_num*sizeof(void *));
+    add_resp->created_obj_results = USP_ARENA_REALLOC(add_resp->created_obj_results, new_num*sizeof(void *));
     add_resp->n_created_obj_results = new_num;
     add_resp->created_obj_results[new_num-1] = created_obj_res;
 
     // Connect all objects together, and fill in their members
-    created_obj_res->requested_path = USP_STRDUP(path);
+    created_obj_res->requested_path = USP_ARENA_STRDUP(path);
     created_obj_res->oper_status = oper_status;
 
     oper_status->oper_status_case = USP__ADD_RESP__CREATED_OBJECT_RESULT__OPERATION_STATUS__OPER_STATUS_OPER_FAILURE;
     oper_status->oper_failure = oper_failure;
 
     oper_failure->err_code = err_code;
-    oper_failure->err_msg = USP_STRDUP(err_msg);
+    oper_failure->err_msg = USP_ARENA_STRDUP(err_msg);
 
     // In the protobuf schema, the OperFailure object does not store the param_name of the parameter which caused the failure
     // But we might need this later, if the OperFailure object is converted into a param_errs object of an Error message
@@ -670,23 +678,23 @@ AddResp_OperSuccess(Usp__AddResp *add_resp, char *req_path, char *path)
     int new_num;    // new number of entries in the created object result array
     
     // Allocate memory to store the created object result
-    created_obj_res = USP_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult));
+    created_obj_res = USP_ARENA_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult));
     usp__add_resp__created_object_result__init(created_obj_res);
 
-    oper_status = USP_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus));
+    oper_status = USP_ARENA_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus));
     usp__add_resp__created_object_result__operation_status__init(oper_status);    
     
-    oper_success = USP_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus__OperationSuccess));
+    oper_success = USP_ARENA_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus__OperationSuccess));
     usp__add_resp__created_object_result__operation_status__operation_success__init(oper_success);
 
     // Increase the size of the vector
     new_num = add_resp->n_created_obj_results + 1;
-    add_resp->created_obj_results = USP_REALLOC(add_resp->created_obj_results, new_num*sizeof(void *));
+    add_resp->created_obj_results = USP_ARENA_REALLOC(add_resp->created_obj_results, new_num*sizeof(void *));
     add_resp->n_created_obj_results = new_num;
     add_resp->created_obj_results[new_num-1] = created_obj_res;
 
     // Connect all objects together, and fill in their members
-    created_obj_res->requested_path = USP_STRDUP(req_path);
+    created_obj_res->requested_path = USP_ARENA_STRDUP(req_path);
     created_obj_res->oper_status = oper_status;
 
     oper_status->oper_status_case = USP__ADD_RESP__CREATED_OBJECT_RESULT__OPERATION_STATUS__OPER_STATUS_OPER_SUCCESS;
@@ -695,7 +703,7 @@ AddResp_OperSuccess(Usp__AddResp *add_resp, char *req_path, char *path)
     oper_success->n_param_errs = 0;
 
 
-    oper_success->instantiated_path = USP_STRDUP(path);
+    oper_success->instantiated_path = USP_ARENA_STRDUP(path);
     oper_success->param_errs = NULL;             // Start from an empty list
     oper_success->n_param_errs = 0;
 
@@ -756,19 +764,19 @@ AddResp_OperSuccess_ParamErr(Usp__AddResp__CreatedObjectResult__OperationStatus_
     int new_num;    // new number of entries in the param_err array
 
     // Allocate memory to store the param_err entry
-    param_err_entry = USP_MALLOC(sizeof(Usp__AddResp__ParameterError));
+    param_err_entry = USP_ARENA_MALLOC(sizeof(Usp__AddResp__ParameterError));
     usp__add_resp__parameter_error__init(param_err_entry);
 
     // Increase the size of the vector
     new_num = oper_success->n_param_errs + 1;
-    oper_success->param_errs = USP_REALLOC(oper_success->param_errs, new_num*sizeof(void *));
+    oper_success->param_errs = USP_ARENA_REALLOC(oper_success->param_errs, new_num*sizeof(void *));
     oper_success->n_param_errs = new_num;
     oper_success->param_errs[new_num-1] = param_err_entry;
 
     // Initialise the param_err_entry
-    param_err_entry->param = USP_STRDUP(path);
+    param_err_entry->param = USP_ARENA_STRDUP(path);
     param_err_entry->err_code = err_code;
-    param_err_entry->err_msg = USP_STRDUP(err_msg);
+    param_err_entry->err_msg = USP_ARENA_STRDUP(err_msg);
 
     return param_err_entry;
 }
@@ -797,13 +805,13 @@ void AddOperSuccess_UniqueKeys(Usp__AddResp__CreatedObjectResult__OperationStatu
 
     // Allocate the unique key map vector
     oper_success->n_unique_keys = kvv->num_entries;
-    oper_success->unique_keys = USP_MALLOC(kvv->num_entries*sizeof(void *));
+    oper_success->unique_keys = USP_ARENA_MALLOC(kvv->num_entries*sizeof(void *));
 
     // Add all unique keys to the unique key map
     for (i=0; i < kvv->num_entries; i++)
     {
         // Allocate memory to store the map entry
-        entry = USP_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus__OperationSuccess__UniqueKeysEntry));
+        entry = USP_ARENA_MALLOC(sizeof(Usp__AddResp__CreatedObjectResult__OperationStatus__OperationSuccess__UniqueKeysEntry));
         usp__add_resp__created_object_result__operation_status__operation_success__unique_keys_entry__init(entry);
         oper_success->unique_keys[i] = entry;
         
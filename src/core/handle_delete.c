@@ -295,24 +295,24 @@ Usp__Msg *CreateDeleteResp(char *msg_id)
     Usp__DeleteResp *del_resp;
 
     // Allocate and initialise memory to store the parts of the USP message
-    resp = USP_MALLOC(sizeof(Usp__Msg));
+    resp = USP_ARENA_MALLOC(sizeof(Usp__Msg));
     usp__msg__init(resp);
 
-    header = USP_MALLOC(sizeof(Usp__Header));
+    header = USP_ARENA_MALLOC(sizeof(Usp__Header));
     usp__header__init(header);
 
-    body = USP_MALLOC(sizeof(Usp__Body));
+    body = USP_ARENA_MALLOC(sizeof(Usp__Body));
     usp__body__init(body);
 
-    response = USP_MALLOC(sizeof(Usp__Response));
+    response = USP_ARENA_MALLOC(sizeof(Usp__Response));
     usp__response__init(response);
 
-    del_resp = USP_MALLOC(sizeof(Usp__DeleteResp));
+    del_resp = USP_ARENA_MALLOC(sizeof(Usp__DeleteResp));
     usp__delete_resp__init(del_resp);
 
     // Connect the structures together
     resp->header = header;
-    header->msg_id = USP_STRDUP(msg_id);
+    header->msg_id = USP_ARENA_STRDUP(msg_id);
     header->msg_type = USP__HEADER__MSG_TYPE__DELETE_RESP;
 
     resp->body = body;
@@ -351,32 +351,32 @@ AddDeleteResp_OperFailure(Usp__DeleteResp *del_resp, char *path, uint32_t err_co
     int new_num;    // new number of entries in the created object result array
     
     // Allocate memory to store the created object result
-    deleted_obj_res = USP_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult));
+    deleted_obj_res = USP_ARENA_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult));
     usp__delete_resp__deleted_object_result__init(deleted_obj_res);
 
     // Allocate memory to store the created oper status object
-    oper_status = USP_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult__OperationStatus));
+    oper_status = USP_ARENA_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult__OperationStatus));
     usp__delete_resp__deleted_object_result__operation_status__init(oper_status);
 
     // Allocate memory to store the created oper failure object
-    oper_failure = USP_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult__OperationStatus__OperationFailure));
+    oper_failure = USP_ARENA_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult__OperationStatus__OperationFailure));
     usp__delete_resp__deleted_object_result__operation_status__operation_failure__init(oper_failure);
 
     // Increase the size of the vector
     new_num = del_resp->n_deleted_obj_results + 1;
-    del_resp->deleted_obj_results = USP_REALLOC(del_resp->deleted_obj_results, new_num*sizeof(void *));
+    del_resp->deleted_obj_results = USP_ARENA_REALLOC(del_resp->deleted_obj_results, new_num*sizeof(void *));
     del_resp->n_deleted_obj_results = new_num;
     del_resp->deleted_obj_results[new_num-1] = deleted_obj_res;
 
     // Fill in its members
-    deleted_obj_res->requested_path = USP_STRDUP(path);
+    deleted_obj_res->requested_path = USP_ARENA_STRDUP(path);
     deleted_obj_res->oper_status = oper_status;
 
     oper_status->oper_status_case = USP__DELETE_RESP__DELETED_OBJECT_RESULT__OPERATION_STATUS__OPER_STATUS_OPER_FAILURE;
     oper_status->oper_failure = oper_failure;
     
     oper_failure->err_code = err_code;
-    oper_failure->err_msg = USP_STRDUP(err_msg);
+    oper_failure->err_msg = USP_ARENA_STRDUP(err_msg);
 
     return oper_failure;
 }
@@ -476,25 +476,25 @@ AddDeleteResp_OperSuccess(Usp__DeleteResp *del_resp, char *path)
     int new_num;    // new number of entries in the created object result array
     
     // Allocate memory to store the created object result
-    deleted_obj_res = USP_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult));
+    deleted_obj_res = USP_ARENA_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult));
     usp__delete_resp__deleted_object_result__init(deleted_obj_res);
 
     // Allocate memory to store the created oper status object
-    oper_status = USP_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult__OperationStatus));
+    oper_status = USP_ARENA_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult__OperationStatus));
     usp__delete_resp__deleted_object_result__operation_status__init(oper_status);
 
     // Allocate memory to store the created oper success object
-    oper_success = USP_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult__OperationStatus__OperationSuccess));
+    oper_success = USP_ARENA_MALLOC(sizeof(Usp__DeleteResp__DeletedObjectResult__OperationStatus__OperationSuccess));
     usp__delete_resp__deleted_object_result__operation_status__operation_success__init(oper_success);
 
     // Increase the size of the vector
     new_num = del_resp->n_deleted_obj_results + 1;
-    del_resp->deleted_obj_results = USP_REALLOC(del_resp->deleted_obj_results, new_num*sizeof(void *));
+    del_resp->deleted_obj_results = USP_ARENA_REALLOC(del_resp->deleted_obj_results, new_num*sizeof(void *));
     del_resp->n_deleted_obj_results = new_num;
     del_resp->deleted_obj_results[new_num-1] = deleted_obj_res;
 
     // Fill in its members
-    deleted_obj_res->requested_path = USP_STRDUP(path);
+    deleted_obj_res->requested_path = USP_ARENA_STRDUP(path);
     deleted_obj_res->oper_status = oper_status;
 
     oper_status->oper_status_case = USP__DELETE_RESP__DELETED_OBJECT_RESULT__OPERATION_STATUS__OPER_STATUS_OPER_SUCCESS;
@@ -527,7 +527,7 @@ void AddOperSuccess_AffectedPath(Usp__DeleteResp__DeletedObjectResult__Operation
 
     // Increase the size of the vector
     new_num = oper_success->n_affected_paths + 1;
-    oper_success->affected_paths = USP_REALLOC(oper_success->affected_paths, new_num*sizeof(void *));
+    oper_success->affected_paths = USP_ARENA_REALLOC(oper_success->affected_paths, new_num*sizeof(void *));
     oper_success->n_affected_paths = new_num;
 
     // Add the path to the vector
@@ -555,12 +555,12 @@ void AddOperSuccess_UnaffectedPathError(Usp__DeleteResp__DeletedObjectResult__Op
     Usp__DeleteResp__UnaffectedPathError *unaffected_path_err;
 
     // Allocate memory to store the unaffected path error
-    unaffected_path_err = USP_MALLOC(sizeof(Usp__DeleteResp__UnaffectedPathError));
+    unaffected_path_err = USP_ARENA_MALLOC(sizeof(Usp__DeleteResp__UnaffectedPathError));
     usp__delete_resp__unaffected_path_error__init(unaffected_path_err);
 
     // Increase the size of the vector
     new_num = oper_success->n_unaffected_path_errs + 1;
-    oper_success->unaffected_path_errs = USP_REALLOC(oper_success->unaffected_path_errs, new_num*sizeof(void *));
+    oper_success->unaffected_path_errs = USP_ARENA_REALLOC(oper_success->unaffected_path_errs, new_num*sizeof(void *));
     oper_success->n_unaffected_path_errs = new_num;
     oper_success->unaffected_path_errs[new_num-1] = unaffected_path_err;
 
@@ -568,7 +568,7 @@ void AddOperSuccess_UnaffectedPathError(Usp__DeleteResp__DeletedObjectResult__Op
     unaffected_path_err = oper_success->unaffected_path_errs[new_num-1];
     unaffected_path_err->unaffected_path = TEXT_UTILS_StrDupWithTrailingDot(path);
     unaffected_path_err->err_code = err_code;
-    unaffected_path_err->err_msg = USP_STRDUP(err_msg);
+    unaffected_path_err->err_msg = USP_ARENA_STRDUP(err_msg);
 }
 
 /*********************************************************************//**
@@ -200,24 +200,24 @@ Usp__Msg *CreateGetInstancesResp(char *msg_id)
     Usp__GetInstancesResp *get_inst_resp;
 
     // Allocate memory to store the USP message
-    resp = USP_MALLOC(sizeof(Usp__Msg));
+    resp = USP_ARENA_MALLOC(sizeof(Usp__Msg));
     usp__msg__init(resp);
 
-    header = USP_MALLOC(sizeof(Usp__Header));
+    header = USP_ARENA_MALLOC(sizeof(Usp__Header));
     usp__header__init(header);
 
-    body = USP_MALLOC(sizeof(Usp__Body));
+    body = USP_ARENA_MALLOC(sizeof(Usp__Body));
     usp__body__init(body);
 
-    response = USP_MALLOC(sizeof(Usp__Response));
+    response = USP_ARENA_MALLOC(sizeof(Usp__Response));
     usp__response__init(response);
 
-    get_inst_resp = USP_MALLOC(sizeof(Usp__GetInstancesResp));
+    get_inst_resp = USP_ARENA_MALLOC(sizeof(Usp__GetInstancesResp));
     usp__get_instances_resp__init(get_inst_resp);
 
     // Connect the structures together
     resp->header = header;
-    header->msg_id = USP_STRDUP(msg_id);
+    header->msg_id = USP_ARENA_STRDUP(msg_id);
     header->msg_type = USP__HEADER__MSG_TYPE__GET_INSTANCES_RESP;
 
     resp->body = body;
@@ -252,19 +252,19 @@ AddGetInstances_RequestedPathResult(Usp__GetInstancesResp *gi_resp, char *reques
     int new_num;    // new number of entries in the requested path result array
 
     // Allocate memory to store the RequestedPathResult object
-    req_path_res = USP_MALLOC(sizeof(Usp__GetInstancesResp__RequestedPathResult));
+    req_path_res = USP_ARENA_MALLOC(sizeof(Usp__GetInstancesResp__RequestedPathResult));
     usp__get_instances_resp__requested_path_result__init(req_path_res);
 
     // Increase the size of the vector
     new_num = gi_resp->n_req_path_results + 1;
-    gi_resp->req_path_results = USP_REALLOC(gi_resp->req_path_results, new_num*sizeof(void *));
+    gi_resp->req_path_results = USP_ARENA_REALLOC(gi_resp->req_path_results, new_num*sizeof(void *));
     gi_resp->n_req_path_results = new_num;
     gi_resp->req_path_results[new_num-1] = req_path_res;
 
     // Fill in the RequestedPathResult object
-    req_path_res->requested_path = USP_STRDUP(requested_path);
+    req_path_res->requested_path = USP_ARENA_STRDUP(requested_path);
     req_path_res->err_code = err;
-    req_path_res->err_msg = USP_STRDUP(err_msg);
+    req_path_res->err_msg = USP_ARENA_STRDUP(err_msg);
 
     return req_path_res;
 }
@@ -292,22 +292,22 @@ void AddRequestedPathResult_CurrInstance(Usp__GetInstancesResp__RequestedPathRes
     int len;
 
     // Allocate memory to store the CurrInstance object
-    cur_inst = USP_MALLOC(sizeof(Usp__GetInstancesResp__CurrInstance));
+    cur_inst = USP_ARENA_MALLOC(sizeof(Usp__GetInstancesResp__CurrInstance));
     usp__get_instances_resp__curr_instance__init(cur_inst);
 
     // Increase the size of the vector
     new_num = req_path_res->n_curr_insts + 1;
-    req_path_res->curr_insts = USP_REALLOC(req_path_res->curr_insts, new_num*sizeof(void *));
+    req_path_res->curr_insts = USP_ARENA_REALLOC(req_path_res->curr_insts, new_num*sizeof(void *));
     req_path_res->n_curr_insts = new_num;
     req_path_res->curr_insts[new_num-1] = cur_inst;
 
     // Fill in the CurrInst object
     cur_inst->n_unique_keys = unique_keys->num_entries;
-    cur_inst->unique_keys = USP_MALLOC(unique_keys->num_entries*sizeof(void *));
+    cur_inst->unique_keys = USP_ARENA_MALLOC(unique_keys->num_entries*sizeof(void *));
 
     // Copy the instantiated path, adding a trailing '.' to the end of it
     len = strlen(path);
-    cur_inst->instantiated_obj_path = USP_MALLOC(len+2);   // Plus 2 to include trailing '.' and NULL terminator
+    cur_inst->instantiated_obj_path = USP_ARENA_MALLOC(len+2);   // Plus 2 to include trailing '.' and NULL terminator
     memcpy(cur_inst->instantiated_obj_path, path, len);
     cur_inst->instantiated_obj_path[len] = '.';
     cur_inst->instantiated_obj_path[len+1] = '\0';
@@ -316,13 +316,13 @@ void AddRequestedPathResult_CurrInstance(Usp__GetInstancesResp__RequestedPathRes
     for (i=0; i < unique_keys->num_entries; i++)
     {
         // Allocate memory to store this unique key object
-        unique_key = USP_MALLOC(sizeof(Usp__GetInstancesResp__CurrInstance__UniqueKeysEntry));
+        unique_key = USP_ARENA_MALLOC(sizeof(Usp__GetInstancesResp__CurrInstance__UniqueKeysEntry));
         usp__get_instances_resp__curr_instance__unique_keys_entry__init(unique_key);
 
         // Fill in this unique key
         kv = &unique_keys->vector[i];
-        unique_key->key = USP_STRDUP(kv->key);
-        unique_key->value = USP_STRDUP(kv->value);
+        unique_key->key = USP_ARENA_STRDUP(kv->key);
+        unique_key->value = USP_ARENA_STRDUP(kv->value);
 
         // Attach this unique key in the unique_keys array (of the CurrInstance object)
         cur_inst->unique_keys[i] = unique_key;
@@ -340,24 +340,24 @@ Usp__Msg *CreateGetSupportedDMResp(char *msg_id)
     Usp__GetSupportedDMResp *get_sup_resp;
 
     // Allocate memory to store the USP message
-    resp = USP_MALLOC(sizeof(Usp__Msg));
+    resp = USP_ARENA_MALLOC(sizeof(Usp__Msg));
     usp__msg__init(resp);
 
-    header = USP_MALLOC(sizeof(Usp__Header));
+    header = USP_ARENA_MALLOC(sizeof(Usp__Header));
     usp__header__init(header);
 
-    body = USP_MALLOC(sizeof(Usp__Body));
+    body = USP_ARENA_MALLOC(sizeof(Usp__Body));
     usp__body__init(body);
 
-    response = USP_MALLOC(sizeof(Usp__Response));
+    response = USP_ARENA_MALLOC(sizeof(Usp__Response));
     usp__response__init(response);
 
-    get_sup_resp = USP_MALLOC(sizeof(Usp__GetSupportedDMResp));
+    get_sup_resp = USP_ARENA_MALLOC(sizeof(Usp__GetSupportedDMResp));
     usp__get_supported_dmresp__init(get_sup_resp);
 
     // Connect the structures together
     resp->header = header;
-    header->msg_id = USP_STRDUP(msg_id);
+    header->msg_id = USP_ARENA_STRDUP(msg_id);
     header->msg_type = USP__HEADER__MSG_TYPE__GET_SUPPORTED_DM_RESP;
 
     resp->body = body;
@@ -392,20 +392,20 @@ AddGetSupportedDM_ReqObjResult(Usp__GetSupportedDMResp *gs_resp, char *requested
     int new_num;    // new number of entries in the requested obj result array
 
     // Allocate memory to store the RequestedObjResult object
-    ror = USP_MALLOC(sizeof(Usp__GetSupportedDMResp__RequestedObjectResult));
+    ror = USP_ARENA_MALLOC(sizeof(Usp__GetSupportedDMResp__RequestedObjectResult));
     usp__get_supported_dmresp__requested_object_result__init(ror);
 
     // Increase the size of the vector
     new_num = gs_resp->n_req_obj_results + 1;
-    gs_resp->req_obj_results = USP_REALLOC(gs_resp->req_obj_results, new_num*sizeof(void *));
+    gs_resp->req_obj_results = USP_ARENA_REALLOC(gs_resp->req_obj_results, new_num*sizeof(void *));
     gs_resp->n_req_obj_results = new_num;
     gs_resp->req_obj_results[new_num-1] = ror;
 
     // Fill in the RequestedObjResult object
-    ror->req_obj_path = USP_STRDUP(requested_path);
+    ror->req_obj_path = USP_ARENA_STRDUP(requested_path);
     ror->err_code = err;
-    ror->err_msg = USP_STRDUP(err_msg);
-    ror->data_model_inst_uri = USP_STRDUP(bbf_uri);
+    ror->err_msg = USP_ARENA_STRDUP(err_msg);
+    ror->data_model_inst_uri = USP_ARENA_STRDUP(bbf_uri);
 
     return ror;
 }
@@ -436,18 +436,18 @@ AddReqObjResult_SupportedObjResult(Usp__GetSupportedDMResp__RequestedObjectResul
     #define CAN_DELETE 0x02
 
     // Allocate memory to store the SupportedObjResult object
-    sor = USP_MALLOC(sizeof(Usp__GetSupportedDMResp__SupportedObjectResult));
+    sor = USP_ARENA_MALLOC(sizeof(Usp__GetSupportedDMResp__SupportedObjectResult));
     usp__get_supported_dmresp__supported_object_result__init(sor);
 
     // Increase the size of the vector
     new_num = ror->n_supported_objs + 1;
-    ror->supported_objs = USP_REALLOC(ror->supported_objs, new_num*sizeof(void *));
+    ror->supported_objs = USP_ARENA_REALLOC(ror->supported_objs, new_num*sizeof(void *));
     ror->n_supported_objs = new_num;
     ror->supported_objs[new_num-1] = sor;
 
     // Fill in the SupportedObjResult object. Path must include a trailing '.'
     len = strlen(node->path);
-    sor->supported_obj_path = USP_MALLOC(len+2);  // Plus 2 to include trailing '.' and NULL terminator
+    sor->supported_obj_path = USP_ARENA_MALLOC(len+2);  // Plus 2 to include trailing '.' and NULL terminator
     memcpy(sor->supported_obj_path, node->path, len);
     sor->supported_obj_path[len] = '.';
     sor->supported_obj_path[len+1] = '\0';
@@ -500,17 +500,17 @@ void AddSupportedObjResult_SupportedCommandResult(Usp__GetSupportedDMResp__Suppo
     int i;
 
     // Allocate memory to store the SupportedCommandResult object
-    cr = USP_MALLOC(sizeof(Usp__GetSupportedDMResp__SupportedCommandResult));
+    cr = USP_ARENA_MALLOC(sizeof(Usp__GetSupportedDMResp__SupportedCommandResult));
     usp__get_supported_dmresp__supported_command_result__init(cr);
 
     // Increase the size of the vector
     new_num = sor->n_supported_commands + 1;
-    sor->supported_commands = USP_REALLOC(sor->supported_commands, new_num*sizeof(void *));
+    sor->supported_commands = USP_ARENA_REALLOC(sor->supported_commands, new_num*sizeof(void *));
     sor->n_supported_commands = new_num;
     sor->supported_commands[new_num-1] = cr;
 
     // Fill in the SupportedCommandResult object
-    cr->command_name = USP_STRDUP(node->name);
+    cr->command_name = USP_ARENA_STRDUP(node->name);
 
     // Copy the command's input arguments into the SupportedCommandResult
     info = &node->registered.oper_info;
@@ -518,10 +518,10 @@ void AddSupportedObjResult_SupportedCommandResult(Usp__GetSupportedDMResp__Suppo
     if (sv->num_entries > 0)
     {
         cr->n_input_arg_names = sv->num_entries;
-        cr->input_arg_names = USP_MALLOC(sv->num_entries*sizeof(void *));
+        cr->input_arg_names = USP_ARENA_MALLOC(sv->num_entries*sizeof(void *));
         for (i=0; i < sv->num_entries; i++)
         {
-            cr->input_arg_names[i] = USP_STRDUP(sv->vector[i]);
+            cr->input_arg_names[i] = USP_ARENA_STRDUP(sv->vector[i]);
         }
     }
 
@@ -530,10 +530,10 @@ void AddSupportedObjResult_SupportedCommandResult(Usp__GetSupportedDMResp__Suppo
     if (sv->num_entries > 0)
     {
         cr->n_output_arg_names = sv->num_entries;
-        cr->output_arg_names = USP_MALLOC(sv->num_entries*sizeof(void *));
+        cr->output_arg_names = USP_ARENA_MALLOC(sv->num_entries*sizeof(void *));
         for (i=0; i < sv->num_entries; i++)
         {
-            cr->output_arg_names[i] = USP_STRDUP(sv->vector[i]);
+            cr->output_arg_names[i] = USP_ARENA_STRDUP(sv->vector[i]);
         }
     }
 }
@@ -559,17 +559,17 @@ void AddSupportedObjResult_SupportedEventResult(Usp__GetSupportedDMResp__Support
     int i;
 
     // Allocate memory to store the SupportedEventResult object
-    er = USP_MALLOC(sizeof(Usp__GetSupportedDMResp__SupportedEventResult));
+    er = USP_ARENA_MALLOC(sizeof(Usp__GetSupportedDMResp__SupportedEventResult));
     usp__get_supported_dmresp__supported_event_result__init(er);
 
     // Increase the size of the vector
     new_num = sor->n_supported_events + 1;
-    sor->supported_events = USP_REALLOC(sor->supported_events, new_num*sizeof(void *));
+    sor->supported_events = USP_ARENA_REALLOC(sor->supported_events, new_num*sizeof(void *));
     sor->n_supported_events = new_num;
     sor->supported_events[new_num-1] = er;
 
     // Fill in the SupportedCommandResult object
-    er->event_name = USP_STRDUP(node->name);
+    er->event_name = USP_ARENA_STRDUP(node->name);
 
     // Copy the event's arguments into the SupportedEventResult
     info = &node->registered.event_info;
@@ -577,10 +577,10 @@ void AddSupportedObjResult_SupportedEventResult(Usp__GetSupportedDMResp__Support
     if (sv->num_entries > 0)
     {
         er->n_arg_names = sv->num_entries;
-        er->arg_names = USP_MALLOC(sv->num_entries*sizeof(void *));
+        er->arg_names = USP_ARENA_MALLOC(sv->num_entries*sizeof(void *));
         for (i=0; i < sv->num_entries; i++)
         {
-            er->arg_names[i] = USP_STRDUP(sv->vector[i]);
+            er->arg_names[i] = USP_ARENA_STRDUP(sv->vector[i]);
         }
     }
 }
@@ -657,17 +657,17 @@ void AddSupportedObjResult_SupportedParamResult(Usp__GetSupportedDMResp__Support
     }
 
     // Allocate memory to store the SupportedParamResult object
-    pr = USP_MALLOC(sizeof(Usp__GetSupportedDMResp__SupportedParamResult));
+    pr = USP_ARENA_MALLOC(sizeof(Usp__GetSupportedDMResp__SupportedParamResult));
     usp__get_supported_dmresp__supported_param_result__init(pr);
 
     // Increase the size of the vector
     new_num = sor->n_supported_params + 1;
-    sor->supported_params = USP_REALLOC(sor->supported_params, new_num*sizeof(void *));
+    sor->supported_params = USP_ARENA_REALLOC(sor->supported_params, new_num*sizeof(void *));
     sor->n_supported_params = new_num;
     sor->supported_params[new_num-1] = pr;
 
     // Fill in the SupportedCommandResult object
-    pr->param_name = USP_STRDUP(node->name);
+    pr->param_name = USP_ARENA_STRDUP(node->name);
     pr->access = CalcDMSchemaParamAccess(is_read_allowed, is_write_allowed);
 }
 
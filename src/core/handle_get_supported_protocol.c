@@ -116,24 +116,24 @@ Usp__Msg *CreateGetSupportedProtocolResp(char *msg_id)
     Usp__GetSupportedProtocolResp *get_sup_resp;
 
     // Allocate memory to store the USP message
-    resp = USP_MALLOC(sizeof(Usp__Msg));
+    resp = USP_ARENA_MALLOC(sizeof(Usp__Msg));
     usp__msg__init(resp);
 
-    header = USP_MALLOC(sizeof(Usp__Header));
+    header = USP_ARENA_MALLOC(sizeof(Usp__Header));
     usp__header__init(header);
 
-    body = USP_MALLOC(sizeof(Usp__Body));
+    body = USP_ARENA_MALLOC(sizeof(Usp__Body));
     usp__body__init(body);
 
-    response = USP_MALLOC(sizeof(Usp__Response));
+    response = USP_ARENA_MALLOC(sizeof(Usp__Response));
     usp__response__init(response);
 
-    get_sup_resp = USP_MALLOC(sizeof(Usp__GetSupportedProtocolResp));
+    get_sup_resp = USP_ARENA_MALLOC(sizeof(Usp__GetSupportedProtocolResp));
     usp__get_supported_protocol_resp__init(get_sup_resp);
 
     // Connect the structures together
     resp->header = header;
-    header->msg_id = USP_STRDUP(msg_id);
+    header->msg_id = USP_ARENA_STRDUP(msg_id);
     header->msg_type = USP__HEADER__MSG_TYPE__GET_SUPPORTED_PROTO_RESP;
 
     resp->body = body;
@@ -142,7 +142,7 @@ Usp__Msg *CreateGetSupportedProtocolResp(char *msg_id)
     response->resp_type_case = USP__RESPONSE__RESP_TYPE_GET_SUPPORTED_PROTOCOL_RESP;
 
     response->get_supported_protocol_resp = get_sup_resp;
-    get_sup_resp->agent_supported_protocol_versions = USP_STRDUP("1.0");
+    get_sup_resp->agent_supported_protocol_versions = USP_ARENA_STRDUP("1.0");
 
     return resp;
 }    
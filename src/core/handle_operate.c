@@ -229,24 +229,24 @@ Usp__Msg *CreateOperResp(char *msg_id)
     Usp__OperateResp *oper_resp;
 
     // Allocate and initialise memory to store the parts of the USP message
-    resp = USP_MALLOC(sizeof(Usp__Msg));
+    resp = USP_ARENA_MALLOC(sizeof(Usp__Msg));
     usp__msg__init(resp);
 
-    header = USP_MALLOC(sizeof(Usp__Header));
+    header = USP_ARENA_MALLOC(sizeof(Usp__Header));
     usp__header__init(header);
 
-    body = USP_MALLOC(sizeof(Usp__Body));
+    body = USP_ARENA_MALLOC(sizeof(Usp__Body));
     usp__body__init(body);
 
-    response = USP_MALLOC(sizeof(Usp__Response));
+    response = USP_ARENA_MALLOC(sizeof(Usp__Response));
     usp__response__init(response);
 
-    oper_resp = USP_MALLOC(sizeof(Usp__OperateResp));
+    oper_resp = USP_ARENA_MALLOC(sizeof(Usp__OperateResp));
     usp__operate_resp__init(oper_resp);
 
     // Connect the structures together
     resp->header = header;
-    header->msg_id = USP_STRDUP(msg_id);
+    header->msg_id = USP_ARENA_STRDUP(msg_id);
     header->msg_type = USP__HEADER__MSG_TYPE__OPERATE_RESP;
 
     resp->body = body;
@@ -282,26 +282,26 @@ void AddOperRes_CmdFailure(Usp__OperateResp *oper_resp, char *path, int err_code
     int new_num;    // new number of entries in the operation_result array
 
     // Allocate memory to store the structures
-    oper_res = USP_MALLOC(sizeof(Usp__OperateResp__OperationResult));
+    oper_res = USP_ARENA_MALLOC(sizeof(Usp__OperateResp__OperationResult));
     usp__operate_resp__operation_result__init(oper_res);
 
-    cmd_failure = USP_MALLOC(sizeof(Usp__OperateResp__OperationResult__CommandFailure));
+    cmd_failure = USP_ARENA_MALLOC(sizeof(Usp__OperateResp__OperationResult__CommandFailure));
     usp__operate_resp__operation_result__command_failure__init(cmd_failure);
 
     // Increase the size of the vector
     new_num = oper_resp->n_operation_results + 1;
-    oper_resp->operation_results = USP_REALLOC(oper_resp->operation_results, new_num*sizeof(void *));
+    oper_resp->operation_results = USP_ARENA_REALLOC(oper_resp->operation_results, new_num*sizeof(void *));
     oper_resp->n_operation_results = new_num;
     oper_resp->operation_results[new_num-1] = oper_res;
 
     // Initialise the operation result
-    oper_res->executed_command = USP_STRDUP(path);
+    oper_res->executed_command = USP_ARENA_STRDUP(path);
     oper_res->operation_resp_case = USP__OPERATE_RESP__OPERATION_RESULT__OPERATION_RESP_CMD_FAILURE;
     oper_res->cmd_failure = cmd_failure;
 
     // Initialise the command failure
     cmd_failure->err_code = err_code;
-    cmd_failure->err_msg = USP_STRDUP(err_msg);
+    cmd_failure->err_msg = USP_ARENA_STRDUP(err_msg);
 }
 
 /*********************************************************************//**
@@ -325,20 +325,20 @@ void AddOperRes_ReqObjPath(Usp__OperateResp *oper_resp, char *path, int instance
     char buf[MAX_DM_PATH];
 
     // Allocate memory to store the structures
-    oper_res = USP_MALLOC(sizeof(Usp__OperateResp__OperationResult));
+    oper_res = USP_ARENA_MALLOC(sizeof(Usp__OperateResp__OperationResult));
     usp__operate_resp__operation_result__init(oper_res);
 
     // Increase the size of the vector
     new_num = oper_resp->n_operation_results + 1;
-    oper_resp->operation_results = USP_REALLOC(oper_resp->operation_results, new_num*sizeof(void *));
+    oper_resp->operation_results = USP_ARENA_REALLOC(oper_resp->operation_results, new_num*sizeof(void *));
     oper_resp->n_operation_results = new_num;
     oper_resp->operation_results[new_num-1] = oper_res;
 
     // Initialise the operation result
-    oper_res->executed_command = USP_STRDUP(path);
+    oper_res->executed_command = USP_ARENA_STRDUP(path);
     oper_res->operation_resp_case = USP__OPERATE_RESP__OPERATION_RESULT__OPERATION_RESP_REQ_OBJ_PATH;
     USP_SNPRINTF(buf, sizeof(buf), "Device.LocalAgent.Request.%d", instance);
-    oper_res->req_obj_path = USP_STRDUP(buf);
+    oper_res->req_obj_path = USP_ARENA_STRDUP(buf);
 }
 
 /*********************************************************************//**
@@ -365,40 +365,40 @@ void AddOperRes_ReqOutputArgs(Usp__OperateResp *oper_resp, char *path, kv_vector
     kv_pair_t *arg;
 
     // Allocate memory to store the structures
-    oper_res = USP_MALLOC(sizeof(Usp__OperateResp__OperationResult));
+    oper_res = USP_ARENA_MALLOC(sizeof(Usp__OperateResp__OperationResult));
     usp__operate_resp__operation_result__init(oper_res);
 
-    output_args = USP_MALLOC(sizeof(Usp__OperateResp__OperationResult__OutputArgs));
+    output_args = USP_ARENA_MALLOC(sizeof(Usp__OperateResp__OperationResult__OutputArgs));
     usp__operate_resp__operation_result__output_args__init(output_args);
 
     // Increase the size of the vector
     new_num = oper_resp->n_operation_results + 1;
-    oper_resp->operation_results = USP_REALLOC(oper_resp->operation_results, new_num*sizeof(void *));
+    oper_resp->operation_results = USP_ARENA_REALLOC(oper_resp->operation_results, new_num*sizeof(void *));
     oper_resp->n_operation_results = new_num;
     oper_resp->operation_results[new_num-1] = oper_res;
 
     // Initialise the operation result
-    oper_res->executed_command = USP_STRDUP(path);
+    oper_res->executed_command = USP_ARENA_STRDUP(path);
     oper_res->operation_resp_case = USP__OPERATE_RESP__OPERATION_RESULT__OPERATION_RESP_REQ_OUTPUT_ARGS;
     oper_res->req_output_args = output_args;
 
     // Initialise the output args object
     num_args = args->num_entries;
     output_args->n_output_args = num_args;
-    output_args->output_args = USP_MALLOC(num_args*sizeof(void *));
+    output_args->output_args = USP_ARENA_MALLOC(num_args*sizeof(void *));
 
     // Iterate over all output arguments, adding them to the operate result object
     for (i=0; i<num_args; i++)
     {
         // Allocate an output arg map entry
-        entry = USP_MALLOC(sizeof(Usp__OperateResp__OperationResult__OutputArgs__OutputArgsEntry));
+        entry = USP_ARENA_MALLOC(sizeof(Usp__OperateResp__OperationResult__OutputArgs__OutputArgsEntry));
         usp__operate_resp__operation_result__output_args__output_args_entry__init(entry);
         output_args->output_args[i] = entry;
 
         // Initialise the output arg map entry
         arg = &args->vector[i];
-        entry->key = USP_STRDUP(arg->key);
-        entry->value = USP_STRDUP(arg->value);
+        entry->key = USP_ARENA_STRDUP(arg->key);
+        entry->value = USP_ARENA_STRDUP(arg->value);
     }
 }
 
@@ -406,6 +406,19 @@ int UpdateObject(char *obj_path,
         }
     }
 
+    // Exit if the vendor was unable to apply the parameters set in this object by its group set callback
+    // NOTE: The group set callback applies the object instance as a whole, so a failure fails the whole object
+    if (result == USP_ERR_OK)
+    {
+        err = DM_TRANS_ApplyGroupSets();
+        if (err != USP_ERR_OK)
+        {
+            RemoveSetResp_LastUpdateObjResult(set_resp);
+            AddSetResp_OperFailure(set_resp, up->obj_path, err, USP_ERR_GetMessage());
+            result = err;
+        }
+    }
+
     return result;
 }
 
@@ -432,24 +445,24 @@ Usp__Msg *CreateSetResp(char *msg_id)
     Usp__SetResp *set_resp;
 
     // Allocate and initialise memory to store the parts of the USP message
-    resp = USP_MALLOC(sizeof(Usp__Msg));
+    resp = USP_ARENA_MALLOC(sizeof(Usp__Msg));
     usp__msg__init(resp);
 
-    header = USP_MALLOC(sizeof(Usp__Header));
+    header = USP_ARENA_MALLOC(sizeof(Usp__Header));
     usp__header__init(header);
 
-    body = USP_MALLOC(sizeof(Usp__Body));
+    body = USP_ARENA_MALLOC(sizeof(Usp__Body));
     usp__body__init(body);
 
-    response = USP_MALLOC(sizeof(Usp__Response));
+    response = USP_ARENA_MALLOC(sizeof(Usp__Response));
     usp__response__init(response);
 
-    set_resp = USP_MALLOC(sizeof(Usp__SetResp));
+    set_resp = USP_ARENA_MALLOC(sizeof(Usp__SetResp));
     usp__set_resp__init(set_resp);
 
     // Connect the structures together
     resp->header = header;
-    header->msg_id = USP_STRDUP(msg_id);
+    header->msg_id = USP_ARENA_STRDUP(msg_id);
     header->msg_type = USP__HEADER__MSG_TYPE__SET_RESP;
 
     resp->body = body;
@@ -487,30 +500,30 @@ AddSetResp_OperFailure(Usp__SetResp *set_resp, char *path, int err_code, char *e
     int new_num;    // new number of entries in the updated object result array
     
     // Allocate memory to store the updated object result
-    updated_obj_res = USP_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult));
+    updated_obj_res = USP_ARENA_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult));
     usp__set_resp__updated_object_result__init(updated_obj_res);
 
-    oper_status = USP_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult__OperationStatus));
+    oper_status = USP_ARENA_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult__OperationStatus));
     usp__set_resp__updated_object_result__operation_status__init(oper_status);    
 
-    oper_failure = USP_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult__OperationStatus__OperationFailure));
+    oper_failure = USP_ARENA_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult__OperationStatus__OperationFailure));
     usp__set_resp__updated_object_result__operation_status__operation_failure__init(oper_failure);
 
     // Increase the size of the vector
     new_num = set_resp->n_updated_obj_results + 1;
-    set_resp->updated_obj_results = USP_REALLOC(set_resp->updated_obj_results, new_num*sizeof(void *));
+    set_resp->updated_obj_results = USP_ARENA_REALLOC(set_resp->updated_obj_results, new_num*sizeof(void *));
     set_resp->n_updated_obj_results = new_num;
     set_resp->updated_obj_results[new_num-1] = updated_obj_res;
 
     // Connect all objects together, and fill in their members
-    updated_obj_res->requested_path = USP_STRDUP(path);
+    updated_obj_res->requested_path = USP_ARENA_STRDUP(path);
     updated_obj_res->oper_status = oper_status;
 
     oper_status->oper_status_case = USP__SET_RESP__UPDATED_OBJECT_RESULT__OPERATION_STATUS__OPER_STATUS_OPER_FAILURE;
     oper_status->oper_failure = oper_failure;
 
     oper_failure->err_code = err_code;
-    oper_failure->err_msg = USP_STRDUP(err_msg);
+    oper_failure->err_msg = USP_ARENA_STRDUP(err_msg);
     oper_failure->n_updated_inst_failures = 0;
     oper_failure->updated_inst_failures = NULL;
 
@@ -538,12 +551,12 @@ AddOperFailure_UpdatedInstFailure(Usp__SetResp__UpdatedObjectResult__OperationSt
     int len;
 
     // Allocate memory to store the updated instance failure entry
-    updated_inst_failure = USP_MALLOC(sizeof(Usp__SetResp__UpdatedInstanceFailure));
+    updated_inst_failure = USP_ARENA_MALLOC(sizeof(Usp__SetResp__UpdatedInstanceFailure));
     usp__set_resp__updated_instance_failure__init(updated_inst_failure);
 
     // Increase the size of the vector
     new_num = oper_failure->n_updated_inst_failures + 1;
-    oper_failure->updated_inst_failures = USP_REALLOC(oper_failure->updated_inst_failures, new_num*sizeof(void *));
+    oper_failure->updated_inst_failures = USP_ARENA_REALLOC(oper_failure->updated_inst_failures, new_num*sizeof(void *));
     oper_failure->n_updated_inst_failures = new_num;
     oper_failure->updated_inst_failures[new_num-1] = updated_inst_failure;
 
@@ -553,7 +566,7 @@ AddOperFailure_UpdatedInstFailure(Usp__SetResp__UpdatedObjectResult__OperationSt
 
     // Add the object path with a trailing '.'
     len = strlen(path) + 2;   // Plus 2 to allow for adding a trailing '.' and NULL terminator
-    updated_inst_failure->affected_path = USP_MALLOC(len);
+    updated_inst_failure->affected_path = USP_ARENA_MALLOC(len);
     USP_SNPRINTF(updated_inst_failure->affected_path, len, "%s.", path);
 
     return updated_inst_failure;
@@ -581,19 +594,19 @@ AddUpdatedInstFailure_ParamErr(Usp__SetResp__UpdatedInstanceFailure *updated_ins
     int new_num;    // new number of entries in the param_err array
 
     // Allocate memory to store the param_err entry
-    param_err_entry = USP_MALLOC(sizeof(Usp__SetResp__ParameterError));
+    param_err_entry = USP_ARENA_MALLOC(sizeof(Usp__SetResp__ParameterError));
     usp__set_resp__parameter_error__init(param_err_entry);
 
     // Increase the size of the vector
     new_num = updated_inst_failure->n_param_errs + 1;
-    updated_inst_failure->param_errs = USP_REALLOC(updated_inst_failure->param_errs, new_num*sizeof(void *));
+    updated_inst_failure->param_errs = USP_ARENA_REALLOC(updated_inst_failure->param_errs, new_num*sizeof(void *));
     updated_inst_failure->n_param_errs = new_num;
     updated_inst_failure->param_errs[new_num-1] = param_err_entry;
 
     // Initialise the param_err_entry
-    param_err_entry->param = USP_STRDUP(path);
+    param_err_entry->param = USP_ARENA_STRDUP(path);
     param_err_entry->err_code = err_code;
-    param_err_entry->err_msg = USP_STRDUP(err_msg);
+    param_err_entry->err_msg = USP_ARENA_STRDUP(err_msg);
 
     return param_err_entry;
 }
@@ -720,23 +733,23 @@ AddSetResp_OperSuccess(Usp__SetResp *set_resp, char *path)
     int new_num;    // new number of entries in the updated object result array
     
     // Allocate memory to store the updated object result
-    updated_obj_res = USP_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult));
+    updated_obj_res = USP_ARENA_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult));
     usp__set_resp__updated_object_result__init(updated_obj_res);
 
-    oper_status = USP_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult__OperationStatus));
+    oper_status = USP_ARENA_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult__OperationStatus));
     usp__set_resp__updated_object_result__operation_status__init(oper_status);    
     
-    oper_success = USP_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult__OperationStatus__OperationSuccess));
+    oper_success = USP_ARENA_MALLOC(sizeof(Usp__SetResp__UpdatedObjectResult__OperationStatus__OperationSuccess));
     usp__set_resp__updated_object_result__operation_status__operation_success__init(oper_success);
 
     // Increase the size of the vector
     new_num = set_resp->n_updated_obj_results + 1;
-    set_resp->updated_obj_results = USP_REALLOC(set_resp->updated_obj_results, new_num*sizeof(void *));
+    set_resp->updated_obj_results = USP_ARENA_REALLOC(set_resp->updated_obj_results, new_num*sizeof(void *));
     set_resp->n_updated_obj_results = new_num;
     set_resp->updated_obj_results[new_num-1] = updated_obj_res;
 
     // Connect all objects together, and fill in their members
-    updated_obj_res->requested_path = USP_STRDUP(path);
+    updated_obj_res->requested_path = USP_ARENA_STRDUP(path);
     updated_obj_res->oper_status = oper_status;
 
     oper_status->oper_status_case = USP__SET_RESP__UPDATED_OBJECT_RESULT__OPERATION_STATUS__OPER_STATUS_OPER_SUCCESS;
@@ -796,12 +809,12 @@ AddOperSuccess_UpdatedInstRes(Usp__SetResp__UpdatedObjectResult__OperationStatus
     int len;
 
     // Allocate memory to store the updated instance result entry
-    updated_inst_result = USP_MALLOC(sizeof(Usp__SetResp__UpdatedInstanceResult));
+    updated_inst_result = USP_ARENA_MALLOC(sizeof(Usp__SetResp__UpdatedInstanceResult));
     usp__set_resp__updated_instance_result__init(updated_inst_result);
 
     // Increase the size of the vector
     new_num = oper_success->n_updated_inst_results + 1;
-    oper_success->updated_inst_results = USP_REALLOC(oper_success->updated_inst_results, new_num*sizeof(void *));
+    oper_success->updated_inst_results = USP_ARENA_REALLOC(oper_success->updated_inst_results, new_num*sizeof(void *));
     oper_success->n_updated_inst_results = new_num;
     oper_success->updated_inst_results[new_num-1] = updated_inst_result;
 
@@ -813,7 +826,7 @@ AddOperSuccess_UpdatedInstRes(Usp__SetResp__UpdatedObjectResult__OperationStatus
 
     // Add the object path with a trailing '.'
     len = strlen(path) + 2;   // Plus 2 to allow for adding a trailing '.' and NULL terminator
-    updated_inst_result->affected_path = USP_MALLOC(len);
+    updated_inst_result->affected_path = USP_ARENA_MALLOC(len);
     USP_SNPRINTF(updated_inst_result->affected_path, len, "%s.", path);
 
     return updated_inst_result;
@@ -840,18 +853,18 @@ AddUpdatedInstRes_ParamsEntry(Usp__SetResp__UpdatedInstanceResult *updated_inst_
     int new_num;    // new number of entries in the updated instance result array
 
     // Allocate memory to store the updated instance result entry
-    entry = USP_MALLOC(sizeof(Usp__SetResp__UpdatedInstanceResult__UpdatedParamsEntry));
+    entry = USP_ARENA_MALLOC(sizeof(Usp__SetResp__UpdatedInstanceResult__UpdatedParamsEntry));
     usp__set_resp__updated_instance_result__updated_params_entry__init(entry);
 
     // Increase the size of the vector
     new_num = updated_inst_result->n_updated_params + 1;
-    updated_inst_result->updated_params = USP_REALLOC(updated_inst_result->updated_params , new_num*sizeof(void *));
+    updated_inst_result->updated_params = USP_ARENA_REALLOC(updated_inst_result->updated_params , new_num*sizeof(void *));
     updated_inst_result->n_updated_params = new_num;
     updated_inst_result->updated_params[new_num-1] = entry;
 
     // Initialise the result param map entry
-    entry->key = USP_STRDUP(key);
-    entry->value = USP_STRDUP(value);
+    entry->key = USP_ARENA_STRDUP(key);
+    entry->value = USP_ARENA_STRDUP(value);
 
     return entry;
 }
@@ -878,19 +891,19 @@ AddUpdatedInstRes_ParamErr(Usp__SetResp__UpdatedInstanceResult *updated_inst_res
     int new_num;    // new number of entries in the param_err array
 
     // Allocate memory to store the param_err entry
-    param_err_entry = USP_MALLOC(sizeof(Usp__SetResp__ParameterError));
+    param_err_entry = USP_ARENA_MALLOC(sizeof(Usp__SetResp__ParameterError));
     usp__set_resp__parameter_error__init(param_err_entry);
 
     // Increase the size of the vector
     new_num = updated_inst_result->n_param_errs + 1;
-    updated_inst_result->param_errs = USP_REALLOC(updated_inst_result->param_errs, new_num*sizeof(void *));
+    updated_inst_result->param_errs = USP_ARENA_REALLOC(updated_inst_result->param_errs, new_num*sizeof(void *));
     updated_inst_result->n_param_errs = new_num;
     updated_inst_result->param_errs[new_num-1] = param_err_entry;
 
     // Initialise the param_err_entry
-    param_err_entry->param = USP_STRDUP(path);
+    param_err_entry->param = USP_ARENA_STRDUP(path);
     param_err_entry->err_code = err_code;
-    param_err_entry->err_msg = USP_STRDUP(err_msg);
+    param_err_entry->err_msg = USP_ARENA_STRDUP(err_msg);
 
     return param_err_entry;
 }
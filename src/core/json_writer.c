@@ -0,0 +1,715 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file json_writer.c
+ *
+ * Streaming JSON writer. JSON is serialized directly into a growable buffer, as each member is added,
+ * rather than building a tree of JSON nodes and then serializing the tree (as the ccan/json library does)
+ * The output is byte-for-byte identical to that of json_stringify() (or json_encode() for compact output)
+ * The writer may also stream the JSON in chunks to a sink callback (eg to compress it), so that the whole of the JSON is never held in memory
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "common_defs.h"
+#include "json_writer.h"
+
+//------------------------------------------------------------------------------
+// Initial size of the buffer allocated by the writer. The buffer doubles in size when more space is needed
+#define INITIAL_JSON_WRITER_SIZE  256
+
+//------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+void StartContainer(json_writer_t *jw, char *key, char open_char);
+void EndContainer(json_writer_t *jw, char close_char);
+void WriteMemberPrefix(json_writer_t *jw, char *key);
+void WriteEscapedString(json_writer_t *jw, char *str);
+void WriteChars(json_writer_t *jw, char *str, int len);
+void WriteNewLine(json_writer_t *jw);
+void EnsureSpace(json_writer_t *jw, int needed);
+void FlushToSink(json_writer_t *jw);
+int Utf8SequenceLen(unsigned char *s);
+
+/*********************************************************************//**
+**
+** JSON_WRITER_Init
+**
+** Initialises a JSON writer
+**
+** \param   jw - pointer to JSON writer to initialise
+** \param   indent - string used to indent each nesting level, or NULL for compact output
+**                   NOTE: This string is not copied, so must remain valid for the lifetime of the writer
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_Init(json_writer_t *jw, char *indent)
+{
+    memset(jw, 0, sizeof(json_writer_t));
+    jw->indent = indent;
+    jw->max_len = INITIAL_JSON_WRITER_SIZE;
+    jw->buf = USP_MALLOC(jw->max_len);
+    jw->buf[0] = '\0';
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_InitStream
+**
+** Initialises a streaming JSON writer, which passes the JSON to the specified callback in chunks, as it is written
+**
+** \param   jw - pointer to JSON writer to initialise
+** \param   indent - string used to indent each nesting level, or NULL for compact output
+**                   NOTE: This string is not copied, so must remain valid for the lifetime of the writer
+** \param   sink - callback to pass each chunk of JSON to
+** \param   sink_arg - argument to pass to the callback
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_InitStream(json_writer_t *jw, char *indent, json_writer_sink_t sink, void *sink_arg)
+{
+    memset(jw, 0, sizeof(json_writer_t));
+    jw->indent = indent;
+    jw->sink = sink;
+    jw->sink_arg = sink_arg;
+    jw->max_len = JSON_WRITER_CHUNK_SIZE;
+    jw->buf = USP_MALLOC(jw->max_len);
+    jw->buf[0] = '\0';
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_StartObject
+**
+** Starts a JSON object. Subsequent members are added to this object, until JSON_WRITER_EndObject() is called
+**
+** \param   jw - pointer to JSON writer
+** \param   key - name of the object, if it is a member of an object, or NULL if it is an array element (or at the top level)
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_StartObject(json_writer_t *jw, char *key)
+{
+    StartContainer(jw, key, '{');
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_EndObject
+**
+** Ends the JSON object started by JSON_WRITER_StartObject()
+**
+** \param   jw - pointer to JSON writer
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_EndObject(json_writer_t *jw)
+{
+    EndContainer(jw, '}');
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_StartArray
+**
+** Starts a JSON array. Subsequent elements are added to this array, until JSON_WRITER_EndArray() is called
+**
+** \param   jw - pointer to JSON writer
+** \param   key - name of the array, if it is a member of an object, or NULL if it is an array element (or at the top level)
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_StartArray(json_writer_t *jw, char *key)
+{
+    StartContainer(jw, key, '[');
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_EndArray
+**
+** Ends the JSON array started by JSON_WRITER_StartArray()
+**
+** \param   jw - pointer to JSON writer
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_EndArray(json_writer_t *jw)
+{
+    EndContainer(jw, ']');
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_AddString
+**
+** Adds a string to the current JSON object or array, quoting and escaping it
+**
+** \param   jw - pointer to JSON writer
+** \param   key - name of the member (if adding to an object), or NULL (if adding to an array)
+** \param   value - UTF-8 string to add
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_AddString(json_writer_t *jw, char *key, char *value)
+{
+    WriteMemberPrefix(jw, key);
+    WriteEscapedString(jw, value);
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_AddNumber
+**
+** Adds a number to the current JSON object or array
+** NOTE: Numbers which cannot be represented in JSON (infinity and NaN) are written as null
+**
+** \param   jw - pointer to JSON writer
+** \param   key - name of the member (if adding to an object), or NULL (if adding to an array)
+** \param   value - number to add
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_AddNumber(json_writer_t *jw, char *key, double value)
+{
+    char buf[64];
+    int len;
+
+    WriteMemberPrefix(jw, key);
+
+    // Exit if the number cannot be represented in JSON
+    if (isfinite(value) == false)
+    {
+        WriteChars(jw, "null", 4);
+        return;
+    }
+
+    // NOTE: This uses the same format as the ccan/json library
+    len = snprintf(buf, sizeof(buf), "%.16g", value);
+    WriteChars(jw, buf, len);
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_AddBool
+**
+** Adds a boolean to the current JSON object or array
+**
+** \param   jw - pointer to JSON writer
+** \param   key - name of the member (if adding to an object), or NULL (if adding to an array)
+** \param   value - boolean to add
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_AddBool(json_writer_t *jw, char *key, bool value)
+{
+    WriteMemberPrefix(jw, key);
+    if (value)
+    {
+        WriteChars(jw, "true", 4);
+    }
+    else
+    {
+        WriteChars(jw, "false", 5);
+    }
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_AddRaw
+**
+** Adds a value which is already in JSON format to the current JSON object or array
+**
+** \param   jw - pointer to JSON writer
+** \param   key - name of the member (if adding to an object), or NULL (if adding to an array)
+** \param   json_value - JSON formatted value to add (eg a quoted and escaped string, or a number). This is added verbatim
+**
+** \return  None
+**
+**************************************************************************/
+void JSON_WRITER_AddRaw(json_writer_t *jw, char *key, char *json_value)
+{
+    WriteMemberPrefix(jw, key);
+    WriteChars(jw, json_value, strlen(json_value));
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_Finish
+**
+** Returns the JSON written, passing ownership of the buffer to the caller
+** NOTE: The writer must not be used after this call, unless it is re-initialised
+**
+** \param   jw - pointer to JSON writer
+**
+** \return  pointer to dynamically allocated NULL terminated buffer containing the JSON. The caller must free this with USP_FREE()
+**
+**************************************************************************/
+char *JSON_WRITER_Finish(json_writer_t *jw)
+{
+    char *buf;
+
+    buf = jw->buf;
+    jw->buf = NULL;
+    jw->len = 0;
+    jw->max_len = 0;
+
+    return buf;
+}
+
+/*********************************************************************//**
+**
+** JSON_WRITER_FinishStream
+**
+** Passes any remaining JSON to the sink callback of a streaming JSON writer, and frees the writer's buffer
+** NOTE: The writer must not be used after this call, unless it is re-initialised
+**
+** \param   jw - pointer to JSON writer
+**
+** \return  USP_ERR_OK if successful, otherwise the first error returned by the sink callback
+**
+**************************************************************************/
+int JSON_WRITER_FinishStream(json_writer_t *jw)
+{
+    int err;
+
+    if (jw->len > 0)
+    {
+        FlushToSink(jw);
+    }
+
+    err = jw->sink_err;
+    USP_FREE(jw->buf);
+    memset(jw, 0, sizeof(json_writer_t));
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** StartContainer
+**
+** Starts a JSON object or array
+**
+** \param   jw - pointer to JSON writer
+** \param   key - name of the object or array, if it is a member of an object, or NULL otherwise
+** \param   open_char - character which opens the object or array
+**
+** \return  None
+**
+**************************************************************************/
+void StartContainer(json_writer_t *jw, char *key, char open_char)
+{
+    WriteMemberPrefix(jw, key);
+    WriteChars(jw, &open_char, 1);
+
+    USP_ASSERT(jw->depth < MAX_JSON_WRITER_DEPTH);
+    jw->has_members[jw->depth] = false;
+    jw->depth++;
+}
+
+/*********************************************************************//**
+**
+** EndContainer
+**
+** Ends the current JSON object or array
+** NOTE: As with the ccan/json library, empty objects and arrays are written without any whitespace inside them
+**
+** \param   jw - pointer to JSON writer
+** \param   close_char - character which closes the object or array
+**
+** \return  None
+**
+**************************************************************************/
+void EndContainer(json_writer_t *jw, char close_char)
+{
+    USP_ASSERT(jw->depth > 0);
+    jw->depth--;
+
+    if (jw->has_members[jw->depth])
+    {
+        WriteNewLine(jw);
+    }
+    WriteChars(jw, &close_char, 1);
+}
+
+/*********************************************************************//**
+**
+** WriteMemberPrefix
+**
+** Writes the separator from the previous member of the current object or array, the indentation and the key of the next member
+**
+** \param   jw - pointer to JSON writer
+** \param   key - name of the member (if adding to an object), or NULL (if adding to an array or at the top level)
+**
+** \return  None
+**
+**************************************************************************/
+void WriteMemberPrefix(json_writer_t *jw, char *key)
+{
+    // Exit if writing the top level value
+    if (jw->depth == 0)
+    {
+        return;
+    }
+
+    if (jw->has_members[jw->depth-1])
+    {
+        WriteChars(jw, ",", 1);
+    }
+    jw->has_members[jw->depth-1] = true;
+    WriteNewLine(jw);
+
+    if (key != NULL)
+    {
+        WriteEscapedString(jw, key);
+        if (jw->indent != NULL)
+        {
+            WriteChars(jw, ": ", 2);
+        }
+        else
+        {
+            WriteChars(jw, ":", 1);
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** WriteNewLine
+**
+** Writes a new line, indented to the current nesting depth (only if the writer is not writing compact output)
+**
+** \param   jw - pointer to JSON writer
+**
+** \return  None
+**
+**************************************************************************/
+void WriteNewLine(json_writer_t *jw)
+{
+    int i;
+    int indent_len;
+
+    // Exit if writing compact output
+    if (jw->indent == NULL)
+    {
+        return;
+    }
+
+    WriteChars(jw, "\n", 1);
+
+    // If streaming, pass the JSON to the sink at the end of a line, once enough has accumulated
+    // (this avoids splitting lines across chunks, so that the sink may log the JSON line by line)
+    if ((jw->sink != NULL) && (jw->len >= JSON_WRITER_CHUNK_SIZE/2))
+    {
+        FlushToSink(jw);
+    }
+
+    indent_len = strlen(jw->indent);
+    for (i=0; i < jw->depth; i++)
+    {
+        WriteChars(jw, jw->indent, indent_len);
+    }
+}
+
+/*********************************************************************//**
+**
+** WriteEscapedString
+**
+** Writes the specified string, quoted and escaped for JSON
+** NOTE: Escaping matches the ccan/json library. Control characters are escaped, but other UTF-8 characters are written verbatim.
+**       Invalid UTF-8 bytes are replaced by the Unicode replacement character (U+FFFD)
+**
+** \param   jw - pointer to JSON writer
+** \param   str - UTF-8 string to write
+**
+** \return  None
+**
+**************************************************************************/
+void WriteEscapedString(json_writer_t *jw, char *str)
+{
+    unsigned char *s = (unsigned char *)str;
+    unsigned char c;
+    char *p;
+    int seq_len;
+    static const char hex[] = "0123456789ABCDEF";
+
+    // Ensure there is enough space in the buffer for the worst case (every character escaped as "\u00XX", plus the enclosing quotes)
+    EnsureSpace(jw, 6*strlen(str) + 2);
+
+    p = &jw->buf[jw->len];
+    *p++ = '\"';
+    while (*s != '\0')
+    {
+        c = *s;
+        switch(c)
+        {
+            case '\"':
+            case '\\':
+                *p++ = '\\';
+                *p++ = c;
+                s++;
+                break;
+
+            case '\b':
+                *p++ = '\\';
+                *p++ = 'b';
+                s++;
+                break;
+
+            case '\f':
+                *p++ = '\\';
+                *p++ = 'f';
+                s++;
+                break;
+
+            case '\n':
+                *p++ = '\\';
+                *p++ = 'n';
+                s++;
+                break;
+
+            case '\r':
+                *p++ = '\\';
+                *p++ = 'r';
+                s++;
+                break;
+
+            case '\t':
+                *p++ = '\\';
+                *p++ = 't';
+                s++;
+                break;
+
+            default:
+                if (c < 0x1F)
+                {
+                    // Control character (NOTE: The ccan/json library does not escape 0x1F, so neither do we)
+                    memcpy(p, "\\u00", 4);
+                    p[4] = hex[c >> 4];
+                    p[5] = hex[c & 0xF];
+                    p += 6;
+                    s++;
+                }
+                else if (c < 0x80)
+                {
+                    *p++ = c;
+                    s++;
+                }
+                else
+                {
+                    seq_len = Utf8SequenceLen(s);
+                    if (seq_len == 0)
+                    {
+                        // Invalid UTF-8 byte, so replace it with U+FFFD
+                        *p++ = (char)0xEF;
+                        *p++ = (char)0xBF;
+                        *p++ = (char)0xBD;
+                        s++;
+                    }
+                    else
+                    {
+                        memcpy(p, s, seq_len);
+                        p += seq_len;
+                        s += seq_len;
+                    }
+                }
+                break;
+        }
+    }
+    *p++ = '\"';
+    *p = '\0';
+
+    jw->len = p - jw->buf;
+}
+
+/*********************************************************************//**
+**
+** WriteChars
+**
+** Writes the specified characters into the writer's buffer
+**
+** \param   jw - pointer to JSON writer
+** \param   str - pointer to characters to write
+** \param   len - number of characters to write
+**
+** \return  None
+**
+**************************************************************************/
+void WriteChars(json_writer_t *jw, char *str, int len)
+{
+    EnsureSpace(jw, len);
+    memcpy(&jw->buf[jw->len], str, len);
+    jw->len += len;
+    jw->buf[jw->len] = '\0';
+}
+
+/*********************************************************************//**
+**
+** EnsureSpace
+**
+** Ensures that the writer's buffer has space for the specified number of characters, plus a NULL terminator
+**
+** \param   jw - pointer to JSON writer
+** \param   needed - number of characters which are going to be written
+**
+** \return  None
+**
+**************************************************************************/
+void EnsureSpace(json_writer_t *jw, int needed)
+{
+    // Exit if there is already enough space
+    if (jw->len + needed + 1 <= jw->max_len)
+    {
+        return;
+    }
+
+    // If streaming, pass the JSON written so far to the sink, rather than growing the buffer
+    if ((jw->sink != NULL) && (jw->len > 0))
+    {
+        FlushToSink(jw);
+        if (needed + 1 <= jw->max_len)
+        {
+            return;
+        }
+    }
+
+    while (jw->len + needed + 1 > jw->max_len)
+    {
+        jw->max_len *= 2;
+    }
+
+    jw->buf = USP_REALLOC(jw->buf, jw->max_len);
+}
+
+/*********************************************************************//**
+**
+** Utf8SequenceLen
+**
+** Determines the length of the UTF-8 encoded character at the specified position in a string
+** NOTE: The rules are the same as those of the ccan/json library (overlong encodings, surrogates and codepoints beyond U+10FFFF are invalid)
+**
+** \param   s - pointer to the first byte of the UTF-8 encoded character
+**
+** \return  number of bytes in the character, or 0 if the character is not validly encoded
+**
+**************************************************************************/
+int Utf8SequenceLen(unsigned char *s)
+{
+    unsigned char c = s[0];
+    int len;
+    int i;
+
+    if (c <= 0x7F)
+    {
+        return 1;
+    }
+    else if (c <= 0xC1)
+    {
+        return 0;       // Continuation byte or overlong 2 byte sequence
+    }
+    else if (c <= 0xDF)
+    {
+        len = 2;
+    }
+    else if (c <= 0xEF)
+    {
+        // Exit if overlong 3 byte sequence, or a surrogate (U+D800..U+DFFF)
+        if (((c == 0xE0) && (s[1] < 0xA0)) || ((c == 0xED) && (s[1] > 0x9F)))
+        {
+            return 0;
+        }
+        len = 3;
+    }
+    else if (c <= 0xF4)
+    {
+        // Exit if overlong 4 byte sequence, or beyond U+10FFFF
+        if (((c == 0xF0) && (s[1] < 0x90)) || ((c == 0xF4) && (s[1] > 0x8F)))
+        {
+            return 0;
+        }
+        len = 4;
+    }
+    else
+    {
+        return 0;
+    }
+
+    // Exit if any of the subsequent bytes are not continuation bytes
+    // NOTE: This stops at the NULL terminator, as it is not a continuation byte
+    for (i=1; i < len; i++)
+    {
+        if ((s[i] & 0xC0) != 0x80)
+        {
+            return 0;
+        }
+    }
+
+    return len;
+}
+
+/*********************************************************************//**
+**
+** FlushToSink
+**
+** Passes the JSON accumulated in the buffer of a streaming JSON writer to its sink callback, then empties the buffer
+**
+** \param   jw - pointer to JSON writer
+**
+** \return  None
+**
+**************************************************************************/
+void FlushToSink(json_writer_t *jw)
+{
+    // Only call the sink, if it has not previously failed
+    if (jw->sink_err == USP_ERR_OK)
+    {
+        jw->sink_err = jw->sink(jw->buf, jw->len, jw->sink_arg);
+    }
+
+    jw->len = 0;
+    jw->buf[0] = '\0';
+}
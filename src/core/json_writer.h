@@ -0,0 +1,91 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2016-2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file json_writer.h
+ *
+ * Streaming JSON writer, which serializes JSON directly into a growable buffer (without building a tree of JSON nodes)
+ *
+ */
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+
+//-----------------------------------------------------------------------------------------
+// Maximum nesting depth of JSON objects and arrays supported by the writer
+#define MAX_JSON_WRITER_DEPTH 8
+
+//-----------------------------------------------------------------------------------------
+// Typedef for callback called by a streaming JSON writer, with each chunk of JSON written
+// NOTE: The chunk is always NULL terminated (at buf[len]), and the callback must not retain the buffer
+typedef int (*json_writer_sink_t)(char *buf, int len, void *arg);
+
+//-----------------------------------------------------------------------------------------
+// Size of chunks passed to the sink callback of a streaming JSON writer
+// NOTE: When writing indented JSON, chunks are split at the end of a line, so may be smaller than this
+#define JSON_WRITER_CHUNK_SIZE  16384
+
+//-----------------------------------------------------------------------------------------
+// JSON writer state
+typedef struct
+{
+    char *buf;              // Buffer containing the JSON written so far. This is always NULL terminated
+    int len;                // Number of characters written to the buffer (excluding the NULL terminator)
+    int max_len;            // Number of bytes allocated to the buffer
+    char *indent;           // String used to indent each nesting level (or NULL for compact output, without whitespace)
+    int depth;              // Current nesting depth of objects and arrays
+    bool has_members[MAX_JSON_WRITER_DEPTH];  // Whether the object or array at each nesting depth has had any members written to it yet
+    json_writer_sink_t sink;        // Callback to pass each chunk of JSON to, if the writer is streaming (or NULL if the JSON is accumulated in the buffer)
+    void *sink_arg;                 // Argument to pass to the sink callback
+    int sink_err;                   // Error returned by the sink callback. After an error, the sink callback is not called again
+} json_writer_t;
+
+//-----------------------------------------------------------------------------------------
+// API functions
+// NOTE: The key argument is the name of the member when writing to an object, and must be NULL when writing to an array (or at the top level)
+void JSON_WRITER_Init(json_writer_t *jw, char *indent);
+void JSON_WRITER_InitStream(json_writer_t *jw, char *indent, json_writer_sink_t sink, void *sink_arg);
+void JSON_WRITER_StartObject(json_writer_t *jw, char *key);
+void JSON_WRITER_EndObject(json_writer_t *jw);
+void JSON_WRITER_StartArray(json_writer_t *jw, char *key);
+void JSON_WRITER_EndArray(json_writer_t *jw);
+void JSON_WRITER_AddString(json_writer_t *jw, char *key, char *value);
+void JSON_WRITER_AddNumber(json_writer_t *jw, char *key, double value);
+void JSON_WRITER_AddBool(json_writer_t *jw, char *key, bool value);
+void JSON_WRITER_AddRaw(json_writer_t *jw, char *key, char *json_value);
+char *JSON_WRITER_Finish(json_writer_t *jw);
+int JSON_WRITER_FinishStream(json_writer_t *jw);
+
+#endif
@@ -731,8 +731,9 @@ void AddKeyValueInternal(kv_vector_t *kvv, char *key, char *value)
     int new_num_entries;
     kv_pair_t *pair;
 
+    // NOTE: The array is grown geometrically, so that building a large vector does not reallocate on every addition
     new_num_entries = kvv->num_entries + 1;
-    kvv->vector = USP_REALLOC(kvv->vector, new_num_entries*sizeof(kv_pair_t));
+    kvv->vector = USP_REALLOC_GEOMETRIC(kvv->vector, new_num_entries*sizeof(kv_pair_t));
 
     pair = &kvv->vector[ kvv->num_entries ];
     pair->key = key;
@@ -67,6 +67,7 @@
 #include "usp_coap.h"
 #include "stomp.h"
 #include "retry_wait.h"
+#include "proto_trace.h"
 
 #ifdef ENABLE_HIDL
 #include "hidl_server.h"
@@ -84,8 +85,10 @@ static struct option long_options[] =
     {"dbfile",     required_argument, NULL, 'f'},    // Sets the name of the path to use for the database file
     {"verbose",    required_argument, NULL, 'v'},    // Verbosity level for debug logging
     {"meminfo",    no_argument,       NULL, 'm'},    // Collects and prints information useful to debugging memory leaks
+    {"memtrack",   required_argument, NULL, 't'},    // Enables low overhead tracking of memory allocations by call site (argument is callstack sample rate)
     {"error",      no_argument,       NULL, 'e'},    // Prints the callstack whenever an error is detected
     {"prototrace" ,no_argument,       NULL, 'p'},    // Enables logging of the protocol trace
+    {"capture",    required_argument, NULL, 'r'},    // Captures all USP records sent and received to the specified file (in binary form)
     {"command",    no_argument,       NULL, 'c'},    // The rest of the command line is a command to invoke on the active USP Agent.
                                                      // Using this option turns this executable into just a CLI for the active USP Agent.
     {"authcert",   no_argument,       NULL, 'a'},    // Specifies the location of a file containing the client certificate to use authenticating this device
@@ -94,7 +97,7 @@ static struct option long_options[] =
 };
 
 // In the string argument, the colons (after the option) mean that those options require arguments
-static char short_options[] = "hl:f:v:a:mepc";
+static char short_options[] = "hl:f:v:a:t:r:mepc";
 
 //--------------------------------------------------------------------------------------
 // Variables set by command line arguments
@@ -124,6 +127,7 @@ int main(int argc, char *argv[])
     int err;
     int c;
     int option_index = 0;
+    unsigned sample_rate;
     char *db_file = DEFAULT_DATABASE_FILE;
     bool enable_mem_info = false;
 
@@ -178,6 +182,22 @@ int main(int argc, char *argv[])
                 enable_mem_info = true;
                 break;
 
+            case 't':
+                // Exit if unable to start tracking memory allocations
+                err = TEXT_UTILS_StringToUnsigned(optarg, &sample_rate);
+                if ((err != USP_ERR_OK) || (sample_rate == 0))
+                {
+                    USP_LOG_Error("ERROR: Memory tracking sample rate (%s) is invalid or out of range", optarg);
+                    goto exit;
+                }
+
+                err = USP_MEM_StartTracking(sample_rate);
+                if (err != USP_ERR_OK)
+                {
+                    goto exit;
+                }
+                break;
+
             case 'e':
                 // Enable callstack printing when an error occurs
                 enable_callstack_debug = true;
@@ -188,6 +208,15 @@ int main(int argc, char *argv[])
                 enable_protocol_trace = true;
                 break;
 
+            case 'r':
+                // Exit if unable to start capturing USP records
+                err = PROTO_TRACE_StartCapture(optarg);
+                if (err != USP_ERR_OK)
+                {
+                    goto exit;
+                }
+                break;
+
             case 'a':
                 // Set the location of the client certificate file to use
                 auth_cert_file = optarg;
@@ -243,6 +272,13 @@ int main(int argc, char *argv[])
     }
 
 
+    // Exit if unable to write out log messages from a background thread (so that logging does not hold up the other threads)
+    err = USP_LOG_StartAsync();
+    if (err != USP_ERR_OK)
+    {
+        goto exit;
+    }
+
     // Exit if unable to start USP Agent
     err = MAIN_Start(db_file, enable_mem_info);
     if (err != USP_ERR_OK)
@@ -270,6 +306,7 @@ int main(int argc, char *argv[])
 exit:
     // If the code gets here, an error occurred
     USP_LOG_Error("USP Agent aborted unexpectedly");
+    USP_LOG_StopAsync();
     return -1;
 }
 
@@ -377,9 +414,15 @@ int MAIN_Start(char *db_file, bool enable_mem_info)
 **************************************************************************/
 void MAIN_Stop(void)
 {
+    // Flush all captured USP records to file
+    PROTO_TRACE_StopCapture();
+
     // Free all memory used by USP Agent
     DM_EXEC_Destroy();
     curl_global_cleanup();
+
+    // Write out all buffered log messages
+    USP_LOG_StopAsync();
 }
 
 /*********************************************************************//**
@@ -401,8 +444,12 @@ void PrintUsage(void)
     printf("--dbfile (-f)     Sets the path of the file to store the database in\n");
     printf("--verbose (-v)    Sets the debug verbosity log level: 0=Off, 1=Error(default), 2=Warning, 3=Info\n");
     printf("--prototrace (-p) Enables trace logging of the USP protocol messages\n");
+    printf("--capture (-r)    Captures all USP records sent and received to the specified file, with low overhead\n");
+    printf("                  Use '-c decode [capture file]' to print the captured USP records\n");
     printf("--authcert (-a)   Sets the path of the PEM formatted file containing a client certificate and private key to authenticate this device with\n");
     printf("--meminfo (-m)    Collects and prints information useful to debugging memory leaks\n");
+    printf("--memtrack (-t)   Enables low overhead tracking of memory allocations by call site. Use '-c dump allocators' to show the top allocators\n");
+    printf("                  The argument sets the sample rate for capturing callstacks (eg 100 captures 1 in 100 allocations at each call site)\n");
     printf("--error (-e)      Enables printing of the callstack whenever an error is detected\n");
     printf("--command (-c)    Sends a CLI command to the running USP Agent and prints the response\n");
     printf("                  To get a list of all CLI commands use '-c help'\n");
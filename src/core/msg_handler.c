@@ -50,6 +50,7 @@
 #include "text_utils.h"
 #include "usp-record.pb-c.h"
 #include "stomp.h"
+#include "msg_stats.h"
 
 //------------------------------------------------------------------------
 // Index of the controller that sent the current USP message being processed
@@ -61,6 +62,37 @@ static int cur_msg_controller_instance = INVALID;
 // This is saved off before handling each message, as each message handler needs it fairly deeply in its processing
 static combined_role_t cur_msg_combined_role = { ROLE_DEFAULT, ROLE_DEFAULT};
 
+//------------------------------------------------------------------------
+// Message statistics for the current USP message being processed (all times in microseconds, 0 if statistics are disabled)
+static unsigned long long cur_record_unpack_time = 0;   // Time taken to unpack the USP record encapsulating the current message
+static unsigned long long cur_msg_pack_time = 0;        // Time spent packing messages queued whilst handling the current message
+
+//------------------------------------------------------------------------
+// Field number of the 'payload' field in a NoSessionContextRecord (see usp-record.proto)
+#define NO_SESSION_CONTEXT_PAYLOAD_FIELD  2
+
+//------------------------------------------------------------------------
+// Field numbers of the fields in a USP Record which are checked by PreScanUspRecord() (see usp-record.proto)
+#define RECORD_VERSION_FIELD              1
+#define RECORD_TO_ID_FIELD                2
+#define RECORD_FROM_ID_FIELD              3
+#define RECORD_PAYLOAD_SECURITY_FIELD     4
+#define RECORD_NO_SESSION_CONTEXT_FIELD   7
+#define RECORD_SESSION_CONTEXT_FIELD      8
+
+//------------------------------------------------------------------------
+// Result of pre-scanning a USP record
+typedef enum
+{
+    kPreScan_Ok,            // The USP record should be unpacked and processed
+    kPreScan_Ignore,        // The USP record should be ignored
+    kPreScan_Malformed      // The USP record is not a valid protobuf encoding
+} prescan_result_t;
+
+//------------------------------------------------------------------------
+// Number of USP records ignored by PreScanUspRecord(), without being unpacked
+static unsigned records_rejected = 0;
+
 //------------------------------------------------------------------------
 // Array used to convert from an enumeration to it's string representation
 static enum_entry_t usp_msg_types[] = {
@@ -89,7 +121,16 @@ static enum_entry_t usp_msg_types[] = {
 
 //------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
-int HandleUspMessage(Usp__Msg *usp, char *controller_endpoint, char *stomp_dest, int stomp_instance);
+int HandleUspMessage(Usp__Msg *usp, char *controller_endpoint, char *stomp_dest, int stomp_instance, unsigned long long unpack_time);
+int QueueUspRecord(Usp__Header__MsgType usp_msg_type, char *endpoint_id, unsigned char *pbuf, int pbuf_len, char *stomp_dest, int stomp_instance, unsigned long long pack_start);
+int QueuePackedRecord(Usp__Header__MsgType usp_msg_type, char *endpoint_id, unsigned char *buf, int len, char *stomp_dest, int stomp_instance, unsigned long long pack_start);
+unsigned char *PackUspMsgInRecord(Usp__Msg *usp, char *endpoint_id, int *record_len);
+void InitUspRecord(UspRecord__Record *rec, UspRecord__NoSessionContextRecord *ctx, char *endpoint_id, unsigned char *pbuf, int pbuf_len);
+int PackVarint(unsigned value, unsigned char *buf);
+int VarintSize(unsigned value);
+prescan_result_t PreScanUspRecord(unsigned char *pbuf, int pbuf_len);
+int ScanVarint(unsigned char *buf, int len, unsigned long long *value);
+bool IsFieldEqual(unsigned char *field, int field_len, char *str);
 bool IsValidUspRecord(UspRecord__Record *rec);
 void CacheControllerRoleForCurMsg(char *endpoint_id, ctrust_role_t role, bool rxed_over_stomp);
 
@@ -114,12 +155,49 @@ int MSG_HANDLER_HandleBinaryRecord(unsigned char *pbuf, int pbuf_len, ctrust_rol
 {
     int err;
     UspRecord__Record *rec;
+    unsigned long long unpack_start;
+    mtp_protocol_t protocol;
+
+    // Capture the USP record in binary form (if enabled)
+    protocol = kMtpProtocol_STOMP;
+#ifdef ENABLE_COAP
+    if (stomp_instance == INVALID)
+    {
+        protocol = kMtpProtocol_CoAP;
+    }
+#endif
+    PROTO_TRACE_CaptureRecord(kCaptureDir_Received, protocol, pbuf, pbuf_len);
+
+    // Exit if the USP record can be rejected without unpacking it (eg not addressed to us, unknown controller, or the controller is sending too many messages)
+    // NOTE: Ignored records are not fatal, so we don't want the caller to terminate the connection
+    switch(PreScanUspRecord(pbuf, pbuf_len))
+    {
+        case kPreScan_Ok:
+            break;
+
+        case kPreScan_Ignore:
+            records_rejected++;
+            return USP_ERR_OK;
+            break;
+
+        default:
+        case kPreScan_Malformed:
+            records_rejected++;
+            USP_ERR_SetMessage("%s(%d): USP record is not a valid protobuf encoding. Ignoring USP Message", __FUNCTION__, __LINE__);
+            return USP_ERR_INTERNAL_ERROR;
+            break;
+    }
+
+    // All protobuf structures associated with handling this USP record (including the response) are allocated from the message arena
+    USP_MEM_ArenaStart();
 
     // Exit if unable to unpack the USP record
+    unpack_start = MSG_STATS_GetTime();
     rec = usp_record__record__unpack(pbuf_allocator, pbuf_len, pbuf);
     if (rec == NULL)
     {
         USP_ERR_SetMessage("%s(%d): usp_record__session_record__unpack failed. Ignoring USP Message", __FUNCTION__, __LINE__);
+        USP_MEM_ArenaStop();
         return USP_ERR_INTERNAL_ERROR;
     }
 
@@ -135,15 +213,35 @@ int MSG_HANDLER_HandleBinaryRecord(unsigned char *pbuf, int pbuf_len, ctrust_rol
     PROTO_TRACE_ProtobufMessage(&rec->base);
 
     // Process the encapsulated USP message
+    cur_record_unpack_time = MSG_STATS_GetTimeSince(unpack_start);
     err = MSG_HANDLER_HandleBinaryMessage(rec->no_session_context->payload.data, rec->no_session_context->payload.len, role, allowed_controllers, rec->from_id, stomp_dest, stomp_instance);
+    cur_record_unpack_time = 0;
 
 exit:
-    // Free the unpacked USP record
-    usp_record__record__free_unpacked(rec, pbuf_allocator);
+    // Free the unpacked USP record (and everything else allocated from the message arena)
+    // NOTE: There is no need to call usp_record__record__free_unpacked(), as the record was allocated from the arena
+    USP_MEM_ArenaStop();
 
     return err;
 }
 
+/*********************************************************************//**
+**
+** MSG_HANDLER_GetRecordsRejected
+**
+** Returns the number of USP records which have been rejected without being unpacked
+** (because they were malformed, not addressed to this agent, from an unknown controller, or exceeded the controller's rate limit)
+**
+** \param   None
+**
+** \return  Number of USP records rejected
+**
+**************************************************************************/
+unsigned MSG_HANDLER_GetRecordsRejected(void)
+{
+    return records_rejected;
+}
+
 /*********************************************************************//**
 **
 ** MSG_HANDLER_HandleBinaryMessage
@@ -166,8 +264,11 @@ int MSG_HANDLER_HandleBinaryMessage(unsigned char *pbuf, int pbuf_len, ctrust_ro
     int err;
     Usp__Msg *usp;
     bool rxed_over_stomp;
+    unsigned long long unpack_start;
+    unsigned long long unpack_time;
 
     // Exit if unable to unpack the USP message
+    unpack_start = MSG_STATS_GetTime();
     usp = usp__msg__unpack(pbuf_allocator, pbuf_len, pbuf);
     if (usp == NULL)
     {
@@ -175,6 +276,13 @@ int MSG_HANDLER_HandleBinaryMessage(unsigned char *pbuf, int pbuf_len, ctrust_ro
         return USP_ERR_INTERNAL_ERROR;
     }
 
+    // Include the time taken to unpack the encapsulating USP record (if this message was received in a USP record)
+    unpack_time = MSG_STATS_GetTimeSince(unpack_start);
+    if (unpack_time != 0)
+    {
+        unpack_time += cur_record_unpack_time;
+    }
+
     // Set the role that the controller should use when handling this message
     rxed_over_stomp = (stomp_instance != INVALID);
     CacheControllerRoleForCurMsg(controller_endpoint, role, rxed_over_stomp);
@@ -183,7 +291,10 @@ int MSG_HANDLER_HandleBinaryMessage(unsigned char *pbuf, int pbuf_len, ctrust_ro
     PROTO_TRACE_ProtobufMessage(&usp->base);
 
     // Exit if unable to process the message
-    err = HandleUspMessage(usp, controller_endpoint, stomp_dest, stomp_instance);
+    // NOTE: Values returned by group get callbacks are cached whilst handling the message, so that each object instance is only got once
+    DATA_MODEL_StartGroupGetCache();
+    err = HandleUspMessage(usp, controller_endpoint, stomp_dest, stomp_instance, unpack_time);
+    DATA_MODEL_StopGroupGetCache();
     if (err != USP_ERR_OK)
     {
         goto exit;
@@ -193,8 +304,11 @@ int MSG_HANDLER_HandleBinaryMessage(unsigned char *pbuf, int pbuf_len, ctrust_ro
     err = USP_ERR_OK;
 
 exit:
-    // Free the unpacked USP message
-    usp__msg__free_unpacked(usp, pbuf_allocator);
+    // Free the unpacked USP message, if it was not allocated from the message arena (which is freed in one go by the caller)
+    if (USP_MEM_IsArenaActive() == false)
+    {
+        usp__msg__free_unpacked(usp, pbuf_allocator);
+    }
 
     return err;
 }
@@ -223,6 +337,9 @@ void MSG_HANDLER_LogMessageToSend(Usp__Header__MsgType usp_msg_type, unsigned ch
     char buf[MAX_ISO8601_LEN];
     UspRecord__NoSessionContextRecord *ctx;
 
+    // Capture the USP record in binary form (if enabled)
+    PROTO_TRACE_CaptureRecord(kCaptureDir_Sent, protocol, pbuf, pbuf_len);
+
     // Log the message
     USP_PROTOCOL("\n");
     USP_LOG_Info("%s sending at time %s, to host %s over %s", 
@@ -310,7 +427,7 @@ void MSG_HANDLER_HandleUnknownMsgType(Usp__Msg *usp, char *controller_endpoint,
 **
 ** MSG_HANDLER_QueueMessage
 ** 
-** Serializes a USP message to a buffer, then queues it, to be sent to a controller
+** Serializes a USP message (encapsulated in a USP record) to a buffer, then queues it, to be sent to a controller
 ** 
 ** \param   endpoint_id - controller to send the message to
 ** \param   usp - pointer to protobuf-c structure describing the USP message to send
@@ -322,10 +439,9 @@ void MSG_HANDLER_HandleUnknownMsgType(Usp__Msg *usp, char *controller_endpoint,
 **************************************************************************/
 int MSG_HANDLER_QueueMessage(char *endpoint_id, Usp__Msg *usp, char *stomp_dest, int stomp_instance)
 {
-    unsigned char *pbuf;
-    int pbuf_len;
-    int size;
-    int err;
+    unsigned char *buf;
+    int len;
+    unsigned long long pack_start;
 
     // Exit if parameters not specified
     if ((endpoint_id == NULL) || (usp == NULL))
@@ -334,19 +450,12 @@ int MSG_HANDLER_QueueMessage(char *endpoint_id, Usp__Msg *usp, char *stomp_dest,
         return USP_ERR_INTERNAL_ERROR;
     }
 
-    // Serialize the USP message into a buffer
-    pbuf_len = usp__msg__get_packed_size(usp);
-    pbuf = USP_MALLOC(pbuf_len);
-    size = usp__msg__pack(usp, pbuf);
-    USP_ASSERT(size == pbuf_len);          // If these are not equal, then we may have had a buffer overrun, so terminate
+    // Serialize the USP message directly into the buffer containing the USP record
+    pack_start = MSG_STATS_GetTime();
+    buf = PackUspMsgInRecord(usp, endpoint_id, &len);
 
-    // Encapsulate this message in a USP record, then queue the record, to send to a controller
-    err = MSG_HANDLER_QueueUspRecord(usp->header->msg_type, endpoint_id, pbuf, pbuf_len, stomp_dest, stomp_instance);
-
-    // Free the serialized USP message
-    USP_FREE(pbuf);
-
-    return err;
+    // Queue the record, to send to a controller
+    return QueuePackedRecord(usp->header->msg_type, endpoint_id, buf, len, stomp_dest, stomp_instance, pack_start);
 }
 
 /*********************************************************************//**
@@ -369,13 +478,37 @@ int MSG_HANDLER_QueueMessage(char *endpoint_id, Usp__Msg *usp, char *stomp_dest,
 **
 **************************************************************************/
 int MSG_HANDLER_QueueUspRecord(Usp__Header__MsgType usp_msg_type, char *endpoint_id, unsigned char *pbuf, int pbuf_len, char *stomp_dest, int stomp_instance)
+{
+    return QueueUspRecord(usp_msg_type, endpoint_id, pbuf, pbuf_len, stomp_dest, stomp_instance, MSG_STATS_GetTime());
+}
+
+/*********************************************************************//**
+**
+** QueueUspRecord
+** 
+** Serializes a protobuf USP record structure to a buffer (with encapsulated USP message),
+** then queues it, to be sent to a controller. Also records the time taken to pack the message.
+** 
+** \param   usp_msg_type - Type of USP message contained in pbuf. This is used for debug logging when the message is sent by the MTP.
+** \param   endpoint_id - controller to send the message to
+** \param   pbuf - pointer to buffer containing serialized USP message
+**                 NOTE: Ownership of the serialized USP message stays with the caller
+** \param   pbuf_len - length of protobuf encoded USP message
+** \param   stomp_dest - STOMP destination set in 'reply-to-dest:' header, to which this message is a response
+**                       Note: If set to NULL, the STOMP destination is looked up, based on controller endpoint_id
+** \param   stomp_instance - STOMP instance (in Device.STOMP.Connection table) to send the reply to
+** \param   pack_start - time at which packing of the USP message started (from MSG_STATS_GetTime())
+** 
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int QueueUspRecord(Usp__Header__MsgType usp_msg_type, char *endpoint_id, unsigned char *pbuf, int pbuf_len, char *stomp_dest, int stomp_instance, unsigned long long pack_start)
 {
     UspRecord__Record rec;
     UspRecord__NoSessionContextRecord ctx;
     unsigned char *buf;
     int len;
     int size;
-    int err;
 
     // Exit if no controller setup to send the message to
     if (endpoint_id == NULL)
@@ -385,21 +518,7 @@ int MSG_HANDLER_QueueUspRecord(Usp__Header__MsgType usp_msg_type, char *endpoint
 
     // Fill in the USP Record structure
     // NOTE: This is all statically allocated (or owned elsewhere), so no need to free
-    usp_record__record__init(&rec);
-    rec.version = "1.0";
-    rec.to_id = endpoint_id;
-    rec.from_id = DEVICE_LOCAL_AGENT_GetEndpointID();
-    rec.payload_security = USP_RECORD__RECORD__PAYLOAD_SECURITY__PLAINTEXT;
-    rec.mac_signature.data = NULL;
-    rec.mac_signature.len = 0;
-    rec.sender_cert.data = NULL;
-    rec.sender_cert.len = 0;
-    rec.record_type_case = USP_RECORD__RECORD__RECORD_TYPE_NO_SESSION_CONTEXT;
-
-    usp_record__no_session_context_record__init(&ctx);
-    ctx.payload.data = pbuf;
-    ctx.payload.len = pbuf_len;
-    rec.no_session_context = &ctx;
+    InitUspRecord(&rec, &ctx, endpoint_id, pbuf, pbuf_len);
 
     // Serialize the protobuf record structure into a buffer
     len = usp_record__record__get_packed_size(&rec);
@@ -407,6 +526,41 @@ int MSG_HANDLER_QueueUspRecord(Usp__Header__MsgType usp_msg_type, char *endpoint
     size = usp_record__record__pack(&rec, buf);
     USP_ASSERT(size == len);          // If these are not equal, then we may have had a buffer overrun, so terminate
 
+    return QueuePackedRecord(usp_msg_type, endpoint_id, buf, len, stomp_dest, stomp_instance, pack_start);
+}
+
+/*********************************************************************//**
+**
+** QueuePackedRecord
+** 
+** Queues a serialized USP record, to be sent to a controller. Also records the time taken to pack the record.
+** 
+** \param   usp_msg_type - Type of USP message contained in the record. This is used for debug logging when the message is sent by the MTP.
+** \param   endpoint_id - controller to send the message to
+** \param   buf - pointer to buffer containing serialized USP record
+**                NOTE: Ownership of this buffer passes to this function
+** \param   len - length of serialized USP record
+** \param   stomp_dest - STOMP destination set in 'reply-to-dest:' header, to which this message is a response
+**                       Note: If set to NULL, the STOMP destination is looked up, based on controller endpoint_id
+** \param   stomp_instance - STOMP instance (in Device.STOMP.Connection table) to send the reply to
+** \param   pack_start - time at which packing of the USP message started (from MSG_STATS_GetTime())
+** 
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int QueuePackedRecord(Usp__Header__MsgType usp_msg_type, char *endpoint_id, unsigned char *buf, int len, char *stomp_dest, int stomp_instance, unsigned long long pack_start)
+{
+    int err;
+    unsigned long long pack_time;
+
+    // Record the time taken to pack the USP message and record
+    pack_time = MSG_STATS_GetTimeSince(pack_start);
+    if (pack_time != 0)
+    {
+        cur_msg_pack_time += pack_time;
+        MSG_STATS_Record(MSG_STATS_GetSlot(endpoint_id), usp_msg_type, kMsgStatsStage_Pack, pack_time);
+    }
+
     // Exit if unable to queue the message, to send to a controller
     // NOTE: If successful, ownership of the buffer passes to the MTP layer. If not successful, buffer is freed here
     err = DEVICE_CONTROLLER_QueueBinaryMessage(usp_msg_type, endpoint_id, buf, len, stomp_dest, stomp_instance);
@@ -419,6 +573,147 @@ int MSG_HANDLER_QueueUspRecord(Usp__Header__MsgType usp_msg_type, char *endpoint
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** PackUspMsgInRecord
+** 
+** Serializes a USP message, encapsulated in a USP record, into a single buffer
+** The USP message is packed directly into its final position in the USP record, avoiding
+** serializing the USP message into an intermediate buffer, then copying it into the USP record
+** 
+** \param   usp - pointer to protobuf-c structure describing the USP message to send
+** \param   endpoint_id - controller to send the message to
+** \param   record_len - pointer to variable in which to return the length of the serialized USP record
+** 
+** \return  pointer to dynamically allocated buffer containing the serialized USP record
+**
+**************************************************************************/
+unsigned char *PackUspMsgInRecord(Usp__Msg *usp, char *endpoint_id, int *record_len)
+{
+    UspRecord__Record rec;
+    UspRecord__NoSessionContextRecord ctx;
+    unsigned char *buf;
+    unsigned char *p;
+    int msg_len;
+    int ctx_len;
+    int prefix_len;
+    int len;
+    int size;
+
+    // Calculate the size of the record, without the payload
+    // NOTE: The payload (no_session_context) is the last field in the record, so it is serialized last. 
+    // Without the USP message, it is serialized as the field's tag, followed by a length of 0
+    InitUspRecord(&rec, &ctx, endpoint_id, NULL, 0);
+    prefix_len = usp_record__record__get_packed_size(&rec) - 1;     // Minus 1 to remove the zero length of the no_session_context field
+
+    // Calculate the size of the record, including the USP message
+    msg_len = usp__msg__get_packed_size(usp);
+    ctx_len = 1 + VarintSize(msg_len) + msg_len;       // 1 byte for the tag of the payload field in no_session_context
+    len = prefix_len + VarintSize(ctx_len) + ctx_len;
+
+    // Serialize the record, without the payload
+    buf = USP_MALLOC(len);
+    size = usp_record__record__pack(&rec, buf);
+    USP_ASSERT((size == prefix_len + 1) && (buf[prefix_len] == 0));    // If not, then the record has not been serialized in the expected format
+
+    // Overwrite the zero length of the no_session_context field with the actual length, then add the payload field's header
+    p = &buf[prefix_len];
+    p += PackVarint(ctx_len, p);
+    *p++ = (NO_SESSION_CONTEXT_PAYLOAD_FIELD << 3) | PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED;
+    p += PackVarint(msg_len, p);
+
+    // Serialize the USP message, directly into the record
+    size = usp__msg__pack(usp, p);
+    USP_ASSERT((size == msg_len) && (&p[size] == &buf[len]));    // If these are not equal, then we may have had a buffer overrun, so terminate
+
+    *record_len = len;
+    return buf;
+}
+
+/*********************************************************************//**
+**
+** InitUspRecord
+** 
+** Fills in the structures describing a USP record, sent by this agent to the specified controller
+** 
+** \param   rec - pointer to USP record structure to fill in
+** \param   ctx - pointer to no session context structure to fill in
+** \param   endpoint_id - controller to send the message to
+** \param   pbuf - pointer to buffer containing serialized USP message
+** \param   pbuf_len - length of protobuf encoded USP message
+** 
+** \return  None
+**
+**************************************************************************/
+void InitUspRecord(UspRecord__Record *rec, UspRecord__NoSessionContextRecord *ctx, char *endpoint_id, unsigned char *pbuf, int pbuf_len)
+{
+    usp_record__record__init(rec);
+    rec->version = "1.0";
+    rec->to_id = endpoint_id;
+    rec->from_id = DEVICE_LOCAL_AGENT_GetEndpointID();
+    rec->payload_security = USP_RECORD__RECORD__PAYLOAD_SECURITY__PLAINTEXT;
+    rec->mac_signature.data = NULL;
+    rec->mac_signature.len = 0;
+    rec->sender_cert.data = NULL;
+    rec->sender_cert.len = 0;
+    rec->record_type_case = USP_RECORD__RECORD__RECORD_TYPE_NO_SESSION_CONTEXT;
+
+    usp_record__no_session_context_record__init(ctx);
+    ctx->payload.data = pbuf;
+    ctx->payload.len = pbuf_len;
+    rec->no_session_context = ctx;
+}
+
+/*********************************************************************//**
+**
+** PackVarint
+** 
+** Serializes the specified value as a protobuf varint
+** 
+** \param   value - value to serialize
+** \param   buf - pointer to buffer in which to serialize the value. This must have space for VarintSize(value) bytes
+** 
+** \return  Number of bytes written to the buffer
+**
+**************************************************************************/
+int PackVarint(unsigned value, unsigned char *buf)
+{
+    int len = 0;
+
+    while (value >= 0x80)
+    {
+        buf[len++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    buf[len++] = value;
+
+    return len;
+}
+
+/*********************************************************************//**
+**
+** VarintSize
+** 
+** Returns the number of bytes needed to serialize the specified value as a protobuf varint
+** 
+** \param   value - value to serialize
+** 
+** \return  Number of bytes needed
+**
+**************************************************************************/
+int VarintSize(unsigned value)
+{
+    int len = 1;
+
+    while (value >= 0x80)
+    {
+        len++;
+        value >>= 7;
+    }
+
+    return len;
+}
+
 /*********************************************************************//**
 **
 ** MSG_HANDLER_GetMsgControllerInstance
@@ -516,13 +811,17 @@ char *MSG_HANDLER_UspMsgTypeToString(int msg_type)
 ** \param   controller_endpoint - endpoint which sent this message
 ** \param   stomp_dest - STOMP destination to send the reply to (or NULL if none setup in received message)
 ** \param   stomp_instance - STOMP instance (in Device.STOMP.Connection table) to send the reply to
+** \param   unpack_time - time taken to unpack the message (in microseconds), or 0 if message statistics are disabled
 **
 ** \return  USP_ERR_OK if successful, anything else causes the caller to terminate the connection to the controller, and retry
 **
 **************************************************************************/
-int HandleUspMessage(Usp__Msg *usp, char *controller_endpoint, char *stomp_dest, int stomp_instance)
+int HandleUspMessage(Usp__Msg *usp, char *controller_endpoint, char *stomp_dest, int stomp_instance, unsigned long long unpack_time)
 {
     char buf[MAX_ISO8601_LEN];
+    unsigned long long handle_start;
+    unsigned long long handle_time;
+    int slot;
 
     // Ignore the message if it came from a controller which we do not recognise
     cur_msg_controller_instance = DEVICE_CONTROLLER_FindInstanceByEndpointId(controller_endpoint);
@@ -547,6 +846,8 @@ int HandleUspMessage(Usp__Msg *usp, char *controller_endpoint, char *stomp_dest,
                 iso8601_cur_time(buf, sizeof(buf)) );
 
     // Process the message
+    handle_start = MSG_STATS_GetTime();
+    cur_msg_pack_time = 0;
     switch(usp->header->msg_type)
     {
         case USP__HEADER__MSG_TYPE__GET:
@@ -590,6 +891,19 @@ int HandleUspMessage(Usp__Msg *usp, char *controller_endpoint, char *stomp_dest,
             break;
     }
 
+    // Record the time taken to unpack and handle the message (excluding the time taken to pack the response)
+    handle_time = MSG_STATS_GetTimeSince(handle_start);
+    if (handle_time != 0)
+    {
+        slot = MSG_STATS_GetSlot(controller_endpoint);
+        if (unpack_time != 0)
+        {
+            MSG_STATS_Record(slot, usp->header->msg_type, kMsgStatsStage_Unpack, unpack_time);
+        }
+        handle_time = (handle_time > cur_msg_pack_time) ? handle_time - cur_msg_pack_time : 0;
+        MSG_STATS_Record(slot, usp->header->msg_type, kMsgStatsStage_Handle, handle_time);
+    }
+
 exit:
     cur_msg_controller_instance = INVALID;
 
@@ -675,6 +989,231 @@ bool IsValidUspRecord(UspRecord__Record *rec)
     return true;
 }
 
+/*********************************************************************//**
+**
+** PreScanUspRecord
+**
+** Performs a lightweight scan of the protobuf encoding of a received USP record, to determine whether it
+** can be rejected without the cost of unpacking it (and the USP message which it contains)
+** The scan only looks at the top level fields of the USP record, and does not allocate any memory.
+** The checks performed are a subset of IsValidUspRecord(), plus checks that the message is from a known controller,
+** which has not exceeded its inbound rate limit
+**
+** \param   pbuf - pointer to buffer containing protobuf encoded USP record
+** \param   pbuf_len - length of protobuf encoded USP record
+**
+** \return  result of the pre-scan
+**
+**************************************************************************/
+prescan_result_t PreScanUspRecord(unsigned char *pbuf, int pbuf_len)
+{
+    unsigned char *p = pbuf;
+    unsigned char *end = &pbuf[pbuf_len];
+    unsigned long long tag;
+    unsigned long long value;
+    int field_num;
+    int wire_type;
+    int len;
+    unsigned char *version = NULL;
+    int version_len = 0;
+    unsigned char *to_id = NULL;
+    int to_id_len = 0;
+    unsigned char *from_id = NULL;
+    int from_id_len = 0;
+    unsigned long long payload_security = 0;
+    int record_type = 0;
+    int payload_len = 0;
+    char endpoint_id[MAX_DM_SHORT_VALUE_LEN];
+
+    // Iterate over all top level fields in the USP record
+    while (p < end)
+    {
+        // Exit if unable to parse the field's tag
+        len = ScanVarint(p, end-p, &tag);
+        if (len == 0)
+        {
+            return kPreScan_Malformed;
+        }
+        p += len;
+        field_num = (int)(tag >> 3);
+        wire_type = (int)(tag & 7);
+
+        switch(wire_type)
+        {
+            case PROTOBUF_C_WIRE_TYPE_VARINT:
+                len = ScanVarint(p, end-p, &value);
+                if (len == 0)
+                {
+                    return kPreScan_Malformed;
+                }
+                p += len;
+
+                if (field_num == RECORD_PAYLOAD_SECURITY_FIELD)
+                {
+                    payload_security = value;
+                }
+                break;
+
+            case PROTOBUF_C_WIRE_TYPE_LENGTH_PREFIXED:
+                len = ScanVarint(p, end-p, &value);
+                if ((len == 0) || (value > end-p-len))
+                {
+                    return kPreScan_Malformed;
+                }
+                p += len;
+
+                switch(field_num)
+                {
+                    case RECORD_VERSION_FIELD:
+                        version = p;
+                        version_len = (int) value;
+                        break;
+
+                    case RECORD_TO_ID_FIELD:
+                        to_id = p;
+                        to_id_len = (int) value;
+                        break;
+
+                    case RECORD_FROM_ID_FIELD:
+                        from_id = p;
+                        from_id_len = (int) value;
+                        break;
+
+                    case RECORD_NO_SESSION_CONTEXT_FIELD:
+                    case RECORD_SESSION_CONTEXT_FIELD:
+                        // NOTE: These fields are a oneof, so the last one in the record is the one used
+                        record_type = field_num;
+                        payload_len = (int) value;
+                        break;
+
+                    default:
+                        break;
+                }
+                p += value;
+                break;
+
+            case PROTOBUF_C_WIRE_TYPE_64BIT:
+                if (end - p < 8)
+                {
+                    return kPreScan_Malformed;
+                }
+                p += 8;
+                break;
+
+            case PROTOBUF_C_WIRE_TYPE_32BIT:
+                if (end - p < 4)
+                {
+                    return kPreScan_Malformed;
+                }
+                p += 4;
+                break;
+
+            default:
+                return kPreScan_Malformed;
+                break;
+        }
+    }
+
+    // Exit if unsupported version
+    if (IsFieldEqual(version, version_len, "1.0") == false)
+    {
+        USP_LOG_Warning("%s: WARNING: Ignoring USP record with unsupported version (%.*s)", __FUNCTION__, version_len, (char *)version);
+        return kPreScan_Ignore;
+    }
+
+    // Exit if this record is not supposed to be processed by us
+    if (IsFieldEqual(to_id, to_id_len, DEVICE_LOCAL_AGENT_GetEndpointID()) == false)
+    {
+        USP_LOG_Warning("%s: WARNING: Ignoring USP record as it was addressed to endpoint_id=%.*s", __FUNCTION__, to_id_len, (char *)to_id);
+        return kPreScan_Ignore;
+    }
+
+    // Exit if this record contains an encrypted payload
+    if (payload_security != USP_RECORD__RECORD__PAYLOAD_SECURITY__PLAINTEXT)
+    {
+        USP_LOG_Warning("%s: WARNING: Ignoring USP record as it contains an encrypted payload", __FUNCTION__);
+        return kPreScan_Ignore;
+    }
+
+    // Exit if this record does not contain a payload, or contains an End-to-End Session Context (which we don't yet support)
+    if ((record_type != RECORD_NO_SESSION_CONTEXT_FIELD) || (payload_len == 0))
+    {
+        USP_LOG_Warning("%s: WARNING: Ignoring USP record as it does not contain a payload without session context", __FUNCTION__);
+        return kPreScan_Ignore;
+    }
+
+    // Exit if no USP destination to send the message back to
+    if ((from_id == NULL) || (from_id_len == 0) || (from_id_len >= sizeof(endpoint_id)))
+    {
+        USP_LOG_Warning("%s: WARNING: Ignoring USP record as from_id is blank or too long", __FUNCTION__);
+        return kPreScan_Ignore;
+    }
+
+    // Exit if the record is from an unknown controller, or one which has exceeded its rate limit
+    memcpy(endpoint_id, from_id, from_id_len);
+    endpoint_id[from_id_len] = '\0';
+    if (DEVICE_CONTROLLER_IsInboundMessageAllowed(endpoint_id) == false)
+    {
+        return kPreScan_Ignore;
+    }
+
+    return kPreScan_Ok;
+}
+
+/*********************************************************************//**
+**
+** ScanVarint
+**
+** Parses a protobuf varint from the specified buffer
+**
+** \param   buf - pointer to buffer containing the varint
+** \param   len - number of bytes remaining in the buffer
+** \param   value - pointer to variable in which to return the value of the varint
+**
+** \return  Number of bytes occupied by the varint, or 0 if the varint is truncated or too long
+**
+**************************************************************************/
+int ScanVarint(unsigned char *buf, int len, unsigned long long *value)
+{
+    unsigned long long result = 0;
+    int i;
+
+    for (i=0; (i < len) && (i < 10); i++)
+    {
+        result |= ((unsigned long long)(buf[i] & 0x7F)) << (7*i);
+        if ((buf[i] & 0x80) == 0)
+        {
+            *value = result;
+            return i+1;
+        }
+    }
+
+    return 0;
+}
+
+/*********************************************************************//**
+**
+** IsFieldEqual
+**
+** Determines whether a (non NULL terminated) string field in a protobuf encoding matches the specified string
+**
+** \param   field - pointer to string field in the protobuf encoding, or NULL if the field was not present
+** \param   field_len - length of the string field
+** \param   str - pointer to string to compare against
+**
+** \return  true if the strings match
+**
+**************************************************************************/
+bool IsFieldEqual(unsigned char *field, int field_len, char *str)
+{
+    if (field == NULL)
+    {
+        return false;
+    }
+
+    return (strlen(str) == field_len) && (memcmp(field, str, field_len) == 0);
+}
+
 /*********************************************************************//**
 **
 ** CacheControllerRoleForCurMsg
@@ -54,6 +54,7 @@ typedef int (*paramerror_extractor_t)(Usp__Msg *src_msg, Usp__Msg *err_msg);
 //------------------------------------------------------------------------------
 // API functions
 int MSG_HANDLER_HandleBinaryRecord(unsigned char *pbuf, int pbuf_len, ctrust_role_t role, char *allowed_controllers, char *stomp_dest, int stomp_instance);
+unsigned MSG_HANDLER_GetRecordsRejected(void);
 int MSG_HANDLER_HandleBinaryMessage(unsigned char *pbuf, int pbuf_len, ctrust_role_t role, char *allowed_controllers, char *controller_endpoint, char *stomp_dest, int stomp_instance);
 void MSG_HANDLER_LogMessageToSend(Usp__Header__MsgType usp_msg_type, unsigned char *pbuf, int pbuf_len, mtp_protocol_t protocol, char *host, unsigned char *stomp_header);
 int MSG_HANDLER_QueueMessage(char *endpoint_id, Usp__Msg *usp, char *stomp_dest, int stomp_instance);
@@ -0,0 +1,602 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file msg_stats.c
+ *
+ * Collects latency histograms of USP messages, broken down by controller, message type and processing stage
+ * The histograms are exposed via the CLI ('dump msgstats') and via the data model (Device.LocalAgent.Controller.{i}.X_ARRIS-COM_MessageStats)
+ *
+ * NOTE: Collection is disabled by default (Device.LocalAgent.X_ARRIS-COM_MessageStats.Enable).
+ *       When disabled, the only overhead is a call to MSG_STATS_GetTime() per processing stage
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "common_defs.h"
+#include "data_model.h"
+#include "device.h"
+#include "usp_api.h"
+#include "dm_access.h"
+#include "msg_stats.h"
+
+
+//------------------------------------------------------------------------------
+// Location of the message statistics objects within the data model
+#define MSG_STATS_ROOT "Device.LocalAgent.X_ARRIS-COM_MessageStats"
+#define MSG_STATS_CONTROLLER_ROOT "Device.LocalAgent.Controller.{i}.X_ARRIS-COM_MessageStats"
+
+//------------------------------------------------------------------------------
+// Histogram buckets. Bucket 0 counts times of less than MIN_BUCKET_TIME microseconds,
+// each subsequent bucket covers twice the range of the previous, and the last bucket counts everything longer
+#define MIN_BUCKET_TIME 16              // in microseconds
+#define NUM_BUCKETS 20                  // Last bucket counts times of 4.2 seconds or more
+
+//------------------------------------------------------------------------------
+// Number of USP message types (Usp__Header__MsgType) that statistics are collected for
+#define NUM_MSG_TYPES (USP__HEADER__MSG_TYPE__GET_SUPPORTED_PROTO_RESP+1)
+
+//------------------------------------------------------------------------------
+// Histogram for a single processing stage of a single message type
+typedef struct
+{
+    unsigned count;                     // Number of times that have been recorded
+    unsigned long long total_time;      // Sum of all times recorded (in microseconds)
+    unsigned buckets[NUM_BUCKETS];      // Number of times recorded in each bucket
+} msg_stats_histogram_t;
+
+//------------------------------------------------------------------------------
+// Statistics collected for each controller
+// NOTE: The last slot is used for messages whose controller could not be allocated a slot
+typedef struct
+{
+    bool in_use;
+    char endpoint_id[MAX_DM_SHORT_VALUE_LEN];
+    msg_stats_histogram_t hist[NUM_MSG_TYPES][kMsgStatsStage_Max];
+} msg_stats_slot_t;
+
+#define NUM_SLOTS (MAX_CONTROLLERS+1)
+static msg_stats_slot_t msg_stats_slots[NUM_SLOTS];
+
+//------------------------------------------------------------------------------
+// Whether statistics are being collected (Device.LocalAgent.X_ARRIS-COM_MessageStats.Enable)
+// NOTE: Counters are updated using atomic operations, because the queue-to-wire stage is recorded by the MTP thread
+//       All other accesses (including allocation of slots) occur on the data model thread
+static bool msg_stats_enabled = false;
+
+//------------------------------------------------------------------------------
+// Table describing each USP message type in the data model
+// Requests (sent by a controller) record the Unpack and Handle stages. All other messages (sent by the agent) record the Pack and QueueToWire stages
+typedef struct
+{
+    Usp__Header__MsgType msg_type;
+    char *name;
+    bool is_received;
+} msg_stats_type_t;
+
+static msg_stats_type_t msg_stats_types[] =
+{
+    { USP__HEADER__MSG_TYPE__GET,                       "Get",                      true },
+    { USP__HEADER__MSG_TYPE__SET,                       "Set",                      true },
+    { USP__HEADER__MSG_TYPE__ADD,                       "Add",                      true },
+    { USP__HEADER__MSG_TYPE__DELETE,                    "Delete",                   true },
+    { USP__HEADER__MSG_TYPE__OPERATE,                   "Operate",                  true },
+    { USP__HEADER__MSG_TYPE__NOTIFY_RESP,               "NotifyResp",               true },
+    { USP__HEADER__MSG_TYPE__GET_SUPPORTED_DM,          "GetSupportedDM",           true },
+    { USP__HEADER__MSG_TYPE__GET_INSTANCES,             "GetInstances",             true },
+    { USP__HEADER__MSG_TYPE__GET_SUPPORTED_PROTO,       "GetSupportedProtocol",     true },
+    { USP__HEADER__MSG_TYPE__GET_RESP,                  "GetResp",                  false },
+    { USP__HEADER__MSG_TYPE__SET_RESP,                  "SetResp",                  false },
+    { USP__HEADER__MSG_TYPE__ADD_RESP,                  "AddResp",                  false },
+    { USP__HEADER__MSG_TYPE__DELETE_RESP,               "DeleteResp",               false },
+    { USP__HEADER__MSG_TYPE__OPERATE_RESP,              "OperateResp",              false },
+    { USP__HEADER__MSG_TYPE__NOTIFY,                    "Notify",                   false },
+    { USP__HEADER__MSG_TYPE__GET_SUPPORTED_DM_RESP,     "GetSupportedDMResp",       false },
+    { USP__HEADER__MSG_TYPE__GET_INSTANCES_RESP,        "GetInstancesResp",         false },
+    { USP__HEADER__MSG_TYPE__GET_SUPPORTED_PROTO_RESP,  "GetSupportedProtocolResp", false },
+    { USP__HEADER__MSG_TYPE__ERROR,                     "Error",                    false },
+};
+
+//------------------------------------------------------------------------------
+// Names of each processing stage in the data model
+static char *msg_stats_stage_names[kMsgStatsStage_Max] =
+{
+    "Unpack",           // kMsgStatsStage_Unpack
+    "Handle",           // kMsgStatsStage_Handle
+    "Pack",             // kMsgStatsStage_Pack
+    "QueueToWire",      // kMsgStatsStage_QueueToWire
+};
+
+//------------------------------------------------------------------------------
+// Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
+int NotifyChange_MsgStatsEnable(dm_req_t *req, char *value);
+int Get_MsgStatsHistogram(dm_req_t *req, char *buf, int len);
+int FindMsgStatsSlot(char *endpoint_id);
+msg_stats_type_t *FindMsgStatsType(char *name);
+int CalcMsgStatsBucket(unsigned long long time_taken);
+void FormMsgStatsHistogram(msg_stats_histogram_t *h, char *buf, int len);
+
+/*********************************************************************//**
+**
+** MSG_STATS_Init
+**
+** Initialises this component, and registers all parameters which it implements
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int MSG_STATS_Init(void)
+{
+    int err = USP_ERR_OK;
+    int i;
+    int j;
+    int len;
+    unsigned long long bound;
+    msg_stats_type_t *mt;
+    char buf[MAX_DM_SHORT_VALUE_LEN];
+    char path[MAX_DM_PATH];
+
+    memset(msg_stats_slots, 0, sizeof(msg_stats_slots));
+
+    // Form the list of upper bounds of each histogram bucket (the last bucket has no upper bound)
+    len = 0;
+    bound = MIN_BUCKET_TIME;
+    for (i=0; i<NUM_BUCKETS-1; i++)
+    {
+        len += USP_SNPRINTF(&buf[len], sizeof(buf)-len, "%s%llu", (i==0) ? "" : ",", bound);
+        bound *= 2;
+    }
+
+    // Register global parameters
+    err |= USP_REGISTER_DBParam_ReadWrite(MSG_STATS_ROOT ".Enable", "false", NULL, NotifyChange_MsgStatsEnable, DM_BOOL);
+    err |= USP_REGISTER_Param_Constant(MSG_STATS_ROOT ".BucketUpperBounds", buf, DM_STRING);
+
+    // Register a histogram parameter for each message type and stage, for each controller
+    for (i=0; i<NUM_ELEM(msg_stats_types); i++)
+    {
+        mt = &msg_stats_types[i];
+        for (j=0; j<kMsgStatsStage_Max; j++)
+        {
+            // Skip stages which are not relevant to this message type
+            if ((mt->is_received) != ((j==kMsgStatsStage_Unpack) || (j==kMsgStatsStage_Handle)))
+            {
+                continue;
+            }
+
+            USP_SNPRINTF(path, sizeof(path), "%s.%s.%s", MSG_STATS_CONTROLLER_ROOT, mt->name, msg_stats_stage_names[j]);
+            err |= USP_REGISTER_VendorParam_ReadOnly(path, Get_MsgStatsHistogram, DM_STRING);
+        }
+    }
+
+    // Exit if any errors occurred
+    if (err != USP_ERR_OK)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // If the code gets here, then registration was successful
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** MSG_STATS_Start
+**
+** Starts this component, reading whether statistics collection is enabled from the database
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int MSG_STATS_Start(void)
+{
+    int err;
+
+    err = DM_ACCESS_GetBool(MSG_STATS_ROOT ".Enable", &msg_stats_enabled);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** MSG_STATS_GetTime
+**
+** Returns a timestamp to use for timing a processing stage, or 0 if statistics are not being collected
+** Callers skip calling MSG_STATS_Record() if this returns 0
+**
+** \param   None
+**
+** \return  monotonic time in microseconds, or 0 if statistics collection is disabled
+**
+**************************************************************************/
+unsigned long long MSG_STATS_GetTime(void)
+{
+    struct timespec ts;
+
+    // Exit if statistics are not being collected
+    if (msg_stats_enabled == false)
+    {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((unsigned long long)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000) + 1;   // NOTE: +1 ensures that this never returns 0
+}
+
+/*********************************************************************//**
+**
+** MSG_STATS_GetTimeSince
+**
+** Returns the time elapsed since a timestamp returned by MSG_STATS_GetTime()
+**
+** \param   start_time - timestamp returned by MSG_STATS_GetTime()
+**
+** \return  elapsed time in microseconds, or 0 if statistics collection is (or was, at start_time) disabled
+**
+**************************************************************************/
+unsigned long long MSG_STATS_GetTimeSince(unsigned long long start_time)
+{
+    unsigned long long cur_time;
+
+    // Exit if statistics were not being collected at the start time
+    if (start_time == 0)
+    {
+        return 0;
+    }
+
+    // Exit if statistics are not being collected now
+    cur_time = MSG_STATS_GetTime();
+    if (cur_time == 0)
+    {
+        return 0;
+    }
+
+    // NOTE: A time of 0 is returned as 1, so that the caller can distinguish it from statistics being disabled
+    return (cur_time > start_time) ? cur_time - start_time : 1;
+}
+
+/*********************************************************************//**
+**
+** MSG_STATS_GetSlot
+**
+** Returns the slot in which to collect statistics for the specified controller, allocating a slot if necessary
+** NOTE: This function must only be called from the data model thread
+**
+** \param   endpoint_id - endpoint_id of the controller
+**
+** \return  index of the slot to use
+**
+**************************************************************************/
+int MSG_STATS_GetSlot(char *endpoint_id)
+{
+    int i;
+    msg_stats_slot_t *slot;
+
+    // Exit if this controller has already been allocated a slot
+    i = FindMsgStatsSlot(endpoint_id);
+    if (i != INVALID)
+    {
+        return i;
+    }
+
+    // Allocate a free slot to this controller
+    for (i=0; i<NUM_SLOTS-1; i++)
+    {
+        slot = &msg_stats_slots[i];
+        if (slot->in_use == false)
+        {
+            USP_STRNCPY(slot->endpoint_id, endpoint_id, sizeof(slot->endpoint_id));
+            slot->in_use = true;
+            return i;
+        }
+    }
+
+    // If the code gets here, then all slots are in use, so use the overflow slot
+    return NUM_SLOTS-1;
+}
+
+/*********************************************************************//**
+**
+** MSG_STATS_Record
+**
+** Records the time taken by a processing stage of a USP message
+** NOTE: This function may be called from the data model thread or the MTP thread
+**
+** \param   slot - slot of the controller which sent (or will receive) the message. See MSG_STATS_GetSlot()
+** \param   msg_type - type of the USP message
+** \param   stage - processing stage that was timed
+** \param   time_taken - time taken by the processing stage (in microseconds)
+**
+** \return  None
+**
+**************************************************************************/
+void MSG_STATS_Record(int slot, Usp__Header__MsgType msg_type, msg_stats_stage_t stage, unsigned long long time_taken)
+{
+    msg_stats_histogram_t *h;
+
+    // Exit if the message type or slot is not one that we collect statistics for
+    if ((msg_type < 0) || (msg_type >= NUM_MSG_TYPES) || (slot < 0) || (slot >= NUM_SLOTS))
+    {
+        return;
+    }
+
+    h = &msg_stats_slots[slot].hist[msg_type][stage];
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->total_time, time_taken, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->buckets[ CalcMsgStatsBucket(time_taken) ], 1, __ATOMIC_RELAXED);
+}
+
+/*********************************************************************//**
+**
+** MSG_STATS_Dump
+**
+** Logs all non-empty histograms
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void MSG_STATS_Dump(void)
+{
+    int i;
+    int j;
+    int k;
+    msg_stats_slot_t *slot;
+    msg_stats_type_t *mt;
+    msg_stats_histogram_t *h;
+    char *endpoint_id;
+    char buf[MAX_DM_SHORT_VALUE_LEN];
+
+    if (msg_stats_enabled == false)
+    {
+        USP_DUMP("Message statistics collection is disabled (%s.Enable)", MSG_STATS_ROOT);
+    }
+
+    for (i=0; i<NUM_SLOTS; i++)
+    {
+        slot = &msg_stats_slots[i];
+        endpoint_id = (i==NUM_SLOTS-1) ? "(other)" : slot->endpoint_id;
+        for (j=0; j<NUM_ELEM(msg_stats_types); j++)
+        {
+            mt = &msg_stats_types[j];
+            for (k=0; k<kMsgStatsStage_Max; k++)
+            {
+                // Skip histograms which have no entries
+                h = &slot->hist[mt->msg_type][k];
+                if (h->count == 0)
+                {
+                    continue;
+                }
+
+                FormMsgStatsHistogram(h, buf, sizeof(buf));
+                USP_DUMP("%s %s.%s: count=%u avg=%lluus buckets=[%s]", endpoint_id, mt->name, msg_stats_stage_names[k], 
+                         h->count, h->total_time/h->count, buf);
+            }
+        }
+    }
+}
+
+/*********************************************************************//**
+**
+** NotifyChange_MsgStatsEnable
+**
+** Function called after Device.LocalAgent.X_ARRIS-COM_MessageStats.Enable is modified
+**
+** \param   req - pointer to structure identifying the path
+** \param   value - new value of this parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int NotifyChange_MsgStatsEnable(dm_req_t *req, char *value)
+{
+    msg_stats_enabled = val_bool;
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** Get_MsgStatsHistogram
+**
+** Gets the value of a Device.LocalAgent.Controller.{i}.X_ARRIS-COM_MessageStats.{MsgType}.{Stage} parameter
+** The value is a comma separated list of the number of times in each bucket (see BucketUpperBounds)
+**
+** \param   req - pointer to structure identifying the parameter
+** \param   buf - pointer to buffer into which to return the value of the parameter (as a textual string)
+** \param   len - length of buffer in which to return the value of the parameter
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int Get_MsgStatsHistogram(dm_req_t *req, char *buf, int len)
+{
+    char name[MAX_DM_PATH];
+    char *stage_name;
+    char *p;
+    char *endpoint_id;
+    msg_stats_type_t *mt;
+    msg_stats_histogram_t empty;
+    int slot;
+    int i;
+
+    // Split the last two segments of the schema path into the message type and stage
+    p = strstr(req->schema_path, "X_ARRIS-COM_MessageStats.");
+    USP_ASSERT(p != NULL);
+    USP_STRNCPY(name, &p[sizeof("X_ARRIS-COM_MessageStats.")-1], sizeof(name));
+    stage_name = strchr(name, '.');
+    USP_ASSERT(stage_name != NULL);
+    *stage_name++ = '\0';
+
+    mt = FindMsgStatsType(name);
+    USP_ASSERT(mt != NULL);
+    for (i=0; i<kMsgStatsStage_Max; i++)
+    {
+        if (strcmp(stage_name, msg_stats_stage_names[i])==0)
+        {
+            break;
+        }
+    }
+    USP_ASSERT(i < kMsgStatsStage_Max);
+
+    // Return an empty histogram, if no statistics have been collected for this controller
+    endpoint_id = DEVICE_CONTROLLER_FindEndpointIdByInstance(inst1);
+    slot = (endpoint_id == NULL) ? INVALID : FindMsgStatsSlot(endpoint_id);
+    if (slot == INVALID)
+    {
+        memset(&empty, 0, sizeof(empty));
+        FormMsgStatsHistogram(&empty, buf, len);
+        return USP_ERR_OK;
+    }
+
+    FormMsgStatsHistogram(&msg_stats_slots[slot].hist[mt->msg_type][i], buf, len);
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** FindMsgStatsSlot
+**
+** Finds the slot which has been allocated to the specified controller
+**
+** \param   endpoint_id - endpoint_id of the controller
+**
+** \return  index of the slot, or INVALID if no slot has been allocated to the controller
+**
+**************************************************************************/
+int FindMsgStatsSlot(char *endpoint_id)
+{
+    int i;
+    msg_stats_slot_t *slot;
+
+    for (i=0; i<NUM_SLOTS-1; i++)
+    {
+        slot = &msg_stats_slots[i];
+        if ((slot->in_use) && (strcmp(slot->endpoint_id, endpoint_id)==0))
+        {
+            return i;
+        }
+    }
+
+    return INVALID;
+}
+
+/*********************************************************************//**
+**
+** FindMsgStatsType
+**
+** Finds the entry in the message type table matching the specified name
+**
+** \param   name - name of the message type, as used in the data model
+**
+** \return  pointer to entry in the message type table, or NULL if no match found
+**
+**************************************************************************/
+msg_stats_type_t *FindMsgStatsType(char *name)
+{
+    int i;
+    msg_stats_type_t *mt;
+
+    for (i=0; i<NUM_ELEM(msg_stats_types); i++)
+    {
+        mt = &msg_stats_types[i];
+        if (strcmp(mt->name, name)==0)
+        {
+            return mt;
+        }
+    }
+
+    return NULL;
+}
+
+/*********************************************************************//**
+**
+** CalcMsgStatsBucket
+**
+** Calculates which histogram bucket the specified time falls into
+**
+** \param   time_taken - time (in microseconds)
+**
+** \return  index of the histogram bucket
+**
+**************************************************************************/
+int CalcMsgStatsBucket(unsigned long long time_taken)
+{
+    int bucket = 0;
+    unsigned long long bound = MIN_BUCKET_TIME;
+
+    while ((time_taken >= bound) && (bucket < NUM_BUCKETS-1))
+    {
+        bound *= 2;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+/*********************************************************************//**
+**
+** FormMsgStatsHistogram
+**
+** Forms a comma separated list of the number of times in each bucket of the specified histogram
+**
+** \param   h - pointer to histogram
+** \param   buf - pointer to buffer in which to return the string
+** \param   len - length of buffer in which to return the string
+**
+** \return  None
+**
+**************************************************************************/
+void FormMsgStatsHistogram(msg_stats_histogram_t *h, char *buf, int len)
+{
+    int i;
+    int n = 0;
+
+    buf[0] = '\0';
+    for (i=0; (i<NUM_BUCKETS) && (n<len); i++)
+    {
+        n += USP_SNPRINTF(&buf[n], len-n, "%s%u", (i==0) ? "" : ",", h->buckets[i]);
+    }
+}
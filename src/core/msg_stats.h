@@ -0,0 +1,68 @@
+/*
+ *
+ * Copyright (C) 2019, Broadband Forum
+ * Copyright (C) 2019  ARRIS Enterprises, LLC
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF 
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/**
+ * \file msg_stats.h
+ *
+ * Latency histograms of USP messages, broken down by controller, message type and processing stage
+ *
+ */
+#ifndef MSG_STATS_H
+#define MSG_STATS_H
+
+#include "usp-msg.pb-c.h"
+
+//------------------------------------------------------------------------------
+// Stages of processing of a USP message which are timed
+typedef enum
+{
+    kMsgStatsStage_Unpack,          // Unpacking the received USP record and message
+    kMsgStatsStage_Handle,          // Handling the received USP message (excluding packing of the response)
+    kMsgStatsStage_Pack,            // Packing a USP message and its USP record, ready to send
+    kMsgStatsStage_QueueToWire,     // Time from queuing a packed USP record, to it being written to the MTP connection
+
+    kMsgStatsStage_Max              // Always last enumeration, used to size arrays
+} msg_stats_stage_t;
+
+//------------------------------------------------------------------------------
+// API Functions
+int MSG_STATS_Init(void);
+int MSG_STATS_Start(void);
+unsigned long long MSG_STATS_GetTime(void);
+unsigned long long MSG_STATS_GetTimeSince(unsigned long long start_time);
+int MSG_STATS_GetSlot(char *endpoint_id);
+void MSG_STATS_Record(int slot, Usp__Header__MsgType msg_type, msg_stats_stage_t stage, unsigned long long time_taken);
+void MSG_STATS_Dump(void);
+
+#endif
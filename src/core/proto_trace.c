@@ -36,22 +36,63 @@
  * \file proto_trace.c
  *
  * Functions for pretty printing a USP message in protobuf debug format
+ * and for capturing USP records to a binary file (for offline decoding)
  *
  */
 
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
 #include <protobuf-c/protobuf-c.h>
 
 #include "common_defs.h"
 #include "proto_trace.h"
+#include "os_utils.h"
+#include "iso8601.h"
+#include "device.h"
+#include "usp-msg.pb-c.h"
+#include "usp-record.pb-c.h"
 
 // Number of spaces to use for each indentation block when printing messages in JSON format
 #define INDENTATION 2
 
+//------------------------------------------------------------------------------------
+// Capture file format
+// The file starts with CAPTURE_FILE_MAGIC, followed by the format version (32 bit, network byte order)
+// Each captured USP record is then stored as a CAPTURE_RECORD_HDR_LEN byte header, followed by the protobuf encoded USP record
+// Record header (all fields in network byte order):
+//    [0..3]   timestamp (seconds since the Unix epoch)
+//    [4..7]   timestamp (microseconds)
+//    [8]      direction (capture_dir_t)
+//    [9]      MTP protocol (mtp_protocol_t)
+//    [10..11] reserved (0)
+//    [12..15] length of the USP record (in bytes)
+#define CAPTURE_FILE_MAGIC "OBUSPCAP"
+#define CAPTURE_FILE_MAGIC_LEN (sizeof(CAPTURE_FILE_MAGIC)-1)
+#define CAPTURE_FILE_VERSION 1
+#define CAPTURE_RECORD_HDR_LEN 16
+
+// Maximum size of a USP record accepted by the decoder. Protects against decoding corrupted files
+#define MAX_CAPTURED_RECORD_LEN (16*1024*1024)
+
+//------------------------------------------------------------------------------------
+// State of the capture file
+// NOTE: The capture file is written from both the data model thread (received records) and MTP thread (sent records), hence the mutex
+static FILE *capture_fp = NULL;
+static char *capture_filename = NULL;
+static long capture_size = 0;           // Number of bytes written to the current capture file
+static pthread_mutex_t capture_mutex;
+
 //------------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 void PrintProtobufCMessageRecursive(ProtobufCMessage *msg, int indent);
 void PrintProtobufFieldRecursive(const ProtobufCFieldDescriptor *fields, void *p_value, int indent);
+int OpenCaptureFile(void);
+void RotateCaptureFile(void);
+void DecodeCapturedRecord(capture_dir_t dir, mtp_protocol_t protocol, struct timeval *tv, unsigned char *pbuf, int pbuf_len, void *arg);
 
 /*********************************************************************//**
 **
@@ -76,6 +117,390 @@ void PROTO_TRACE_ProtobufMessage(ProtobufCMessage *base)
     USP_PROTOCOL("\n");
 }
 
+/*********************************************************************//**
+**
+** PROTO_TRACE_StartCapture
+**
+** Starts capturing all USP records sent and received to the specified file
+** This is a low overhead alternative to protocol tracing: the USP records are written out in binary form (without being unpacked)
+** and may be decoded offline using the 'decode' CLI command
+** NOTE: This function must be called before any threads are started
+**
+** \param   filename - name of the file to capture to. Any existing file is overwritten.
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int PROTO_TRACE_StartCapture(char *filename)
+{
+    int err;
+
+    // Exit if unable to create the mutex protecting the capture file
+    err = OS_UTILS_InitMutex(&capture_mutex);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    USP_SAFE_FREE(capture_filename);
+    capture_filename = USP_STRDUP(filename);
+
+    // Exit if unable to create the capture file
+    err = OpenCaptureFile();
+    if (err != USP_ERR_OK)
+    {
+        USP_SAFE_FREE(capture_filename);
+        return err;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** PROTO_TRACE_StopCapture
+**
+** Stops capturing USP records, flushing any buffered records to the capture file
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void PROTO_TRACE_StopCapture(void)
+{
+    // Exit if not capturing
+    if (capture_fp == NULL)
+    {
+        return;
+    }
+
+    OS_UTILS_LockMutex(&capture_mutex);
+    fclose(capture_fp);
+    capture_fp = NULL;
+    USP_SAFE_FREE(capture_filename);
+    OS_UTILS_UnlockMutex(&capture_mutex);
+}
+
+/*********************************************************************//**
+**
+** PROTO_TRACE_CaptureRecord
+**
+** Appends the specified USP record to the capture file (if capturing)
+** NOTE: This function may be called from the data model thread or the MTP thread
+**
+** \param   dir - whether the USP record was received or is being sent
+** \param   protocol - MTP that the USP record was received on or is being sent on
+** \param   pbuf - pointer to buffer containing protobuf encoded USP record
+** \param   pbuf_len - length of protobuf encoded USP record
+**
+** \return  None
+**
+**************************************************************************/
+void PROTO_TRACE_CaptureRecord(capture_dir_t dir, mtp_protocol_t protocol, unsigned char *pbuf, int pbuf_len)
+{
+    unsigned char hdr[CAPTURE_RECORD_HDR_LEN];
+    struct timeval tv;
+    uint32_t val;
+    size_t written;
+
+    // Exit if not capturing
+    if (capture_fp == NULL)
+    {
+        return;
+    }
+
+    // Form the record header
+    gettimeofday(&tv, NULL);
+    val = htonl((uint32_t)tv.tv_sec);
+    memcpy(&hdr[0], &val, sizeof(val));
+    val = htonl((uint32_t)tv.tv_usec);
+    memcpy(&hdr[4], &val, sizeof(val));
+    hdr[8] = (unsigned char) dir;
+    hdr[9] = (unsigned char) protocol;
+    hdr[10] = 0;
+    hdr[11] = 0;
+    val = htonl((uint32_t)pbuf_len);
+    memcpy(&hdr[12], &val, sizeof(val));
+
+    OS_UTILS_LockMutex(&capture_mutex);
+
+    // Exit if capture was stopped by another thread
+    if (capture_fp == NULL)
+    {
+        goto exit;
+    }
+
+    // Write the record. NOTE: The file is fully buffered, so this does not usually result in a system call
+    written = fwrite(hdr, 1, sizeof(hdr), capture_fp);
+    written += fwrite(pbuf, 1, pbuf_len, capture_fp);
+    if (written != sizeof(hdr) + pbuf_len)
+    {
+        USP_LOG_Error("%s: Failed to write to capture file %s (%s). Stopping capture.", __FUNCTION__, capture_filename, strerror(errno));
+        fclose(capture_fp);
+        capture_fp = NULL;
+        goto exit;
+    }
+
+    // Start a new capture file, if this one has become too large
+    capture_size += written;
+    if (capture_size >= CAPTURE_MAX_FILE_SIZE)
+    {
+        RotateCaptureFile();
+    }
+
+exit:
+    OS_UTILS_UnlockMutex(&capture_mutex);
+}
+
+/*********************************************************************//**
+**
+** PROTO_TRACE_DecodeCapture
+**
+** Pretty prints all USP records contained in the specified capture file
+**
+** \param   filename - name of the capture file to decode
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int PROTO_TRACE_DecodeCapture(char *filename)
+{
+    int count = 0;
+    int err;
+
+    // Decoding prints the records using the protocol trace
+    enable_protocol_trace = true;
+
+    err = PROTO_TRACE_ReadCapture(filename, DecodeCapturedRecord, &count);
+    USP_PROTOCOL("Decoded %d USP records", count);
+
+    return err;
+}
+
+/*********************************************************************//**
+**
+** PROTO_TRACE_ReadCapture
+**
+** Reads all USP records contained in the specified capture file, calling the specified callback for each one
+**
+** \param   filename - name of the capture file to read
+** \param   record_cb - callback to call for each USP record read
+** \param   arg - argument to pass to the callback
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int PROTO_TRACE_ReadCapture(char *filename, capture_record_cb_t record_cb, void *arg)
+{
+    FILE *fp;
+    unsigned char file_hdr[CAPTURE_FILE_MAGIC_LEN + sizeof(uint32_t)];
+    unsigned char hdr[CAPTURE_RECORD_HDR_LEN];
+    unsigned char *pbuf = NULL;
+    uint32_t val;
+    struct timeval tv;
+    int len;
+    int count = 0;
+    int err = USP_ERR_OK;
+
+    // Exit if unable to open the capture file
+    fp = fopen(filename, "rb");
+    if (fp == NULL)
+    {
+        USP_ERR_SetMessage("%s: Unable to open capture file %s (%s)", __FUNCTION__, filename, strerror(errno));
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if the file is not a capture file
+    if ((fread(file_hdr, 1, sizeof(file_hdr), fp) != sizeof(file_hdr)) ||
+        (memcmp(file_hdr, CAPTURE_FILE_MAGIC, CAPTURE_FILE_MAGIC_LEN) != 0))
+    {
+        USP_ERR_SetMessage("%s: %s is not a USP record capture file", __FUNCTION__, filename);
+        err = USP_ERR_INTERNAL_ERROR;
+        goto exit;
+    }
+
+    // Exit if the capture file is of a later version than this code understands
+    memcpy(&val, &file_hdr[CAPTURE_FILE_MAGIC_LEN], sizeof(val));
+    if (ntohl(val) > CAPTURE_FILE_VERSION)
+    {
+        USP_ERR_SetMessage("%s: Unsupported capture file version (%u)", __FUNCTION__, ntohl(val));
+        err = USP_ERR_INTERNAL_ERROR;
+        goto exit;
+    }
+
+    // Iterate over all records in the file
+    while (fread(hdr, 1, sizeof(hdr), fp) == sizeof(hdr))
+    {
+        // Exit if the record length is corrupted
+        memcpy(&val, &hdr[12], sizeof(val));
+        len = (int) ntohl(val);
+        if ((len < 0) || (len > MAX_CAPTURED_RECORD_LEN))
+        {
+            USP_ERR_SetMessage("%s: Record %d has an invalid length (%d)", __FUNCTION__, count+1, len);
+            err = USP_ERR_INTERNAL_ERROR;
+            goto exit;
+        }
+
+        // Exit if the file was truncated part way through the record (eg if the agent was killed before flushing the capture file)
+        pbuf = USP_REALLOC(pbuf, (len > 0) ? len : 1);
+        if (fread(pbuf, 1, len, fp) != len)
+        {
+            USP_LOG_Warning("%s: Capture file truncated in record %d", __FUNCTION__, count+1);
+            break;
+        }
+
+        count++;
+        memcpy(&val, &hdr[0], sizeof(val));
+        tv.tv_sec = (time_t) ntohl(val);
+        memcpy(&val, &hdr[4], sizeof(val));
+        tv.tv_usec = ntohl(val) % 1000000;
+        record_cb((capture_dir_t) hdr[8], (mtp_protocol_t) hdr[9], &tv, pbuf, len, arg);
+    }
+
+exit:
+    USP_SAFE_FREE(pbuf);
+    fclose(fp);
+    return err;
+}
+
+/*********************************************************************//**
+**
+** OpenCaptureFile
+**
+** Creates the capture file, and writes the file header to it
+** NOTE: When called after the capture has started, the caller must hold the capture mutex
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int OpenCaptureFile(void)
+{
+    FILE *fp;
+    uint32_t version;
+
+    // Exit if unable to create the capture file
+    fp = fopen(capture_filename, "wb");
+    if (fp == NULL)
+    {
+        USP_ERR_SetMessage("%s: Unable to create capture file %s (%s)", __FUNCTION__, capture_filename, strerror(errno));
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Write the file header
+    version = htonl(CAPTURE_FILE_VERSION);
+    fwrite(CAPTURE_FILE_MAGIC, 1, CAPTURE_FILE_MAGIC_LEN, fp);
+    fwrite(&version, 1, sizeof(version), fp);
+
+    capture_size = CAPTURE_FILE_MAGIC_LEN + sizeof(version);
+    capture_fp = fp;
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** RotateCaptureFile
+**
+** Renames the current capture file with a '.1' suffix and starts a new capture file
+** NOTE: The caller must hold the capture mutex
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void RotateCaptureFile(void)
+{
+    char old_filename[MAX_DM_PATH];
+    int err;
+
+    fclose(capture_fp);
+    capture_fp = NULL;
+
+    USP_SNPRINTF(old_filename, sizeof(old_filename), "%s.1", capture_filename);
+    if (rename(capture_filename, old_filename) != 0)
+    {
+        USP_LOG_Error("%s: Unable to rename %s to %s (%s)", __FUNCTION__, capture_filename, old_filename, strerror(errno));
+    }
+
+    // NOTE: If unable to open the new capture file, then capturing stops
+    err = OpenCaptureFile();
+    if (err != USP_ERR_OK)
+    {
+        USP_LOG_Error("%s", USP_ERR_GetMessage());
+    }
+}
+
+/*********************************************************************//**
+**
+** DecodeCapturedRecord
+**
+** Pretty prints a single USP record (and the USP message contained in it) read from a capture file
+** This function is called by PROTO_TRACE_ReadCapture()
+**
+** \param   dir - whether the USP record was received or sent
+** \param   protocol - MTP that the USP record was received or sent on
+** \param   tv - time at which the USP record was captured
+** \param   pbuf - pointer to buffer containing protobuf encoded USP record
+** \param   pbuf_len - length of protobuf encoded USP record
+** \param   arg - pointer to count of USP records decoded
+**
+** \return  None
+**
+**************************************************************************/
+void DecodeCapturedRecord(capture_dir_t dir, mtp_protocol_t protocol, struct timeval *tv, unsigned char *pbuf, int pbuf_len, void *arg)
+{
+    UspRecord__Record *rec;
+    Usp__Msg *usp;
+    char buf[MAX_ISO8601_LEN];
+    int len;
+    int *count = (int *) arg;
+
+    (*count)++;
+
+    // Form the timestamp, inserting the microseconds before the trailing 'Z'
+    iso8601_from_unix_time(tv->tv_sec, buf, sizeof(buf));
+    len = strlen(buf);
+    if ((len > 0) && (buf[len-1] == 'Z'))
+    {
+        USP_SNPRINTF(&buf[len-1], sizeof(buf)-len+1, ".%06uZ", (unsigned) tv->tv_usec);
+    }
+
+    USP_PROTOCOL("\n%s %s %s (%d bytes)", buf,
+                 (dir == kCaptureDir_Sent) ? "SENT over" : "RECEIVED on",
+                 (protocol < kMtpProtocol_Max) ? DEVICE_MTP_EnumToString(protocol) : "UNKNOWN", pbuf_len);
+
+    // Exit if unable to unpack the USP record
+    rec = usp_record__record__unpack(pbuf_allocator, pbuf_len, pbuf);
+    if (rec == NULL)
+    {
+        USP_PROTOCOL("ERROR: Unable to unpack USP record");
+        return;
+    }
+
+    PROTO_TRACE_ProtobufMessage(&rec->base);
+
+    // Print the encapsulated USP message (if any)
+    if ((rec->record_type_case == USP_RECORD__RECORD__RECORD_TYPE_NO_SESSION_CONTEXT) &&
+        (rec->no_session_context != NULL) && (rec->no_session_context->payload.data != NULL))
+    {
+        usp = usp__msg__unpack(pbuf_allocator, rec->no_session_context->payload.len, rec->no_session_context->payload.data);
+        if (usp != NULL)
+        {
+            PROTO_TRACE_ProtobufMessage(&usp->base);
+            usp__msg__free_unpacked(usp, pbuf_allocator);
+        }
+        else
+        {
+            USP_PROTOCOL("ERROR: Unable to unpack USP message");
+        }
+    }
+
+    usp_record__record__free_unpacked(rec, pbuf_allocator);
+}
+
 /*********************************************************************//**
 **
 ** PrintProtobufCMessageRecursive
@@ -36,16 +36,37 @@
  * \file proto_trace.h
  *
  * Functions for pretty printing a USP message in protobuf debug format
+ * and for capturing USP records to a binary file (for offline decoding)
  *
  */
 #ifndef PROTO_TRACE_H
 #define PROTO_TRACE_H
 
 #include <protobuf-c/protobuf-c.h>
+#include <sys/time.h>
+
+#include "mtp_exec.h"
+
+//------------------------------------------------------------------------------
+// Direction of a captured USP record
+typedef enum
+{
+    kCaptureDir_Received,       // USP record received from a controller
+    kCaptureDir_Sent,           // USP record sent to a controller
+} capture_dir_t;
+
+//------------------------------------------------------------------------------
+// Typedef for callback called by PROTO_TRACE_ReadCapture() for each USP record in a capture file
+typedef void (*capture_record_cb_t)(capture_dir_t dir, mtp_protocol_t protocol, struct timeval *tv, unsigned char *pbuf, int pbuf_len, void *arg);
 
 //------------------------------------------------------------------------------
 // API Functions
 void PROTO_TRACE_ProtobufMessage(ProtobufCMessage *msg);
+int PROTO_TRACE_StartCapture(char *filename);
+void PROTO_TRACE_StopCapture(void);
+void PROTO_TRACE_CaptureRecord(capture_dir_t dir, mtp_protocol_t protocol, unsigned char *pbuf, int pbuf_len);
+int PROTO_TRACE_DecodeCapture(char *filename);
+int PROTO_TRACE_ReadCapture(char *filename, capture_record_cb_t record_cb, void *arg);
 
 
 #endif
@@ -68,6 +68,7 @@
 #include "mtp_exec.h"
 #include "msg_handler.h"
 #include "proto_trace.h"
+#include "msg_stats.h"
 #include "data_model.h"
 #include "iso8601.h"
 #include "text_utils.h"
@@ -172,6 +173,8 @@ typedef struct
     int pbuf_len;           // Length of protobuf message to send
     char *controller_queue; // Name of the STOMP queue to send this message to
     char *agent_queue;      // Name of the STOMP queue used by this agent
+    unsigned long long queued_time; // Time at which this message was queued (for message statistics), or 0 if message statistics are disabled
+    int stats_slot;         // Message statistics slot of the controller that this message is being sent to
 } stomp_send_item_t;
 
 //------------------------------------------------------------------------------
@@ -501,6 +504,7 @@ void STOMP_ProcessAllSocketActivity(socket_set_t *set)
 ** Function called to queue a message on the specified STOMP connection
 **
 ** \param   usp_msg_type - Type of USP message contained in pbuf. This is used for debug logging when the message is sent by the MTP.
+** \param   endpoint_id - controller to send the message to (used for message statistics)
 ** \param   instance - instance number of the stomp connection in Device.STOMP.Connection.{i}
 ** \param   controller_queue - name of STOMP queue to send this message to
 ** \param   agent_queue - name of agent's STOMP queue configured for this connection in the data model
@@ -510,7 +514,7 @@ void STOMP_ProcessAllSocketActivity(socket_set_t *set)
 ** \return  USP_ERR_OK if successful
 **
 **************************************************************************/
-int STOMP_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, int instance, char *controller_queue, char *agent_queue, unsigned char *pbuf, int pbuf_len)
+int STOMP_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, char *endpoint_id, int instance, char *controller_queue, char *agent_queue, unsigned char *pbuf, int pbuf_len)
 {
     stomp_connection_t *sc;
     stomp_send_item_t *send_item;
@@ -543,6 +547,8 @@ int STOMP_QueueBinaryMessage(Usp__Header__MsgType usp_msg_type, int instance, ch
     send_item->pbuf_len = pbuf_len;
     send_item->controller_queue = USP_STRDUP(controller_queue);
     send_item->agent_queue = USP_STRDUP(agent_queue);
+    send_item->queued_time = MSG_STATS_GetTime();
+    send_item->stats_slot = (send_item->queued_time != 0) ? MSG_STATS_GetSlot(endpoint_id) : INVALID;
 
     DLLIST_LinkToTail(&sc->usp_record_send_queue, send_item);
     err = USP_ERR_OK;
@@ -1814,6 +1820,7 @@ int TransmitStompMessage(stomp_connection_t *sc)
     unsigned char *buf;
     int bytes_to_attempt;
     stomp_send_item_t *queued_msg;
+    unsigned long long time_taken;
 
     // Determine what to send
     buf = &sc->txframe[ sc->txframe_sent_count ];
@@ -1861,6 +1868,11 @@ int TransmitStompMessage(stomp_connection_t *sc)
     if (sc->txframe_contains_usp_record)
     {
         queued_msg = (stomp_send_item_t *) sc->usp_record_send_queue.head;
+        time_taken = MSG_STATS_GetTimeSince(queued_msg->queued_time);
+        if (time_taken != 0)
+        {
+            MSG_STATS_Record(queued_msg->stats_slot, queued_msg->usp_msg_type, kMsgStatsStage_QueueToWire, time_taken);
+        }
         USP_FREE(queued_msg->pbuf);
         USP_FREE(queued_msg->controller_queue);
         USP_FREE(queued_msg->agent_queue);
@@ -45,10 +45,27 @@
 #include "str_vector.h"
 #include "text_utils.h"
 
+//------------------------------------------------------------------------
+// Chunk of memory used to store the strings of a pooled string vector
+// Strings are copied contiguously into the chunk, so that destroying the vector only frees the chunks, rather than each string
+struct str_pool_chunk_tag
+{
+    struct str_pool_chunk_tag *next;    // Next (older) chunk owned by the vector
+    int size;                           // Number of bytes in the data area of this chunk
+    int used;                           // Number of bytes of the data area which contain strings
+    char data[];                        // Data area containing the strings
+};
+
+// Minimum size of the data area of a chunk. Chunks double in size (up to the maximum) as the vector grows
+#define MIN_STR_POOL_CHUNK_SIZE  1024
+#define MAX_STR_POOL_CHUNK_SIZE  (64*1024)
+
 //------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 int PtrToNaturalStrCmp(const void *arg1, const void *arg2);
 int NaturalStrCmp(char *s1, char *s2);
+char *CopyString(str_vector_t *sv, char *str);
+void DestroyPool(str_vector_t *sv);
 
 
 /*********************************************************************//**
@@ -66,6 +83,28 @@ void STR_VECTOR_Init(str_vector_t *sv)
 {
     sv->vector = NULL;
     sv->num_entries = 0;
+    sv->is_pooled = false;
+    sv->pool = NULL;
+}
+
+/*********************************************************************//**
+**
+** STR_VECTOR_InitPooled
+**
+** Initialises a string vector structure, whose strings are stored in chunks owned by the vector
+** This makes building and destroying large vectors cheaper, as strings are not individually allocated and freed
+** NOTE: The strings in a pooled vector must not be freed individually, or have their ownership moved elsewhere
+**       (apart from by STR_VECTOR_ConvertToKeyValueVector(), which copies them)
+**
+** \param   sv - pointer to structure to initialise
+**
+** \return  None
+**
+**************************************************************************/
+void STR_VECTOR_InitPooled(str_vector_t *sv)
+{
+    STR_VECTOR_Init(sv);
+    sv->is_pooled = true;
 }
 
 /*********************************************************************//**
@@ -100,7 +139,7 @@ void STR_VECTOR_Clone(str_vector_t *sv, char **src_vector, int src_num_entries)
         {
             str = "";
         }
-        sv->vector[i] = USP_STRDUP(str);
+        sv->vector[i] = CopyString(sv, str);
     }
 }
 
@@ -120,9 +159,10 @@ void STR_VECTOR_Add(str_vector_t *sv, char *str)
 {
     int new_num_entries;
 
+    // NOTE: The array is grown geometrically, so that building a large vector does not reallocate on every addition
     new_num_entries = sv->num_entries + 1;
-    sv->vector = USP_REALLOC(sv->vector, new_num_entries*sizeof(char *));
-    sv->vector[ sv->num_entries ] = USP_STRDUP(str);
+    sv->vector = USP_REALLOC_GEOMETRIC(sv->vector, new_num_entries*sizeof(char *));
+    sv->vector[ sv->num_entries ] = CopyString(sv, str);
     sv->num_entries = new_num_entries;
 }
 
@@ -206,9 +246,16 @@ void STR_VECTOR_Destroy(str_vector_t *sv)
     }
 
     // Free all strings in the vector
-    for (i=0; i < sv->num_entries; i++)
+    if (sv->is_pooled)
     {
-        USP_FREE( sv->vector[i] );
+        DestroyPool(sv);
+    }
+    else
+    {
+        for (i=0; i < sv->num_entries; i++)
+        {
+            USP_FREE( sv->vector[i] );
+        }
     }
 
     // Free the vector itself
@@ -216,6 +263,7 @@ void STR_VECTOR_Destroy(str_vector_t *sv)
 
 exit:
     // Ensure structure is re-initialised
+    // NOTE: A pooled vector stays pooled, so that it may be reused
     sv->vector = NULL;
     sv->num_entries = 0;
 }
@@ -265,14 +313,16 @@ void STR_VECTOR_ConvertToKeyValueVector(str_vector_t *sv, kv_vector_t *kvv)
     kvv->num_entries = sv->num_entries;
 
     // Move all entries in string vector to be keys in the key-value pair vector
+    // NOTE: Strings in a pooled vector are owned by the pool, so have to be copied
     for (i=0; i < sv->num_entries; i++)
     {
         pair = &kvv->vector[i];
-        pair->key = sv->vector[i];
+        pair->key = (sv->is_pooled) ? USP_STRDUP(sv->vector[i]) : sv->vector[i];
         pair->value = NULL;
     }
 
     // Finally destroy the string vector, all memory referenced by it has been moved to the key-value pair vector
+    DestroyPool(sv);
     USP_FREE(sv->vector);
     sv->vector = NULL;
     sv->num_entries = 0;
@@ -423,3 +473,77 @@ int NaturalStrCmp(char *s1, char *s2)
     return (int)c1 - (int)c2;
 }
 
+/*********************************************************************//**
+**
+** CopyString
+**
+** Copies a string, for storing in the specified string vector
+** If the vector is pooled, the string is copied into the vector's pool, otherwise it is dynamically allocated
+**
+** \param   sv - pointer to string vector which will own the copy of the string
+** \param   str - pointer to string to copy
+**
+** \return  pointer to copy of string
+**
+**************************************************************************/
+char *CopyString(str_vector_t *sv, char *str)
+{
+    str_pool_chunk_t *chunk;
+    int len;
+    int size;
+    char *copy;
+
+    // Exit if the vector is not pooled
+    if (sv->is_pooled == false)
+    {
+        return USP_STRDUP(str);
+    }
+
+    // Allocate a new chunk, if there is not enough space left in the current chunk
+    len = strlen(str) + 1;
+    chunk = sv->pool;
+    if ((chunk == NULL) || (chunk->used + len > chunk->size))
+    {
+        size = (chunk == NULL) ? MIN_STR_POOL_CHUNK_SIZE : MIN(2*chunk->size, MAX_STR_POOL_CHUNK_SIZE);
+        size = MAX(size, len);
+        chunk = USP_MALLOC(sizeof(str_pool_chunk_t) + size);
+        chunk->next = sv->pool;
+        chunk->size = size;
+        chunk->used = 0;
+        sv->pool = chunk;
+    }
+
+    // Copy the string into the chunk
+    copy = &chunk->data[chunk->used];
+    memcpy(copy, str, len);
+    chunk->used += len;
+
+    return copy;
+}
+
+/*********************************************************************//**
+**
+** DestroyPool
+**
+** Frees all chunks containing the strings of a pooled string vector
+**
+** \param   sv - pointer to string vector
+**
+** \return  None
+**
+**************************************************************************/
+void DestroyPool(str_vector_t *sv)
+{
+    str_pool_chunk_t *chunk;
+    str_pool_chunk_t *next;
+
+    chunk = sv->pool;
+    while (chunk != NULL)
+    {
+        next = chunk->next;
+        USP_FREE(chunk);
+        chunk = next;
+    }
+
+    sv->pool = NULL;
+}
@@ -42,12 +42,18 @@
 #ifndef STR_VECTOR_H
 #define STR_VECTOR_H
 
+//-----------------------------------------------------------------------------------------
+// Chunk of memory used to store the strings of a pooled string vector
+typedef struct str_pool_chunk_tag str_pool_chunk_t;
+
 //-----------------------------------------------------------------------------------------
 // String vector type
 typedef struct
 {
     char **vector;
     int num_entries;
+    bool is_pooled;             // Set if the strings are stored in chunks owned by the vector (see STR_VECTOR_InitPooled), rather than individually allocated
+    str_pool_chunk_t *pool;     // Linked list of chunks containing the strings, if the vector is pooled
 } str_vector_t;
 
 //-----------------------------------------------------------------------------------------
@@ -56,6 +62,7 @@ typedef struct
 //-----------------------------------------------------------------------------------------
 // String Vector API
 void STR_VECTOR_Init(str_vector_t *sv);
+void STR_VECTOR_InitPooled(str_vector_t *sv);
 void STR_VECTOR_Clone(str_vector_t *sv, char **src_vector, int src_num_entries);
 void STR_VECTOR_Add(str_vector_t *sv, char *str);
 void STR_VECTOR_Add_IfNotExist(str_vector_t *sv, char *str);
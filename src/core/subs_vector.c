@@ -164,6 +164,7 @@ void SUBS_VECTOR_DestroySubscriber(subs_t *sub)
 
     STR_VECTOR_Destroy(&sub->path_expressions);
     KV_VECTOR_Destroy(&sub->last_values);
+    USP_SAFE_FREE(sub->last_typed_values);
     STR_VECTOR_Destroy(&sub->resolved_paths);
 }
 
@@ -77,6 +77,7 @@ typedef struct
     time_t expiry_time;                 // Time at which this subscription should be stopped and removed from the DB
     unsigned retry_expiry_period;       // Device.LocalAgent.Subscription.{i}.NotifExpiration
     kv_vector_t last_values;            // List of parameters+values from last time that the subscription was polled (if the subscription is a value change subscription)
+    struct dm_typed_value_tag *last_typed_values; // Types and native values of the parameters in last_values (same order), or NULL if not known
     str_vector_t resolved_paths;       // Used to cache the resolved paths of an object deletion subscription before the object has been deleted from the data model
 } subs_t;
 
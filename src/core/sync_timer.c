@@ -43,6 +43,7 @@
 #include <time.h>
 #include <limits.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "common_defs.h"
 #include "sync_timer.h"
@@ -56,14 +57,24 @@ typedef struct
     time_t     next_timeout;    // time at which this timer should next fire
     timer_cb_t timer_cb;        // function to call when timer period has expired.
     int        id;              // unique identifier for this callback (allocated by caller of this library) within the namespace of the callback
+    int        slot;            // index of the entry in the hash table (see timer_vector_t) which refers to this timer
 } sync_timer_t;
 
 //--------------------------------------------------------------------------------------
 // Structure containing a dynamic array of timers
+// The array is organised as a binary min-heap, ordered by the time at which each timer next fires (with disabled timers last)
+// This means that the timer which fires first is always at the start of the array, and timers can be added, reloaded
+// and removed without sorting the whole array
+// A hash table (keyed by callback and id) stores the index of each timer in the heap, so that a timer can be found without
+// searching the whole array. The hash table uses open addressing (linear probing), and is kept at most half full
 typedef struct
 {
     int num_entries;
+    int max_entries;
     sync_timer_t *vector;
+
+    int *slots;         // Hash table. Each entry contains the index of a timer in the vector, or INVALID if the entry is unused
+    int num_slots;      // Number of entries in the hash table. NOTE: Always zero or a power of 2
 } timer_vector_t;
 
 static timer_vector_t sync_timers;
@@ -72,12 +83,29 @@ static timer_vector_t sync_timers;
 // Variable that is always updated to reflect the time at which the next timer should fire
 static time_t first_sync_timer_time;
 
+//--------------------------------------------------------------------------------------
+// Structure identifying a timer which is due to fire
+typedef struct
+{
+    timer_cb_t timer_cb;
+    int        id;
+} due_timer_t;
+
 
 
 //------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 int FindSyncTimer(timer_cb_t timer_cb, int id);
+int HashSyncTimer(timer_cb_t timer_cb, int id);
+void AddSyncTimerSlot(int index);
+void RemoveSyncTimerSlot(int slot);
+void GrowSyncTimerSlots(void);
 void UpdateFirstSyncTimerTime(void);
+bool IsSyncTimerBefore(sync_timer_t *a, sync_timer_t *b);
+int SiftSyncTimerUp(int index);
+void SiftSyncTimerDown(int index);
+void RestoreSyncTimerOrder(int index);
+void SwapSyncTimers(int i, int j);
 
 /*********************************************************************//**
 **
@@ -94,6 +122,9 @@ void SYNC_TIMER_Init(void)
 {
     sync_timers.vector = NULL;
     sync_timers.num_entries = 0;
+    sync_timers.max_entries = 0;
+    sync_timers.slots = NULL;
+    sync_timers.num_slots = 0;
     first_sync_timer_time = (time_t) INT_MAX;
 }
 
@@ -111,7 +142,7 @@ void SYNC_TIMER_Init(void)
 void SYNC_TIMER_Destroy(void)
 {
     USP_SAFE_FREE(sync_timers.vector);
-
+    USP_SAFE_FREE(sync_timers.slots);
 }
 
 /*********************************************************************//**
@@ -129,7 +160,6 @@ void SYNC_TIMER_Destroy(void)
 **************************************************************************/
 int SYNC_TIMER_Add(timer_cb_t timer_cb, int id, time_t callback_time)
 {
-    int new_num_entries;
     sync_timer_t *st;
     int index;
 
@@ -148,17 +178,30 @@ int SYNC_TIMER_Add(timer_cb_t timer_cb, int id, time_t callback_time)
         return USP_ERR_INTERNAL_ERROR;
     }
 
-    // Add this timer to the vector
+    // Increase the size of the vector, if it is full
+    if (sync_timers.num_entries == sync_timers.max_entries)
+    {
+        sync_timers.max_entries = (sync_timers.max_entries == 0) ? 16 : 2*sync_timers.max_entries;
+        sync_timers.vector = USP_REALLOC(sync_timers.vector, sync_timers.max_entries*sizeof(sync_timer_t));
+    }
+
+    // Increase the size of the hash table, if adding this timer would make it more than half full
+    if (2*(sync_timers.num_entries + 1) > sync_timers.num_slots)
+    {
+        GrowSyncTimerSlots();
+    }
+
+    // Add this timer to the end of the vector, then move it to its correct position in the heap
+    index = sync_timers.num_entries;
     st = &sync_timers.vector[index];
-    new_num_entries = sync_timers.num_entries + 1;
-    sync_timers.vector = USP_REALLOC(sync_timers.vector, new_num_entries*sizeof(sync_timer_t));
-    st = &sync_timers.vector[ sync_timers.num_entries ];
     st->timer_cb = timer_cb;
     st->id = id;
     st->next_timeout = callback_time;
     st->enabled = true;
 
-    sync_timers.num_entries = new_num_entries;
+    sync_timers.num_entries++;
+    AddSyncTimerSlot(index);
+    SiftSyncTimerUp(index);
 
     // Update the time at which the next timer should fire
     UpdateFirstSyncTimerTime();
@@ -192,10 +235,11 @@ int SYNC_TIMER_Reload(timer_cb_t timer_cb, int id, time_t callback_time)
         return USP_ERR_INTERNAL_ERROR;
     }
 
-    // Reload the timer
+    // Reload the timer, then move it to its new position in the heap
     st = &sync_timers.vector[index];
     st->enabled = true;
     st->next_timeout = callback_time;
+    RestoreSyncTimerOrder(index);
 
     // Update the time at which the next timer should fire
     UpdateFirstSyncTimerTime();
@@ -218,7 +262,7 @@ int SYNC_TIMER_Reload(timer_cb_t timer_cb, int id, time_t callback_time)
 int SYNC_TIMER_Remove(timer_cb_t timer_cb, int id)
 {
     int index;
-    int num_to_move;
+    int last;
 
     // Exit if timer could not be found
     index = FindSyncTimer(timer_cb, id);
@@ -228,14 +272,21 @@ int SYNC_TIMER_Remove(timer_cb_t timer_cb, int id)
         return USP_ERR_INTERNAL_ERROR;
     }
 
-    // Remove this timer from the vector, by moving down the rest of the timers in the array
-    num_to_move = sync_timers.num_entries - 1 - index;
-    if (num_to_move > 0)
+    // Remove this timer from the vector, by replacing it with the last timer in the array, then moving that timer to its correct position in the heap
+    RemoveSyncTimerSlot(sync_timers.vector[index].slot);
+    last = sync_timers.num_entries - 1;
+    if (index != last)
     {
-        memmove(&sync_timers.vector[index], &sync_timers.vector[index+1], num_to_move*sizeof(sync_timer_t));
+        memcpy(&sync_timers.vector[index], &sync_timers.vector[last], sizeof(sync_timer_t));
+        sync_timers.slots[ sync_timers.vector[index].slot ] = index;
     }
     sync_timers.num_entries--;
 
+    if (index < sync_timers.num_entries)
+    {
+        RestoreSyncTimerOrder(index);
+    }
+
     // Update the time at which the next timer should fire
     UpdateFirstSyncTimerTime();
 
@@ -292,9 +343,12 @@ int SYNC_TIMER_TimeToNext(void)
 void SYNC_TIMER_Execute(void)
 {
     int i;
+    int index;
     time_t cur_time;
     sync_timer_t *st;
-    timer_cb_t timer_cb;
+    due_timer_t *due = NULL;
+    int num_due = 0;
+    int max_due = 0;
 
     // Exit if it is not yet time for any of the timers to fire
     cur_time = time(NULL);
@@ -303,23 +357,45 @@ void SYNC_TIMER_Execute(void)
         return;
     }
 
-    // Iterate over all timers
-    for (i=0; i < sync_timers.num_entries; i++)
+    // Determine all timers which should fire, by taking them from the top of the heap
+    // Mark each timer as fired, if the callback wants the timer to continue, then it can call SYNC_TIMER_Reload()
+    // NOTE: The callbacks are only called after all fired timers have been determined, because callbacks may add, reload or remove timers
+    while (sync_timers.num_entries > 0)
     {
-        // Determine if this timer should fire
-        st = &sync_timers.vector[i];
-        if ((st->enabled) && (cur_time >= st->next_timeout))
+        st = &sync_timers.vector[0];
+        if ((st->enabled == false) || (cur_time < st->next_timeout))
         {
-            // Mark the timer as fired, if the callback wants the timer to continue, then it can call SYNC_TIMER_Reload()
-            st->enabled = false;
-    
-            // Call the registered callback
-            timer_cb = st->timer_cb;
-            USP_ASSERT(timer_cb != NULL)
-            timer_cb(st->id);
+            break;
         }
+
+        if (num_due == max_due)
+        {
+            max_due = (max_due == 0) ? 16 : 2*max_due;
+            due = USP_REALLOC(due, max_due*sizeof(due_timer_t));
+        }
+        due[num_due].timer_cb = st->timer_cb;
+        due[num_due].id = st->id;
+        num_due++;
+
+        st->enabled = false;
+        SiftSyncTimerDown(0);
     }
 
+    // Call the registered callbacks
+    for (i=0; i < num_due; i++)
+    {
+        // Skip this timer if it has been removed or reloaded by the callback of a previous timer
+        index = FindSyncTimer(due[i].timer_cb, due[i].id);
+        if ((index == INVALID) || (sync_timers.vector[index].enabled))
+        {
+            continue;
+        }
+
+        USP_ASSERT(due[i].timer_cb != NULL)
+        due[i].timer_cb(due[i].id);
+    }
+    USP_SAFE_FREE(due);
+
     // Update the time at which the next timer should fire
     UpdateFirstSyncTimerTime();
 }
@@ -341,40 +417,199 @@ void SYNC_TIMER_Execute(void)
 **************************************************************************/
 void *SYNC_TIMER_PRIV_GetVector(int *allocated_size)
 {
-    *allocated_size = sync_timers.num_entries * sizeof(timer_vector_t);
+    *allocated_size = sync_timers.max_entries * sizeof(sync_timer_t);
     return sync_timers.vector;
 }
 
+/*********************************************************************//**
+**
+** SYNC_TIMER_PRIV_GetSlots
+**
+** Gets information about the dynamically allocated hash table of sync timers
+** This is necessary to make meminfo collection work correctly, for the same reason as SYNC_TIMER_PRIV_GetVector()
+**
+** \param   allocated_size - pointer to variable in which to return the size of the hash table
+**
+** \return  pointer to memory allocated for the hash table
+**
+**************************************************************************/
+void *SYNC_TIMER_PRIV_GetSlots(int *allocated_size)
+{
+    *allocated_size = sync_timers.num_slots * sizeof(int);
+    return sync_timers.slots;
+}
+
 /*********************************************************************//**
 **
 ** FindSyncTimer
 **
-** Finds the timer identified by matching callback
+** Finds the timer identified by matching callback and id, using the hash table
 **
-** \param   timer_cb - callback function identifying the timer to reload
+** \param   timer_cb - callback function identifying the timer to find
+** \param   id - unique identifier of the timer, within the namespace of the callback
 **
-** \return  index of matching timer, or INVALID if no match was found
+** \return  index of matching timer in the vector, or INVALID if no match was found
 **
 **************************************************************************/
 int FindSyncTimer(timer_cb_t timer_cb, int id)
 {
-    int i;
+    int slot;
+    int index;
     sync_timer_t *st;
-    
-    // Iterate over all timers
-    for (i=0; i < sync_timers.num_entries; i++)
+
+    // Exit if no timers have been added yet
+    if (sync_timers.num_slots == 0)
+    {
+        return INVALID;
+    }
+
+    // Iterate over all entries in the hash table, starting from the hashed entry, until an unused entry is found
+    slot = HashSyncTimer(timer_cb, id);
+    while (sync_timers.slots[slot] != INVALID)
     {
-        st = &sync_timers.vector[i];
+        index = sync_timers.slots[slot];
+        st = &sync_timers.vector[index];
         if ((st->timer_cb == timer_cb) && (st->id == id))
         {
-            return i;
+            return index;
         }
+
+        slot = (slot + 1) & (sync_timers.num_slots - 1);
     }
 
     // If the code gets here, then no match was found
     return INVALID;
 }
 
+/*********************************************************************//**
+**
+** HashSyncTimer
+**
+** Returns the entry in the hash table at which to start searching for the specified timer
+**
+** \param   timer_cb - callback function identifying the timer
+** \param   id - unique identifier of the timer, within the namespace of the callback
+**
+** \return  index of entry in the hash table
+**
+**************************************************************************/
+int HashSyncTimer(timer_cb_t timer_cb, int id)
+{
+    uint32_t hash;
+
+    hash = (uint32_t)((uintptr_t)timer_cb >> 4) ^ ((uint32_t)id * 0x9E3779B1);
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 16;
+
+    return hash & (sync_timers.num_slots - 1);
+}
+
+/*********************************************************************//**
+**
+** AddSyncTimerSlot
+**
+** Adds the specified timer to the hash table
+** NOTE: The caller must ensure that there is a free entry in the hash table
+**
+** \param   index - index of the timer in the vector
+**
+** \return  None
+**
+**************************************************************************/
+void AddSyncTimerSlot(int index)
+{
+    sync_timer_t *st;
+    int slot;
+
+    // Find the first unused entry, starting from the hashed entry
+    st = &sync_timers.vector[index];
+    slot = HashSyncTimer(st->timer_cb, st->id);
+    while (sync_timers.slots[slot] != INVALID)
+    {
+        slot = (slot + 1) & (sync_timers.num_slots - 1);
+    }
+
+    sync_timers.slots[slot] = index;
+    st->slot = slot;
+}
+
+/*********************************************************************//**
+**
+** RemoveSyncTimerSlot
+**
+** Removes the specified entry from the hash table
+** Subsequent entries in the same run of used entries are moved back into the gap, if necessary,
+** so that they can still be found by FindSyncTimer()
+**
+** \param   slot - index of the entry to remove from the hash table
+**
+** \return  None
+**
+**************************************************************************/
+void RemoveSyncTimerSlot(int slot)
+{
+    int mask;
+    int next;
+    int home;
+    sync_timer_t *st;
+
+    mask = sync_timers.num_slots - 1;
+    sync_timers.slots[slot] = INVALID;
+
+    // Iterate over all subsequent entries, until an unused entry is found
+    next = slot;
+    while (true)
+    {
+        next = (next + 1) & mask;
+        if (sync_timers.slots[next] == INVALID)
+        {
+            break;
+        }
+
+        // Skip this entry, if its hashed entry lies (cyclically) after the gap, as it can still be found
+        st = &sync_timers.vector[ sync_timers.slots[next] ];
+        home = HashSyncTimer(st->timer_cb, st->id);
+        if (((next - home) & mask) < ((next - slot) & mask))
+        {
+            continue;
+        }
+
+        // Otherwise move the entry into the gap, leaving a gap at its old position
+        sync_timers.slots[slot] = sync_timers.slots[next];
+        sync_timers.slots[next] = INVALID;
+        st->slot = slot;
+        slot = next;
+    }
+}
+
+/*********************************************************************//**
+**
+** GrowSyncTimerSlots
+**
+** Doubles the size of the hash table, re-adding all timers to it
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void GrowSyncTimerSlots(void)
+{
+    int i;
+
+    sync_timers.num_slots = (sync_timers.num_slots == 0) ? 32 : 2*sync_timers.num_slots;
+    sync_timers.slots = USP_REALLOC(sync_timers.slots, sync_timers.num_slots*sizeof(int));
+    for (i=0; i < sync_timers.num_slots; i++)
+    {
+        sync_timers.slots[i] = INVALID;
+    }
+
+    for (i=0; i < sync_timers.num_entries; i++)
+    {
+        AddSyncTimerSlot(i);
+    }
+}
+
 /*********************************************************************//**
 **
 ** UpdateFirstSyncTimerTime
@@ -388,27 +623,155 @@ int FindSyncTimer(timer_cb_t timer_cb, int id)
 **************************************************************************/
 void UpdateFirstSyncTimerTime(void)
 {
-    int i;
-    sync_timer_t *st;
-    time_t first;
-    
-    // Iterate over all timers
-    first = (time_t) INT_MAX;
-    for (i=0; i < sync_timers.num_entries; i++)
+    // Exit if there are no enabled timers. As disabled timers are ordered last, this is the case if the first timer is disabled
+    if ((sync_timers.num_entries == 0) || (sync_timers.vector[0].enabled == false))
     {
-        // Skip this timer if it is not enabled
-        st = &sync_timers.vector[i];
-        if (st->enabled == false)
+        first_sync_timer_time = (time_t) INT_MAX;
+        return;
+    }
+
+    // The first timer in the heap is the one which fires first
+    first_sync_timer_time = sync_timers.vector[0].next_timeout;
+}
+
+/*********************************************************************//**
+**
+** IsSyncTimerBefore
+**
+** Determines whether timer 'a' should be ordered before timer 'b' in the heap
+** Enabled timers are ordered before disabled timers. Enabled timers are ordered by the time at which they fire
+**
+** \param   a - pointer to first timer to compare
+** \param   b - pointer to second timer to compare
+**
+** \return  true if timer 'a' should be ordered before timer 'b'
+**
+**************************************************************************/
+bool IsSyncTimerBefore(sync_timer_t *a, sync_timer_t *b)
+{
+    if (a->enabled != b->enabled)
+    {
+        return a->enabled;
+    }
+
+    return (a->next_timeout < b->next_timeout);
+}
+
+/*********************************************************************//**
+**
+** SiftSyncTimerUp
+**
+** Moves the specified timer towards the top of the heap, until it is not before its parent
+**
+** \param   index - index of the timer in the vector
+**
+** \return  new index of the timer in the vector
+**
+**************************************************************************/
+int SiftSyncTimerUp(int index)
+{
+    int parent;
+
+    while (index > 0)
+    {
+        // Exit if the timer is in the correct position relative to its parent
+        parent = (index - 1)/2;
+        if (IsSyncTimerBefore(&sync_timers.vector[index], &sync_timers.vector[parent]) == false)
         {
-            continue;
+            break;
         }
 
-        // Update the time at which the first timer fires
-        if (st->next_timeout < first)
+        SwapSyncTimers(index, parent);
+        index = parent;
+    }
+
+    return index;
+}
+
+/*********************************************************************//**
+**
+** SiftSyncTimerDown
+**
+** Moves the specified timer towards the bottom of the heap, until none of its children are before it
+**
+** \param   index - index of the timer in the vector
+**
+** \return  None
+**
+**************************************************************************/
+void SiftSyncTimerDown(int index)
+{
+    int child;
+    int first;
+
+    while (true)
+    {
+        // Determine which of the timer and its children should be first
+        first = index;
+        child = 2*index + 1;
+        if ((child < sync_timers.num_entries) && (IsSyncTimerBefore(&sync_timers.vector[child], &sync_timers.vector[first])))
+        {
+            first = child;
+        }
+
+        child++;
+        if ((child < sync_timers.num_entries) && (IsSyncTimerBefore(&sync_timers.vector[child], &sync_timers.vector[first])))
+        {
+            first = child;
+        }
+
+        // Exit if the timer is in the correct position relative to its children
+        if (first == index)
         {
-            first = st->next_timeout;
+            return;
         }
+
+        SwapSyncTimers(index, first);
+        index = first;
     }
+}
+
+/*********************************************************************//**
+**
+** RestoreSyncTimerOrder
+**
+** Moves the specified timer to its correct position in the heap, after the time at which it fires has been changed
+**
+** \param   index - index of the timer in the vector
+**
+** \return  None
+**
+**************************************************************************/
+void RestoreSyncTimerOrder(int index)
+{
+    // If the timer did not need to move up the heap, then it may need to move down the heap
+    if (SiftSyncTimerUp(index) == index)
+    {
+        SiftSyncTimerDown(index);
+    }
+}
+
+/*********************************************************************//**
+**
+** SwapSyncTimers
+**
+** Swaps the position of the specified timers in the vector
+**
+** \param   i - index of first timer to swap
+** \param   j - index of second timer to swap
+**
+** \return  None
+**
+**************************************************************************/
+void SwapSyncTimers(int i, int j)
+{
+    sync_timer_t temp;
+
+    memcpy(&temp, &sync_timers.vector[i], sizeof(sync_timer_t));
+    memcpy(&sync_timers.vector[i], &sync_timers.vector[j], sizeof(sync_timer_t));
+    memcpy(&sync_timers.vector[j], &temp, sizeof(sync_timer_t));
 
-    first_sync_timer_time = first;
+    // Update the hash table with the new positions of the timers
+    sync_timers.slots[ sync_timers.vector[i].slot ] = i;
+    sync_timers.slots[ sync_timers.vector[j].slot ] = j;
 }
@@ -58,5 +58,6 @@ int SYNC_TIMER_Remove(timer_cb_t timer_cb, int id);
 int SYNC_TIMER_TimeToNext(void);
 void SYNC_TIMER_Execute(void);
 void *SYNC_TIMER_PRIV_GetVector(int *allocated_size);
+void *SYNC_TIMER_PRIV_GetSlots(int *allocated_size);
 
 #endif
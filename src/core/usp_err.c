@@ -282,6 +282,9 @@ void USP_ERR_Terminate(char *fmt, ...)
     usp_error[sizeof(usp_error)-1] = '\0';
     va_end(ap);
     
+    // Write out any buffered log messages, and log the remaining messages synchronously, so that they are not lost by abort()
+    USP_LOG_StopAsync();
+
     if (usp_log_level >= kLogLevel_Error)
     {
         USP_LOG_Puts(kLogType_Debug, usp_error);
@@ -343,6 +346,9 @@ void USP_ERR_Terminate_OnAssert(const char *func, int line, char *statement)
 **************************************************************************/
 void SegFaultHandler(int sig)
 {
+    // Write out any buffered log messages, and log the remaining messages synchronously, so that they are not lost by abort()
+    USP_LOG_StopAsync();
+
     USP_LOG_Error("ERROR: Segmentation Fault");
     USP_LOG_Callstack();
     abort();    // call abort() rather than exit() so that a core dump is created
@@ -37,6 +37,11 @@
  *
  * Functions through which all debug prints are passed
  *
+ * When running as a daemon, log messages are written out asynchronously (see USP_LOG_StartAsync):
+ * each thread copies its log messages into its own lock-free ring buffer, and a background thread
+ * periodically writes out the log messages from all ring buffers (in the order that they were logged),
+ * flushing the log file once per batch, rather than once per log message.
+ *
  */
 
 #include <stdio.h>
@@ -47,6 +52,8 @@
 #include <syslog.h>
 #include <unistd.h>
 #include <dlfcn.h>
+#include <time.h>
+#include <pthread.h>
 
 #include <execinfo.h>
 
@@ -54,6 +61,7 @@
 #include "cli.h"
 #include "usp_api.h"
 #include "data_model.h"  // for vendor_hook_callbacks
+#include "os_utils.h"
 
 //------------------------------------------------------------------------------------
 // File to send logging output to
@@ -64,9 +72,81 @@ static FILE *log_fd;
 log_level_t usp_log_level = kLogLevel_Error;    // Verbosity level
 bool enable_protocol_trace = false;             // Whether protocol tracing should be sent out or not
 
+//------------------------------------------------------------------------------------
+// Header stored in a log ring buffer before each log message
+// The log message (including NULL terminator) follows the header, padded to a multiple of the size of the header
+typedef struct
+{
+    unsigned len;       // Number of characters in the log message (not including NULL terminator), or LOG_RING_WRAP
+    unsigned seq;       // Sequence number of the log message. Used to write out log messages from all threads in the order they were logged
+} log_rec_hdr_t;
+
+// Value of log_rec_hdr_t.len indicating that the rest of the ring buffer is unused, and the next log message is at the start of the buffer
+#define LOG_RING_WRAP  0xFFFFFFFF
+
+// Number of bytes occupied in a log ring buffer by a log message of the specified length
+#define LOG_REC_SIZE(len)  (sizeof(log_rec_hdr_t) + (((len) + 1 + sizeof(log_rec_hdr_t) - 1) & ~(sizeof(log_rec_hdr_t) - 1)))
+
+// Maximum length of a log message stored in a log ring buffer. Longer log messages are truncated
+#define MAX_LOG_REC_LEN  (LOG_RING_SIZE/4)
+
+//------------------------------------------------------------------------------------
+// State used to suppress identical consecutive debug level log messages logged by a thread
+typedef struct
+{
+    char msg[USP_ERR_MAXLEN];   // Last debug level log message which was written out by the thread
+    time_t time;                // Time at which msg was written out, or 0 if there is no message to compare against
+    unsigned repeats;           // Number of times that msg has been suppressed since it was written out
+                                // NOTE: Accessed atomically, as the log flusher reports (and resets) it when the suppression window expires
+} log_repeat_t;
+
+//------------------------------------------------------------------------------------
+// Ring buffer of log messages, written to by a single thread, and read by the log flusher
+// NOTE: head and tail are free running offsets (ie not modulo LOG_RING_SIZE)
+typedef struct
+{
+    unsigned head;              // Offset at which the next log message will be written. Only updated by the thread which owns the ring buffer
+    unsigned tail;              // Offset of the next log message to write out. Only updated by the log flusher
+    unsigned dropped;           // Number of log messages dropped because the ring buffer was full
+    unsigned dropped_reported;  // Number of dropped log messages which the log flusher has already reported
+    log_repeat_t repeat;        // Suppression of repeated debug level messages logged by the thread owning this ring buffer
+    char buf[LOG_RING_SIZE];
+} log_ring_t;
+
+//------------------------------------------------------------------------------------
+// State associated with asynchronous logging
+static bool log_async = false;                      // Set if log messages are being written out by the log flusher
+static log_ring_t *log_rings[MAX_LOG_RINGS];        // Ring buffers of all threads which have logged. NOTE: An entry may be NULL until the thread has allocated it
+static int num_log_rings = 0;                       // Number of entries allocated in log_rings[]
+static unsigned log_seq = 0;                        // Sequence number to give the next log message
+static pthread_mutex_t log_flush_mutex;             // Serializes writing out the ring buffers (between the log flusher and USP_LOG_StopAsync)
+
+static __thread log_ring_t *thread_log_ring = NULL; // Ring buffer owned by this thread
+static __thread bool thread_log_ring_failed = false;// Set if this thread could not get a ring buffer, so logs synchronously
+static __thread bool thread_is_flushing = false;    // Set whilst this thread is writing out the ring buffers
+
+//------------------------------------------------------------------------------------
+// Suppression state used by this thread when it does not have a ring buffer (eg when logging synchronously)
+// NOTE: Suppression state is per thread, so that log messages from one thread do not interrupt the suppression in another
+static __thread log_repeat_t thread_log_repeat;
+
+//------------------------------------------------------------------------------------
+// List of call sites which have suppressed error/warning messages, so that the log flusher can report them when their window expires
+// NOTE: Call sites are only ever added to the front of this list (never removed), so it may be walked without a lock
+static log_limit_t *limited_call_sites = NULL;
+
 //------------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
-void LogMessageToFile(FILE *fd, char *str);
+void LogMessageToFile(FILE *fd, char *str, bool flush);
+void LogDebugMessage(char *str);
+void LogMessage(char *str);
+bool QueueLogMessage(char *str);
+log_ring_t *GetThreadLogRing(void);
+void *LogFlusherMain(void *args);
+void FlushLogRings(bool is_final);
+int FlushRepeatCount(log_ring_t *ring, time_t cur_time, bool is_final);
+int FlushSuppressedCounts(time_t cur_time, bool is_final);
+void ReportSuppressedCount(log_limit_t *limit, unsigned suppressed, bool is_flusher);
 void CloseLog(void);
 
 /*********************************************************************//**
@@ -127,6 +207,83 @@ int USP_LOG_SetFile(char *file)
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** USP_LOG_StartAsync
+**
+** Starts writing out log messages asynchronously, from a background thread
+** After calling this function, log messages are buffered by the thread which logs them, and written out
+** every LOG_FLUSH_PERIOD_MS. This keeps the cost of file writes (and syslog) off the threads which log.
+** NOTE: Log messages sent to the CLI are not affected (they are always sent synchronously)
+** NOTE: The vendor log_message_cb is called from the log flusher thread, when logging asynchronously
+**
+** \param   None
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int USP_LOG_StartAsync(void)
+{
+    int err;
+
+    // Exit if already logging asynchronously
+    if (log_async)
+    {
+        return USP_ERR_OK;
+    }
+
+    // Exit if unable to create the mutex serializing writing out the ring buffers
+    err = OS_UTILS_InitMutex(&log_flush_mutex);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if unable to start the log flusher thread
+    log_async = true;
+    err = OS_UTILS_CreateThread(LogFlusherMain, NULL);
+    if (err != USP_ERR_OK)
+    {
+        log_async = false;
+        return err;
+    }
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** USP_LOG_StopAsync
+**
+** Stops writing out log messages asynchronously, writing out all log messages which are currently buffered
+** Subsequent log messages are written out synchronously by the thread which logs them
+** NOTE: This is also called before the agent aborts, so that the log messages leading up to the abort are not lost
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void USP_LOG_StopAsync(void)
+{
+    // Exit if not logging asynchronously
+    if (log_async == false)
+    {
+        return;
+    }
+
+    log_async = false;
+
+    // Exit if this thread is already writing out the ring buffers (eg it faulted whilst doing so)
+    // In this case the buffered log messages cannot be written out, as the mutex serializing writing them out is already held
+    if (thread_is_flushing)
+    {
+        return;
+    }
+
+    FlushLogRings(true);
+}
+
 /*********************************************************************//**
 **
 ** USP_LOG_Callstack
@@ -362,6 +519,72 @@ void USP_LOG_Printf(log_type_t log_type, char *fmt, ...)
     USP_LOG_Puts(log_type, buf);
 }
 
+/*********************************************************************//**
+**
+** USP_LOG_PrintfLimited
+**
+** Logs the specified error or warning message, unless the call site has already logged LOG_LIMIT_BURST messages
+** within the current window of LOG_REPEAT_WINDOW seconds
+** The number of messages suppressed is logged when the window expires: either by the next message logged from the call site,
+** or (when logging asynchronously) by the log flusher
+**
+** \param   limit - pointer to rate limiting state of the call site
+** \param   fmt - printf style format
+**
+** \return  true if the message was logged, false if it was suppressed
+**
+**************************************************************************/
+bool USP_LOG_PrintfLimited(log_limit_t *limit, char *fmt, ...)
+{
+    va_list ap;
+    char buf[USP_ERR_MAXLEN];
+    time_t cur_time;
+    time_t window_start;
+    unsigned suppressed;
+    bool is_listed;
+
+    // Start a new window, if the current window has expired, reporting the number of messages suppressed in it
+    cur_time = time(NULL);
+    window_start = __atomic_load_n(&limit->window_start, __ATOMIC_RELAXED);
+    if ((window_start == 0) || (cur_time - window_start >= LOG_REPEAT_WINDOW))
+    {
+        __atomic_store_n(&limit->window_start, cur_time, __ATOMIC_RELAXED);
+        __atomic_store_n(&limit->count, 0, __ATOMIC_RELAXED);
+        suppressed = __atomic_exchange_n(&limit->suppressed, 0, __ATOMIC_RELAXED);
+        if (suppressed > 0)
+        {
+            ReportSuppressedCount(limit, suppressed, false);
+        }
+    }
+
+    // Exit if this call site has already logged its quota of messages in this window
+    if (__atomic_add_fetch(&limit->count, 1, __ATOMIC_RELAXED) > LOG_LIMIT_BURST)
+    {
+        __atomic_add_fetch(&limit->suppressed, 1, __ATOMIC_RELAXED);
+
+        // Add this call site to the list checked by the log flusher, if this is the first time it has suppressed a message
+        is_listed = __atomic_exchange_n(&limit->is_listed, true, __ATOMIC_ACQ_REL);
+        if (is_listed == false)
+        {
+            limit->next = __atomic_load_n(&limited_call_sites, __ATOMIC_ACQUIRE);
+            while (__atomic_compare_exchange_n(&limited_call_sites, &limit->next, limit, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE) == false)
+            {
+                // NOTE: On failure, limit->next has been updated with the current head of the list, so just retry
+            }
+        }
+        return false;
+    }
+
+    // Print the message to the buffer
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    buf[sizeof(buf)-1] = '\0';
+    va_end(ap);
+
+    USP_LOG_Puts(kLogType_Debug, buf);
+    return true;
+}
+
 /*********************************************************************//**
 **
 ** USP_LOG_Puts
@@ -386,7 +609,19 @@ void USP_LOG_Puts(log_type_t log_type, char *str)
             }
             else
             {    
-                LogMessageToFile(log_fd, str);
+                LogMessage(str);
+            }
+            break;
+
+        case kLogType_Verbose:
+            if (dump_to_cli)
+            {
+                CLI_SERVER_SendResponse(str);
+                CLI_SERVER_SendResponse("\n");
+            }
+            else
+            {
+                LogDebugMessage(str);
             }
             break;
 
@@ -398,19 +633,505 @@ void USP_LOG_Puts(log_type_t log_type, char *str)
             }
             else
             {
-                LogMessageToFile(log_fd, str);
+                LogMessage(str);
             }
             break;
 
         case kLogType_Protocol:
             if (enable_protocol_trace)
             {
-                LogMessageToFile(log_fd, str);
+                LogMessage(str);
             }
             break;
     }
 }    
 
+/*********************************************************************//**
+**
+** LogDebugMessage
+**
+** Logs the specified debug level message, suppressing identical consecutive messages logged by the same thread
+** within LOG_REPEAT_WINDOW seconds. The number of suppressed messages is logged when the run of repeats ends:
+** either when the next different message is logged, or (when logging asynchronously) by the log flusher when the window expires
+**
+** \param   str - pointer to string to log
+**
+** \return  None
+**
+**************************************************************************/
+void LogDebugMessage(char *str)
+{
+    log_ring_t *ring;
+    log_repeat_t *rs;
+    time_t cur_time;
+    unsigned repeats;
+    char buf[64];
+    int len;
+
+    // Determine the suppression state to use. When logging asynchronously, it is stored in the thread's ring buffer, so that the log flusher can access it
+    ring = (log_async) ? GetThreadLogRing() : NULL;
+    rs = (ring != NULL) ? &ring->repeat : &thread_log_repeat;
+
+    // Exit if this message is a repeat of the last message, logged within the suppression window
+    cur_time = time(NULL);
+    if ((rs->time != 0) && (cur_time - rs->time < LOG_REPEAT_WINDOW) && (strcmp(str, rs->msg)==0))
+    {
+        __atomic_add_fetch(&rs->repeats, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // Log the number of times that the last message was suppressed (if not already logged by the log flusher)
+    repeats = __atomic_exchange_n(&rs->repeats, 0, __ATOMIC_RELAXED);
+    if (repeats > 0)
+    {
+        USP_SNPRINTF(buf, sizeof(buf), "(Last message repeated %u times)", repeats);
+        LogMessage(buf);
+    }
+
+    LogMessage(str);
+
+    // Save the message, so that repeats of it can be detected
+    // NOTE: Messages which are too long to save are never suppressed
+    len = strlen(str);
+    if (len < sizeof(rs->msg))
+    {
+        memcpy(rs->msg, str, len+1);
+        __atomic_store_n(&rs->time, cur_time, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        __atomic_store_n(&rs->time, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/*********************************************************************//**
+**
+** LogMessage
+**
+** Logs the specified message to the current log destination, buffering it if logging asynchronously
+**
+** \param   str - pointer to string to log
+**
+** \return  None
+**
+**************************************************************************/
+void LogMessage(char *str)
+{
+    bool is_queued;
+
+    if (log_async)
+    {
+        is_queued = QueueLogMessage(str);
+        if (is_queued)
+        {
+            return;
+        }
+    }
+
+    // If the code gets here, then the message must be written out synchronously
+    LogMessageToFile(log_fd, str, true);
+}
+
+/*********************************************************************//**
+**
+** QueueLogMessage
+**
+** Copies the specified log message into the calling thread's ring buffer, for the log flusher to write out
+** If the ring buffer is full, then this thread writes out the ring buffers itself (rather than waiting for the log flusher),
+** and if the ring buffer is still full after that, then the message is dropped (and counted)
+** NOTE: This function is lock free, unless the ring buffer is full. It only writes to the ring buffer owned by the calling thread.
+**
+** \param   str - pointer to string to log
+**
+** \return  true if the message was queued or dropped, false if the caller must log the message synchronously
+**
+**************************************************************************/
+bool QueueLogMessage(char *str)
+{
+    log_ring_t *ring;
+    log_rec_hdr_t *hdr;
+    unsigned len;
+    unsigned size;
+    unsigned head;
+    unsigned used;
+    unsigned pos;
+    unsigned wrap_size;
+
+    // Exit if this thread does not have a ring buffer
+    ring = GetThreadLogRing();
+    if (ring == NULL)
+    {
+        return false;
+    }
+
+    len = strlen(str);
+    if (len > MAX_LOG_REC_LEN)
+    {
+        len = MAX_LOG_REC_LEN;
+    }
+    size = LOG_REC_SIZE(len);
+
+    // Determine whether the message needs to wrap to the start of the ring buffer, to be stored contiguously
+    head = ring->head;
+    pos = head & (LOG_RING_SIZE-1);
+    wrap_size = (size > LOG_RING_SIZE - pos) ? LOG_RING_SIZE - pos : 0;
+
+    // Wait for space in the ring buffer, if it is full
+    // NOTE: The ring buffer is not written out if this thread is already writing out the ring buffers (eg vendor log hook logging)
+    used = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if ((used + wrap_size + size > LOG_RING_SIZE) && (thread_is_flushing == false))
+    {
+        FlushLogRings(false);
+        used = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    }
+
+    // Exit if there is no space for the message in the ring buffer
+    if (used + wrap_size + size > LOG_RING_SIZE)
+    {
+        __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    // Mark the rest of the ring buffer as unused, if wrapping
+    if (wrap_size > 0)
+    {
+        hdr = (log_rec_hdr_t *) &ring->buf[pos];
+        hdr->len = LOG_RING_WRAP;
+        head += wrap_size;
+        pos = 0;
+    }
+
+    // Copy the message into the ring buffer
+    hdr = (log_rec_hdr_t *) &ring->buf[pos];
+    hdr->len = len;
+    hdr->seq = __atomic_fetch_add(&log_seq, 1, __ATOMIC_RELAXED);
+    memcpy(&hdr[1], str, len);
+    ring->buf[pos + sizeof(log_rec_hdr_t) + len] = '\0';
+
+    // Publish the message to the log flusher
+    __atomic_store_n(&ring->head, head + size, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/*********************************************************************//**
+**
+** GetThreadLogRing
+**
+** Returns the ring buffer owned by the calling thread, allocating it, if this is the first time that the thread has logged
+**
+** \param   None
+**
+** \return  pointer to ring buffer, or NULL if the thread must log synchronously
+**
+**************************************************************************/
+log_ring_t *GetThreadLogRing(void)
+{
+    log_ring_t *ring;
+    int index;
+
+    // Exit if this thread already has a ring buffer, or was unable to get one
+    if ((thread_log_ring != NULL) || (thread_log_ring_failed))
+    {
+        return thread_log_ring;
+    }
+
+    // Exit if all ring buffers have already been claimed by other threads
+    index = __atomic_fetch_add(&num_log_rings, 1, __ATOMIC_ACQ_REL);
+    if (index >= MAX_LOG_RINGS)
+    {
+        thread_log_ring_failed = true;
+        return NULL;
+    }
+
+    // Exit if unable to allocate the ring buffer
+    // NOTE: malloc() is used directly, since USP_MALLOC() may itself log
+    ring = calloc(1, sizeof(log_ring_t));
+    if (ring == NULL)
+    {
+        thread_log_ring_failed = true;
+        return NULL;
+    }
+
+    // Make the ring buffer visible to the log flusher
+    // NOTE: Ring buffers are never freed, as the owning thread may log at any time until the process exits
+    __atomic_store_n(&log_rings[index], ring, __ATOMIC_RELEASE);
+    thread_log_ring = ring;
+
+    return ring;
+}
+
+/*********************************************************************//**
+**
+** LogFlusherMain
+**
+** Main loop of the log flusher thread. Periodically writes out the log messages in all ring buffers.
+**
+** \param   args - unused
+**
+** \return  NULL
+**
+**************************************************************************/
+void *LogFlusherMain(void *args)
+{
+    while (log_async)
+    {
+        usleep(LOG_FLUSH_PERIOD_MS*1000);
+        FlushLogRings(false);
+    }
+
+    return NULL;
+}
+
+/*********************************************************************//**
+**
+** FlushLogRings
+**
+** Writes out all log messages currently in the ring buffers, in the order that they were logged
+** Then reports any messages which have been dropped since the last time this function was called,
+** the number of repeated debug level messages suppressed in runs which have ended,
+** and the number of error/warning messages suppressed by call sites whose rate limiting window has expired
+**
+** \param   is_final - set if no more messages will be buffered, so all suppressed repeats should be reported now
+**
+** \return  None
+**
+**************************************************************************/
+void FlushLogRings(bool is_final)
+{
+    unsigned heads[MAX_LOG_RINGS];
+    unsigned tails[MAX_LOG_RINGS];
+    log_rec_hdr_t *hdrs[MAX_LOG_RINGS];
+    log_ring_t *ring;
+    log_rec_hdr_t *hdr;
+    int num_rings;
+    int best;
+    int count = 0;
+    unsigned dropped;
+    time_t cur_time;
+    char buf[128];
+    int i;
+
+    OS_UTILS_LockMutex(&log_flush_mutex);
+    thread_is_flushing = true;
+
+    // Snapshot the messages currently in each ring buffer
+    num_rings = __atomic_load_n(&num_log_rings, __ATOMIC_ACQUIRE);
+    num_rings = MIN(num_rings, MAX_LOG_RINGS);
+    for (i=0; i<num_rings; i++)
+    {
+        hdrs[i] = NULL;
+        ring = __atomic_load_n(&log_rings[i], __ATOMIC_ACQUIRE);
+        if (ring != NULL)
+        {
+            heads[i] = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+            tails[i] = ring->tail;
+        }
+        else
+        {
+            heads[i] = 0;
+            tails[i] = 0;
+        }
+    }
+
+    // Repeatedly write out the earliest logged message from all of the ring buffers
+    while (1)
+    {
+        best = INVALID;
+        for (i=0; i<num_rings; i++)
+        {
+            // Skip this ring buffer if it has no (more) messages to write out
+            if (tails[i] == heads[i])
+            {
+                continue;
+            }
+
+            // Skip over any wrap marker
+            if (hdrs[i] == NULL)
+            {
+                ring = log_rings[i];
+                hdr = (log_rec_hdr_t *) &ring->buf[ tails[i] & (LOG_RING_SIZE-1) ];
+                if (hdr->len == LOG_RING_WRAP)
+                {
+                    tails[i] += LOG_RING_SIZE - (tails[i] & (LOG_RING_SIZE-1));
+                    hdr = (log_rec_hdr_t *) &ring->buf[0];
+                }
+                hdrs[i] = hdr;
+            }
+
+            // NOTE: Sequence numbers are compared in a way which copes with them wrapping
+            if ((best == INVALID) || ((int)(hdrs[i]->seq - hdrs[best]->seq) < 0))
+            {
+                best = i;
+            }
+        }
+
+        // Exit loop if all messages have been written out
+        if (best == INVALID)
+        {
+            break;
+        }
+
+        // Write out the message, then free its space in the ring buffer
+        hdr = hdrs[best];
+        LogMessageToFile(log_fd, (char *) &hdr[1], false);
+        tails[best] += LOG_REC_SIZE(hdr->len);
+        hdrs[best] = NULL;
+        __atomic_store_n(&log_rings[best]->tail, tails[best], __ATOMIC_RELEASE);
+        count++;
+    }
+
+    // Report any messages which have been dropped, and the number of repeated messages suppressed
+    cur_time = time(NULL);
+    for (i=0; i<num_rings; i++)
+    {
+        ring = log_rings[i];
+        if (ring != NULL)
+        {
+            count += FlushRepeatCount(ring, cur_time, is_final);
+
+            dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+            if (dropped != ring->dropped_reported)
+            {
+                USP_SNPRINTF(buf, sizeof(buf), "WARNING: Log buffer full. Dropped %u log messages (%u in total from this thread)", dropped - ring->dropped_reported, dropped);
+                LogMessageToFile(log_fd, buf, false);
+                ring->dropped_reported = dropped;
+                count++;
+            }
+        }
+    }
+
+    // Report the number of error/warning messages suppressed by call sites whose window has expired
+    count += FlushSuppressedCounts(cur_time, is_final);
+
+    // Flush the log file once for all of the messages written out
+    if ((count > 0) && (log_fd != NULL))
+    {
+        fflush(log_fd);
+    }
+
+    thread_is_flushing = false;
+    OS_UTILS_UnlockMutex(&log_flush_mutex);
+}
+
+/*********************************************************************//**
+**
+** FlushRepeatCount
+**
+** Writes out the number of times that the last debug level message of the thread owning the specified ring buffer was suppressed,
+** if the run of repeats has ended (ie the suppression window has expired)
+** NOTE: This function must be called with log_flush_mutex held
+**
+** \param   ring - pointer to ring buffer of the thread
+** \param   cur_time - current time
+** \param   is_final - set if the number of suppressed messages should be written out, even if the suppression window has not expired
+**
+** \return  number of lines written out
+**
+**************************************************************************/
+int FlushRepeatCount(log_ring_t *ring, time_t cur_time, bool is_final)
+{
+    log_repeat_t *rs;
+    time_t last_time;
+    unsigned repeats;
+    char buf[64];
+
+    // Exit if no messages have been suppressed
+    rs = &ring->repeat;
+    if (__atomic_load_n(&rs->repeats, __ATOMIC_RELAXED) == 0)
+    {
+        return 0;
+    }
+
+    // Exit if further repeats of the message may still be suppressed
+    last_time = __atomic_load_n(&rs->time, __ATOMIC_RELAXED);
+    if ((is_final == false) && (last_time != 0) && (cur_time - last_time < LOG_REPEAT_WINDOW))
+    {
+        return 0;
+    }
+
+    // Exit if the owning thread has reported the suppressed messages itself in the meantime
+    repeats = __atomic_exchange_n(&rs->repeats, 0, __ATOMIC_RELAXED);
+    if (repeats == 0)
+    {
+        return 0;
+    }
+
+    USP_SNPRINTF(buf, sizeof(buf), "(Last message repeated %u times)", repeats);
+    LogMessageToFile(log_fd, buf, false);
+    return 1;
+}
+
+/*********************************************************************//**
+**
+** FlushSuppressedCounts
+**
+** Writes out the number of error/warning messages suppressed by each call site whose rate limiting window has expired
+** NOTE: This function must be called with log_flush_mutex held
+**
+** \param   cur_time - current time
+** \param   is_final - set if the number of suppressed messages should be written out, even if the window has not expired
+**
+** \return  number of lines written out
+**
+**************************************************************************/
+int FlushSuppressedCounts(time_t cur_time, bool is_final)
+{
+    log_limit_t *limit;
+    time_t window_start;
+    unsigned suppressed;
+    int count = 0;
+
+    limit = __atomic_load_n(&limited_call_sites, __ATOMIC_ACQUIRE);
+    while (limit != NULL)
+    {
+        // Report the messages suppressed by this call site, if its window has expired
+        // NOTE: The count is exchanged with 0, in case the call site has reported it itself in the meantime
+        window_start = __atomic_load_n(&limit->window_start, __ATOMIC_RELAXED);
+        if ((is_final) || (cur_time - window_start >= LOG_REPEAT_WINDOW))
+        {
+            suppressed = __atomic_exchange_n(&limit->suppressed, 0, __ATOMIC_RELAXED);
+            if (suppressed > 0)
+            {
+                ReportSuppressedCount(limit, suppressed, true);
+                count++;
+            }
+        }
+
+        limit = limit->next;
+    }
+
+    return count;
+}
+
+/*********************************************************************//**
+**
+** ReportSuppressedCount
+**
+** Logs the number of error/warning messages suppressed by the specified call site
+**
+** \param   limit - pointer to rate limiting state of the call site
+** \param   suppressed - number of messages suppressed
+** \param   is_flusher - set if called when writing out the ring buffers (with log_flush_mutex held), rather than by the logging thread
+**
+** \return  None
+**
+**************************************************************************/
+void ReportSuppressedCount(log_limit_t *limit, unsigned suppressed, bool is_flusher)
+{
+    char buf[256];
+
+    USP_SNPRINTF(buf, sizeof(buf), "(Suppressed %u further messages logged at %s:%d within %d seconds)", suppressed, limit->file, limit->line, LOG_REPEAT_WINDOW);
+    if (is_flusher)
+    {
+        LogMessageToFile(log_fd, buf, false);
+    }
+    else
+    {
+        USP_LOG_Puts(kLogType_Debug, buf);
+    }
+}
+
 /*********************************************************************//**
 **
 ** LogMessageToFile
@@ -420,11 +1141,12 @@ void USP_LOG_Puts(log_type_t log_type, char *str)
 **
 ** \param   fd - file to log the string to, or NULL if logging to syslog
 ** \param   str - pointer to string to log
+** \param   flush - set if the file should be flushed after writing the string. The log flusher flushes once per batch of messages instead
 **
 ** \return  None
 **
 **************************************************************************/
-void LogMessageToFile(FILE *fd, char *str)
+void LogMessageToFile(FILE *fd, char *str, bool flush)
 {
     log_message_cb_t log_message_cb;
 
@@ -436,7 +1158,10 @@ void LogMessageToFile(FILE *fd, char *str)
     else
     {
         fprintf(fd, "%s\n", str);
-        fflush(fd);
+        if (flush)
+        {
+            fflush(fd);
+        }
     }
 
     // Send the message to the vendor hook
@@ -41,6 +41,8 @@
 #ifndef USP_LOG_H
 #define USP_LOG_H
 
+#include <time.h>
+
 //------------------------------------------------------------------------------------
 // Enumeration for type of information being logged
 typedef enum
@@ -59,18 +61,40 @@ typedef enum
 typedef enum
 {
     kLogType_Debug,
+    kLogType_Verbose,       // Debug level messages (see USP_LOG_Debug). Identical consecutive messages are suppressed (see LOG_REPEAT_WINDOW)
     kLogType_Dump,
     kLogType_Protocol
 } log_type_t;
 
+//------------------------------------------------------------------------------------
+// State used to rate limit the error and warning messages logged at a single call site (see USP_LOG_Error and USP_LOG_Warning)
+// At most LOG_LIMIT_BURST messages are logged from each call site within LOG_REPEAT_WINDOW seconds. Further messages are
+// suppressed, and the number suppressed is logged when the window expires
+// NOTE: There is one instance of this structure per call site, declared statically by the logging macros
+typedef struct log_limit_s
+{
+    const char *file;           // Source file containing the call site
+    int line;                   // Line number of the call site
+    time_t window_start;        // Time at which the current window started, or 0 if no message has been logged yet
+    unsigned count;             // Number of messages logged or suppressed in the current window
+    unsigned suppressed;        // Number of messages suppressed, which have not yet been reported
+    bool is_listed;             // Set once this call site has been added to the list of call sites which have suppressed messages
+    struct log_limit_s *next;   // Next call site in the list of call sites which have suppressed messages
+} log_limit_t;
+
+#define LOG_LIMIT_INIT  { __FILE__, __LINE__, 0, 0, 0, false, NULL }
+
 //------------------------------------------------------------------------------------
 // API
 void USP_LOG_Init(void);
 int USP_LOG_SetFile(char *file);
+int USP_LOG_StartAsync(void);
+void USP_LOG_StopAsync(void);
 void USP_LOG_Callstack(void);
 void USP_LOG_HexBufferLong(char *title, unsigned char *buf, int len);
 void USP_LOG_String(log_type_t log_type, char *str);
 void USP_LOG_Printf(log_type_t log_type, char *fmt, ...) __attribute__((format(printf, 2, 3)));
+bool USP_LOG_PrintfLimited(log_limit_t *limit, char *fmt, ...) __attribute__((format(printf, 2, 3)));
 void USP_LOG_Puts(log_type_t log_type, char *str);
 
 //------------------------------------------------------------------------------------
@@ -79,16 +103,18 @@ extern log_level_t usp_log_level;
 extern bool enable_protocol_trace;
 extern bool enable_callstack_debug;
 
-#define USP_LOG_Error(...)       if (usp_log_level >= kLogLevel_Error)   { USP_LOG_Printf(kLogType_Debug, __VA_ARGS__); if (enable_callstack_debug) { USP_LOG_Callstack(); } }
-#define USP_LOG_Warning(...)     if (usp_log_level >= kLogLevel_Warning) { USP_LOG_Printf(kLogType_Debug, __VA_ARGS__); }
+// NOTE: Error and warning messages are rate limited per call site (see log_limit_t), so that eg a repeatedly failing connection does not flood the log
+#define USP_LOG_Error(...)       if (usp_log_level >= kLogLevel_Error)   { static log_limit_t usp_log_limit = LOG_LIMIT_INIT; if (USP_LOG_PrintfLimited(&usp_log_limit, __VA_ARGS__) && enable_callstack_debug) { USP_LOG_Callstack(); } }
+#define USP_LOG_Warning(...)     if (usp_log_level >= kLogLevel_Warning) { static log_limit_t usp_log_limit = LOG_LIMIT_INIT; USP_LOG_PrintfLimited(&usp_log_limit, __VA_ARGS__); }
 #define USP_LOG_Info(...)        if (usp_log_level >= kLogLevel_Info)    { USP_LOG_Printf(kLogType_Debug, __VA_ARGS__); }
-#define USP_LOG_Debug(...)       if (usp_log_level >= kLogLevel_Debug)   { USP_LOG_Printf(kLogType_Debug, __VA_ARGS__); }
+#define USP_LOG_Debug(...)       if (usp_log_level >= kLogLevel_Debug)   { USP_LOG_Printf(kLogType_Verbose, __VA_ARGS__); }
 
 // Macro used to dump out the data model/database etc
 #define USP_DUMP(...)       USP_LOG_Printf(kLogType_Dump, __VA_ARGS__)
 
 // Macro used to print out STOMP frames
-#define USP_PROTOCOL(...)   USP_LOG_Printf(kLogType_Protocol, __VA_ARGS__)
+// NOTE: The arguments are only formatted if protocol tracing is enabled
+#define USP_PROTOCOL(...)   do { if (enable_protocol_trace) { USP_LOG_Printf(kLogType_Protocol, __VA_ARGS__); } } while (0)
 
 
 #endif
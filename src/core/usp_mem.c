@@ -46,6 +46,7 @@
 #include <malloc.h>
 #include <protobuf-c/protobuf-c.h>
 #include <pthread.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <dlfcn.h>
 
@@ -85,6 +86,94 @@ bool collect_memory_info = false;
 int baseline_memory_usage = INVALID;
 
 static minfo_t *minfo = NULL;
+
+//------------------------------------------------------------------------------------
+// Low overhead memory tracking, suitable for use in production (enabled by the '--memtrack' command line option)
+// Live allocations are stored in a hash table, sharded by pointer (to reduce lock contention), and
+// aggregated into per call site counters. The callstack is captured for 1 in every N allocations at each call site
+typedef struct
+{
+    uintptr_t addr;                 // Address of the allocated memory, or 0 if this slot is free
+    int size;                       // Size of the allocation
+    int site;                       // Index of the call site in mem_sites[] which made the allocation
+} mem_track_entry_t;
+
+typedef struct
+{
+    pthread_mutex_t mutex;          // Protects access to this shard
+    mem_track_entry_t *entries;     // Open addressed (linear probing) hash table of live allocations
+    int capacity;                   // Number of slots in the entries array (always a power of 2)
+    int num_entries;                // Number of slots in use
+} mem_track_shard_t;
+
+#define MEM_TRACK_SHARDS  16                // Must be a power of 2
+#define MEM_TRACK_INITIAL_CAPACITY  1024    // Must be a power of 2
+static mem_track_shard_t mem_track_shards[MEM_TRACK_SHARDS];
+
+typedef struct
+{
+    int in_use;                     // Set (with release semantics) after func and line have been filled in
+    const char *func;               // Name of the function which made the allocation
+    int line;                       // Line number of the allocation
+    long long live_bytes;           // Number of bytes currently allocated by this call site
+    int live_allocs;                // Number of allocations made by this call site which have not been freed
+    unsigned total_allocs;          // Total number of allocations made by this call site
+    void *callstack[12];            // Return addresses of the most recently sampled callstack (unresolved, to keep sampling cheap)
+    int callstack_depth;            // Number of entries in callstack[]
+} mem_site_t;
+
+#define MAX_MEM_SITES 2048          // Must be a power of 2. NOTE: The first entry is used for allocations from call sites which don't fit in the table
+static mem_site_t *mem_sites = NULL;
+static pthread_mutex_t mem_sites_mutex;   // Protects addition of call sites and update of sampled callstacks
+
+// Set if memory tracking is enabled. This is only set at startup (before other threads have been started)
+static bool track_memory = false;
+
+// The callstack is captured for 1 in every mem_track_sample_rate allocations at each call site
+static unsigned mem_track_sample_rate = 1;
+
+//------------------------------------------------------------------------------------
+// Arena used to allocate the protobuf structures associated with handling a single USP record
+// (the unpacked USP record, the unpacked USP message, and the response message tree)
+// Allocations are made by bumping a pointer within a chunk, and all chunks are freed in one go by USP_MEM_ArenaStop()
+typedef struct arena_chunk_tag
+{
+    struct arena_chunk_tag *next;   // Next (older) chunk in the arena
+    int size;                       // Number of bytes in the data area of this chunk
+    int used;                       // Number of bytes of the data area which have been allocated
+    int last;                       // Offset of the block allocated last from this chunk (or INVALID). Used to grow blocks in place
+} arena_chunk_t;
+
+// Each block allocated from the arena is preceded by this header
+typedef struct
+{
+    int capacity;                   // Number of bytes available in this block (not including this header)
+    int pad;                        // Ensures that the block following this header is aligned
+} arena_block_t;
+
+// Alignment (in bytes) of all blocks allocated from the arena
+#define ARENA_ALIGN 8
+#define ARENA_ROUND_UP(x) ( ((x) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1) )
+
+// Pointer to the start of the (aligned) data area of a chunk, following the chunk header
+#define ARENA_CHUNK_DATA(chunk)  ( (unsigned char *)(chunk) + ARENA_ROUND_UP(sizeof(arena_chunk_t)) )
+
+// Size of the first chunk in the arena. This chunk is kept between USP records, so that steady state handling of small messages does not call malloc()
+#define ARENA_INITIAL_CHUNK_SIZE  (16*1024)
+
+typedef struct
+{
+    arena_chunk_t *chunks;          // Linked list of chunks, most recently allocated first. The last chunk in the list is the initial chunk
+    int num_allocs;                 // Number of blocks allocated from the arena since it was started. For debug
+    int num_bytes;                  // Number of bytes allocated from the arena since it was started (including headers). For debug
+} mem_arena_t;
+
+static mem_arena_t msg_arena = { NULL, 0, 0 };
+
+// Pointer to the arena being used by the current thread, or NULL if allocations should not be made from an arena
+// NOTE: This is thread local, as the MTP thread may unpack protobuf messages (for protocol trace) whilst the data model thread is handling a USP record
+static __thread mem_arena_t *active_arena = NULL;
+
 //------------------------------------------------------------------------------------
 // Forward declarations. Note these are not static, because we need them in the symbol table for USP_LOG_Callstack() to show them
 void *Protobuf_Alloc(void *allocator_data, size_t size);
@@ -93,6 +182,16 @@ minfo_t *FindFreeMemInfo(void);
 minfo_t *FindMemInfoByPtr(void *ptr);
 void PrintMemInfoEntry(minfo_t *mi, char *str, int index);
 void GetCallers(char **callers, int num_callers);
+arena_chunk_t *NewArenaChunk(int min_size, arena_chunk_t *next);
+void TrackAlloc(const char *func, int line, void *ptr, int size);
+bool TrackFree(uintptr_t addr, mem_track_entry_t *removed);
+void RestoreTrackedAlloc(mem_track_entry_t *removed);
+void AddMemTrackEntry(uintptr_t addr, int size, int site);
+int FindMemSite(const char *func, int line);
+mem_track_shard_t *FindMemTrackShard(uintptr_t addr, unsigned *hash);
+void GrowMemTrackShard(mem_track_shard_t *shard);
+int CompareMemSitesByLiveBytes(const void *a, const void *b);
+arena_chunk_t *FindArenaChunk(void *ptr);
 
 //------------------------------------------------------------------------------------
 // Structure defining functions used to allocate and free memory associated with protocol buffers
@@ -124,7 +223,7 @@ void *Protobuf_Alloc(void *allocator_data, size_t size)
 {
     void *ptr;
 
-    ptr = USP_MALLOC(size);
+    ptr = USP_ARENA_MALLOC(size);
 
     return ptr;
 }
@@ -143,7 +242,7 @@ void *Protobuf_Alloc(void *allocator_data, size_t size)
 **************************************************************************/
 void Protobuf_Free(void *allocator_data, void *pointer)
 {
-    USP_FREE(pointer);
+    USP_ARENA_FREE(pointer);
 }
 
 /*********************************************************************//**
@@ -200,6 +299,12 @@ void *USP_MEM_Malloc(const char *func, int line, int size)
         USP_ERR_Terminate("%s (%d): malloc(%d bytes) failed", func, line, size);
     }
 
+    // Track the allocation, if enabled
+    if (track_memory)
+    {
+        TrackAlloc(func, line, ptr, size);
+    }
+
     // Collect memory info, if enabled
     if (collect_memory_info)
     {
@@ -244,6 +349,12 @@ void USP_MEM_Free(const char *func, int line, void *ptr)
 {
     minfo_t *mi;
     
+    // Stop tracking the allocation, if enabled
+    if (track_memory)
+    {
+        TrackFree((uintptr_t)ptr, NULL);
+    }
+
     // Free the memory
     free(ptr);
 
@@ -283,14 +394,36 @@ void *USP_MEM_Realloc(const char *func, int line, void *ptr, int size)
 {
     minfo_t *mi;
     void *new_ptr;
+    uintptr_t old_addr;
+    mem_track_entry_t removed;
+    bool is_tracked = false;
+
+    // Stop tracking the current allocation before calling realloc(), as once realloc() has returned, the old address
+    // may have been freed and handed out to another thread (which would add its own tracking entry for it)
+    old_addr = (uintptr_t)ptr;
+    if (track_memory)
+    {
+        is_tracked = TrackFree(old_addr, &removed);
+    }
 
     // Terminate if out of memory
     new_ptr = realloc(ptr, size);
     if (new_ptr == NULL)
     {
+        // NOTE: The original allocation is still valid, so restore its tracking entry
+        if (is_tracked)
+        {
+            RestoreTrackedAlloc(&removed);
+        }
         USP_ERR_Terminate("%s (%d): realloc(%d bytes) failed", func, line, size);
     }
 
+    // Track the reallocation, if enabled
+    if (track_memory)
+    {
+        TrackAlloc(func, line, new_ptr, size);
+    }
+
     // Collect memory info, if enabled
     if (collect_memory_info)
     {
@@ -316,6 +449,38 @@ void *USP_MEM_Realloc(const char *func, int line, void *ptr, int size)
     return new_ptr;
 }
 
+/*********************************************************************//**
+**
+** USP_MEM_ReallocGeometric
+**
+** Ensures that a buffer which is being grown incrementally (eg the array of a vector) is at least the specified size
+** The buffer is only reallocated if it is not already big enough, and then to at least double its current size,
+** so that growing a buffer one element at a time results in O(log n) reallocations, rather than O(n)
+** NOTE: The current capacity of the buffer is obtained from the heap (rather than being stored by the caller),
+**       so this works for buffers regardless of how they were allocated (eg by vendor code)
+**
+** \param   func - name of caller
+** \param   line - line number of caller
+** \param   ptr - pointer to current buffer (or NULL if none allocated yet)
+** \param   size - minimum number of bytes required in the buffer
+**
+** \return  pointer to buffer (which may have been moved)
+**
+**************************************************************************/
+void *USP_MEM_ReallocGeometric(const char *func, int line, void *ptr, int size)
+{
+    int capacity;
+
+    // Exit if the buffer is already big enough
+    capacity = (ptr == NULL) ? 0 : (int) malloc_usable_size(ptr);
+    if (size <= capacity)
+    {
+        return ptr;
+    }
+
+    return USP_MEM_Realloc(func, line, ptr, MAX(size, 2*capacity));
+}
+
 /*********************************************************************//**
 **
 ** USP_MEM_Strdup
@@ -349,6 +514,12 @@ void *USP_MEM_Strdup(const char *func, int line, void *ptr)
         USP_ERR_Terminate("%s (%d): strdup(%d bytes) failed", func, line, (int)strlen(ptr)+1);
     }
 
+    // Track the allocation, if enabled
+    if (track_memory)
+    {
+        TrackAlloc(func, line, new_ptr, strlen(ptr)+1);
+    }
+
 
     // Collect memory info, if enabled
     if (collect_memory_info)
@@ -407,13 +578,18 @@ void USP_MEM_StartCollection(void)
     baseline_memory_usage = mallinfo().uordblks;
     USP_LOG_Info("Baseline Memory usage: %d", baseline_memory_usage);
 
-    // The sync timer vector is reallocated by BulkDataCollection after collection has been started,
+    // The sync timer vector (and its hash table) is reallocated by BulkDataCollection after collection has been started,
     // so needs to be in the meminfo array (otherwise we assert that a realloc has occured before an alloc)
     mi = FindFreeMemInfo();
     USP_ASSERT(mi != NULL);
     mi->ptr = SYNC_TIMER_PRIV_GetVector(&mi->size);
     mi->func = sync_timer_add_str;
 
+    mi = FindFreeMemInfo();
+    USP_ASSERT(mi != NULL);
+    mi->ptr = SYNC_TIMER_PRIV_GetSlots(&mi->size);
+    mi->func = sync_timer_add_str;
+
     OS_UTILS_UnlockMutex(&mem_access_mutex);
 }
 
@@ -587,6 +763,856 @@ int USP_MEM_PrintAll(void)
 }
 
 
+/*********************************************************************//**
+**
+** USP_MEM_StartTracking
+**
+** Starts low overhead tracking of all memory allocations, aggregated by call site
+** NOTE: This must be called before any threads other than the data model thread have been started
+**       Memory allocated before tracking was started is not tracked
+**
+** \param   sample_rate - the callstack is captured for 1 in every sample_rate allocations at each call site
+**
+** \return  USP_ERR_OK if successful
+**
+**************************************************************************/
+int USP_MEM_StartTracking(unsigned sample_rate)
+{
+    int i;
+    int err;
+    mem_track_shard_t *shard;
+
+    // Exit if tracking has already been started
+    if (track_memory)
+    {
+        return USP_ERR_OK;
+    }
+
+    // Exit if unable to create the mutex protecting the call sites
+    err = OS_UTILS_InitMutex(&mem_sites_mutex);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Allocate the call site table
+    // NOTE: calloc() is used directly (rather than USP_MALLOC) to avoid the tracking code tracking itself
+    mem_sites = calloc(MAX_MEM_SITES, sizeof(mem_site_t));
+    if (mem_sites == NULL)
+    {
+        USP_ERR_Terminate("%s: calloc(%d bytes) failed", __FUNCTION__, (int)(MAX_MEM_SITES*sizeof(mem_site_t)));
+    }
+    mem_sites[0].in_use = true;
+    mem_sites[0].func = "Other (call site table full)";
+
+    // Initialise all shards of the hash table
+    for (i=0; i<MEM_TRACK_SHARDS; i++)
+    {
+        shard = &mem_track_shards[i];
+        err = OS_UTILS_InitMutex(&shard->mutex);
+        if (err != USP_ERR_OK)
+        {
+            return err;
+        }
+
+        shard->capacity = MEM_TRACK_INITIAL_CAPACITY;
+        shard->num_entries = 0;
+        shard->entries = calloc(shard->capacity, sizeof(mem_track_entry_t));
+        if (shard->entries == NULL)
+        {
+            USP_ERR_Terminate("%s: calloc(%d bytes) failed", __FUNCTION__, (int)(shard->capacity*sizeof(mem_track_entry_t)));
+        }
+    }
+
+    mem_track_sample_rate = (sample_rate == 0) ? 1 : sample_rate;
+    track_memory = true;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** USP_MEM_DumpTopAllocators
+**
+** Dumps the call sites which currently have the most memory allocated
+**
+** \param   max_sites - maximum number of call sites to dump
+**
+** \return  None
+**
+**************************************************************************/
+void USP_MEM_DumpTopAllocators(int max_sites)
+{
+    int i, j;
+    mem_site_t *snapshot;
+    mem_site_t *ms;
+    int num_sites = 0;
+    long long total_bytes = 0;
+    int total_allocs = 0;
+    Dl_info info;
+    const char *name;
+
+    // Exit if memory tracking is not enabled
+    if (track_memory == false)
+    {
+        USP_DUMP("Memory tracking is not enabled. Start USP Agent with the '--memtrack' option");
+        return;
+    }
+
+    // Take a snapshot of the call sites, so that they can be sorted without holding the mutex
+    // NOTE: malloc() is used directly (rather than USP_MALLOC), so that the snapshot does not appear in the dump
+    snapshot = malloc(MAX_MEM_SITES*sizeof(mem_site_t));
+    if (snapshot == NULL)
+    {
+        USP_ERR_Terminate("%s: malloc(%d bytes) failed", __FUNCTION__, (int)(MAX_MEM_SITES*sizeof(mem_site_t)));
+    }
+
+    OS_UTILS_LockMutex(&mem_sites_mutex);
+    for (i=0; i<MAX_MEM_SITES; i++)
+    {
+        if (__atomic_load_n(&mem_sites[i].in_use, __ATOMIC_ACQUIRE))
+        {
+            ms = &snapshot[num_sites++];
+            memcpy(ms, &mem_sites[i], sizeof(mem_site_t));
+            ms->live_bytes = __atomic_load_n(&mem_sites[i].live_bytes, __ATOMIC_RELAXED);
+            ms->live_allocs = __atomic_load_n(&mem_sites[i].live_allocs, __ATOMIC_RELAXED);
+            total_bytes += ms->live_bytes;
+            total_allocs += ms->live_allocs;
+        }
+    }
+    OS_UTILS_UnlockMutex(&mem_sites_mutex);
+
+    // Sort the call sites by the number of bytes they currently have allocated
+    qsort(snapshot, num_sites, sizeof(mem_site_t), CompareMemSitesByLiveBytes);
+
+    USP_DUMP("Tracked memory in use: %lld bytes in %d allocations, from %d call sites (callstack sampled 1 in %u)", total_bytes, total_allocs, num_sites, mem_track_sample_rate);
+    for (i=0; (i < num_sites) && (i < max_sites); i++)
+    {
+        ms = &snapshot[i];
+        if (ms->live_allocs == 0)
+        {
+            break;
+        }
+
+        USP_DUMP("%lld bytes in %d allocations (%u total) %s (line number:%d)", ms->live_bytes, ms->live_allocs, ms->total_allocs, ms->func, ms->line);
+        for (j=0; j < ms->callstack_depth; j++)
+        {
+            name = "Unknown";
+            if ((dladdr(ms->callstack[j], &info) != 0) && (info.dli_sname != NULL))
+            {
+                name = info.dli_sname;
+            }
+            USP_DUMP("   %s", name);
+        }
+    }
+
+    free(snapshot);
+}
+
+/*********************************************************************//**
+**
+** TrackAlloc
+**
+** Adds the specified allocation to the memory tracking hash table, and updates the counters of its call site
+**
+** \param   func - name of caller
+** \param   line - line number of caller
+** \param   ptr - pointer to allocated memory
+** \param   size - size of the allocation
+**
+** \return  None
+**
+**************************************************************************/
+void TrackAlloc(const char *func, int line, void *ptr, int size)
+{
+    mem_site_t *ms;
+    unsigned count;
+    int site;
+    void *callstack[NUM_ELEM(ms->callstack)+1];
+    int depth;
+
+    // Update the counters for the call site
+    site = FindMemSite(func, line);
+    ms = &mem_sites[site];
+    __atomic_add_fetch(&ms->live_bytes, size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ms->live_allocs, 1, __ATOMIC_RELAXED);
+    count = __atomic_add_fetch(&ms->total_allocs, 1, __ATOMIC_RELAXED);
+
+    // Capture the callstack, if this allocation is sampled
+    // NOTE: The first entry in the callstack is this function, so is skipped
+    if ((count % mem_track_sample_rate) == 0)
+    {
+        depth = backtrace(callstack, NUM_ELEM(callstack));
+        OS_UTILS_LockMutex(&mem_sites_mutex);
+        ms->callstack_depth = MAX(depth-1, 0);
+        memcpy(ms->callstack, &callstack[1], ms->callstack_depth*sizeof(void *));
+        OS_UTILS_UnlockMutex(&mem_sites_mutex);
+    }
+
+    // Add the allocation to the hash table
+    AddMemTrackEntry((uintptr_t)ptr, size, site);
+}
+
+/*********************************************************************//**
+**
+** AddMemTrackEntry
+**
+** Adds an entry for the specified allocation to the memory tracking hash table
+**
+** \param   addr - address of allocated memory
+** \param   size - size of the allocation
+** \param   site - index of the call site in mem_sites[] which made the allocation
+**
+** \return  None
+**
+**************************************************************************/
+void AddMemTrackEntry(uintptr_t addr, int size, int site)
+{
+    mem_track_shard_t *shard;
+    mem_track_entry_t *entry;
+    unsigned hash;
+    unsigned mask;
+
+    shard = FindMemTrackShard(addr, &hash);
+    OS_UTILS_LockMutex(&shard->mutex);
+    if (2*(shard->num_entries+1) > shard->capacity)
+    {
+        GrowMemTrackShard(shard);
+    }
+
+    mask = shard->capacity - 1;
+    entry = &shard->entries[hash & mask];
+    while (entry->addr != 0)
+    {
+        hash++;
+        entry = &shard->entries[hash & mask];
+    }
+
+    entry->addr = addr;
+    entry->size = size;
+    entry->site = site;
+    shard->num_entries++;
+    OS_UTILS_UnlockMutex(&shard->mutex);
+}
+
+/*********************************************************************//**
+**
+** RestoreTrackedAlloc
+**
+** Restores an allocation which was removed from the memory tracking hash table by TrackFree()
+** This is used if realloc() fails, as the original allocation is still valid
+**
+** \param   removed - pointer to entry returned by TrackFree()
+**
+** \return  None
+**
+**************************************************************************/
+void RestoreTrackedAlloc(mem_track_entry_t *removed)
+{
+    mem_site_t *ms;
+
+    AddMemTrackEntry(removed->addr, removed->size, removed->site);
+
+    ms = &mem_sites[removed->site];
+    __atomic_add_fetch(&ms->live_bytes, removed->size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ms->live_allocs, 1, __ATOMIC_RELAXED);
+}
+
+/*********************************************************************//**
+**
+** TrackFree
+**
+** Removes the specified allocation from the memory tracking hash table, and updates the counters of its call site
+** NOTE: Allocations which were made before tracking was started are ignored
+** NOTE: The address is passed as an integer, so that this function may be called before the memory is freed or reallocated
+**
+** \param   addr - address of memory being freed
+** \param   removed - pointer to variable in which to return the entry removed from the hash table, or NULL if not required
+**
+** \return  true if the allocation was being tracked
+**
+**************************************************************************/
+bool TrackFree(uintptr_t addr, mem_track_entry_t *removed)
+{
+    mem_track_shard_t *shard;
+    mem_track_entry_t *entry;
+    mem_site_t *ms;
+    unsigned hash;
+    unsigned mask;
+    unsigned hole;
+    unsigned ideal;
+    int size;
+    int site;
+
+    // Exit if nothing to free
+    if (addr == 0)
+    {
+        return false;
+    }
+
+    // Exit if the allocation is not in the hash table
+    shard = FindMemTrackShard(addr, &hash);
+    OS_UTILS_LockMutex(&shard->mutex);
+    mask = shard->capacity - 1;
+    entry = &shard->entries[hash & mask];
+    while (entry->addr != addr)
+    {
+        if (entry->addr == 0)
+        {
+            OS_UTILS_UnlockMutex(&shard->mutex);
+            return false;
+        }
+        hash++;
+        entry = &shard->entries[hash & mask];
+    }
+
+    size = entry->size;
+    site = entry->site;
+    if (removed != NULL)
+    {
+        *removed = *entry;
+    }
+
+    // Remove the entry, moving back any following entries in the same probe sequence, so that no tombstones are needed
+    hole = hash & mask;
+    hash++;
+    while (shard->entries[hash & mask].addr != 0)
+    {
+        entry = &shard->entries[hash & mask];
+        FindMemTrackShard(entry->addr, &ideal);
+        if (((hash - ideal) & mask) >= ((hash - hole) & mask))
+        {
+            shard->entries[hole] = *entry;
+            hole = hash & mask;
+        }
+        hash++;
+    }
+    shard->entries[hole].addr = 0;
+    shard->num_entries--;
+    OS_UTILS_UnlockMutex(&shard->mutex);
+
+    // Update the counters for the call site
+    ms = &mem_sites[site];
+    __atomic_sub_fetch(&ms->live_bytes, size, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&ms->live_allocs, 1, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+/*********************************************************************//**
+**
+** FindMemSite
+**
+** Finds (or adds) the entry in the call site table for the specified call site
+**
+** \param   func - name of caller
+** \param   line - line number of caller
+**
+** \return  index of the call site in mem_sites[]
+**
+**************************************************************************/
+int FindMemSite(const char *func, int line)
+{
+    unsigned hash;
+    unsigned i;
+    mem_site_t *ms;
+
+    // NOTE: Index 0 is reserved for call sites which do not fit in the table
+    hash = ((unsigned)(((size_t)func) >> 3) ^ ((unsigned)line * 2654435761U)) & (MAX_MEM_SITES-1);
+
+    // Lockless lookup of an existing call site. Call sites are never removed, and func/line are immutable once in_use is set
+    for (i=0; i<MAX_MEM_SITES; i++)
+    {
+        hash = (hash == 0) ? 1 : hash;
+        ms = &mem_sites[hash];
+        if (__atomic_load_n(&ms->in_use, __ATOMIC_ACQUIRE) == false)
+        {
+            break;
+        }
+
+        if ((ms->func == func) && (ms->line == line))
+        {
+            return hash;
+        }
+        hash = (hash + 1) & (MAX_MEM_SITES-1);
+    }
+
+    // Exit if the table is full
+    if (i == MAX_MEM_SITES)
+    {
+        return 0;
+    }
+
+    // Add the call site, re-checking under the mutex whether another thread has added it (or used this slot) in the meantime
+    OS_UTILS_LockMutex(&mem_sites_mutex);
+    for ( ; i<MAX_MEM_SITES; i++)
+    {
+        hash = (hash == 0) ? 1 : hash;
+        ms = &mem_sites[hash];
+        if (ms->in_use == false)
+        {
+            ms->func = func;
+            ms->line = line;
+            __atomic_store_n(&ms->in_use, true, __ATOMIC_RELEASE);
+            OS_UTILS_UnlockMutex(&mem_sites_mutex);
+            return hash;
+        }
+
+        if ((ms->func == func) && (ms->line == line))
+        {
+            OS_UTILS_UnlockMutex(&mem_sites_mutex);
+            return hash;
+        }
+        hash = (hash + 1) & (MAX_MEM_SITES-1);
+    }
+    OS_UTILS_UnlockMutex(&mem_sites_mutex);
+
+    // If the code gets here, then the table became full
+    return 0;
+}
+
+/*********************************************************************//**
+**
+** FindMemTrackShard
+**
+** Determines which shard of the memory tracking hash table stores the specified allocation
+**
+** \param   addr - address of allocated memory
+** \param   hash - pointer to variable in which to return the hash of the address
+**
+** \return  pointer to shard
+**
+**************************************************************************/
+mem_track_shard_t *FindMemTrackShard(uintptr_t addr, unsigned *hash)
+{
+    unsigned long long h;
+
+    // Fibonacci hashing. The bottom bits of the address are discarded, as they are always zero due to alignment
+    h = (((unsigned long long)addr) >> 4) * 11400714819323198485ULL;
+    *hash = (unsigned)(h >> 32);
+
+    return &mem_track_shards[(h >> 28) & (MEM_TRACK_SHARDS-1)];
+}
+
+/*********************************************************************//**
+**
+** GrowMemTrackShard
+**
+** Doubles the capacity of a shard of the memory tracking hash table
+** NOTE: This function must be called with the shard's mutex held
+**
+** \param   shard - pointer to shard to grow
+**
+** \return  None
+**
+**************************************************************************/
+void GrowMemTrackShard(mem_track_shard_t *shard)
+{
+    int i;
+    mem_track_entry_t *old_entries;
+    int old_capacity;
+    mem_track_entry_t *entry;
+    unsigned hash;
+    unsigned mask;
+
+    old_entries = shard->entries;
+    old_capacity = shard->capacity;
+
+    shard->capacity = 2*old_capacity;
+    shard->entries = calloc(shard->capacity, sizeof(mem_track_entry_t));
+    if (shard->entries == NULL)
+    {
+        USP_ERR_Terminate("%s: calloc(%d bytes) failed", __FUNCTION__, (int)(shard->capacity*sizeof(mem_track_entry_t)));
+    }
+
+    // Rehash all entries into the new table
+    mask = shard->capacity - 1;
+    for (i=0; i<old_capacity; i++)
+    {
+        if (old_entries[i].addr != 0)
+        {
+            FindMemTrackShard(old_entries[i].addr, &hash);
+            entry = &shard->entries[hash & mask];
+            while (entry->addr != 0)
+            {
+                hash++;
+                entry = &shard->entries[hash & mask];
+            }
+            *entry = old_entries[i];
+        }
+    }
+
+    free(old_entries);
+}
+
+/*********************************************************************//**
+**
+** CompareMemSitesByLiveBytes
+**
+** qsort() comparison function, used to sort call sites into descending order of the number of bytes they have allocated
+**
+** \param   a - pointer to first call site to compare
+** \param   b - pointer to second call site to compare
+**
+** \return  negative if a should be before b
+**
+**************************************************************************/
+int CompareMemSitesByLiveBytes(const void *a, const void *b)
+{
+    const mem_site_t *ms1 = (const mem_site_t *) a;
+    const mem_site_t *ms2 = (const mem_site_t *) b;
+
+    if (ms1->live_bytes > ms2->live_bytes)
+    {
+        return -1;
+    }
+    else if (ms1->live_bytes < ms2->live_bytes)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*********************************************************************//**
+**
+** USP_MEM_ArenaStart
+**
+** Starts allocating protobuf structures for the calling thread from the message arena
+** This is called before unpacking a received USP record, and USP_MEM_ArenaStop() is called after the response has been queued
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void USP_MEM_ArenaStart(void)
+{
+    // Arenas are not nested, and only one thread (the data model thread) handles USP records
+    USP_ASSERT(active_arena == NULL);
+
+    // Allocate the initial chunk, if this is the first time that the arena has been used
+    if (msg_arena.chunks == NULL)
+    {
+        msg_arena.chunks = NewArenaChunk(ARENA_INITIAL_CHUNK_SIZE, NULL);
+    }
+
+    msg_arena.num_allocs = 0;
+    msg_arena.num_bytes = 0;
+    active_arena = &msg_arena;
+}
+
+/*********************************************************************//**
+**
+** USP_MEM_ArenaStop
+**
+** Frees all memory allocated from the message arena, and stops the calling thread allocating from it
+** NOTE: The initial chunk is kept, ready for the next USP record
+**
+** \param   None
+**
+** \return  None
+**
+**************************************************************************/
+void USP_MEM_ArenaStop(void)
+{
+    arena_chunk_t *chunk;
+    arena_chunk_t *next;
+    int num_chunks = 0;
+
+    USP_ASSERT(active_arena == &msg_arena);
+
+    // Free all chunks, apart from the initial chunk (which is the last in the list)
+    chunk = msg_arena.chunks;
+    while (chunk->next != NULL)
+    {
+        next = chunk->next;
+        free(chunk);
+        chunk = next;
+        num_chunks++;
+    }
+
+    // Reset the initial chunk, so that it can be reused
+    chunk->used = 0;
+    chunk->last = INVALID;
+    msg_arena.chunks = chunk;
+
+    USP_LOG_Debug("%s: %d allocations (%d bytes) in %d chunks", __FUNCTION__, msg_arena.num_allocs, msg_arena.num_bytes, num_chunks+1);
+    active_arena = NULL;
+}
+
+/*********************************************************************//**
+**
+** USP_MEM_IsArenaActive
+**
+** Determines whether protobuf structures are currently being allocated from the message arena by the calling thread
+** If so, unpacked protobuf structures need not be freed individually, as they will be freed by USP_MEM_ArenaStop()
+**
+** \param   None
+**
+** \return  true if the message arena is active
+**
+**************************************************************************/
+bool USP_MEM_IsArenaActive(void)
+{
+    return (active_arena != NULL);
+}
+
+/*********************************************************************//**
+**
+** USP_MEM_ArenaMalloc
+**
+** Allocates memory from the message arena, or from the heap if the arena is not active for the calling thread
+** This function will terminate USP Agent, if out of memory
+**
+** \param   func - name of caller
+** \param   line - line number of caller
+** \param   size - number of bytes to allocate
+**
+** \return  pointer to allocated memory
+**
+**************************************************************************/
+void *USP_MEM_ArenaMalloc(const char *func, int line, int size)
+{
+    arena_chunk_t *chunk;
+    arena_block_t *block;
+    int capacity;
+    int needed;
+
+    // Allocate from the heap, if the arena is not active
+    if (active_arena == NULL)
+    {
+        return USP_MEM_Malloc(func, line, size);
+    }
+
+    // Allocate a new chunk, if there is not enough space left in the current chunk
+    capacity = ARENA_ROUND_UP(MAX(size, 1));
+    needed = sizeof(arena_block_t) + capacity;
+    chunk = active_arena->chunks;
+    if (chunk->used + needed > chunk->size)
+    {
+        chunk = NewArenaChunk(MAX(needed, 2*chunk->size), chunk);
+        active_arena->chunks = chunk;
+    }
+
+    // Bump allocate the block from the chunk
+    block = (arena_block_t *) (ARENA_CHUNK_DATA(chunk) + chunk->used);
+    block->capacity = capacity;
+    chunk->last = chunk->used;
+    chunk->used += needed;
+
+    active_arena->num_allocs++;
+    active_arena->num_bytes += needed;
+
+    return (void *)(block+1);
+}
+
+/*********************************************************************//**
+**
+** USP_MEM_ArenaFree
+**
+** Frees memory allocated by USP_MEM_ArenaMalloc() or USP_MEM_ArenaRealloc()
+** Memory in the message arena is not freed until USP_MEM_ArenaStop() is called (unless it was the last block allocated)
+** Memory which was not allocated from the arena is freed immediately
+**
+** \param   func - name of caller
+** \param   line - line number of caller
+** \param   ptr - pointer to memory to free
+**
+** \return  None
+**
+**************************************************************************/
+void USP_MEM_ArenaFree(const char *func, int line, void *ptr)
+{
+    arena_chunk_t *chunk;
+    int offset;
+
+    // Free from the heap, if the memory was not allocated from the arena
+    chunk = FindArenaChunk(ptr);
+    if (chunk == NULL)
+    {
+        USP_MEM_Free(func, line, ptr);
+        return;
+    }
+
+    // Reclaim the space, if this was the last block allocated from the chunk
+    offset = (unsigned char *)ptr - ARENA_CHUNK_DATA(chunk) - sizeof(arena_block_t);
+    if (offset == chunk->last)
+    {
+        chunk->used = chunk->last;
+        chunk->last = INVALID;
+    }
+}
+
+/*********************************************************************//**
+**
+** USP_MEM_ArenaRealloc
+**
+** Reallocates memory allocated by USP_MEM_ArenaMalloc() or USP_MEM_ArenaRealloc()
+** Blocks in the message arena are grown in place if possible, otherwise they are moved
+** to a new block with at least double the capacity, so that arrays grown one element at a time are copied O(log n) times
+**
+** \param   func - name of caller
+** \param   line - line number of caller
+** \param   ptr - pointer to memory to reallocate (or NULL)
+** \param   size - number of bytes to reallocate
+**
+** \return  pointer to reallocated memory
+**
+**************************************************************************/
+void *USP_MEM_ArenaRealloc(const char *func, int line, void *ptr, int size)
+{
+    arena_chunk_t *chunk;
+    arena_block_t *block;
+    void *new_ptr;
+    int offset;
+    int capacity;
+
+    // Allocate a new block, if none previously allocated
+    if (ptr == NULL)
+    {
+        return USP_MEM_ArenaMalloc(func, line, size);
+    }
+
+    // Reallocate from the heap, if the memory was not allocated from the arena
+    chunk = FindArenaChunk(ptr);
+    if (chunk == NULL)
+    {
+        return USP_MEM_Realloc(func, line, ptr, size);
+    }
+
+    // Exit if the block already has enough capacity
+    block = ((arena_block_t *)ptr) - 1;
+    if (size <= block->capacity)
+    {
+        return ptr;
+    }
+
+    // Exit if the block was the last allocated from its chunk, and can be grown in place
+    capacity = ARENA_ROUND_UP(MAX(size, 2*block->capacity));
+    offset = (unsigned char *)block - ARENA_CHUNK_DATA(chunk);
+    if ((offset == chunk->last) && (offset + (int)sizeof(arena_block_t) + capacity <= chunk->size))
+    {
+        active_arena->num_bytes += capacity - block->capacity;
+        chunk->used = offset + sizeof(arena_block_t) + capacity;
+        block->capacity = capacity;
+        return ptr;
+    }
+
+    // Otherwise move the block. The old block is freed when the arena is stopped
+    new_ptr = USP_MEM_ArenaMalloc(func, line, capacity);
+    memcpy(new_ptr, ptr, block->capacity);
+
+    return new_ptr;
+}
+
+/*********************************************************************//**
+**
+** USP_MEM_ArenaStrdup
+**
+** Copies a string into memory allocated from the message arena (or from the heap if the arena is not active)
+** NOTE: This function treats a NULL input string, as a NULL output
+**
+** \param   func - name of caller
+** \param   line - line number of caller
+** \param   ptr - pointer to buffer containing string to copy
+**
+** \return  pointer to copy of string
+**
+**************************************************************************/
+void *USP_MEM_ArenaStrdup(const char *func, int line, void *ptr)
+{
+    void *new_ptr;
+    int size;
+
+    // Exit if nothing to copy
+    if (ptr == NULL)
+    {
+        return NULL;
+    }
+
+    // Copy from the heap, if the arena is not active
+    if (active_arena == NULL)
+    {
+        return USP_MEM_Strdup(func, line, ptr);
+    }
+
+    size = strlen(ptr) + 1;
+    new_ptr = USP_MEM_ArenaMalloc(func, line, size);
+    memcpy(new_ptr, ptr, size);
+
+    return new_ptr;
+}
+
+/*********************************************************************//**
+**
+** NewArenaChunk
+**
+** Allocates a new chunk for the message arena
+** NOTE: Chunks are not tracked by the memory info debug, as the initial chunk is deliberately kept between USP records
+**
+** \param   min_size - minimum number of bytes which may be allocated from the chunk
+** \param   next - pointer to chunk to link the new chunk in front of
+**
+** \return  pointer to new chunk
+**
+**************************************************************************/
+arena_chunk_t *NewArenaChunk(int min_size, arena_chunk_t *next)
+{
+    arena_chunk_t *chunk;
+
+    // Terminate if out of memory
+    chunk = malloc(ARENA_ROUND_UP(sizeof(arena_chunk_t)) + min_size);
+    if (chunk == NULL)
+    {
+        USP_ERR_Terminate("%s: malloc(%d bytes) failed", __FUNCTION__, min_size);
+    }
+
+    chunk->next = next;
+    chunk->size = min_size;
+    chunk->used = 0;
+    chunk->last = INVALID;
+
+    return chunk;
+}
+
+/*********************************************************************//**
+**
+** FindArenaChunk
+**
+** Finds the chunk of the message arena (active for the calling thread) containing the specified pointer
+**
+** \param   ptr - pointer to memory
+**
+** \return  pointer to chunk, or NULL if the memory was not allocated from the arena
+**
+**************************************************************************/
+arena_chunk_t *FindArenaChunk(void *ptr)
+{
+    arena_chunk_t *chunk;
+    unsigned char *start;
+
+    // Exit if the arena is not active
+    if (active_arena == NULL)
+    {
+        return NULL;
+    }
+
+    chunk = active_arena->chunks;
+    while (chunk != NULL)
+    {
+        start = ARENA_CHUNK_DATA(chunk);
+        if (((unsigned char *)ptr >= start) && ((unsigned char *)ptr < start + chunk->used))
+        {
+            return chunk;
+        }
+        chunk = chunk->next;
+    }
+
+    // If the code gets here, then the memory was not allocated from the arena
+    return NULL;
+}
+
 /*********************************************************************//**
 **
 ** PrintMemInfoEntry
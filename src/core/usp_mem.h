@@ -48,6 +48,17 @@
 #define USP_SAFE_FREE(x)            if (x != NULL) { USP_MEM_Free(__FUNCTION__, __LINE__, x); x = NULL; }
 #define USP_REALLOC(x, y)           USP_MEM_Realloc(__FUNCTION__, __LINE__, x, y)
 #define USP_STRDUP(x)               USP_MEM_Strdup(__FUNCTION__, __LINE__, x)
+#define USP_REALLOC_GEOMETRIC(x, y) USP_MEM_ReallocGeometric(__FUNCTION__, __LINE__, x, y)
+
+//------------------------------------------------------------------------------------
+// Helper macros used to allocate the protobuf structures of USP messages (unpacked requests and responses)
+// If a message arena is active (see USP_MEM_ArenaStart), then memory is allocated from the arena and freed in one go when it is stopped
+// Otherwise these behave the same as the macros above
+// NOTE: Memory allocated by these macros must be freed using USP_ARENA_FREE() or usp__msg__free_unpacked(), not USP_FREE()
+#define USP_ARENA_MALLOC(x)         USP_MEM_ArenaMalloc(__FUNCTION__, __LINE__, x)
+#define USP_ARENA_FREE(x)           USP_MEM_ArenaFree(__FUNCTION__, __LINE__, x)
+#define USP_ARENA_REALLOC(x, y)     USP_MEM_ArenaRealloc(__FUNCTION__, __LINE__, x, y)
+#define USP_ARENA_STRDUP(x)         USP_MEM_ArenaStrdup(__FUNCTION__, __LINE__, x)
 
 //------------------------------------------------------------------------------------
 // Functions wrapping memory allocation
@@ -56,12 +67,22 @@ void *USP_MEM_Malloc(const char *func, int line, int size);
 void USP_MEM_Free(const char *func, int line, void *ptr);
 void *USP_MEM_Realloc(const char *func, int line, void *ptr, int size);
 void *USP_MEM_Strdup(const char *func, int line, void *ptr);
+void *USP_MEM_ReallocGeometric(const char *func, int line, void *ptr, int size);
 void USP_MEM_StartCollection(void);
 void USP_MEM_StopCollection(void);
 void USP_MEM_Print(void);
 void USP_MEM_PrintSummary(void);
 void USP_MEM_PrintLeakReport(void);
 int USP_MEM_PrintAll(void);
+int USP_MEM_StartTracking(unsigned sample_rate);
+void USP_MEM_DumpTopAllocators(int max_sites);
+void USP_MEM_ArenaStart(void);
+void USP_MEM_ArenaStop(void);
+bool USP_MEM_IsArenaActive(void);
+void *USP_MEM_ArenaMalloc(const char *func, int line, int size);
+void USP_MEM_ArenaFree(const char *func, int line, void *ptr);
+void *USP_MEM_ArenaRealloc(const char *func, int line, void *ptr, int size);
+void *USP_MEM_ArenaStrdup(const char *func, int line, void *ptr);
 void MAIN_Stop(void);
 
 // Pointer to structure containing the protocol buffer allocator function
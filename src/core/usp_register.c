@@ -475,6 +475,48 @@ int USP_REGISTER_VendorParam_ReadOnly(char *path, dm_get_value_cb_t get_cb, unsi
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** USP_REGISTER_VendorParam_ReadOnlyCached
+**
+** Registers a read only vendor parameter whose value is expensive to obtain
+** The value returned by the get callback is reused by subsequent gets of the parameter (with the same instance numbers)
+** for up to cache_ttl milliseconds, or until any parameter is set or object instance deleted
+**
+** \param   path - full data model path for the parameter
+** \param   get_cb - callback called to get the value of the parameter
+** \param   type_flags - type of the parameter
+** \param   cache_ttl - time (in ms) for which a value returned by get_cb may be reused. If 0, the value is not cached
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int USP_REGISTER_VendorParam_ReadOnlyCached(char *path, dm_get_value_cb_t get_cb, unsigned type_flags, unsigned cache_ttl)
+{
+    dm_node_t *node;
+    int err;
+
+    // Exit if unable to register the parameter
+    err = USP_REGISTER_VendorParam_ReadOnly(path, get_cb, type_flags);
+    if (err != USP_ERR_OK)
+    {
+        return err;
+    }
+
+    // Exit if the parameter's value should not be cached
+    if (cache_ttl == 0)
+    {
+        return USP_ERR_OK;
+    }
+
+    // Add a cache to the node registered above
+    node = DM_PRIV_AddSchemaPath(path, kDMNodeType_VendorParam_ReadOnly, SUPPRESS_PRE_EXISTANCE_ERR);
+    USP_ASSERT(node != NULL);
+    DM_PRIV_AddValueCache(node, cache_ttl);
+    return USP_ERR_OK;
+}
+
 /*********************************************************************//**
 **
 ** USP_REGISTER_VendorParam_ReadWrite
@@ -831,6 +873,121 @@ int USP_REGISTER_Object_UniqueKey(char *path, char **params, int num_params)
     return USP_ERR_OK;
 }
 
+/*********************************************************************//**
+**
+** USP_REGISTER_GroupGet
+**
+** Registers a callback which gets the values of all vendor parameters in an instance of an object at once
+** This is useful if the vendor obtains all of the values from a single snapshot (eg of a table row or a set of counters),
+** as the values are then consistent with each other, and the snapshot only needs to be taken once
+** The callback adds {parameter name vs value} for the parameters which are immediate children of the object instance
+** Any vendor parameter not returned by the callback is obtained using its own get callback instead
+** NOTE: For multi-instance objects, this function must be called after the object has been registered by USP_REGISTER_Object()
+**
+** \param   path - full data model path for the object (multi-instance or single instance)
+** \param   get_group_cb - callback called to get the values of all parameters in an instance of the object
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int USP_REGISTER_GroupGet(char *path, dm_get_group_cb_t get_group_cb)
+{
+    dm_node_t *node;
+
+    // Exit if this function is not being called from within VENDOR_Init()
+    if (is_executing_within_dm_init == false)
+    {
+        USP_ERR_SetMessage(usp_err_bad_scope_str, __FUNCTION__, path);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if input parameters are not defined
+    if ((path == NULL) || (get_group_cb == NULL))
+    {
+        USP_ERR_SetMessage(usp_err_invalid_param_str, __FUNCTION__);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if unable to find this object in the data model
+    // NOTE: This call will add the path if not already added. The type of the last node (multi-instance or single instance)
+    // is determined by whether the path ends in '{i}'
+    node = DM_PRIV_AddSchemaPath(path, kDMNodeType_Object_MultiInstance, SUPPRESS_PRE_EXISTANCE_ERR);
+    if (node == NULL)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if the path is not to an object
+    if (IsObject(node) == false)
+    {
+        USP_ERR_SetMessage("%s: Path '%s' is not an object", __FUNCTION__, path);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    node->registered.object_info.get_group_cb = get_group_cb;
+    is_group_get_registered = true;
+
+    return USP_ERR_OK;
+}
+
+/*********************************************************************//**
+**
+** USP_REGISTER_GroupSet
+**
+** Registers a callback which applies all vendor parameters set in an instance of an object at once
+** This is useful if applying each parameter individually is expensive (eg it causes hardware to be reconfigured)
+** When this callback is registered, the set callbacks of the vendor parameters which are immediate children of the object
+** are not called. Instead, their new values are passed to this callback as {parameter name vs value} when the transaction is committed
+** If the callback returns an error, then the transaction is aborted
+** NOTE: For multi-instance objects, this function must be called after the object has been registered by USP_REGISTER_Object()
+**
+** \param   path - full data model path for the object (multi-instance or single instance)
+** \param   set_group_cb - callback called to apply all parameters set in an instance of the object
+**
+** \return  USP_ERR_OK if successful
+**          USP_ERR_INTERNAL_ERROR if any other error occurred
+**
+**************************************************************************/
+int USP_REGISTER_GroupSet(char *path, dm_set_group_cb_t set_group_cb)
+{
+    dm_node_t *node;
+
+    // Exit if this function is not being called from within VENDOR_Init()
+    if (is_executing_within_dm_init == false)
+    {
+        USP_ERR_SetMessage(usp_err_bad_scope_str, __FUNCTION__, path);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if input parameters are not defined
+    if ((path == NULL) || (set_group_cb == NULL))
+    {
+        USP_ERR_SetMessage(usp_err_invalid_param_str, __FUNCTION__);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if unable to find this object in the data model
+    // NOTE: This call will add the path if not already added. The type of the last node (multi-instance or single instance)
+    // is determined by whether the path ends in '{i}'
+    node = DM_PRIV_AddSchemaPath(path, kDMNodeType_Object_MultiInstance, SUPPRESS_PRE_EXISTANCE_ERR);
+    if (node == NULL)
+    {
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    // Exit if the path is not to an object
+    if (IsObject(node) == false)
+    {
+        USP_ERR_SetMessage("%s: Path '%s' is not an object", __FUNCTION__, path);
+        return USP_ERR_INTERNAL_ERROR;
+    }
+
+    node->registered.object_info.set_group_cb = set_group_cb;
+
+    return USP_ERR_OK;
+}
+
 /*********************************************************************//**
 **
 ** USP_REGISTER_SyncOperation
@@ -249,6 +249,9 @@ typedef int (*dm_sync_oper_cb_t)(dm_req_t *req, char *command_key, kv_vector_t *
 typedef int (*dm_async_oper_cb_t)(dm_req_t *req, kv_vector_t *input_args, int instance);
 typedef int (*dm_async_restart_cb_t)(dm_req_t *req, int instance, bool *is_restart, int *err_code, char *err_msg, int err_msg_len, kv_vector_t *output_args);
 
+typedef int (*dm_get_group_cb_t)(dm_req_t *req, kv_vector_t *params);
+typedef int (*dm_set_group_cb_t)(dm_req_t *req, kv_vector_t *params);
+
 //-------------------------------------------------------------------------
 // Typedefs for core vendor hook callbacks
 
@@ -353,6 +356,7 @@ int USP_REGISTER_Param_Constant(char *path, char *value, unsigned type_flags);
 int USP_REGISTER_DBParam_ReadWrite(char *path, char *value, dm_validate_value_cb_t validator_cb, dm_notify_set_cb_t notify_set_cb, unsigned type_flags);
 int USP_REGISTER_Param_NumEntries(char *path, char *table_path);
 int USP_REGISTER_VendorParam_ReadOnly(char *path, dm_get_value_cb_t get_cb, unsigned type_flags);
+int USP_REGISTER_VendorParam_ReadOnlyCached(char *path, dm_get_value_cb_t get_cb, unsigned type_flags, unsigned cache_ttl);
 int USP_REGISTER_VendorParam_ReadWrite(char *path, dm_get_value_cb_t get_cb, dm_set_value_cb_t set_cb, dm_notify_set_cb_t notify_set_cb, unsigned type_flags);
 int USP_REGISTER_DBParam_ReadOnlyAuto(char *path, dm_get_value_cb_t get_cb, unsigned type_flags);
 int USP_REGISTER_DBParam_ReadWriteAuto(char *path, dm_get_value_cb_t get_cb, dm_validate_value_cb_t validator_cb, 
@@ -363,6 +367,8 @@ int USP_REGISTER_DBParam_Secure(char *path, char *value, dm_validate_value_cb_t
 int USP_REGISTER_Object(char *path, dm_validate_add_cb_t validate_add_cb, dm_add_cb_t add_cb, dm_notify_add_cb_t notify_add_cb,
                                    dm_validate_del_cb_t validate_del_cb, dm_del_cb_t del_cb, dm_notify_del_cb_t notify_del_cb);
 int USP_REGISTER_Object_UniqueKey(char *path, char **params, int num_params);
+int USP_REGISTER_GroupGet(char *path, dm_get_group_cb_t get_group_cb);
+int USP_REGISTER_GroupSet(char *path, dm_set_group_cb_t set_group_cb);
 int USP_REGISTER_SyncOperation(char *path, dm_sync_oper_cb_t sync_oper_cb);
 int USP_REGISTER_AsyncOperation(char *path, dm_async_oper_cb_t async_oper_cb, dm_async_restart_cb_t restart_cb);
 int USP_REGISTER_OperationArguments(char *path, char **input_arg_names, int num_input_arg_names, char **output_arg_names, int num_output_arg_names);